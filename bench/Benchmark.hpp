@@ -0,0 +1,175 @@
+#ifndef BENCHMARK_HPP
+#define BENCHMARK_HPP
+
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <string>
+#include <vector>
+
+#if defined(__x86_64__) || defined(__i386__)
+    #include <x86intrin.h>
+    #define COLORGEN_BENCH_TSC 1
+#elif defined(_M_X64) || defined(_M_IX86)
+    #include <intrin.h>
+    #define COLORGEN_BENCH_TSC 1
+#endif
+
+namespace ColorGenerator {
+namespace Bench {
+
+/**
+ * @brief Cycle source for bytes/cycle figures
+ *
+ * Uses the time stamp counter on x86 (a constant-rate clock on current
+ * CPUs, so figures are relative to the nominal frequency). Elsewhere it
+ * falls back to nanoseconds and reports "ns" as its source.
+ */
+struct CycleCounter {
+    static uint64_t now() {
+#ifdef COLORGEN_BENCH_TSC
+        return __rdtsc();
+#else
+        return static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(
+            std::chrono::steady_clock::now().time_since_epoch()).count());
+#endif
+    }
+
+    static const char* source() {
+#ifdef COLORGEN_BENCH_TSC
+        return "tsc";
+#else
+        return "ns";
+#endif
+    }
+};
+
+/**
+ * @brief Sampling limits for one measurement
+ */
+struct RunConfig {
+    double minSeconds = 0.5;     ///< Keep sampling until this much time is spent
+    size_t minIterations = 3;
+    size_t maxIterations = 1000;
+};
+
+/**
+ * @brief Summary of the samples of one case
+ */
+struct Stats {
+    size_t iterations = 0;
+    double minNs = 0.0;
+    double medianNs = 0.0;
+    double p99Ns = 0.0;
+    double medianCycles = 0.0;
+};
+
+/**
+ * @brief Time @p body repeatedly; @p setup runs untimed before each sample
+ */
+template <typename Setup, typename Body>
+Stats measure(const RunConfig& config, Setup&& setup, Body&& body) {
+    std::vector<double> nanoseconds;
+    std::vector<double> cycles;
+    double total = 0.0;
+
+    while (nanoseconds.size() < config.maxIterations &&
+           (nanoseconds.size() < config.minIterations || total < config.minSeconds)) {
+        setup();
+        const auto start = std::chrono::steady_clock::now();
+        const uint64_t startCycles = CycleCounter::now();
+        body();
+        const uint64_t endCycles = CycleCounter::now();
+        const auto end = std::chrono::steady_clock::now();
+
+        const double ns = std::chrono::duration<double, std::nano>(end - start).count();
+        nanoseconds.push_back(ns);
+        cycles.push_back(static_cast<double>(endCycles - startCycles));
+        total += ns * 1e-9;
+    }
+
+    auto percentile = [](std::vector<double> values, double p) {
+        std::sort(values.begin(), values.end());
+        size_t index = static_cast<size_t>(p * static_cast<double>(values.size() - 1) + 0.5);
+        return values[index];
+    };
+
+    Stats stats;
+    stats.iterations = nanoseconds.size();
+    stats.minNs = *std::min_element(nanoseconds.begin(), nanoseconds.end());
+    stats.medianNs = percentile(nanoseconds, 0.5);
+    stats.p99Ns = percentile(nanoseconds, 0.99);
+    stats.medianCycles = percentile(cycles, 0.5);
+    return stats;
+}
+
+template <typename Body>
+Stats measure(const RunConfig& config, Body&& body) {
+    return measure(config, [] {}, std::forward<Body>(body));
+}
+
+/**
+ * @brief Streams results as one JSON document on stdout
+ */
+class JSONReport {
+public:
+    JSONReport() {
+        std::printf("{\n  \"benchmark\": \"ColorImageGenerator\",\n"
+                    "  \"cycle_source\": \"%s\",\n  \"results\": [", CycleCounter::source());
+    }
+
+    ~JSONReport() {
+        std::printf("\n  ]\n}\n");
+    }
+
+    JSONReport(const JSONReport&) = delete;
+    JSONReport& operator=(const JSONReport&) = delete;
+
+    /**
+     * @brief Emit one result
+     * @param stage Stage name
+     * @param size Size label (preset name, or "none" for size-independent stages)
+     * @param width Image width (0 if not applicable)
+     * @param height Image height (0 if not applicable)
+     * @param bytes Bytes processed per iteration
+     * @param stats Timing summary
+     * @param extra Additional stage-specific JSON members (e.g. "\"output_bytes\": 123"), or empty
+     */
+    void add(const std::string& stage, const std::string& size, uint32_t width, uint32_t height,
+             uint64_t bytes, const Stats& stats, const std::string& extra = std::string()) {
+        const double bytesPerCycle = stats.medianCycles > 0.0 ? bytes / stats.medianCycles : 0.0;
+        const double gbPerSecond = stats.medianNs > 0.0 ? bytes / stats.medianNs : 0.0;
+        std::printf("%s\n    {\"stage\": \"%s\", \"size\": \"%s\", \"width\": %u, \"height\": %u, "
+                    "\"bytes\": %llu, \"iterations\": %zu, "
+                    "\"ns\": {\"min\": %.0f, \"median\": %.0f, \"p99\": %.0f}, "
+                    "\"bytes_per_cycle\": %.4f, \"gb_per_s\": %.3f%s%s}",
+                    first_ ? "" : ",", stage.c_str(), size.c_str(), width, height,
+                    static_cast<unsigned long long>(bytes), stats.iterations,
+                    stats.minNs, stats.medianNs, stats.p99Ns, bytesPerCycle, gbPerSecond,
+                    extra.empty() ? "" : ", ", extra.c_str());
+        std::fflush(stdout);
+        first_ = false;
+    }
+
+private:
+    bool first_ = true;
+};
+
+/**
+ * @brief Keep the optimizer from discarding a computed value
+ */
+template <typename T>
+inline void doNotOptimize(const T& value) {
+#if defined(__GNUC__) || defined(__clang__)
+    asm volatile("" : : "r,m"(value) : "memory");
+#else
+    volatile const T* sink = &value;
+    (void)sink;
+#endif
+}
+
+} // namespace Bench
+} // namespace ColorGenerator
+
+#endif // BENCHMARK_HPP
@@ -0,0 +1,736 @@
+// Microbenchmarks for every stage of the image write path.
+//
+// stb_image_write is compiled privately into this file as the reference
+// the encoders are compared with, so its internal stages (line
+// filtering, CRC, DCT) can be timed on their own. The application does
+// not link it.
+
+#if defined(__GNUC__)
+    #pragma GCC diagnostic push
+    #pragma GCC diagnostic ignored "-Wunused-function"
+    #pragma GCC diagnostic ignored "-Wmissing-field-initializers"
+#endif
+#define STB_IMAGE_WRITE_STATIC
+#define STB_IMAGE_WRITE_IMPLEMENTATION
+#include "../include/stb_image_write.h"
+#if defined(__GNUC__)
+    #pragma GCC diagnostic pop
+#endif
+
+#include "Benchmark.hpp"
+#include "../include/Color.hpp"
+#include "../include/Gradient.hpp"
+#include "../include/Noise.hpp"
+#include "../include/Resolution.hpp"
+#include "../include/TestPattern.hpp"
+#include "../include/formats/STBImageWriter.hpp"
+#include "../include/formats/Deflate.hpp"
+#include "../include/formats/JPEGColor.hpp"
+#include "../include/formats/JPEGCommon.hpp"
+#include "../include/formats/JPEGEncoder.hpp"
+#include "../include/formats/JPEGTransform.hpp"
+#include "../include/formats/PNGEncoder.hpp"
+#include "../include/formats/SolidPNGEncoder.hpp"
+#include "../include/formats/SolidJPEGEncoder.hpp"
+#include "../include/formats/SolidBMPEncoder.hpp"
+#include "../include/formats/Y4MWriter.hpp"
+#include "../include/formats/APNGEncoder.hpp"
+#include "../include/formats/GIFWriter.hpp"
+#include "../include/formats/QOIWriter.hpp"
+#include "../include/formats/WebPWriter.hpp"
+#include <array>
+#include <climits>
+#include <cstdlib>
+#include <cstring>
+#include <filesystem>
+#include <initializer_list>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#ifndef _WIN32
+    #include <unistd.h>
+#else
+    #include <process.h>
+    #define getpid _getpid
+#endif
+
+using namespace ColorGenerator;
+using namespace ColorGenerator::Bench;
+
+namespace {
+
+struct SizeCase {
+    const char* name;
+    Resolution resolution;
+};
+
+const Color BENCH_COLOR(0x34, 0x98, 0xDB);
+const Color BENCH_COLOR_ALPHA(0x34, 0x98, 0xDB, 0x80);
+const int JPEG_QUALITY = 95;
+
+std::vector<std::string> splitList(const std::string& text) {
+    std::vector<std::string> items;
+    std::stringstream stream(text);
+    std::string item;
+    while (std::getline(stream, item, ',')) {
+        if (!item.empty()) items.push_back(item);
+    }
+    return items;
+}
+
+bool selected(const std::vector<std::string>& filter, const std::string& name) {
+    if (filter.empty()) return true;
+    for (const std::string& item : filter) {
+        if (name.find(item) != std::string::npos) return true;
+    }
+    return false;
+}
+
+/**
+ * @brief Context shared by all stages for one image size
+ */
+struct StageContext {
+    const RunConfig& config;
+    JSONReport& report;
+    const SizeCase& size;
+    const std::vector<std::string>& stages;
+    std::string scratchPath;
+
+    bool wants(const std::string& stage) const { return selected(stages, stage); }
+
+    uint32_t width() const { return size.resolution.getWidth(); }
+    uint32_t height() const { return size.resolution.getHeight(); }
+    uint64_t pixels() const { return size.resolution.getPixelCount(); }
+
+    void add(const std::string& stage, uint64_t bytes, const Stats& stats,
+             const std::string& extra = std::string()) const {
+        report.add(stage, size.name, width(), height(), bytes, stats, extra);
+    }
+};
+
+void discard(void*, void*, int) {}
+
+/**
+ * @brief Fill @p buffer with 4-octave simplex noise, a stand-in for photographic content
+ *
+ * A solid buffer compresses trivially, so stages whose cost depends on
+ * the content (filtering, deflate, entropy coding) are timed on this.
+ */
+void fillDetail(PixelBuffer& buffer, const Resolution& resolution) {
+    Noise::Options options;
+    options.type = NoiseType::Simplex;
+    options.seed = 42;
+    options.octaves = 4;
+    options.scale = 32.0f;
+    Noise(BENCH_COLOR, resolution, options).fill(buffer);
+}
+
+// ---------------------------------------------------------------------------
+// Stages
+// ---------------------------------------------------------------------------
+
+void benchColorParse(const RunConfig& config, JSONReport& report) {
+    const std::vector<std::string> inputs = {
+        "#FF5733", "3498DB", "#F0A", "#FF573380", "0000FF40", "#abcdef", "#000", "FFFFFFFF"
+    };
+    const int rounds = 128;
+    uint64_t bytes = 0;
+    for (const std::string& input : inputs) bytes += input.size();
+    bytes *= rounds;
+
+    Stats stats = measure(config, [&] {
+        uint32_t checksum = 0;
+        for (int round = 0; round < rounds; ++round) {
+            for (const std::string& input : inputs) {
+                Color color(input);
+                checksum += color.getRed() + color.getAlpha();
+            }
+        }
+        doNotOptimize(checksum);
+    });
+    report.add("color_parse", "none", 0, 0, bytes, stats);
+}
+
+void benchFill(const StageContext& ctx, int channels) {
+    // A fresh buffer per sample, as the write path allocates one per image
+    PixelBuffer buffer;
+    Stats stats = measure(ctx.config,
+        [&] { buffer.allocate(0); },
+        [&] {
+            STBImageWriter::fillPixelBuffer(buffer, channels == 4 ? BENCH_COLOR_ALPHA : BENCH_COLOR,
+                                            ctx.size.resolution, channels);
+            doNotOptimize(buffer.data());
+        });
+    ctx.add(channels == 4 ? "fill_rgba" : "fill_rgb", ctx.pixels() * channels, stats);
+}
+
+void benchGradient(const StageContext& ctx, GradientShape shape, const char* name) {
+    Gradient::Options options;
+    options.shape = shape;
+    options.angle = 30.0f;
+    options.dither = Dither::BlueNoise;
+    const Gradient gradient({{BENCH_COLOR, 0.0f}, {Color(0xFF, 0x57, 0x33), 0.6f}, {Color(0x00, 0x00, 0x00), 1.0f}},
+                            ctx.size.resolution, options);
+
+    PixelBuffer buffer;
+    Stats stats = measure(ctx.config,
+        [&] { buffer.allocate(0); },
+        [&] {
+            gradient.fill(buffer);
+            doNotOptimize(buffer.data());
+        });
+    ctx.add(name, ctx.pixels() * 3, stats);
+}
+
+void benchNoise(const StageContext& ctx, NoiseType type, const char* name) {
+    Noise::Options options;
+    options.type = type;
+    options.seed = 42;
+    options.octaves = 4;
+    const Noise noise(BENCH_COLOR, ctx.size.resolution, options);
+
+    PixelBuffer buffer;
+    Stats stats = measure(ctx.config,
+        [&] { buffer.allocate(0); },
+        [&] {
+            noise.fill(buffer);
+            doNotOptimize(buffer.data());
+        });
+    ctx.add(name, ctx.pixels() * 3, stats);
+}
+
+/**
+ * @brief Adaptive per-row filter selection as done by stbi_write_png_to_mem
+ */
+void filterImage(unsigned char* pixels, int width, int height, int channels,
+                 std::vector<unsigned char>& filtered, std::vector<signed char>& line) {
+    const int stride = width * channels;
+    for (int y = 0; y < height; ++y) {
+        int best = 0;
+        int bestEstimate = INT_MAX;
+        for (int filter = 0; filter < 5; ++filter) {
+            stbiw__encode_png_line(pixels, stride, width, height, y, channels, filter, line.data());
+            int estimate = 0;
+            for (int i = 0; i < stride; ++i) {
+                estimate += std::abs(static_cast<int>(line[i]));
+            }
+            if (estimate < bestEstimate) {
+                bestEstimate = estimate;
+                best = filter;
+            }
+        }
+        if (best != 4) {
+            stbiw__encode_png_line(pixels, stride, width, height, y, channels, best, line.data());
+        }
+        unsigned char* row = filtered.data() + static_cast<size_t>(y) * (stride + 1);
+        row[0] = static_cast<unsigned char>(best);
+        std::memcpy(row + 1, line.data(), static_cast<size_t>(stride));
+    }
+}
+
+void benchPNG(const StageContext& ctx, PixelBuffer& pixels) {
+    const int width = static_cast<int>(ctx.width());
+    const int height = static_cast<int>(ctx.height());
+    const int channels = 3;
+    const uint64_t rawBytes = ctx.pixels() * channels;
+
+    std::vector<unsigned char> filtered(static_cast<size_t>(width * channels + 1) * height);
+    std::vector<signed char> line(static_cast<size_t>(width) * channels);
+
+    if (ctx.wants("png_filter")) {
+        Stats stats = measure(ctx.config, [&] {
+            filterImage(pixels.data(), width, height, channels, filtered, line);
+        });
+        ctx.add("png_filter", rawBytes, stats);
+    } else {
+        filterImage(pixels.data(), width, height, channels, filtered, line);
+    }
+
+    if (ctx.wants("zlib_compress")) {
+        Stats stats = measure(ctx.config, [&] {
+            int length = 0;
+            unsigned char* compressed = stbi_zlib_compress(filtered.data(), static_cast<int>(filtered.size()),
+                                                           &length, stbi_write_png_compression_level);
+            doNotOptimize(length);
+            STBIW_FREE(compressed);
+        });
+        ctx.add("zlib_compress", filtered.size(), stats);
+    }
+
+    if (ctx.wants("zlib_parallel")) {
+        Stats stats = measure(ctx.config, [&] {
+            std::vector<uint8_t> compressed = ParallelDeflate::compress(
+                filtered.data(), filtered.size(), stbi_write_png_compression_level);
+            doNotOptimize(compressed.data());
+        });
+        ctx.add("zlib_parallel", filtered.size(), stats);
+    }
+
+    if (ctx.wants("crc32")) {
+        Stats stats = measure(ctx.config, [&] {
+            unsigned int crc = stbiw__crc32(pixels.data(), static_cast<int>(rawBytes));
+            doNotOptimize(crc);
+        });
+        ctx.add("crc32", rawBytes, stats);
+    }
+
+    if (ctx.wants("crc32_fast")) {
+        Stats stats = measure(ctx.config, [&] {
+            uint32_t crc = Crc32::update(0, pixels.data(), static_cast<size_t>(rawBytes));
+            doNotOptimize(crc);
+        });
+        ctx.add("crc32_fast", rawBytes, stats);
+    }
+
+    if (ctx.wants("adler32")) {
+        Stats stats = measure(ctx.config, [&] {
+            Adler32 adler;
+            adler.update(pixels.data(), static_cast<size_t>(rawBytes));
+            doNotOptimize(adler.value());
+        });
+        ctx.add("adler32", rawBytes, stats);
+    }
+
+    if (ctx.wants("png_stb")) {
+        Stats stats = measure(ctx.config, [&] {
+            int length = 0;
+            unsigned char* png = stbi_write_png_to_mem(pixels.data(), width * channels, width, height,
+                                                       channels, &length);
+            doNotOptimize(length);
+            STBIW_FREE(png);
+        });
+        ctx.add("png_stb", rawBytes, stats);
+    }
+
+    if (ctx.wants("png_solid")) {
+        Stats stats = measure(ctx.config, [&] {
+            SolidPNGEncoder::write(ctx.scratchPath, BENCH_COLOR, ctx.size.resolution, channels);
+        });
+        ctx.add("png_solid", rawBytes, stats);
+    }
+
+    // Repeated bands are copied as back-references; compare with png_solid
+    if (ctx.wants("png_bars")) {
+        const TestPattern bars(ctx.size.resolution, TestPattern::Options{});
+        Stats stats = measure(ctx.config, [&] {
+            PNGEncoder::write(ctx.scratchPath, bars, PNGEncoder::Options{});
+        });
+        ctx.add("png_bars", rawBytes, stats);
+    }
+}
+
+void benchQOI(const StageContext& ctx, PixelBuffer& pixels) {
+    const uint64_t rawBytes = ctx.pixels() * 3;
+
+    // Every pixel through the coder, as png_stb does
+    if (ctx.wants("qoi_encode")) {
+        const BufferRowSource source(pixels.data(), ctx.width(), ctx.height(), 3);
+        QOIWriter writer;
+        Stats stats = measure(ctx.config, [&] {
+            writer.write(ctx.scratchPath, source);
+        });
+        ctx.add("qoi_encode", rawBytes, stats);
+    }
+
+    // First row coded, the rest written as repeated run bytes; compare with png_solid
+    if (ctx.wants("qoi_solid")) {
+        QOIWriter writer;
+        Stats stats = measure(ctx.config, [&] {
+            writer.write(ctx.scratchPath, BENCH_COLOR, ctx.size.resolution);
+        });
+        ctx.add("qoi_solid", rawBytes, stats);
+    }
+
+    // Repeated rows are coded twice, then copied; compare with png_bars
+    if (ctx.wants("qoi_bars")) {
+        const TestPattern bars(ctx.size.resolution, TestPattern::Options{});
+        QOIWriter writer;
+        Stats stats = measure(ctx.config, [&] {
+            writer.write(ctx.scratchPath, bars);
+        });
+        ctx.add("qoi_bars", rawBytes, stats);
+    }
+}
+
+void benchJPEG(const StageContext& ctx, PixelBuffer& pixels) {
+    const int width = static_cast<int>(ctx.width());
+    const int height = static_cast<int>(ctx.height());
+    const uint64_t rawBytes = ctx.pixels() * 3;
+
+    // Forward DCT of every luma block, rows then columns as in stbiw__jpg_processDU
+    if (ctx.wants("jpeg_dct")) {
+        Stats stats = measure(ctx.config, [&] {
+            float block[64];
+            float checksum = 0.0f;
+            for (int by = 0; by + 8 <= height; by += 8) {
+                for (int bx = 0; bx + 8 <= width; bx += 8) {
+                    for (int y = 0; y < 8; ++y) {
+                        const uint8_t* row = pixels.data() + (static_cast<size_t>(by + y) * width + bx) * 3;
+                        for (int x = 0; x < 8; ++x) {
+                            block[y * 8 + x] = row[x * 3] - 128.0f;
+                        }
+                    }
+                    for (int i = 0; i < 64; i += 8) {
+                        stbiw__jpg_DCT(&block[i], &block[i + 1], &block[i + 2], &block[i + 3],
+                                       &block[i + 4], &block[i + 5], &block[i + 6], &block[i + 7]);
+                    }
+                    for (int i = 0; i < 8; ++i) {
+                        stbiw__jpg_DCT(&block[i], &block[i + 8], &block[i + 16], &block[i + 24],
+                                       &block[i + 32], &block[i + 40], &block[i + 48], &block[i + 56]);
+                    }
+                    checksum += block[0];
+                }
+            }
+            doNotOptimize(checksum);
+        });
+        ctx.add("jpeg_dct", ctx.pixels(), stats);
+    }
+
+    // The encoder's batched transform with fused quantization and zigzag
+    if (ctx.wants("jpeg_fdct") || ctx.wants("jpeg_fdct_int")) {
+        const size_t stride = static_cast<size_t>(width / 8) * 8;
+        std::vector<uint8_t> plane(stride * static_cast<size_t>(height / 8) * 8);
+        for (size_t i = 0; i < plane.size(); ++i) {
+            const size_t y = i / stride, x = i % stride;
+            plane[i] = pixels.data()[(y * width + x) * 3];
+        }
+        const std::array<uint8_t, 64> table = JPEG::scaleQuantTable(JPEG::LUMA_QUANT, JPEG::qualityScale(JPEG_QUALITY));
+        const JPEG::Quantizer quantizer(table.data());
+        std::vector<int16_t> coefficients(stride * 8);
+
+        for (JPEG::DCTMethod method : {JPEG::DCTMethod::Float, JPEG::DCTMethod::Integer}) {
+            const char* name = method == JPEG::DCTMethod::Float ? "jpeg_fdct" : "jpeg_fdct_int";
+            if (!ctx.wants(name)) continue;
+            Stats stats = measure(ctx.config, [&] {
+                for (size_t y = 0; y + 8 <= plane.size() / stride; y += 8) {
+                    JPEG::transformBlocks(plane.data() + y * stride, stride, stride / 8, quantizer, method,
+                                          coefficients.data());
+                }
+                doNotOptimize(coefficients.data());
+            });
+            ctx.add(name, ctx.pixels(), stats);
+        }
+    }
+
+    // Color conversion, DCT, quantization and Huffman coding
+    if (ctx.wants("jpeg_stb")) {
+        Stats stats = measure(ctx.config, [&] {
+            stbi_write_jpg_to_func(discard, nullptr, width, height, 3, pixels.data(), JPEG_QUALITY);
+        });
+        ctx.add("jpeg_stb", rawBytes, stats);
+    }
+
+    // Same pipeline with restart intervals, segments encoded on all cores
+    JPEGEncoder::Options options;
+    options.quality = JPEG_QUALITY;
+    options.restartRows = JPEGEncoder::DEFAULT_RESTART_ROWS;
+    const bool huffman = ctx.wants("jpeg_huffman_opt") || ctx.wants("jpeg_huffman_sampled");
+    Stats standard;
+    size_t standardBytes = 0;
+    if (ctx.wants("jpeg_parallel") || huffman) {
+        standard = measure(ctx.config, [&] {
+            std::vector<uint8_t> jpeg = JPEGEncoder::encode(pixels.data(), ctx.width(), ctx.height(), 3, options);
+            standardBytes = jpeg.size();
+            doNotOptimize(jpeg.data());
+        });
+        if (ctx.wants("jpeg_parallel")) {
+            ctx.add("jpeg_parallel", rawBytes, standard, "\"output_bytes\": " + std::to_string(standardBytes));
+        }
+    }
+
+    // Two-pass encodes with image-specific Huffman tables; deltas are relative to jpeg_parallel
+    if (huffman) {
+        for (uint32_t step : {1u, 4u}) {
+            const char* name = step == 1 ? "jpeg_huffman_opt" : "jpeg_huffman_sampled";
+            if (!ctx.wants(name)) continue;
+            JPEGEncoder::Options optimized = options;
+            optimized.optimizeHuffman = true;
+            optimized.huffmanSampleStep = step;
+            size_t outputBytes = 0;
+            Stats stats = measure(ctx.config, [&] {
+                std::vector<uint8_t> jpeg = JPEGEncoder::encode(pixels.data(), ctx.width(), ctx.height(), 3, optimized);
+                outputBytes = jpeg.size();
+                doNotOptimize(jpeg.data());
+            });
+            char extra[160];
+            std::snprintf(extra, sizeof(extra),
+                          "\"output_bytes\": %zu, \"size_delta\": %.4f, \"time_delta\": %.4f", outputBytes,
+                          standardBytes ? static_cast<double>(outputBytes) / standardBytes - 1.0 : 0.0,
+                          standard.medianNs > 0.0 ? stats.medianNs / standard.medianNs - 1.0 : 0.0);
+            ctx.add(name, rawBytes, stats, extra);
+        }
+    }
+
+    if (ctx.wants("jpeg_solid")) {
+        Stats stats = measure(ctx.config, [&] {
+            SolidJPEGEncoder::write(ctx.scratchPath, BENCH_COLOR, ctx.size.resolution, JPEG_QUALITY);
+        });
+        ctx.add("jpeg_solid", rawBytes, stats);
+    }
+}
+
+void benchBMP(const StageContext& ctx, PixelBuffer& pixels) {
+    const int width = static_cast<int>(ctx.width());
+    const int height = static_cast<int>(ctx.height());
+    const uint64_t rawBytes = ctx.pixels() * 3;
+
+    if (ctx.wants("bmp_stb")) {
+        Stats stats = measure(ctx.config, [&] {
+            stbi_write_bmp_to_func(discard, nullptr, width, height, 3, pixels.data());
+        });
+        ctx.add("bmp_stb", rawBytes, stats);
+    }
+
+    if (ctx.wants("bmp_solid")) {
+        Stats stats = measure(ctx.config, [&] {
+            SolidBMPEncoder::write(ctx.scratchPath, BENCH_COLOR, ctx.size.resolution, 3);
+        });
+        ctx.add("bmp_solid", rawBytes, stats);
+    }
+}
+
+void benchGIF(const StageContext& ctx) {
+    const uint64_t rawBytes = ctx.pixels() * 3;
+
+    // Analytic LZW: cost grows with the number of codes, not pixels
+    if (ctx.wants("gif_solid")) {
+        GIFWriter writer;
+        Stats stats = measure(ctx.config, [&] {
+            writer.write(ctx.scratchPath, BENCH_COLOR, ctx.size.resolution);
+        });
+        ctx.add("gif_solid", rawBytes, stats);
+    }
+
+    // Exact 16-color palette, then one hash lookup per pixel
+    if (ctx.wants("gif_bars")) {
+        const TestPattern bars(ctx.size.resolution, TestPattern::Options{});
+        GIFWriter writer;
+        Stats stats = measure(ctx.config, [&] {
+            writer.write(ctx.scratchPath, bars);
+        });
+        ctx.add("gif_bars", rawBytes, stats);
+    }
+
+    // 60 frames sharing one LZW stream
+    if (ctx.wants("gif_fade")) {
+        const Fade fade({{BENCH_COLOR, 0.0f}, {Color(0xFF, 0x57, 0x33), 1.0f}}, 60);
+        Stats stats = measure(ctx.config, [&] {
+            GIFWriter::writeFade(ctx.scratchPath, fade, ctx.size.resolution, GIFWriter::AnimationOptions{});
+        });
+        ctx.add("gif_fade", rawBytes * fade.frames(), stats);
+    }
+}
+
+void benchWebP(const StageContext& ctx) {
+    const uint64_t rawBytes = ctx.pixels() * 3;
+
+    // One color: five single-symbol codes and no pixel data, at any size
+    if (ctx.wants("webp_solid")) {
+        WebPWriter writer;
+        Stats stats = measure(ctx.config, [&] {
+            writer.write(ctx.scratchPath, BENCH_COLOR, ctx.size.resolution);
+        });
+        ctx.add("webp_solid", rawBytes, stats);
+    }
+
+    // Palette scan of the distinct rows, bundled indices, repeats as row copies
+    if (ctx.wants("webp_bars")) {
+        const TestPattern bars(ctx.size.resolution, TestPattern::Options{});
+        WebPWriter writer;
+        Stats stats = measure(ctx.config, [&] {
+            writer.write(ctx.scratchPath, bars);
+        });
+        ctx.add("webp_bars", rawBytes, stats);
+    }
+
+    // Predicted ARGB residuals, counted for five cache sizes and then coded
+    if (ctx.wants("webp_argb")) {
+        const Gradient gradient({{BENCH_COLOR, 0.0f}, {Color(0xFF, 0x57, 0x33), 1.0f}},
+                                ctx.size.resolution, Gradient::Options{});
+        PixelBuffer pixels;
+        gradient.fill(pixels);
+        const BufferRowSource source(pixels.data(), ctx.width(), ctx.height(), 3);
+        WebPWriter writer;
+        Stats stats = measure(ctx.config, [&] {
+            writer.write(ctx.scratchPath, source);
+        });
+        ctx.add("webp_argb", rawBytes, stats);
+    }
+}
+
+void benchVideo(const StageContext& ctx) {
+    const uint64_t rawBytes = ctx.pixels() * 3;
+
+    // RGB to limited-range BT.709 4:2:0 of a gradient frame, two rows at a time
+    if (ctx.wants("y4m_convert")) {
+        const Gradient gradient({{BENCH_COLOR, 0.0f}, {Color(0xFF, 0x57, 0x33), 1.0f}},
+                                ctx.size.resolution, Gradient::Options{});
+        PixelBuffer pixels;
+        gradient.fill(pixels);
+        const uint32_t width = ctx.width();
+        const uint32_t height = ctx.height();
+        const size_t planeWidth = (static_cast<size_t>(width) + 1) & ~static_cast<size_t>(1);
+        std::vector<uint8_t> luma(planeWidth * (height + 1));
+        std::vector<uint8_t> chroma(planeWidth * ((height + 1) / 2));
+        Stats stats = measure(ctx.config, [&] {
+            for (uint32_t y = 0; y < height; y += 2) {
+                const uint8_t* row0 = pixels.data() + static_cast<size_t>(y) * width * 3;
+                const uint8_t* row1 = y + 1 < height ? row0 + static_cast<size_t>(width) * 3 : row0;
+                uint8_t* cb = chroma.data() + (y / 2) * planeWidth;
+                JPEG::convertRows(row0, row1, width, 3, JPEG::Subsampling::YUV420, JPEG::BT709_LIMITED,
+                                  planeWidth, luma.data() + y * planeWidth, luma.data() + (y + 1) * planeWidth,
+                                  cb, cb + planeWidth / 2);
+            }
+            doNotOptimize(luma.data());
+        });
+        ctx.add("y4m_convert", rawBytes, stats);
+    }
+
+    // 30 frames of bars: converted once, then written with gathered writes
+    if (ctx.wants("y4m_frames")) {
+        const TestPattern bars(ctx.size.resolution, TestPattern::Options{});
+        Y4MWriter writer;
+        Y4MWriter::Options options;
+        options.frames = 30;
+        writer.setOptions(options);
+        Stats stats = measure(ctx.config, [&] {
+            writer.write(ctx.scratchPath, bars);
+        });
+        ctx.add("y4m_frames", rawBytes * options.frames, stats);
+    }
+
+    // 60-frame fade as an animated PNG: one analytic stream per distinct color, in parallel
+    if (ctx.wants("apng_fade")) {
+        const Fade fade({{BENCH_COLOR, 0.0f}, {Color(0xFF, 0x57, 0x33), 1.0f}}, 60);
+        Stats stats = measure(ctx.config, [&] {
+            APNGEncoder::write(ctx.scratchPath, fade, ctx.size.resolution, APNGEncoder::Options{});
+        });
+        ctx.add("apng_fade", rawBytes * fade.frames(), stats);
+    }
+}
+
+// ---------------------------------------------------------------------------
+// Driver
+// ---------------------------------------------------------------------------
+
+void printUsage(const char* programName) {
+    std::cerr << "Usage: " << programName << " [options]\n\n"
+              << "Options:\n"
+              << "  --sizes <list>         Comma-separated sizes (hd,fullhd,qhd,4k,8k,16k; default: all)\n"
+              << "  --stages <list>        Only run stages whose name contains an entry\n"
+              << "                         (color_parse, fill, gradient, noise, png, zlib, crc32, adler32, jpeg,\n"
+              << "                         bmp, gif, qoi, webp, y4m, apng)\n"
+              << "  --min-time <seconds>   Minimum sampling time per case (default: 0.5)\n"
+              << "  --min-iterations <n>   Minimum samples per case (default: 3)\n"
+              << "  --max-iterations <n>   Maximum samples per case (default: 1000)\n"
+              << "  -h, --help             Show this help message\n\n"
+              << "Results are written to stdout as JSON.\n";
+}
+
+} // namespace
+
+int main(int argc, char* argv[]) {
+    try {
+        RunConfig config;
+        std::vector<std::string> sizeFilter;
+        std::vector<std::string> stageFilter;
+
+        for (int i = 1; i < argc; ++i) {
+            std::string arg = argv[i];
+            auto value = [&]() -> std::string {
+                if (i + 1 >= argc) throw std::invalid_argument("Missing value for " + arg);
+                return argv[++i];
+            };
+
+            if (arg == "-h" || arg == "--help") {
+                printUsage(argv[0]);
+                return 0;
+            } else if (arg == "--sizes") {
+                sizeFilter = splitList(value());
+            } else if (arg == "--stages") {
+                stageFilter = splitList(value());
+            } else if (arg == "--min-time") {
+                config.minSeconds = std::stod(value());
+            } else if (arg == "--min-iterations") {
+                config.minIterations = std::stoul(value());
+            } else if (arg == "--max-iterations") {
+                config.maxIterations = std::stoul(value());
+            } else {
+                std::cerr << "Unknown option: " << arg << "\n";
+                printUsage(argv[0]);
+                return 1;
+            }
+        }
+        if (config.minIterations == 0 || config.maxIterations < config.minIterations) {
+            throw std::invalid_argument("Invalid iteration limits");
+        }
+
+        const std::vector<SizeCase> sizes = {
+            {"hd", Resolution::HD()},
+            {"fullhd", Resolution::FullHD()},
+            {"qhd", Resolution::QHD()},
+            {"4k", Resolution::UHD4K()},
+            {"8k", Resolution(7680, 4320)},
+            {"16k", Resolution(15360, 8640)},
+        };
+
+        const std::string scratchPath = (std::filesystem::temp_directory_path() /
+            ("colorgen-bench-" + std::to_string(getpid()) + ".tmp")).string();
+
+        JSONReport report;
+        if (selected(stageFilter, "color_parse")) {
+            benchColorParse(config, report);
+        }
+
+        for (const SizeCase& size : sizes) {
+            bool wanted = sizeFilter.empty();
+            for (const std::string& name : sizeFilter) {
+                wanted = wanted || name == size.name;
+            }
+            if (!wanted) continue;
+
+            StageContext ctx{config, report, size, stageFilter, scratchPath};
+            if (ctx.wants("fill_rgb")) benchFill(ctx, 3);
+            if (ctx.wants("fill_rgba")) benchFill(ctx, 4);
+            if (ctx.wants("gradient_linear")) benchGradient(ctx, GradientShape::Linear, "gradient_linear");
+            if (ctx.wants("gradient_radial")) benchGradient(ctx, GradientShape::Radial, "gradient_radial");
+            if (ctx.wants("gradient_conic")) benchGradient(ctx, GradientShape::Conic, "gradient_conic");
+            if (ctx.wants("noise_value")) benchNoise(ctx, NoiseType::Value, "noise_value");
+            if (ctx.wants("noise_perlin")) benchNoise(ctx, NoiseType::Perlin, "noise_perlin");
+            if (ctx.wants("noise_simplex")) benchNoise(ctx, NoiseType::Simplex, "noise_simplex");
+            if (ctx.wants("gif_solid") || ctx.wants("gif_bars") || ctx.wants("gif_fade")) benchGIF(ctx);
+            if (ctx.wants("webp_solid") || ctx.wants("webp_bars") || ctx.wants("webp_argb")) benchWebP(ctx);
+            if (ctx.wants("y4m_convert") || ctx.wants("y4m_frames") || ctx.wants("apng_fade")) benchVideo(ctx);
+
+            auto any = [&](std::initializer_list<const char*> stages) {
+                for (const char* stage : stages) {
+                    if (ctx.wants(stage)) return true;
+                }
+                return false;
+            };
+            const bool png = any({"png_filter", "zlib_compress", "zlib_parallel", "crc32", "crc32_fast", "adler32", "png_stb", "png_solid", "png_bars"});
+            const bool jpeg = any({"jpeg_dct", "jpeg_fdct", "jpeg_fdct_int", "jpeg_stb", "jpeg_parallel", "jpeg_huffman_opt", "jpeg_huffman_sampled", "jpeg_solid"});
+            const bool bmp = any({"bmp_stb", "bmp_solid"});
+            const bool qoi = any({"qoi_encode", "qoi_solid", "qoi_bars"});
+            if (!png && !jpeg && !bmp && !qoi) continue;
+
+            PixelBuffer pixels;
+            STBImageWriter::fillPixelBuffer(pixels, BENCH_COLOR, size.resolution, 3);
+            PixelBuffer detail;
+            if (png || jpeg || qoi) fillDetail(detail, size.resolution);
+            if (png) benchPNG(ctx, detail);
+            if (qoi) benchQOI(ctx, detail);
+            if (jpeg) benchJPEG(ctx, detail);
+            if (bmp) benchBMP(ctx, pixels);
+        }
+
+        std::error_code ec;
+        std::filesystem::remove(scratchPath, ec);
+        return 0;
+    } catch (const std::exception& e) {
+        std::cerr << "Error: " << e.what() << "\n";
+        return 1;
+    }
+}
@@ -0,0 +1,91 @@
+#ifndef BATCHPROCESSOR_HPP
+#define BATCHPROCESSOR_HPP
+
+#include "ImageJob.hpp"
+#include <cstdint>
+#include <ostream>
+#include <string>
+#include <string_view>
+
+namespace ColorGenerator {
+
+class ImageCache;
+
+/**
+ * @brief Values used for fields a manifest line leaves out
+ */
+struct BatchDefaults {
+    Resolution resolution;
+    std::string format;  ///< Format name (png, jpg, ...) or empty to use the output extension
+    int quality;
+};
+
+/**
+ * @brief Totals reported after a batch run
+ */
+struct BatchSummary {
+    uint64_t succeeded = 0;
+    uint64_t failed = 0;
+    uint64_t bytesWritten = 0;
+    uint64_t pixels = 0;
+    double seconds = 0.0;
+};
+
+/**
+ * @brief Generates many images from a manifest on a thread pool
+ *
+ * The manifest has one job per line, either CSV or JSON (detected per
+ * line by a leading '{'):
+ *
+ *     color,resolution,output[,quality]
+ *     #FF5733,1920x1080,out/red.png,90
+ *     {"color": "#3498DB", "resolution": "4k", "output": "out/blue.jpg", "quality": 80}
+ *
+ * Blank lines and "#" comments are skipped, as is a CSV header whose
+ * first field is "color". A line starting with "#" is a job only if its
+ * first field is a hex color followed by a comma. JSON lines may also give "format", or "width" and "height"
+ * instead of "resolution". Missing fields fall back to BatchDefaults.
+ *
+ * Manifest files are memory mapped and split into lines in place; each
+ * line is parsed by the worker that runs it. Failures are reported per
+ * line and do not stop the batch.
+ */
+class BatchProcessor {
+public:
+    /**
+     * @brief Configure a batch run
+     * @param defaults Fallback values for omitted fields
+     * @param threads Worker count (0 = hardware concurrency)
+     * @param cache Optional shared output cache
+     */
+    BatchProcessor(const BatchDefaults& defaults, size_t threads, ImageCache* cache = nullptr);
+
+    /**
+     * @brief Run every job in a manifest
+     * @param manifest Manifest path, or "-" to read standard input
+     * @param errors Stream receiving one message per failed job
+     * @return Totals for the run
+     * @throws std::runtime_error if the manifest cannot be read
+     */
+    BatchSummary run(const std::string& manifest, std::ostream& errors);
+
+    /**
+     * @brief Parse one manifest line into a job
+     * @throws std::invalid_argument on malformed input
+     */
+    static ImageJob parseLine(std::string_view line, const BatchDefaults& defaults);
+
+    /**
+     * @brief Print counts and throughput (images/s, MB/s, Mpx/s)
+     */
+    static void printSummary(const BatchSummary& summary, std::ostream& out);
+
+private:
+    BatchDefaults defaults_;
+    size_t threads_;
+    ImageCache* cache_;
+};
+
+} // namespace ColorGenerator
+
+#endif // BATCHPROCESSOR_HPP
@@ -0,0 +1,45 @@
+#ifndef CPUFEATURES_HPP
+#define CPUFEATURES_HPP
+
+namespace ColorGenerator {
+
+/**
+ * @brief Instruction set extensions usable by the SIMD kernels
+ *
+ * Detected once at startup from CPUID (including OS support for the
+ * wider register state). Setting the environment variable COLORGEN_SIMD
+ * to "scalar", "sse2", "avx2" or "avx512" caps the level used, which
+ * is handy for benchmarking and for checking that every path produces
+ * the same output.
+ */
+struct CpuFeatures {
+    bool sse2 = false;
+    bool ssse3 = false;
+    bool sse41 = false;
+    bool pclmul = false;
+    bool avx2 = false;
+    bool avx512 = false;  ///< AVX-512 F and BW
+
+    /**
+     * @brief Features of the running CPU (cached after the first call)
+     */
+    static const CpuFeatures& get();
+};
+
+} // namespace ColorGenerator
+
+/**
+ * @brief Compile a function for an instruction set the build does not
+ *        target by default, so it can be selected at run time
+ */
+#if defined(__GNUC__) || defined(__clang__)
+    #define COLORGEN_TARGET(isa) __attribute__((target(isa)))
+#else
+    #define COLORGEN_TARGET(isa)
+#endif
+
+#if defined(__x86_64__) || defined(__i386__) || defined(_M_X64) || defined(_M_IX86)
+    #define COLORGEN_X86 1
+#endif
+
+#endif // CPUFEATURES_HPP
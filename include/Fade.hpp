@@ -0,0 +1,42 @@
+#ifndef FADE_HPP
+#define FADE_HPP
+
+#include "Color.hpp"
+#include "Gradient.hpp"
+#include <cstdint>
+#include <vector>
+
+namespace ColorGenerator {
+
+/**
+ * @brief A sequence of solid-color frames that moves through color stops
+ *
+ * Stop positions map 0 to the first frame and 1 to the last. Colors
+ * between stops are interpolated per sRGB channel, alpha included, as a
+ * video dissolve would; two stops at the same position make a hard cut,
+ * which gives flashes. Video and animation writers share it so a fade
+ * has the same colors in every format.
+ */
+class Fade {
+public:
+    /**
+     * @param stops At least two stops, as parsed by Gradient::parseStops()
+     * @throws std::invalid_argument for fewer than two stops or zero frames
+     */
+    Fade(std::vector<GradientStop> stops, uint32_t frames);
+
+    uint32_t frames() const { return frames_; }
+
+    /**
+     * @brief Color of frame @p index (0 to frames() - 1)
+     */
+    Color color(uint32_t index) const;
+
+private:
+    std::vector<GradientStop> stops_;
+    uint32_t frames_;
+};
+
+} // namespace ColorGenerator
+
+#endif // FADE_HPP
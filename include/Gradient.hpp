@@ -0,0 +1,142 @@
+#ifndef GRADIENT_HPP
+#define GRADIENT_HPP
+
+#include "Color.hpp"
+#include "PixelFill.hpp"
+#include "Resolution.hpp"
+#include "RowSource.hpp"
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace ColorGenerator {
+
+/**
+ * @brief One color of a gradient and where it sits along the gradient
+ */
+struct GradientStop {
+    Color color;
+    float position;  ///< 0 (start) to 1 (end)
+};
+
+enum class GradientShape {
+    Linear,  ///< Along a direction, spanning the image corner to corner
+    Radial,  ///< Circles around a center
+    Conic    ///< Sweeps clockwise around a center
+};
+
+enum class Dither {
+    None,
+    Ordered,   ///< 16x16 Bayer matrix
+    BlueNoise  ///< 64x64 void-and-cluster threshold tile
+};
+
+/**
+ * @brief Multi-stop linear, radial and conic gradients
+ *
+ * Stops are converted to linear light through an sRGB lookup table and
+ * interpolated there (premultiplied by alpha), and the result is encoded
+ * back to sRGB once per entry of a 4096-entry ramp that keeps 8
+ * fractional bits. A row is drawn in two passes: the ramp position of
+ * each pixel is computed eight (AVX2) or four (SSE2) pixels at a time,
+ * then the ramp is looked up and the fraction rounded or dithered
+ * against a threshold tile. All paths perform the same float operations
+ * in the same order, so the output does not depend on the CPU.
+ *
+ * A gradient is a RowSource, so it streams into every encoder. rows()
+ * splits large requests across ThreadPool::availableThreads() threads,
+ * and fill() renders a whole frame the same way.
+ */
+class Gradient : public RowSource {
+public:
+    struct Options {
+        GradientShape shape = GradientShape::Linear;
+        float angle = 0.0f;    ///< Degrees clockwise from left-to-right: linear direction, conic start
+        float centerX = 0.5f;  ///< Radial/conic center as a fraction of the width
+        float centerY = 0.5f;  ///< Radial/conic center as a fraction of the height
+        float radius = 0.0f;   ///< Radial end circle in pixels, 0 = farthest corner
+        Dither dither = Dither::None;
+    };
+
+    /**
+     * @param stops At least two stops, positions within [0, 1] and non-decreasing
+     * @throws std::invalid_argument for bad stops or options
+     */
+    Gradient(std::vector<GradientStop> stops, const Resolution& resolution, const Options& options);
+
+    uint32_t width() const override { return width_; }
+    uint32_t height() const override { return height_; }
+
+    /**
+     * @brief 4 if any stop is translucent, otherwise 3
+     */
+    int channels() const override { return channels_; }
+
+    const uint8_t* rows(uint32_t y, uint32_t count, uint8_t* scratch) const override;
+
+    /**
+     * @brief Allocate @p buffer and render the whole image into it
+     * @param threads Maximum worker threads (0 = ThreadPool::availableThreads())
+     */
+    void fill(PixelBuffer& buffer, size_t threads = 0) const;
+
+    /**
+     * @brief Parse "color[@position],color[@position],..." (CSS-like)
+     *
+     * Positions are fractions ("0.25") or percentages ("25%"). Missing
+     * positions are spread evenly between their neighbours, the first and
+     * last default to 0 and 1, and a position below an earlier one is
+     * raised to it.
+     *
+     * @throws std::invalid_argument for malformed input or fewer than two stops
+     */
+    static std::vector<GradientStop> parseStops(const std::string& spec);
+
+    /**
+     * @brief "linear", "radial" or "conic"
+     * @throws std::invalid_argument otherwise
+     */
+    static GradientShape parseShape(const std::string& name);
+
+    /**
+     * @brief "none", "ordered" or "blue"
+     * @throws std::invalid_argument otherwise
+     */
+    static Dither parseDither(const std::string& name);
+
+    /// Ramp entries between the first and last stop
+    static constexpr int RAMP_SIZE = 4096;
+
+private:
+    /**
+     * @brief Ramp indices for pixels [x, x + count) of row @p y
+     */
+    void indices(uint32_t y, uint32_t x, uint32_t count, int32_t* out) const;
+
+    void renderRow(uint32_t y, uint8_t* dst) const;
+
+    /**
+     * @brief Draw rows [y, y + count) into @p dst on the calling thread
+     */
+    void renderRows(uint32_t y, uint32_t count, uint8_t* dst) const;
+
+    uint32_t width_;
+    uint32_t height_;
+    int channels_;
+    Options options_;
+
+    /// Shape parameters, already scaled to ramp indices
+    float scaleX_ = 0.0f;
+    float scaleY_ = 0.0f;
+    float offset_ = 0.0f;
+    float centerX_ = 0.0f;
+    float centerY_ = 0.0f;
+
+    /// RAMP_SIZE RGBA entries, sRGB with 8 fractional bits (0 to 255 * 256)
+    std::vector<uint16_t> ramp_;
+};
+
+} // namespace ColorGenerator
+
+#endif // GRADIENT_HPP
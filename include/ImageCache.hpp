@@ -0,0 +1,159 @@
+#ifndef IMAGECACHE_HPP
+#define IMAGECACHE_HPP
+
+#include "Color.hpp"
+#include "Resolution.hpp"
+#include "ImageFormat.hpp"
+#include "ImageWriter.hpp"
+#include <cstdint>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <ostream>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace ColorGenerator {
+
+/**
+ * @brief Everything that determines the bytes of an encoded image
+ */
+struct CacheKey {
+    Color color;
+    Resolution resolution;
+    FormatType format;
+    int quality;  ///< JPEG quality; ignored (normalized to 0) for other formats
+
+    /**
+     * @brief Canonical text form, e.g. "v1 PNG #FF5733FF 1920x1080 q0"
+     */
+    std::string canonical() const;
+
+    /**
+     * @brief 64-bit FNV-1a digest of the canonical form as 16 hex digits
+     */
+    std::string digest() const;
+};
+
+/**
+ * @brief Hit/miss counters for the image cache
+ */
+struct CacheStats {
+    uint64_t memoryHits = 0;
+    uint64_t diskHits = 0;
+    uint64_t misses = 0;
+    uint64_t bytesSaved = 0;   ///< Output bytes served without running an encoder
+    uint64_t bytesStored = 0;  ///< Encoded bytes added to the disk tier
+
+    uint64_t lookups() const { return memoryHits + diskHits + misses; }
+    double hitRatio() const {
+        return lookups() ? static_cast<double>(memoryHits + diskHits) / lookups() : 0.0;
+    }
+    CacheStats& operator+=(const CacheStats& other);
+};
+
+/**
+ * @brief How a cache lookup was satisfied
+ */
+enum class CacheResult {
+    MemoryHit,
+    DiskHit,
+    Miss
+};
+
+/**
+ * @brief Two-tier cache of encoded images in front of IImageFormat::write
+ *
+ * The memory tier is an LRU of encoded bytes bounded by total size. The
+ * disk tier stores one file per key under the cache directory, named by
+ * the key digest (content addressed by request, sharded by the first two
+ * hex digits). Entries are published by atomic rename and guarded by
+ * one lock file per shard, so concurrent processes can share a directory:
+ * the first process to miss encodes while the others wait and then hit.
+ * Keys in the same shard (1 in 256) briefly wait for each other's
+ * encodes; in exchange the directory holds at most 256 lock files.
+ *
+ * Hits are materialized at the output path by reflink when the
+ * filesystem supports it, otherwise by hardlink (if enabled) or
+ * copy_file_range, falling back to a plain copy. The session counters
+ * can be merged into a cumulative stats file in the cache directory.
+ *
+ * All methods are thread safe.
+ */
+class ImageCache {
+public:
+    /**
+     * @brief Open (and create if needed) a cache directory
+     * @param directory Disk tier location
+     * @param memoryCapacity Byte budget of the in-memory tier (0 disables it;
+     *        entries are read back from disk to fill it, which only pays
+     *        off in a long-running process)
+     * @throws std::runtime_error if the directory cannot be created
+     */
+    explicit ImageCache(const std::string& directory,
+                        size_t memoryCapacity = DEFAULT_MEMORY_CAPACITY);
+
+    /**
+     * @brief Produce @p filename for @p key, encoding only on a miss
+     * @param writer Encoder used on a miss
+     * @param key Cache key describing the image
+     * @param filename Output file path
+     * @return How the request was satisfied
+     * @throws std::runtime_error on I/O or encoder failure
+     */
+    CacheResult write(IImageFormat& writer, const CacheKey& key, const std::string& filename);
+
+    /**
+     * @brief Allow hits to be materialized as hardlinks into the cache
+     *
+     * Cache entries are read-only, so hardlinked outputs are read-only too.
+     */
+    void setAllowHardlinks(bool allow) { allowHardlinks_ = allow; }
+
+    /**
+     * @brief Counters for this process
+     */
+    CacheStats getSessionStats() const;
+
+    /**
+     * @brief Counters accumulated in the cache directory by all processes
+     */
+    CacheStats getPersistentStats() const;
+
+    /**
+     * @brief Add this session's unsaved counters to the cumulative stats file
+     */
+    void persistStats();
+
+    /**
+     * @brief Print session and cumulative hit ratios and bytes saved
+     */
+    void printStats(std::ostream& out) const;
+
+    static constexpr size_t DEFAULT_MEMORY_CAPACITY = 64 * 1024 * 1024;
+
+private:
+    using Bytes = std::shared_ptr<const std::vector<uint8_t>>;
+
+    std::string directory_;
+    size_t memoryCapacity_;
+    bool allowHardlinks_ = false;
+
+    mutable std::mutex mutex_;
+    std::list<std::pair<std::string, Bytes>> lru_;
+    std::unordered_map<std::string, std::list<std::pair<std::string, Bytes>>::iterator> index_;
+    size_t memoryUsed_ = 0;
+    CacheStats session_;
+    CacheStats unpersisted_;
+
+    std::string entryPath(const std::string& digest, const std::string& extension) const;
+
+    Bytes memoryLookup(const std::string& id);
+    void memoryInsert(const std::string& id, const std::string& path);
+    void record(CacheResult result, uint64_t bytes, uint64_t stored);
+};
+
+} // namespace ColorGenerator
+
+#endif // IMAGECACHE_HPP
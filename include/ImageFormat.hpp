@@ -3,6 +3,7 @@
 
 #include "Color.hpp"
 #include "Resolution.hpp"
+#include "RowSource.hpp"
 #include <string>
 #include <memory>
 
@@ -30,6 +31,15 @@ public:
                       const Color& color,
                       const Resolution& resolution) = 0;
 
+    /**
+     * @brief Write an image whose pixels are pulled from @p source
+     * @param filename Output file path
+     * @param source Rows to encode (generated images such as gradients)
+     * @return true if successful
+     * @throws std::runtime_error on write failure
+     */
+    virtual bool write(const std::string& filename, const RowSource& source) = 0;
+
     /**
      * @brief Get format name
      * @return Format name (e.g., "PNG", "JPEG", "BMP")
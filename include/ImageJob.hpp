@@ -0,0 +1,59 @@
+#ifndef IMAGEJOB_HPP
+#define IMAGEJOB_HPP
+
+#include "Color.hpp"
+#include "Resolution.hpp"
+#include "ImageFormat.hpp"
+#include "ImageWriter.hpp"
+#include <cstdint>
+#include <map>
+#include <string>
+
+namespace ColorGenerator {
+
+class ImageCache;
+
+/**
+ * @brief One image to generate: what to draw and where to put it
+ */
+struct ImageJob {
+    Color color;
+    Resolution resolution;
+    FormatType format;
+    int quality;         ///< JPEG quality, ignored by other formats
+    std::string output;  ///< Output file path
+};
+
+/**
+ * @brief Runs image jobs with warm, reusable writer instances
+ *
+ * An executor is not thread safe; keep one per worker thread. Writers
+ * are created on first use of each format and reused afterwards. When a
+ * cache is supplied every job goes through it.
+ */
+class JobExecutor {
+public:
+    /**
+     * @brief Create an executor
+     * @param cache Optional shared cache (must outlive the executor)
+     */
+    explicit JobExecutor(ImageCache* cache = nullptr);
+
+    /**
+     * @brief Generate one image
+     * @param job Job description
+     * @return Size of the written file in bytes
+     * @throws std::exception on any failure
+     */
+    uint64_t run(const ImageJob& job);
+
+private:
+    ImageCache* cache_;
+    std::map<FormatType, ImageFormatPtr> writers_;
+
+    IImageFormat& writerFor(FormatType format, int quality);
+};
+
+} // namespace ColorGenerator
+
+#endif // IMAGEJOB_HPP
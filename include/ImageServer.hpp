@@ -0,0 +1,105 @@
+#ifndef IMAGESERVER_HPP
+#define IMAGESERVER_HPP
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+namespace ColorGenerator {
+
+class ImageCache;
+
+/**
+ * @brief Long-running image generation service on a Unix domain socket
+ *
+ * Keeps writers, scratch buffers and the optional cache warm across
+ * requests so per-image cost excludes process startup and resolution
+ * detection. Each connection may pipeline any number of requests;
+ * responses carry the request id and may arrive out of order.
+ *
+ * All integers are little endian. Every message is a frame:
+ *
+ *     u32 length   number of bytes that follow
+ *
+ * Request payload (length <= MAX_REQUEST_SIZE):
+ *
+ *     u8  version     PROTOCOL_VERSION
+ *     u32 id          echoed in the response
+ *     u8  format      FormatType value (0 PNG, 1 JPEG, 2 BMP, 3 RAW, ...)
+ *     u8  flags       bit 0: return the encoded image inline
+ *     u8  quality     JPEG quality 0-100
+ *     u8  r, g, b, a  fill color
+ *     u32 width
+ *     u32 height
+ *     u32 deadline    milliseconds from receipt, 0 for none
+ *     u16 pathLength  output path bytes that follow (ignored when inline)
+ *     ... path
+ *
+ * Response payload:
+ *
+ *     u8  status      a Status value
+ *     u32 id
+ *     ... body        Ok + inline: the encoded file
+ *                     Ok + path:   u64 size of the written file
+ *                     otherwise:   UTF-8 error message
+ *
+ * Requests are queued on a bounded worker pool. When it is full the
+ * connection stops being read, so clients feel backpressure through
+ * the socket. A request whose deadline has passed when a worker picks
+ * it up is answered with DeadlineExceeded without being encoded; one
+ * that finishes late is also reported as DeadlineExceeded (a path
+ * output may still have been written). A malformed frame closes the
+ * connection; connections beyond MAX_CONNECTIONS are refused. Inline
+ * requests whose image would not fit in one frame are refused before
+ * anything is encoded.
+ *
+ * Trust model: a client can make the server write to any path the
+ * server's user can write, so every client is trusted as that user. The
+ * socket is created with mode 0600, which leaves connecting to the
+ * owner (and root); do not loosen its permissions or expose it to other
+ * users.
+ */
+class ImageServer {
+public:
+    enum class Status : uint8_t {
+        Ok = 0,
+        BadRequest = 1,
+        Failed = 2,
+        DeadlineExceeded = 3
+    };
+
+    static constexpr uint8_t PROTOCOL_VERSION = 1;
+    static constexpr uint32_t MAX_REQUEST_SIZE = 64 * 1024;
+    static constexpr size_t MAX_CONNECTIONS = 256;
+
+    /**
+     * @brief Configure a server
+     * @param socketPath Filesystem path of the listening socket
+     * @param threads Worker count (0 = hardware concurrency)
+     * @param cache Optional shared output cache (must outlive the server)
+     */
+    ImageServer(const std::string& socketPath, size_t threads, ImageCache* cache = nullptr);
+
+    /**
+     * @brief Accept and serve connections until stop() or SIGINT/SIGTERM
+     * @throws std::runtime_error if the socket cannot be created, or the
+     *         platform has no Unix domain sockets
+     */
+    void run();
+
+    /**
+     * @brief Ask run() to return after in-flight requests finish
+     */
+    void stop() { stopping_ = true; }
+
+private:
+    std::string socketPath_;
+    size_t threads_;
+    ImageCache* cache_;
+    std::atomic<bool> stopping_{false};
+};
+
+} // namespace ColorGenerator
+
+#endif // IMAGESERVER_HPP
@@ -16,10 +16,14 @@ enum class FormatType {
     PNG,
     JPEG,
     BMP,
+    RAW,
+    Y4M,  ///< YUV4MPEG2 video
+    YUV,  ///< Headerless planar YUV video
+    GIF,
+    QOI,  ///< Quite OK Image format
+    WEBP, ///< Lossless WebP (VP8L)
     // Future formats can be added here:
-    // TIFF,
-    // WEBP,
-    // GIF
+    // TIFF
 };
 
 /**
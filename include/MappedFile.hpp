@@ -0,0 +1,81 @@
+#ifndef MAPPEDFILE_HPP
+#define MAPPEDFILE_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+namespace ColorGenerator {
+
+/**
+ * @brief Memory mapping of an output file or an existing input file
+ *
+ * Output files are created (or truncated) and resized to their exact
+ * final size up front, then mapped so encoders can write straight into
+ * the page cache without an intermediate buffer or stdio copies. Input
+ * files are mapped read-only so they can be parsed without copying.
+ */
+class MappedFile {
+public:
+    /**
+     * @brief Create @p filename with @p size bytes and map it read/write
+     * @param filename Output file path
+     * @param size Exact file size in bytes (must be > 0)
+     * @throws std::runtime_error if the file cannot be created or mapped
+     */
+    MappedFile(const std::string& filename, uint64_t size);
+
+    /**
+     * @brief Map an existing file read-only
+     * @param filename Input file path (an empty file leaves data() null)
+     * @throws std::runtime_error if the file cannot be opened or mapped
+     */
+    explicit MappedFile(const std::string& filename);
+
+    ~MappedFile();
+
+    MappedFile(const MappedFile&) = delete;
+    MappedFile& operator=(const MappedFile&) = delete;
+
+    uint8_t* data() { return data_; }
+    const uint8_t* data() const { return data_; }
+    uint64_t size() const { return size_; }
+
+    /**
+     * @brief Repeat a byte pattern already written at @p offset
+     *
+     * The first @p period bytes at @p offset are copied forward with
+     * doubling memcpy calls until @p length bytes are filled. Doubling
+     * stops at a cache-friendly block size, after which whole blocks
+     * are copied.
+     *
+     * @param offset Start of the pattern in the mapping
+     * @param period Length of the pattern in bytes
+     * @param length Total number of bytes to fill, including the pattern
+     */
+    void replicate(uint64_t offset, size_t period, uint64_t length);
+
+    /**
+     * @brief Unmap and close the file, reporting any error
+     * @throws std::runtime_error if flushing or closing fails
+     */
+    void close();
+
+private:
+    uint8_t* data_ = nullptr;
+    uint64_t size_ = 0;
+    std::string filename_;
+
+#ifdef _WIN32
+    void* file_ = nullptr;
+    void* mapping_ = nullptr;
+#else
+    int fd_ = -1;
+#endif
+
+    static constexpr size_t REPLICATE_BLOCK_SIZE = 1 << 20;
+};
+
+} // namespace ColorGenerator
+
+#endif // MAPPEDFILE_HPP
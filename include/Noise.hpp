@@ -0,0 +1,108 @@
+#ifndef NOISE_HPP
+#define NOISE_HPP
+
+#include "Color.hpp"
+#include "PixelFill.hpp"
+#include "Resolution.hpp"
+#include "RowSource.hpp"
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+namespace ColorGenerator {
+
+enum class NoiseType {
+    Value,   ///< Smoothly interpolated random lattice values
+    Perlin,  ///< Gradient noise on a square lattice
+    Simplex  ///< Gradient noise on a triangular lattice, fewer axis-aligned artifacts
+};
+
+/**
+ * @brief Procedural noise texture tinted with a base color
+ *
+ * Lattice values come from a counter-based hash of (seed, octave,
+ * lattice x, lattice y) rather than a permutation table or a random
+ * stream, so every pixel depends only on its coordinates: any tile can
+ * be regenerated on its own and the image is the same whatever the
+ * tiling or thread count. Octaves of doubling frequency and halving
+ * weight (by default) are summed into a level from 0 to 255, which
+ * darkens the base color towards black below the midpoint and lightens
+ * it towards white above it.
+ *
+ * Sixteen (AVX-512) or eight (AVX2) pixels are evaluated per
+ * instruction, hashes and all. Every path performs the same float
+ * operations in the same order, so the output does not depend on the CPU.
+ */
+class Noise : public RowSource {
+public:
+    struct Options {
+        NoiseType type = NoiseType::Perlin;
+        uint64_t seed = 0;
+        float scale = 64.0f;       ///< Lattice cell size of the first octave, in pixels (>= 1)
+        int octaves = 1;           ///< 1 to MAX_OCTAVES
+        float persistence = 0.5f;  ///< Weight ratio between successive octaves
+        float lacunarity = 2.0f;   ///< Frequency ratio between successive octaves
+        float amount = 0.5f;       ///< 0 = flat base color, 1 = full black-to-white range
+    };
+
+    /**
+     * @param color Base color; its alpha is kept, so translucent colors give RGBA
+     * @throws std::invalid_argument for out-of-range options
+     */
+    Noise(const Color& color, const Resolution& resolution, const Options& options);
+
+    uint32_t width() const override { return width_; }
+    uint32_t height() const override { return height_; }
+    int channels() const override { return channels_; }
+
+    const uint8_t* rows(uint32_t y, uint32_t count, uint8_t* scratch) const override;
+
+    /**
+     * @brief Generate the tile at (@p x, @p y) of size @p tileWidth x @p tileHeight
+     * @param dst Top-left pixel of the tile
+     * @param stride Bytes between rows of @p dst
+     */
+    void tile(uint32_t x, uint32_t y, uint32_t tileWidth, uint32_t tileHeight,
+              uint8_t* dst, size_t stride) const;
+
+    /**
+     * @brief Allocate @p buffer and generate the image into it, TILE_SIZE tiles at a time
+     * @param threads Maximum worker threads (0 = ThreadPool::availableThreads())
+     */
+    void fill(PixelBuffer& buffer, size_t threads = 0) const;
+
+    /**
+     * @brief "value", "perlin" or "simplex"
+     * @throws std::invalid_argument otherwise
+     */
+    static NoiseType parseType(const std::string& name);
+
+    static constexpr int MAX_OCTAVES = 8;
+
+    /// Edge of the square tiles fill() hands to threads
+    static constexpr uint32_t TILE_SIZE = 256;
+
+    /**
+     * @brief Per-octave lattice frequency, weight and hash key
+     */
+    struct Octave {
+        float frequency;  ///< Lattice cells per pixel
+        float weight;     ///< Normalized so the weights sum to 1
+        uint32_t key;     ///< Hash of (seed, octave)
+    };
+
+private:
+    uint32_t width_;
+    uint32_t height_;
+    int channels_;
+    NoiseType type_;
+    int octaves_;
+    Octave octave_[MAX_OCTAVES];
+
+    /// Level (0-255) -> packed RGBA pixel
+    uint32_t palette_[256];
+};
+
+} // namespace ColorGenerator
+
+#endif // NOISE_HPP
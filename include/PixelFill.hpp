@@ -0,0 +1,84 @@
+#ifndef PIXELFILL_HPP
+#define PIXELFILL_HPP
+
+#include "Color.hpp"
+#include "Resolution.hpp"
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+
+namespace ColorGenerator {
+
+/**
+ * @brief Cache-line aligned byte buffer whose contents start uninitialized
+ *
+ * Unlike std::vector, allocating does not zero the memory, so the pages
+ * are first touched by whoever fills them.
+ */
+class PixelBuffer {
+public:
+    static constexpr size_t ALIGNMENT = 64;
+
+    PixelBuffer() = default;
+    explicit PixelBuffer(size_t size) { allocate(size); }
+
+    /**
+     * @brief Replace the contents with @p size uninitialized bytes
+     */
+    void allocate(size_t size);
+
+    uint8_t* data() { return data_.get(); }
+    const uint8_t* data() const { return data_.get(); }
+    size_t size() const { return size_; }
+    bool empty() const { return size_ == 0; }
+
+private:
+    struct AlignedDelete {
+        void operator()(uint8_t* p) const;
+    };
+
+    std::unique_ptr<uint8_t, AlignedDelete> data_;
+    size_t size_ = 0;
+};
+
+/**
+ * @brief Fills pixel memory with a solid color
+ *
+ * The pixel pattern is built once per call, specialized at compile time
+ * for 3 or 4 channels, and broadcast with the widest vector stores the
+ * CPU supports (AVX-512, AVX2 or SSE2, chosen at run time). Large
+ * frames are split across threads in page-sized multiples so each page
+ * is first touched by the thread that fills it.
+ *
+ * The encoders never need a whole solid frame: solid images are written
+ * analytically, and SolidRowSource and the test patterns fill a single
+ * row. Whole-frame fills, and so the threaded path, serve the
+ * benchmarks and callers that want a pixel buffer of their own.
+ */
+class PixelFill {
+public:
+    /**
+     * @brief Fill @p pixelCount pixels starting at @p data
+     * @param data Destination (need not be aligned)
+     * @param pixelCount Number of pixels
+     * @param color Fill color (alpha is written only for 4 channels)
+     * @param channels 3 (RGB) or 4 (RGBA)
+     * @param threads Maximum worker threads (0 = ThreadPool::availableThreads())
+     * @throws std::invalid_argument for an unsupported channel count
+     */
+    static void fill(uint8_t* data, uint64_t pixelCount, const Color& color,
+                     int channels, size_t threads = 0);
+
+    /**
+     * @brief Allocate @p buffer for @p resolution and fill it
+     */
+    static void fill(PixelBuffer& buffer, const Color& color, const Resolution& resolution,
+                     int channels, size_t threads = 0);
+
+    /// Smallest slice worth handing to another thread
+    static constexpr uint64_t MIN_BYTES_PER_THREAD = 4 << 20;
+};
+
+} // namespace ColorGenerator
+
+#endif // PIXELFILL_HPP
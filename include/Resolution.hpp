@@ -65,6 +65,14 @@ public:
      */
     std::string toString() const;
 
+    /**
+     * @brief Parse "WIDTHxHEIGHT" or a preset name (hd, fullhd, qhd, 4k)
+     * @param str Resolution string
+     * @return Parsed resolution
+     * @throws std::invalid_argument if the string is malformed or out of range
+     */
+    static Resolution parse(const std::string& str);
+
     // Common presets
     static Resolution HD();      // 1280x720
     static Resolution FullHD();  // 1920x1080
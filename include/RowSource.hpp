@@ -0,0 +1,117 @@
+#ifndef ROWSOURCE_HPP
+#define ROWSOURCE_HPP
+
+#include "Color.hpp"
+#include "Resolution.hpp"
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace ColorGenerator {
+
+/**
+ * @brief Supplies an image to the streaming encoders a few scanlines at a time
+ *
+ * Rows are tightly packed, 8 bits per channel. Encoders ask for rows in
+ * whatever order suits the format (BMP reads bottom-up, parallel JPEG
+ * reads several stripes at once), so rows() must accept any range and
+ * be safe to call concurrently with different scratch buffers.
+ */
+class RowSource {
+public:
+    virtual ~RowSource() = default;
+
+    virtual uint32_t width() const = 0;
+    virtual uint32_t height() const = 0;
+
+    /**
+     * @brief 1 (gray), 2 (gray + alpha), 3 (RGB) or 4 (RGBA)
+     */
+    virtual int channels() const = 0;
+
+    /**
+     * @brief Bytes per row, computed in 64 bits
+     */
+    uint64_t rowBytes() const { return static_cast<uint64_t>(width()) * channels(); }
+
+    /**
+     * @brief Get rows [y, y + count)
+     * @param scratch count * rowBytes() bytes the source may fill
+     * @return The rows, either in @p scratch or in memory owned by the source
+     */
+    virtual const uint8_t* rows(uint32_t y, uint32_t count, uint8_t* scratch) const = 0;
+
+    /**
+     * @brief Number of rows starting at @p y that are identical to row y - 1
+     *
+     * A hint for encoders that can emit repeated rows without reading or
+     * compressing them again. 0 means row @p y differs from the row above
+     * or the source does not know; the default always returns 0.
+     */
+    virtual uint32_t repeatedRows(uint32_t /*y*/) const { return 0; }
+
+    /**
+     * @brief A period p such that row y is identical to row y - p for every y >= p
+     *
+     * A hint for encoders that can repeat a whole period of rows they have
+     * already encoded, such as the bands of a checkerboard, which lie too
+     * far apart for repeatedRows(). 0 means the rows are not periodic or
+     * the source does not know; the default always returns 0.
+     */
+    virtual uint32_t rowPeriod() const { return 0; }
+};
+
+/**
+ * @brief Row source over an existing top-down pixel buffer; rows are never copied
+ */
+class BufferRowSource : public RowSource {
+public:
+    BufferRowSource(const uint8_t* pixels, uint32_t width, uint32_t height, int channels)
+        : pixels_(pixels), width_(width), height_(height), channels_(channels) {}
+
+    uint32_t width() const override { return width_; }
+    uint32_t height() const override { return height_; }
+    int channels() const override { return channels_; }
+
+    const uint8_t* rows(uint32_t y, uint32_t, uint8_t*) const override {
+        return pixels_ + y * rowBytes();
+    }
+
+private:
+    const uint8_t* pixels_;
+    uint32_t width_;
+    uint32_t height_;
+    int channels_;
+};
+
+/**
+ * @brief Row source for a single color; holds one prefilled row
+ */
+class SolidRowSource : public RowSource {
+public:
+    /**
+     * @param channels 3 (RGB) or 4 (RGBA)
+     * @throws std::invalid_argument for another channel count
+     */
+    SolidRowSource(const Color& color, const Resolution& resolution, int channels);
+
+    uint32_t width() const override { return width_; }
+    uint32_t height() const override { return height_; }
+    int channels() const override { return channels_; }
+
+    const uint8_t* rows(uint32_t y, uint32_t count, uint8_t* scratch) const override;
+
+    uint32_t repeatedRows(uint32_t y) const override { return y == 0 ? 0 : height_ - y; }
+
+    uint32_t rowPeriod() const override { return 1; }
+
+private:
+    uint32_t width_;
+    uint32_t height_;
+    int channels_;
+    std::vector<uint8_t> row_;
+};
+
+} // namespace ColorGenerator
+
+#endif // ROWSOURCE_HPP
@@ -0,0 +1,72 @@
+#ifndef SIZEBUDGET_HPP
+#define SIZEBUDGET_HPP
+
+#include "Color.hpp"
+#include "Resolution.hpp"
+#include "ImageWriter.hpp"
+#include <cstdint>
+#include <functional>
+
+namespace ColorGenerator {
+
+/**
+ * @brief Outcome of fitting an image into a byte budget
+ */
+struct SizeFit {
+    int quality;      ///< Highest JPEG quality that fits (the given quality for other formats)
+    uint64_t size;    ///< Exact encoded size at that quality
+    int evaluations;  ///< Sizes computed by the search
+};
+
+/**
+ * @brief Finds encoder settings whose output fits a byte budget
+ *
+ * Sizes are computed by running the encoders into a byte counter, so
+ * nothing touches disk until the chosen settings are written. The search
+ * assumes the size grows with quality.
+ */
+class SizeBudget {
+public:
+    /**
+     * @brief Highest quality in [minQuality, maxQuality] whose size is at most @p maxBytes
+     *
+     * Tries maxQuality first, since budgets are usually generous, then
+     * narrows a bracket by alternating a model step with plain bisection.
+     * The model interpolates log(size) linearly between the bracket ends,
+     * which tracks JPEG's roughly exponential size curve; the bisection
+     * steps bound the worst case at about twice log2 of the range.
+     * Each quality is evaluated at most once.
+     *
+     * @param sizeAt Encoded size at a given quality
+     * @throws std::runtime_error if even minQuality does not fit
+     */
+    static SizeFit highestQuality(uint64_t maxBytes, int minQuality, int maxQuality,
+                                  const std::function<uint64_t(int)>& sizeAt);
+
+    /**
+     * @brief Exact size of a solid image as IImageFormat::write would produce it
+     *
+     * Video formats are sized for a writer with default options: one frame.
+     *
+     * @param quality JPEG quality, ignored by other formats
+     */
+    static uint64_t encodedSize(FormatType format, const Color& color, const Resolution& resolution,
+                                int quality);
+
+    /**
+     * @brief Choose settings for a solid image so it fits in @p maxBytes
+     *
+     * JPEG searches qualities 1-100. PNG, BMP and raw output have a
+     * single encoding of a solid image, so their exact size is only
+     * checked against the budget.
+     *
+     * @param quality Returned unchanged for formats without a quality setting
+     * @throws std::runtime_error if no setting fits
+     */
+    static SizeFit fit(FormatType format, const Color& color, const Resolution& resolution,
+                       int quality, uint64_t maxBytes);
+};
+
+} // namespace ColorGenerator
+
+#endif // SIZEBUDGET_HPP
@@ -0,0 +1,87 @@
+#ifndef TESTPATTERN_HPP
+#define TESTPATTERN_HPP
+
+#include "Color.hpp"
+#include "Resolution.hpp"
+#include "RowSource.hpp"
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace ColorGenerator {
+
+enum class PatternType {
+    Bars,              ///< SMPTE color bars: 75% bars, reverse blue bars, -I/white/+Q and PLUGE
+    Checkerboard,      ///< Alternating square cells of the two colors
+    Stripes,           ///< Vertical stripes, one cell wide
+    HorizontalStripes, ///< Horizontal stripes, one cell high
+    Grid               ///< Foreground lines every cell pixels over the background
+};
+
+/**
+ * @brief Display calibration and test patterns
+ *
+ * Every pattern is made of a handful of distinct rows, so they are
+ * rendered once up front and rows() only copies them. The source also
+ * knows where each band of identical rows ends and reports it through
+ * repeatedRows(), which lets the PNG encoder copy whole bands as
+ * back-references instead of filtering and compressing each row: a 4K
+ * SMPTE bars PNG costs little more than a solid one. Checkerboards,
+ * stripes and grids also report their rowPeriod(), so the encoder
+ * compresses one period and repeats it for the rest of the image.
+ */
+class TestPattern : public RowSource {
+public:
+    struct Options {
+        PatternType type = PatternType::Bars;
+        Color foreground = Color(255, 255, 255);  ///< Cells, stripes and lines (not used by bars)
+        Color background = Color(0, 0, 0);        ///< Alternate cells, gaps between lines
+        uint32_t cell = 64;                       ///< Cell, stripe or grid spacing in pixels
+        uint32_t lineWidth = 1;                   ///< Grid line thickness in pixels
+    };
+
+    /**
+     * @throws std::invalid_argument for a zero cell size or line width
+     */
+    TestPattern(const Resolution& resolution, const Options& options);
+
+    uint32_t width() const override { return width_; }
+    uint32_t height() const override { return height_; }
+
+    /**
+     * @brief 4 if either color is translucent (bars are always RGB), otherwise 3
+     */
+    int channels() const override { return channels_; }
+
+    const uint8_t* rows(uint32_t y, uint32_t count, uint8_t* scratch) const override;
+
+    uint32_t repeatedRows(uint32_t y) const override;
+
+    /**
+     * @brief Two cells for checkerboards and horizontal stripes, one for grids,
+     *        1 for vertical stripes and 0 for bars
+     */
+    uint32_t rowPeriod() const override { return period_; }
+
+    /**
+     * @brief "bars", "checker", "stripes", "hstripes" or "grid"
+     * @throws std::invalid_argument otherwise
+     */
+    static PatternType parseType(const std::string& name);
+
+private:
+    uint32_t width_;
+    uint32_t height_;
+    int channels_;
+    uint32_t period_ = 0;
+
+    /// Distinct rows of the pattern
+    std::vector<std::vector<uint8_t>> templates_;
+
+    /// Template index of every row
+    std::vector<uint8_t> rowTemplate_;
+};
+
+} // namespace ColorGenerator
+
+#endif // TESTPATTERN_HPP
@@ -0,0 +1,105 @@
+#ifndef THREADPOOL_HPP
+#define THREADPOOL_HPP
+
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace ColorGenerator {
+
+/**
+ * @brief Fixed-size worker pool with a bounded task queue
+ *
+ * submit() blocks while the queue is full, which gives producers natural
+ * backpressure.
+ * Each task receives the index of the worker running it so callers can
+ * keep per-thread state (writers, scratch buffers) without locking.
+ *
+ * Encoders and generators split their own work with parallelFor(). Their
+ * default thread count is availableThreads(), which is 1 on a pool
+ * worker or inside another parallelFor(), so nesting never starts more
+ * threads than the outermost level asked for.
+ */
+class ThreadPool {
+public:
+    /**
+     * @brief Task signature; the argument is the worker index [0, size())
+     */
+    using Task = std::function<void(size_t worker)>;
+
+    /**
+     * @brief Start the workers
+     * @param threads Worker count (0 selects defaultThreadCount())
+     * @param queueCapacity Maximum queued tasks (0 selects 4 per worker)
+     */
+    explicit ThreadPool(size_t threads = 0, size_t queueCapacity = 0);
+
+    /**
+     * @brief Finish all queued tasks and join the workers
+     */
+    ~ThreadPool();
+
+    ThreadPool(const ThreadPool&) = delete;
+    ThreadPool& operator=(const ThreadPool&) = delete;
+
+    /**
+     * @brief Queue a task, waiting for space if the queue is full
+     */
+    void submit(Task task);
+
+    /**
+     * @brief Block until the queue is empty and no task is running
+     */
+    void wait();
+
+    /**
+     * @brief Number of worker threads
+     */
+    size_t size() const { return workers_.size(); }
+
+    /**
+     * @brief Hardware concurrency, or 1 if unknown
+     */
+    static size_t defaultThreadCount();
+
+    /**
+     * @brief Threads the calling code may use for its own work
+     *
+     * 1 on a ThreadPool worker or a parallelFor() thread, where the cores
+     * are already shared out; defaultThreadCount() otherwise.
+     */
+    static size_t availableThreads();
+
+    /**
+     * @brief Run @p task(index, thread) for every index in [0, count)
+     *
+     * Up to @p threads threads (0 selects availableThreads()), the caller
+     * included as thread 0, take indices in order from a shared counter;
+     * thread is in [0, min(threads, count)). The first exception a task
+     * throws is rethrown once every thread has stopped.
+     */
+    static void parallelFor(size_t count, size_t threads,
+                            const std::function<void(size_t index, size_t thread)>& task);
+
+private:
+    std::vector<std::thread> workers_;
+    std::deque<Task> queue_;
+    size_t capacity_;
+    size_t active_ = 0;
+    bool stopping_ = false;
+
+    std::mutex mutex_;
+    std::condition_variable taskReady_;
+    std::condition_variable spaceReady_;
+    std::condition_variable idle_;
+
+    void workerLoop(size_t index);
+};
+
+} // namespace ColorGenerator
+
+#endif // THREADPOOL_HPP
@@ -0,0 +1,59 @@
+#ifndef APNGENCODER_HPP
+#define APNGENCODER_HPP
+
+#include "../Fade.hpp"
+#include "../Resolution.hpp"
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+namespace ColorGenerator {
+
+/**
+ * @brief Animated PNG (APNG) encoder for solid-color animations
+ *
+ * Writes the frames of a Fade: color fades, cuts and flashes. Runs of
+ * identical frames are collapsed into one frame with a longer delay, and
+ * each distinct color is compressed once however often it appears. Up to
+ * 256 distinct colors are stored as 8-bit palette indices (with tRNS for
+ * translucent ones); more are stored as RGB, or RGBA if any is
+ * translucent.
+ *
+ * A frame is encoded analytically like SolidPNGEncoder's image: the first
+ * row, then rows the Up filter turns into zeros. Its few distinct tokens
+ * are coded with a dynamic Huffman code fitted to them, about two bits per
+ * 258-byte match, so a 1080p frame takes a few kilobytes. Distinct colors
+ * are compressed on parallel threads.
+ *
+ * A solid frame that differs from the previous one differs everywhere, so
+ * its dirty rectangle is the whole canvas: changed frames cover it with
+ * blend op SOURCE and dispose op NONE. A delay too long for the 16-bit
+ * fcTL fields continues in 1x1 frames that repaint an unchanged pixel.
+ */
+class APNGEncoder {
+public:
+    struct Options {
+        uint32_t frameRateNum = 25;  ///< Frames per second, as a fraction
+        uint32_t frameRateDen = 1;
+        uint32_t loops = 0;          ///< Times to play the animation, 0 = forever
+        size_t threads = 0;          ///< Maximum compression threads (0 = ThreadPool::availableThreads())
+    };
+
+    /**
+     * @brief Encode the frames of @p fade at @p resolution to @p filename
+     * @throws std::invalid_argument for a zero frame rate
+     * @throws std::runtime_error on write failure
+     */
+    static void write(const std::string& filename, const Fade& fade, const Resolution& resolution,
+                      const Options& options);
+
+    /// Compressed bytes carried by each IDAT or fdAT chunk, at most
+    static constexpr size_t IDAT_CHUNK_SIZE = 1 << 20;
+
+    /// Distinct colors compressed per thread, at least
+    static constexpr size_t MIN_COLORS_PER_THREAD = 4;
+};
+
+} // namespace ColorGenerator
+
+#endif // APNGENCODER_HPP
@@ -0,0 +1,50 @@
+#ifndef BMPENCODER_HPP
+#define BMPENCODER_HPP
+
+#include "../RowSource.hpp"
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+namespace ColorGenerator {
+
+/**
+ * @brief Streaming BMP encoder for images supplied by a RowSource
+ *
+ * Source rows are read from the bottom of the image up, a bounded batch
+ * at a time, swizzled to BGR(A), padded and written in file order, so
+ * only the batch is held in memory.
+ * Headers match stb_image_write: 24-bit BITMAPINFOHEADER for RGB and a
+ * 32-bit BI_BITFIELDS BITMAPV4HEADER for RGBA.
+ */
+class BMPEncoder {
+public:
+    /**
+     * @brief Encode @p source (3 or 4 channels) to @p filename
+     * @throws std::invalid_argument for another channel count
+     * @throws std::runtime_error on write failure
+     */
+    static void write(const std::string& filename, const RowSource& source);
+
+    /**
+     * @brief Exact file size: headers plus rows padded to 4 bytes
+     * @throws std::invalid_argument if channels is not 3 or 4
+     */
+    static uint64_t fileSize(uint32_t width, uint32_t height, int channels);
+
+    /**
+     * @brief Write the file and info headers to @p dst
+     * @return Header size in bytes (at most MAX_HEADER_SIZE), the pixel data offset
+     */
+    static size_t writeHeaders(uint8_t* dst, uint32_t width, uint32_t height, int channels);
+
+    /// Largest header writeHeaders() produces (file header + BITMAPV4HEADER)
+    static constexpr size_t MAX_HEADER_SIZE = 14 + 108;
+
+    /// Source rows requested per call, at most (at least one row)
+    static constexpr size_t READ_BYTES = 1 << 20;
+};
+
+} // namespace ColorGenerator
+
+#endif // BMPENCODER_HPP
@@ -0,0 +1,81 @@
+#ifndef BYTESINK_HPP
+#define BYTESINK_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <fstream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+namespace ColorGenerator {
+
+/**
+ * @brief Output of the analytic encoders: writes the encoded bytes to a file
+ *
+ * Encoders are templates over the sink, so the same code path that writes
+ * a file can also report its exact size through CountingSink.
+ */
+class FileSink {
+public:
+    /**
+     * @param blockSize Bytes written per call when replicating a repeated cycle
+     * @throws std::runtime_error if the file cannot be created
+     */
+    FileSink(const std::string& filename, size_t blockSize = 1 << 20)
+        : filename_(filename), blockSize_(blockSize), file_(filename, std::ios::binary | std::ios::trunc) {
+        if (!file_) {
+            throw std::runtime_error("Failed to open output file: " + filename);
+        }
+    }
+
+    void write(const uint8_t* data, size_t size) {
+        file_.write(reinterpret_cast<const char*>(data), static_cast<std::streamsize>(size));
+    }
+
+    /**
+     * @brief Write @p count copies of @p cycle, as large blocks of copies
+     */
+    void repeat(const uint8_t* cycle, size_t cycleBytes, uint64_t count) {
+        const size_t perBlock = blockSize_ / cycleBytes > 0 ? blockSize_ / cycleBytes : 1;
+        std::vector<uint8_t> block;
+        block.reserve(perBlock * cycleBytes);
+        for (size_t i = 0; i < perBlock && i < count; ++i) {
+            block.insert(block.end(), cycle, cycle + cycleBytes);
+        }
+        while (count > 0) {
+            const uint64_t n = count < perBlock ? count : perBlock;
+            write(block.data(), static_cast<size_t>(n * cycleBytes));
+            count -= n;
+        }
+    }
+
+    /**
+     * @throws std::runtime_error if any write failed
+     */
+    void finish() {
+        if (!file_) {
+            throw std::runtime_error("Failed to write image file: " + filename_);
+        }
+    }
+
+private:
+    std::string filename_;
+    size_t blockSize_;
+    std::ofstream file_;
+};
+
+/**
+ * @brief Output of the analytic encoders: counts the encoded bytes only
+ */
+struct CountingSink {
+    uint64_t size = 0;
+
+    void write(const uint8_t*, size_t bytes) { size += bytes; }
+    void repeat(const uint8_t*, size_t cycleBytes, uint64_t count) { size += cycleBytes * count; }
+    void finish() {}
+};
+
+} // namespace ColorGenerator
+
+#endif // BYTESINK_HPP
@@ -0,0 +1,65 @@
+#ifndef CHECKSUM_HPP
+#define CHECKSUM_HPP
+
+#include <cstddef>
+#include <cstdint>
+
+namespace ColorGenerator {
+
+/**
+ * @brief CRC-32 (polynomial 0xEDB88320) as used by PNG chunks
+ *
+ * Uses PCLMULQDQ carry-less multiplication to fold 64 bytes per step
+ * when the CPU has it, and slicing-by-8 tables otherwise.
+ */
+class Crc32 {
+public:
+    /**
+     * @brief Extend @p crc over @p length bytes (zlib crc32() semantics)
+     * @param crc CRC of the preceding data, 0 to start
+     */
+    static uint32_t update(uint32_t crc, const uint8_t* data, size_t length);
+};
+
+/**
+ * @brief Running Adler-32 checksum as used by the zlib container
+ *
+ * Large updates are summed 32 bytes at a time with SSSE3 or AVX2
+ * (chosen at run time) and reduced once per 5552-byte block.
+ */
+class Adler32 {
+public:
+    static constexpr uint32_t MOD = 65521;
+
+    void update(const uint8_t* data, size_t length);
+
+    void updateByte(uint8_t value) {
+        a_ = (a_ + value) % MOD;
+        b_ = (b_ + a_) % MOD;
+    }
+
+    /**
+     * @brief Feed @p count zero bytes: a is unchanged, b grows by a per byte
+     */
+    void updateZeros(uint64_t count) {
+        b_ = static_cast<uint32_t>((b_ + static_cast<uint64_t>(a_) * (count % MOD)) % MOD);
+    }
+
+    uint32_t value() const { return (b_ << 16) | a_; }
+
+    /**
+     * @brief Checksum of two concatenated blocks from their own checksums
+     * @param first Adler-32 of the first block
+     * @param second Adler-32 of the second block
+     * @param secondLength Length of the second block in bytes
+     */
+    static uint32_t combine(uint32_t first, uint32_t second, uint64_t secondLength);
+
+private:
+    uint32_t a_ = 1;
+    uint32_t b_ = 0;
+};
+
+} // namespace ColorGenerator
+
+#endif // CHECKSUM_HPP
@@ -0,0 +1,271 @@
+#ifndef DEFLATE_HPP
+#define DEFLATE_HPP
+
+#include "Checksum.hpp"
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+namespace ColorGenerator {
+
+/**
+ * @brief Huffman codes for the literal/length and distance alphabets of a block
+ *
+ * fixed() is the code of RFC 1951 section 3.2.6. Other codes are fitted
+ * to the symbol counts of the block they encode (lengths limited to 15
+ * bits) and are described in the block header by
+ * DeflateWriter::beginDynamicBlock(). Blocks made of a handful of
+ * distinct symbols, such as long runs, then cost one or two bits per
+ * token instead of thirteen.
+ */
+class DeflateCode {
+public:
+    /**
+     * @brief A code, already bit-reversed for LSB-first output
+     */
+    struct Code {
+        uint32_t bits;
+        int length;
+    };
+
+    /**
+     * @brief Symbol occurrences of a block, gathered by calling the same
+     *        literal(), match(), run() and endOfBlock() sequence as on the writer
+     */
+    struct Counts {
+        uint64_t literals[286] = {};
+        uint64_t distances[30] = {};
+
+        void literal(uint8_t value) { ++literals[value]; }
+        void endOfBlock() { ++literals[256]; }
+        void match(size_t length, uint32_t distance);
+        void run(uint64_t length, uint32_t distance, const uint8_t* pattern);
+    };
+
+    /**
+     * @brief A code length, or a run of them: 16 repeats the previous length
+     *        3-6 times, 17 and 18 stand for 3-10 and 11-138 zeros
+     */
+    struct LengthToken {
+        int symbol;
+        uint32_t extra;  ///< Repeat count minus the smallest one the symbol codes
+    };
+
+    explicit DeflateCode(const Counts& counts);
+
+    static const DeflateCode& fixed();
+
+    /**
+     * @brief Huffman code lengths for @p counts, at most @p limit bits
+     *
+     * Every code gets at least two symbols so it is complete, as inflaters
+     * expect. If the optimal code is too deep, the counts are flattened
+     * (halved, keeping them non-zero) until it fits.
+     */
+    static void huffmanLengths(const uint64_t* counts, int symbols, int limit, uint8_t* lengths);
+
+    /**
+     * @brief Canonical codes for @p lengths (RFC 1951 section 3.2.2), bit-reversed
+     */
+    static void canonicalCodes(const uint8_t* lengths, int symbols, Code* codes);
+
+    /**
+     * @brief Run-length code a sequence of code lengths, as in a dynamic block header
+     *
+     * VP8L (lossless WebP) describes its codes with the same symbols.
+     */
+    static std::vector<LengthToken> runLengthTokens(const uint8_t* lengths, size_t count);
+
+    const Code& literal(int symbol) const { return literal_[symbol]; }
+    const Code& distance(int symbol) const { return distance_[symbol]; }
+
+private:
+    DeflateCode() = default;
+
+    friend class DeflateWriter;
+
+    std::array<Code, 288> literal_{};
+    std::array<Code, 30> distance_{};
+
+    /// Dynamic block header after BFINAL and BTYPE, as codes to emit in order
+    std::vector<Code> header_;
+};
+
+/**
+ * @brief LSB-first bit packer for deflate blocks with Huffman codes
+ */
+class DeflateWriter {
+public:
+    explicit DeflateWriter(std::vector<uint8_t>& out) : out_(out), code_(&DeflateCode::fixed()) {}
+
+    void putBits(uint32_t bits, int count) {
+        acc_ |= static_cast<uint64_t>(bits) << used_;
+        used_ += count;
+        if (used_ >= 32) {
+            uint32_t word = static_cast<uint32_t>(acc_);
+            out_.push_back(static_cast<uint8_t>(word));
+            out_.push_back(static_cast<uint8_t>(word >> 8));
+            out_.push_back(static_cast<uint8_t>(word >> 16));
+            out_.push_back(static_cast<uint8_t>(word >> 24));
+            acc_ >>= 32;
+            used_ -= 32;
+        }
+    }
+
+    /**
+     * @brief Start a fixed-Huffman block
+     */
+    void beginFixedBlock(bool final) {
+        putBits(final ? 1 : 0, 1);
+        putBits(1, 2);
+        code_ = &DeflateCode::fixed();
+    }
+
+    /**
+     * @brief Start a block coded with @p code, which must outlive the block
+     */
+    void beginDynamicBlock(bool final, const DeflateCode& code);
+
+    void literal(uint8_t value) {
+        const DeflateCode::Code& c = code_->literal_[value];
+        putBits(c.bits, c.length);
+    }
+
+    /**
+     * @brief End-of-block symbol
+     */
+    void endOfBlock() {
+        const DeflateCode::Code& c = code_->literal_[256];
+        putBits(c.bits, c.length);
+    }
+
+    /**
+     * @brief Encode a back-reference (length 3..258, distance 1..32768)
+     */
+    void match(size_t length, uint32_t distance);
+
+    /**
+     * @brief Encode @p length bytes that repeat the previous @p distance bytes
+     * @param pattern The @p distance bytes being repeated, used for a short tail
+     */
+    void run(uint64_t length, uint32_t distance, const uint8_t* pattern);
+
+    /**
+     * @brief Emit an empty non-final stored block, leaving the stream byte aligned
+     *
+     * This is zlib's Z_SYNC_FLUSH marker; independently compressed
+     * streams ending with it can be concatenated.
+     */
+    void syncFlush();
+
+    /**
+     * @brief Pad to a byte boundary and move the remaining bits to the output
+     */
+    void flush();
+
+private:
+    std::vector<uint8_t>& out_;
+    const DeflateCode* code_;
+    uint64_t acc_ = 0;
+    int used_ = 0;
+};
+
+/**
+ * @brief Multi-threaded zlib compressor in the style of pigz
+ *
+ * The input is cut into fixed-size stripes, each deflated on its own
+ * thread with the preceding 32 KiB as a preset dictionary so matches can
+ * still cross stripe boundaries. Every stripe but the last ends with a
+ * sync flush, which byte-aligns it, so the stripes are simply
+ * concatenated into one zlib stream. The per-stripe Adler-32 values are
+ * combined into the trailer. Stripe boundaries do not depend on the
+ * thread count, so the output is identical for any number of threads.
+ */
+class ParallelDeflate {
+public:
+    /**
+     * @brief Compress @p data into a complete zlib stream
+     * @param data Input bytes (may be null if @p length is 0)
+     * @param length Input size in bytes
+     * @param quality Match search effort, as stbi_write_png_compression_level
+     * @param threads Maximum worker threads (0 = ThreadPool::availableThreads())
+     */
+    static std::vector<uint8_t> compress(const uint8_t* data, size_t length,
+                                         int quality, size_t threads = 0);
+
+    /// Input bytes per independently compressed stripe
+    static constexpr size_t STRIPE_SIZE = 128 * 1024;
+
+    /// Deflate window, primed from the previous stripe
+    static constexpr size_t WINDOW_SIZE = 32 * 1024;
+};
+
+/**
+ * @brief ParallelDeflate for input that arrives in pieces
+ *
+ * Input is buffered until a batch of whole stripes is available; the
+ * batch is compressed on up to @p threads threads and the previous
+ * WINDOW_SIZE bytes are kept as the next batch's dictionary. Stripes are
+ * cut at the same offsets as ParallelDeflate::compress, so the stream is
+ * byte-identical to compressing the concatenated input in one call,
+ * while memory stays bounded by the batch size.
+ */
+class DeflateStream {
+public:
+    /**
+     * @param quality Match search effort, as stbi_write_png_compression_level
+     * @param threads Maximum worker threads (0 = ThreadPool::availableThreads())
+     */
+    explicit DeflateStream(int quality, size_t threads = 0);
+    ~DeflateStream();
+
+    DeflateStream(const DeflateStream&) = delete;
+    DeflateStream& operator=(const DeflateStream&) = delete;
+
+    /**
+     * @brief Add input; compressed bytes that are ready are appended to @p out
+     */
+    void write(const uint8_t* data, size_t length, std::vector<uint8_t>& out);
+
+    /**
+     * @brief Add @p count more copies of @p pattern, which must be the last @p length bytes written
+     *
+     * Pending input is compressed first. A pattern that fits in the
+     * window is tokenized against the copy before it: runs inside the
+     * pattern become short-distance matches and the rest is copied from
+     * the previous copy. The tokens are replayed @p count times in one
+     * fixed-Huffman block without hashing anything, so repeated scanlines
+     * cost a few bits per 258 bytes. A longer pattern, such as a period of
+     * rows, is compressed once in stripes with its own end as the
+     * dictionary, and the compressed bytes are appended @p count times.
+     * Later stripes are cut from the end of the copies, so the stream
+     * decodes to the same data but is no longer byte-identical to
+     * ParallelDeflate::compress.
+     *
+     * @throws std::invalid_argument if nothing has been written yet
+     */
+    void repeat(const uint8_t* pattern, size_t length, uint64_t count, std::vector<uint8_t>& out);
+
+    /**
+     * @brief Compress the remaining input and append the end of the zlib stream to @p out
+     */
+    void finish(std::vector<uint8_t>& out);
+
+private:
+    struct State;
+    std::unique_ptr<State> state_;
+
+    void compressStripes(size_t stripes, bool final, std::vector<uint8_t>& out);
+
+    /**
+     * @brief Compress @p stripes stripes of data[begin, end) in parallel into
+     *        the parts and checksums of the state
+     */
+    void deflateStripes(const uint8_t* data, size_t begin, size_t end, size_t stripes, bool final);
+};
+
+} // namespace ColorGenerator
+
+#endif // DEFLATE_HPP
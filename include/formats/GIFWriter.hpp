@@ -0,0 +1,88 @@
+#ifndef GIFWRITER_HPP
+#define GIFWRITER_HPP
+
+#include "../Fade.hpp"
+#include "../ImageFormat.hpp"
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+namespace ColorGenerator {
+
+/**
+ * @brief GIF89a writer for still images and color fade animations
+ *
+ * GIF stores up to 256 palette colors with 1-bit transparency: pixels
+ * with alpha below 128 become the transparent index, all others are
+ * opaque. An image with at most 256 such colors gets an exact palette of
+ * the smallest power-of-two size; one with more is reduced to a 6x7x6
+ * color cube with 8x8 ordered dithering.
+ *
+ * Indices are LZW coded. When the 4096-entry code table fills, the
+ * encoder keeps using it (a deferred clear) as long as its codes cover at
+ * least as many pixels as they did while the table was built, and
+ * starts a new table otherwise. Long runs of one color therefore end up
+ * as 12-bit codes of about 4000 pixels each. A solid image is coded
+ * analytically from the length of the run, in time proportional to the
+ * number of codes rather than pixels.
+ */
+class GIFWriter : public IImageFormat {
+public:
+    struct AnimationOptions {
+        uint32_t frameRateNum = 25;  ///< Frames per second, as a fraction
+        uint32_t frameRateDen = 1;
+        uint32_t loops = 0;          ///< Times to play the animation, 0 = forever
+    };
+
+    GIFWriter() = default;
+    ~GIFWriter() override = default;
+
+    /**
+     * @throws std::invalid_argument for dimensions over 65535
+     * @throws std::runtime_error on write failure
+     */
+    bool write(const std::string& filename,
+               const Color& color,
+               const Resolution& resolution) override;
+
+    /**
+     * @brief Encode @p source, reading it twice: once to build the palette, once to code it
+     * @throws std::invalid_argument for dimensions over 65535
+     * @throws std::runtime_error on write failure
+     */
+    bool write(const std::string& filename, const RowSource& source) override;
+
+    /**
+     * @brief Exact size of the file write() produces for a solid color, without writing it
+     */
+    static uint64_t encodedSize(const Color& color, const Resolution& resolution);
+
+    /**
+     * @brief Write the frames of @p fade as an animated GIF
+     *
+     * Runs of identical frames become one frame with a longer delay. Each
+     * frame carries a two-entry local palette in front of the same LZW
+     * stream, which is therefore compressed once. Delays are rounded to
+     * centiseconds without accumulating error; a delay over 655.35 s
+     * continues in 1x1 frames.
+     *
+     * @throws std::invalid_argument for a zero frame rate, dimensions over 65535 or over 65536 loops
+     * @throws std::runtime_error on write failure
+     */
+    static void writeFade(const std::string& filename, const Fade& fade, const Resolution& resolution,
+                          const AnimationOptions& options);
+
+    std::string getFormatName() const override { return "GIF"; }
+    std::string getExtension() const override { return ".gif"; }
+    bool supportsTransparency() const override { return true; }
+
+    /// Source rows requested per call, at most (at least one row)
+    static constexpr size_t READ_BYTES = 1 << 20;
+
+    /// Codes per window over which a full code table's efficiency is judged
+    static constexpr uint32_t TABLE_CHECK_CODES = 256;
+};
+
+} // namespace ColorGenerator
+
+#endif // GIFWRITER_HPP
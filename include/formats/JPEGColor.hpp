@@ -0,0 +1,107 @@
+#ifndef JPEGCOLOR_HPP
+#define JPEGCOLOR_HPP
+
+#include <cstddef>
+#include <cstdint>
+
+namespace ColorGenerator {
+namespace JPEG {
+
+/**
+ * @brief Chroma subsampling of a YCbCr frame
+ */
+enum class Subsampling {
+    Auto,    ///< stb_image_write's rule: 4:2:0 at quality 90 and below, otherwise 4:4:4
+    YUV444,  ///< Full resolution chroma, 8x8 MCUs
+    YUV422,  ///< Chroma halved horizontally, 16x8 MCUs
+    YUV420   ///< Chroma halved in both directions, 16x16 MCUs
+};
+
+/**
+ * @brief Resolve Subsampling::Auto for @p quality (1-100, 0 = 90)
+ */
+inline Subsampling resolveSubsampling(Subsampling s, int quality) {
+    if (s != Subsampling::Auto) return s;
+    return (quality ? quality : 90) <= 90 ? Subsampling::YUV420 : Subsampling::YUV444;
+}
+
+/// MCU width in pixels (and luma plane granularity)
+inline uint32_t mcuWidth(Subsampling s) { return s == Subsampling::YUV444 ? 8 : 16; }
+
+/// MCU height in pixels, the rows converted per stripe
+inline uint32_t mcuHeight(Subsampling s) { return s == Subsampling::YUV420 ? 16 : 8; }
+
+/// Luma H/V sampling factors as written to SOF0
+inline uint8_t lumaSampling(Subsampling s) {
+    return s == Subsampling::YUV420 ? 0x22 : s == Subsampling::YUV422 ? 0x21 : 0x11;
+}
+
+/**
+ * @brief RGB to YCbCr weights in 1.15 fixed point
+ *
+ * Luma weights sum to the luma range and each set of chroma weights to
+ * zero, so gray stays gray.
+ */
+struct ColorMatrix {
+    int yR, yG, yB;
+    int yOffset;  ///< Added to luma: 0 for full range, 16 for limited range
+    int cbR, cbG, cbB;
+    int crR, crG, crB;
+};
+
+/// JFIF: BT.601, full range
+constexpr ColorMatrix BT601_FULL = {9798, 19235, 3735, 0, -5529, -10855, 16384, 16384, -13720, -2664};
+
+/// Video: BT.601, limited range (Y 16-235, Cb/Cr 16-240)
+constexpr ColorMatrix BT601_LIMITED = {8414, 16520, 3208, 16, -4857, -9535, 14392, 14392, -12052, -2340};
+
+/// Video: BT.709, limited range
+constexpr ColorMatrix BT709_LIMITED = {5983, 20127, 2032, 16, -3298, -11094, 14392, 14392, -13072, -1320};
+
+/**
+ * @brief Tightly packed, top-down source pixels
+ */
+struct SourceImage {
+    const uint8_t* pixels;
+    uint32_t width;
+    uint32_t height;
+    int channels;  ///< 1 (gray), 2 (gray + alpha), 3 (RGB) or 4 (RGBA); alpha is ignored
+};
+
+/**
+ * @brief Convert one row of pixels (two for 4:2:0) to Y, Cb and Cr samples
+ *
+ * @param row1 Second row for 4:2:0, otherwise ignored
+ * @param width Pixels in each row; columns up to @p planeWidth repeat the last one
+ * @param channels 1 to 4, as in SourceImage
+ * @param planeWidth Luma samples to produce, even unless @p subsampling is 4:4:4;
+ *                   half as many chroma samples are produced when subsampled
+ * @param y1 Luma of @p row1 for 4:2:0, otherwise unused
+ */
+void convertRows(const uint8_t* row0, const uint8_t* row1, uint32_t width, int channels,
+                 Subsampling subsampling, const ColorMatrix& matrix, size_t planeWidth,
+                 uint8_t* y0, uint8_t* y1, uint8_t* cb, uint8_t* cr);
+
+/**
+ * @brief Convert one MCU row to 8-bit Y, Cb and Cr planes in a single pass
+ *
+ * Uses 15-bit fixed-point BT.601 coefficients. Cb and Cr are produced
+ * already subsampled: the RGB values of each 2x1 or 2x2 group are summed
+ * and converted once, which equals averaging full-resolution chroma but
+ * rounds only once. Pixels past the right or bottom edge repeat the last
+ * column or row. An SSSE3 kernel handles RGB and RGBA rows, selected at
+ * run time; all paths produce identical planes.
+ *
+ * @param y0 First image row of the stripe
+ * @param planeWidth Luma plane width, a multiple of mcuWidth(); chroma planes are
+ *                   half as wide unless @p subsampling is 4:4:4
+ * @param luma mcuHeight() rows of @p planeWidth samples
+ * @param cb, cr 8 rows of chroma samples each
+ */
+void convertStripe(const SourceImage& image, uint32_t y0, Subsampling subsampling, size_t planeWidth,
+                   uint8_t* luma, uint8_t* cb, uint8_t* cr);
+
+} // namespace JPEG
+} // namespace ColorGenerator
+
+#endif // JPEGCOLOR_HPP
@@ -0,0 +1,220 @@
+#ifndef JPEGCOMMON_HPP
+#define JPEGCOMMON_HPP
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace ColorGenerator {
+namespace JPEG {
+
+/// Natural (row-major) index -> zigzag position
+extern const uint8_t ZIGZAG[64];
+
+/// Annex K quantization tables (natural order)
+extern const int LUMA_QUANT[64];
+extern const int CHROMA_QUANT[64];
+
+/**
+ * @brief Huffman table specification as stored in a DHT segment
+ */
+struct HuffmanSpec {
+    uint8_t counts[16];
+    const uint8_t* values;
+    size_t valueCount;
+};
+
+/// Annex K Huffman tables, as used by stb_image_write
+extern const HuffmanSpec DC_LUMA;
+extern const HuffmanSpec AC_LUMA;
+extern const HuffmanSpec DC_CHROMA;
+extern const HuffmanSpec AC_CHROMA;
+
+struct Code {
+    uint32_t bits;
+    int length;
+};
+
+using CodeTable = std::array<Code, 256>;
+
+/**
+ * @brief Expand a DHT specification into canonical codes indexed by symbol
+ */
+CodeTable buildCodes(const HuffmanSpec& spec);
+
+/// Occurrences of each symbol of one Huffman table
+using SymbolCounts = std::array<uint64_t, 256>;
+
+/**
+ * @brief Build an optimal Huffman table limited to 16-bit codes (T.81 Annex K.2)
+ *
+ * Symbols with a zero count get no code. A reserved pseudo-symbol keeps
+ * every real code from being all ones.
+ *
+ * @param values Receives the symbol list; the returned spec points into it
+ */
+HuffmanSpec buildOptimalTable(const SymbolCounts& counts, std::array<uint8_t, 256>& values);
+
+/**
+ * @brief Map a 1-100 quality (0 = stb default of 90) to stb's table scale factor
+ */
+int qualityScale(int quality);
+
+/**
+ * @brief Scale an Annex K table the same way stb_image_write does (zigzag order)
+ */
+std::array<uint8_t, 64> scaleQuantTable(const int* base, int scale);
+
+/**
+ * @brief Everything needed to write the headers up to and including SOS
+ */
+struct FrameHeader {
+    uint32_t width;
+    uint32_t height;
+    int components;             ///< 1 (grayscale) or 3 (YCbCr)
+    uint8_t lumaSampling;       ///< Luma H/V sampling factors, e.g. 0x22 for 4:2:0
+    const uint8_t* lumaQuant;   ///< 64 entries, zigzag order
+    const uint8_t* chromaQuant; ///< 64 entries, zigzag order (unused for gray)
+    const HuffmanSpec* huffman[4]; ///< DC luma, AC luma, DC chroma, AC chroma
+    uint16_t restartInterval;   ///< MCUs per restart interval, 0 for none
+};
+
+/**
+ * @brief Append SOI, JFIF APP0, DQT, SOF0, DHT, an optional DRI and SOS
+ */
+void writeHeaders(std::vector<uint8_t>& out, const FrameHeader& header);
+
+/**
+ * @brief MSB-first entropy bit writer with 0xFF byte stuffing
+ *
+ * Bits collect in a 64-bit accumulator that is written out a whole word
+ * at a time. Words without an 0xFF byte, found with a bit trick, are
+ * stored directly; only the rare words containing one take the
+ * byte-at-a-time stuffing path. The output vector is grown ahead of the
+ * write position and is only valid after flush() or padToByte().
+ */
+class BitWriter {
+public:
+    explicit BitWriter(std::vector<uint8_t>& out) : out_(out), pos_(out.size()) {}
+
+    /**
+     * @brief Append the low @p count bits of @p bits (count <= 32, no stray high bits)
+     */
+    void put(uint32_t bits, int count) {
+        free_ -= count;
+        if (free_ >= 0) {
+            acc_ = (acc_ << count) | bits;
+        } else {
+            // Top up the word, write it and keep the leftover low bits;
+            // bits already written are shifted out before the next word
+            acc_ = (acc_ << (count + free_)) | (static_cast<uint64_t>(bits) >> -free_);
+            putWord(acc_);
+            acc_ = bits;
+            free_ += 64;
+        }
+    }
+
+    void put(const Code& code) { put(code.bits, code.length); }
+
+    /**
+     * @brief Encode a DC difference: category code and extra bits in one put
+     */
+    void dc(int diff, const CodeTable& codes) {
+        const int category = magnitudeCategory(diff);
+        const Code& code = codes[category];
+        put((code.bits << category) | extraBits(diff, category), code.length + category);
+    }
+
+    /**
+     * @brief Encode a non-zero AC coefficient preceded by @p zeros (< 16) zeros
+     */
+    void ac(int zeros, int value, const CodeTable& codes) {
+        const int category = magnitudeCategory(value);
+        const Code& code = codes[(zeros << 4) + category];
+        put((code.bits << category) | extraBits(value, category), code.length + category);
+    }
+
+    /**
+     * @brief Move every complete byte to the output and trim it to size
+     */
+    void flush();
+
+    /**
+     * @brief Bytes stored in the output so far; bits still in the accumulator are not counted
+     */
+    size_t size() const { return pos_; }
+
+    /**
+     * @brief After flush(), drop the flushed bytes so a streaming caller can reuse the buffer
+     */
+    void discardOutput() {
+        out_.clear();
+        pos_ = 0;
+    }
+
+    /**
+     * @brief Pad the final byte with 1-bits as required before a marker, then flush
+     */
+    void padToByte() {
+        const int partial = (64 - free_) & 7;
+        if (partial) {
+            put((1u << (8 - partial)) - 1, 8 - partial);
+        }
+        flush();
+    }
+
+    static int magnitudeCategory(int value) {
+        const uint32_t magnitude = static_cast<uint32_t>(value < 0 ? -value : value);
+#if defined(__GNUC__) || defined(__clang__)
+        return magnitude ? 32 - __builtin_clz(magnitude) : 0;
+#else
+        int category = 0;
+        for (uint32_t m = magnitude; m; m >>= 1) {
+            ++category;
+        }
+        return category;
+#endif
+    }
+
+    /**
+     * @brief Low @p category bits of @p value, one's complement for negatives
+     */
+    static uint32_t extraBits(int value, int category) {
+        return static_cast<uint32_t>(value + (value >> 31)) & ((1u << category) - 1);
+    }
+
+private:
+    void putWord(uint64_t word) {
+        if (out_.size() - pos_ < 16) {
+            grow();
+        }
+        uint8_t* dst = out_.data() + pos_;
+        // Any byte of ~word zero <=> an 0xFF byte in word
+        if (((~word - 0x0101010101010101ull) & word & 0x8080808080808080ull) == 0) {
+            for (int i = 0; i < 8; ++i) {
+                dst[i] = static_cast<uint8_t>(word >> (56 - 8 * i));
+            }
+            pos_ += 8;
+        } else {
+            putStuffed(word, 64);
+        }
+    }
+
+    /**
+     * @brief Write the @p count / 8 whole bytes below bit @p count of @p word, stuffing 0xFF bytes
+     */
+    void putStuffed(uint64_t word, int count);
+
+    void grow();
+
+    std::vector<uint8_t>& out_;
+    size_t pos_;
+    uint64_t acc_ = 0;
+    int free_ = 64;  ///< Unused low bits of the accumulator
+};
+
+} // namespace JPEG
+} // namespace ColorGenerator
+
+#endif // JPEGCOMMON_HPP
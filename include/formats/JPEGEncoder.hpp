@@ -0,0 +1,93 @@
+#ifndef JPEGENCODER_HPP
+#define JPEGENCODER_HPP
+
+#include "JPEGColor.hpp"
+#include "JPEGTransform.hpp"
+#include "../RowSource.hpp"
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace ColorGenerator {
+
+/**
+ * @brief Baseline JPEG encoder for arbitrary RGB(A) pixel buffers
+ *
+ * Uses stb_image_write's quality mapping, Annex K tables and (by
+ * default) its float AAN DCT and subsampling rule. Each MCU row is
+ * converted to 8-bit Y/Cb/Cr planes in one fixed-point pass, then
+ * transformed a batch of blocks at a time and entropy coded, so the
+ * working set stays in cache.
+ *
+ * With restart markers the image is cut into segments of whole MCU rows.
+ * Each segment starts with fresh DC predictors and its own bit writer,
+ * so segments are encoded on separate threads and joined in order with
+ * RSTn markers. Segment boundaries depend only on the options, never on
+ * the thread count, so the output is deterministic.
+ *
+ * Pixels come from a RowSource, one MCU row of scanlines at a time.
+ * write() streams to the file: segments are encoded in waves of a few per
+ * thread and written as each wave finishes, and a single segment drains
+ * as it is coded, so memory is O(width) for any image height.
+ *
+ * With optimizeHuffman a first pass counts the symbols each table would
+ * code (per segment, in parallel) and the DHT tables are rebuilt from the
+ * counts, typically saving several percent at the cost of a second pass
+ * over the DCT. huffmanSampleStep trades some of that saving for time by
+ * counting only every Nth MCU row.
+ */
+class JPEGEncoder {
+public:
+    struct Options {
+        int quality = 90;          ///< 1-100, 0 selects stb's default of 90
+        uint32_t restartRows = 0;  ///< MCU rows per restart interval, 0 for none (single thread)
+        size_t threads = 0;        ///< Maximum worker threads (0 = ThreadPool::availableThreads())
+        JPEG::DCTMethod dct = JPEG::DCTMethod::Float;
+        JPEG::Subsampling subsampling = JPEG::Subsampling::Auto;  ///< Auto follows stb's quality rule
+        bool optimizeHuffman = false;    ///< Build Huffman tables from the image instead of Annex K
+        uint32_t huffmanSampleStep = 1;  ///< Count symbols of every Nth MCU row (1 = all rows)
+    };
+
+    /**
+     * @brief Encode rows pulled from @p source into a JPEG file image
+     * @throws std::invalid_argument for bad dimensions or channel count
+     */
+    static std::vector<uint8_t> encode(const RowSource& source, const Options& options);
+
+    /**
+     * @brief Encode @p source straight to @p filename
+     * @throws std::invalid_argument for bad dimensions or channel count
+     * @throws std::runtime_error on write failure
+     */
+    static void write(const std::string& filename, const RowSource& source, const Options& options);
+
+    /**
+     * @brief Exact size of the file write() produces for @p source, without writing it
+     * @throws std::invalid_argument for bad dimensions or channel count
+     */
+    static uint64_t encodedSize(const RowSource& source, const Options& options);
+
+    /**
+     * @brief Encode a top-down, tightly packed image into a JPEG file image
+     * @param pixels width * height * channels bytes
+     * @param channels 1 (gray), 2 (gray + alpha), 3 (RGB) or 4 (RGBA); alpha is ignored
+     * @throws std::invalid_argument for bad dimensions or channel count
+     */
+    static std::vector<uint8_t> encode(const uint8_t* pixels, uint32_t width, uint32_t height,
+                                       int channels, const Options& options);
+
+    /**
+     * @brief Encode and write to @p filename
+     * @throws std::runtime_error on write failure
+     */
+    static void write(const std::string& filename, const uint8_t* pixels, uint32_t width,
+                      uint32_t height, int channels, const Options& options);
+
+    /// Restart interval used by callers that want parallel encoding by default
+    static constexpr uint32_t DEFAULT_RESTART_ROWS = 4;
+};
+
+} // namespace ColorGenerator
+
+#endif // JPEGENCODER_HPP
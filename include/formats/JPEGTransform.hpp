@@ -0,0 +1,49 @@
+#ifndef JPEGTRANSFORM_HPP
+#define JPEGTRANSFORM_HPP
+
+#include <cstddef>
+#include <cstdint>
+
+namespace ColorGenerator {
+namespace JPEG {
+
+/**
+ * @brief Forward DCT implementation
+ */
+enum class DCTMethod {
+    Float,   ///< stb_image_write's float AAN DCT
+    Integer  ///< libjpeg's fixed-point "islow" DCT; identical output on every CPU and compiler
+};
+
+/**
+ * @brief One component's quantization table, prepared for both DCT methods
+ */
+struct Quantizer {
+    /**
+     * @param table 64 quantizer values in zigzag order, as written to DQT
+     */
+    explicit Quantizer(const uint8_t* table);
+
+    float scale[64];    ///< Float DCT: 1 / (q * AAN row factor * AAN column factor)
+    float divisor[64];  ///< Integer DCT: q * 8, the islow output scale
+};
+
+/**
+ * @brief Transform, quantize and zigzag @p count horizontally adjacent 8x8 blocks
+ *
+ * Blocks are transformed eight (AVX2) or four (SSE2) at a time, one
+ * block per vector lane, so every lane runs exactly the scalar sequence
+ * of operations and all paths produce identical coefficients. The kernel
+ * is chosen at run time.
+ *
+ * @param samples 8-bit samples (level shifted here), block i starting at column 8 * i
+ * @param stride Bytes per sample row
+ * @param out 64 coefficients per block, in zigzag order
+ */
+void transformBlocks(const uint8_t* samples, size_t stride, size_t count,
+                     const Quantizer& quantizer, DCTMethod method, int16_t* out);
+
+} // namespace JPEG
+} // namespace ColorGenerator
+
+#endif // JPEGTRANSFORM_HPP
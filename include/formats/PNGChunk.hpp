@@ -0,0 +1,45 @@
+#ifndef PNGCHUNK_HPP
+#define PNGCHUNK_HPP
+
+#include <cstddef>
+#include <cstdint>
+
+namespace ColorGenerator {
+
+/**
+ * @brief Store @p value big endian, as PNG chunks and QOI headers do
+ */
+void putU32BE(uint8_t* dst, uint32_t value);
+
+/**
+ * @brief PNG file signature and chunk framing, shared by the PNG, solid PNG and APNG encoders
+ */
+class PNGChunk {
+public:
+    static const uint8_t SIGNATURE[8];
+
+    /**
+     * @brief Length and type of a chunk, and the CRC-32 of its type and data
+     * @param header Receives 8 bytes: length, then type
+     * @param trailer Receives the 4-byte CRC
+     */
+    static void frame(const char* type, const uint8_t* data, size_t length,
+                      uint8_t* header, uint8_t* trailer);
+
+    /**
+     * @brief Write one chunk to @p sink (FileSink or CountingSink)
+     */
+    template <typename Sink>
+    static void write(Sink& sink, const char* type, const uint8_t* data, size_t length) {
+        uint8_t header[8];
+        uint8_t trailer[4];
+        frame(type, data, length, header, trailer);
+        sink.write(header, sizeof(header));
+        sink.write(data, length);
+        sink.write(trailer, sizeof(trailer));
+    }
+};
+
+} // namespace ColorGenerator
+
+#endif // PNGCHUNK_HPP
@@ -0,0 +1,60 @@
+#ifndef PNGENCODER_HPP
+#define PNGENCODER_HPP
+
+#include "../RowSource.hpp"
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+namespace ColorGenerator {
+
+/**
+ * @brief Streaming PNG encoder for images supplied by a RowSource
+ *
+ * Scanlines are pulled from the source a bounded batch at a time,
+ * filtered with stb_image_write's per-row heuristic (or a forced filter)
+ * and fed to a DeflateStream; compressed data is written out in IDAT
+ * chunks as it becomes available. Peak memory is a few rows plus the
+ * deflate batch, independent of image height, and the zlib stream is
+ * byte-identical to ParallelDeflate::compress of the filtered rows.
+ *
+ * Rows the source reports through RowSource::repeatedRows() are not
+ * read: they filter to the same line as the first repeat, which is
+ * emitted once and then copied with DeflateStream::repeat(). A source
+ * with a RowSource::rowPeriod() has rows 1..p encoded normally and their
+ * filtered lines kept; every later whole period filters to those same
+ * lines, so they are repeated too, and only the rows after the last
+ * whole period are read again. Such files decode to the same pixels but
+ * are no longer byte-identical to it.
+ */
+class PNGEncoder {
+public:
+    struct Options {
+        int compressionLevel = 8;  ///< As stbi_write_png_compression_level
+        int filter = -1;           ///< Force filter 0-4, or -1 to pick per row like stb
+        size_t threads = 0;        ///< Maximum deflate threads (0 = ThreadPool::availableThreads())
+    };
+
+    /**
+     * @brief Encode @p source to @p filename
+     * @throws std::invalid_argument for an unsupported channel count
+     * @throws std::runtime_error on write failure
+     */
+    static void write(const std::string& filename, const RowSource& source, const Options& options);
+
+    /// Source rows requested per call, at most (at least one row)
+    static constexpr size_t READ_BYTES = 1 << 20;
+
+    /// Compressed bytes collected before an IDAT chunk is written
+    static constexpr size_t IDAT_CHUNK_SIZE = 1 << 20;
+
+    /// Filtered bytes of a RowSource::rowPeriod() kept to repeat it, at most
+    static constexpr size_t MAX_PERIOD_BYTES = 16 << 20;
+
+    /// Filtered bytes repeated per DeflateStream::repeat() call, at most (at least one period)
+    static constexpr size_t REPEAT_BYTES = 64 << 20;
+};
+
+} // namespace ColorGenerator
+
+#endif // PNGENCODER_HPP
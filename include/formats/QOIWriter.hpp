@@ -0,0 +1,57 @@
+#ifndef QOIWRITER_HPP
+#define QOIWRITER_HPP
+
+#include "../ImageFormat.hpp"
+#include <cstddef>
+#include <cstdint>
+
+namespace ColorGenerator {
+
+/**
+ * @brief QOI ("Quite OK Image") writer: lossless, with very cheap encoding and decoding
+ *
+ * Pixels are coded one at a time as runs, references into a 64-entry
+ * table of recent colors, small differences from the previous pixel, or
+ * literals, byte-identical to the reference encoder. Rows are streamed
+ * from the source a batch at a time; gray sources are written as RGB(A).
+ *
+ * Runs are added in bulk rather than per pixel. A solid image codes its
+ * first row and then (height - 1) x width pixels of run, written as
+ * repeated 62-pixel run bytes. Rows the source reports through
+ * RowSource::repeatedRows() are coded twice, after which every further
+ * repeat codes to the same bytes, which are copied instead.
+ */
+class QOIWriter : public IImageFormat {
+public:
+    QOIWriter() = default;
+    ~QOIWriter() override = default;
+
+    bool write(const std::string& filename,
+               const Color& color,
+               const Resolution& resolution) override;
+
+    /**
+     * @throws std::invalid_argument for an unsupported channel count
+     * @throws std::runtime_error on write failure
+     */
+    bool write(const std::string& filename, const RowSource& source) override;
+
+    /**
+     * @brief Exact size of the file write() produces for a solid color, without writing it
+     */
+    static uint64_t encodedSize(const Color& color, const Resolution& resolution);
+
+    std::string getFormatName() const override { return "QOI"; }
+    std::string getExtension() const override { return ".qoi"; }
+    bool supportsTransparency() const override { return true; }
+
+    /// Source rows requested per call, at most (at least one row)
+    static constexpr size_t READ_BYTES = 1 << 20;
+
+    /// Encoded bytes collected before they are written
+    static constexpr size_t WRITE_BYTES = 1 << 20;
+};
+
+} // namespace ColorGenerator
+
+#endif // QOIWRITER_HPP
@@ -0,0 +1,38 @@
+#ifndef RAWIMAGEWRITER_HPP
+#define RAWIMAGEWRITER_HPP
+
+#include "../ImageFormat.hpp"
+
+namespace ColorGenerator {
+
+/**
+ * @brief Headerless raw pixel writer
+ *
+ * Writes tightly packed, top-down, 8-bit interleaved pixels with no
+ * header: RGB when the color is opaque, RGBA otherwise (the same rule
+ * the PNG and BMP writers use). For a solid color the file is memory
+ * mapped and filled by replicating one pixel, so no intermediate buffer
+ * is needed; row sources are copied to the file a batch of rows at a time.
+ */
+class RawImageWriter : public IImageFormat {
+public:
+    RawImageWriter() = default;
+    ~RawImageWriter() override = default;
+
+    bool write(const std::string& filename,
+              const Color& color,
+              const Resolution& resolution) override;
+
+    bool write(const std::string& filename, const RowSource& source) override;
+
+    /// Source rows requested per call, at most (at least one row)
+    static constexpr size_t READ_BYTES = 1 << 20;
+
+    std::string getFormatName() const override { return "RAW"; }
+    std::string getExtension() const override { return ".raw"; }
+    bool supportsTransparency() const override { return true; }
+};
+
+} // namespace ColorGenerator
+
+#endif // RAWIMAGEWRITER_HPP
@@ -2,15 +2,20 @@
 #define STBIMAGEWRITER_HPP
 
 #include "../ImageFormat.hpp"
-#include <vector>
+#include "../PixelFill.hpp"
+#include "../RowSource.hpp"
+#include "JPEGEncoder.hpp"
 
 namespace ColorGenerator {
 
 /**
- * @brief Unified image writer using stb_image_write library
+ * @brief Unified PNG, JPEG and BMP writer
  *
- * Uses the public domain stb_image_write.h single-header library
- * for writing PNG, JPEG, and BMP formats without external dependencies.
+ * Solid colors go through the analytic Solid*Encoder classes. Other
+ * images are streamed from a RowSource by the PNG, JPEG and BMP
+ * encoders, which follow stb_image_write's output (the public domain
+ * single-header library that originally backed this writer, now only
+ * compiled into the benchmarks as a reference).
  */
 class STBImageWriter : public IImageFormat {
 public:
@@ -32,6 +37,16 @@ public:
               const Color& color,
               const Resolution& resolution) override;
 
+    /**
+     * @brief Stream an arbitrary image from @p source in this writer's format
+     *
+     * Rows are pulled as the encoder needs them, so memory use does not
+     * grow with image height.
+     *
+     * @throws std::runtime_error on write failure
+     */
+    bool write(const std::string& filename, const RowSource& source) override;
+
     std::string getFormatName() const override;
     std::string getExtension() const override;
     bool supportsTransparency() const override;
@@ -52,22 +67,56 @@ public:
      */
     int getJPEGQuality() const { return jpegQuality_; }
 
+    /**
+     * @brief Set JPEG chroma subsampling (Auto follows stb's quality rule)
+     *
+     * Only images streamed from a RowSource are affected; a solid color
+     * decodes to the same pixels with any subsampling.
+     */
+    void setJPEGSubsampling(JPEG::Subsampling subsampling) { jpegSubsampling_ = subsampling; }
+
+    /**
+     * @brief Set the JPEG forward DCT, for images streamed from a RowSource
+     */
+    void setJPEGDCT(JPEG::DCTMethod dct) { jpegDCT_ = dct; }
+
+    /**
+     * @brief Build JPEG Huffman tables from the image, counting every @p sampleStep-th MCU row
+     *
+     * Like the subsampling and DCT, this applies to images streamed from a RowSource.
+     */
+    void setJPEGHuffman(bool optimize, uint32_t sampleStep = 1) {
+        jpegOptimizeHuffman_ = optimize;
+        jpegHuffmanSampleStep_ = sampleStep;
+    }
+
+    /**
+     * @brief Encoder options write() uses for JPEG images streamed from a RowSource
+     */
+    JPEGEncoder::Options getJPEGOptions() const;
+
+    /**
+     * @brief Allocate and fill pixel buffer with solid color
+     *
+     * The buffer is not zeroed first; see PixelFill.
+     */
+    static void fillPixelBuffer(PixelBuffer& buffer,
+                                const Color& color,
+                                const Resolution& resolution,
+                                int channels);
+
 private:
     Format format_;
     int jpegQuality_;
+    JPEG::Subsampling jpegSubsampling_ = JPEG::Subsampling::Auto;
+    JPEG::DCTMethod jpegDCT_ = JPEG::DCTMethod::Float;
+    bool jpegOptimizeHuffman_ = false;
+    uint32_t jpegHuffmanSampleStep_ = 1;
 
     /**
      * @brief Validate and clamp JPEG quality
      */
     static int validateQuality(int quality);
-
-    /**
-     * @brief Allocate and fill pixel buffer with solid color
-     */
-    void fillPixelBuffer(std::vector<uint8_t>& buffer,
-                        const Color& color,
-                        const Resolution& resolution,
-                        int channels) const;
 };
 
 } // namespace ColorGenerator
@@ -0,0 +1,45 @@
+#ifndef SOLIDBMPENCODER_HPP
+#define SOLIDBMPENCODER_HPP
+
+#include "../Color.hpp"
+#include "../Resolution.hpp"
+#include <cstdint>
+#include <string>
+
+namespace ColorGenerator {
+
+/**
+ * @brief Zero-copy BMP encoder for uniform (single color) images
+ *
+ * The output file is sized exactly and memory mapped. The header and a
+ * single padded BGR/BGRA row are written in place, then the row is
+ * replicated through the mapping with large memcpy calls. Headers match
+ * stb_image_write: 24-bit BITMAPINFOHEADER for RGB and a 32-bit
+ * BI_BITFIELDS BITMAPV4HEADER for RGBA.
+ */
+class SolidBMPEncoder {
+public:
+    /**
+     * @brief Write a solid color BMP file
+     * @param filename Output file path
+     * @param color Fill color
+     * @param resolution Image dimensions
+     * @param channels 3 for RGB, 4 for RGBA
+     * @throws std::invalid_argument if channels is not 3 or 4
+     * @throws std::runtime_error on write failure
+     */
+    static void write(const std::string& filename,
+                      const Color& color,
+                      const Resolution& resolution,
+                      int channels);
+
+    /**
+     * @brief Size of the file write() produces: headers plus padded rows
+     * @throws std::invalid_argument if channels is not 3 or 4
+     */
+    static uint64_t encodedSize(const Resolution& resolution, int channels);
+};
+
+} // namespace ColorGenerator
+
+#endif // SOLIDBMPENCODER_HPP
@@ -0,0 +1,57 @@
+#ifndef SOLIDJPEGENCODER_HPP
+#define SOLIDJPEGENCODER_HPP
+
+#include "../Color.hpp"
+#include "../Resolution.hpp"
+#include <cstdint>
+#include <string>
+
+namespace ColorGenerator {
+
+/**
+ * @brief Analytic baseline JPEG encoder for uniform (single color) images
+ *
+ * Every 8x8 block of a solid image has the same DC coefficient and no
+ * AC energy, so no DCT or quantization is performed. The quantized DC
+ * value of each component is computed once, the first MCU carries it as
+ * a DC difference, and every later MCU is the same zero-difference/EOB
+ * bit pattern. Once the bit alignment repeats, the encoded bytes are
+ * replicated straight into the file. Gray colors (R == G == B) produce a
+ * single-component grayscale JPEG.
+ *
+ * Quantization tables and Huffman tables match stb_image_write, so the
+ * output decodes to the same pixel values.
+ */
+class SolidJPEGEncoder {
+public:
+    /**
+     * @brief Write a solid color JPEG file
+     * @param filename Output file path
+     * @param color Fill color (alpha is ignored)
+     * @param resolution Image dimensions
+     * @param quality JPEG quality (1-100, 0 selects the stb default of 90)
+     * @throws std::runtime_error on write failure
+     */
+    static void write(const std::string& filename,
+                      const Color& color,
+                      const Resolution& resolution,
+                      int quality);
+
+    /**
+     * @brief Exact size of the file write() would produce, without writing it
+     *
+     * Runs the same encoder into a byte counter; the replicated body is
+     * counted rather than copied, so the cost is independent of resolution.
+     */
+    static uint64_t encodedSize(const Color& color, const Resolution& resolution, int quality);
+
+private:
+    /**
+     * @brief Size of the replicated block written per file write
+     */
+    static constexpr size_t WRITE_BLOCK_SIZE = 1 << 20;
+};
+
+} // namespace ColorGenerator
+
+#endif // SOLIDJPEGENCODER_HPP
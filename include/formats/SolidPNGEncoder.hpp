@@ -0,0 +1,53 @@
+#ifndef SOLIDPNGENCODER_HPP
+#define SOLIDPNGENCODER_HPP
+
+#include "../Color.hpp"
+#include "../Resolution.hpp"
+#include <cstdint>
+#include <string>
+
+namespace ColorGenerator {
+
+/**
+ * @brief Analytic PNG encoder for uniform (single color) images
+ *
+ * Every scanline of a solid image filters to the same bytes, so the
+ * encoder never builds a pixel buffer. The first row is stored with the
+ * None filter and every following row with the Up filter (all zeros).
+ * Rows are emitted as a fixed-Huffman deflate stream made of long
+ * back-references, written out in bounded IDAT chunks while the CRC-32
+ * and Adler-32 are updated incrementally. Memory use is O(1) apart from
+ * the chunk buffer, regardless of resolution.
+ */
+class SolidPNGEncoder {
+public:
+    /**
+     * @brief Write a solid color PNG file
+     * @param filename Output file path
+     * @param color Fill color
+     * @param resolution Image dimensions
+     * @param channels 3 for RGB, 4 for RGBA
+     * @throws std::invalid_argument if channels is not 3 or 4
+     * @throws std::runtime_error on write failure
+     */
+    static void write(const std::string& filename,
+                      const Color& color,
+                      const Resolution& resolution,
+                      int channels);
+
+    /**
+     * @brief Exact size of the file write() would produce, without writing it
+     * @throws std::invalid_argument if channels is not 3 or 4
+     */
+    static uint64_t encodedSize(const Color& color, const Resolution& resolution, int channels);
+
+private:
+    /**
+     * @brief Size of the compressed data carried by each IDAT chunk
+     */
+    static constexpr size_t IDAT_CHUNK_SIZE = 1 << 20;
+};
+
+} // namespace ColorGenerator
+
+#endif // SOLIDPNGENCODER_HPP
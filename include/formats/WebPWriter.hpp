@@ -0,0 +1,67 @@
+#ifndef WEBPWRITER_HPP
+#define WEBPWRITER_HPP
+
+#include "../ImageFormat.hpp"
+#include <cstddef>
+#include <cstdint>
+
+namespace ColorGenerator {
+
+/**
+ * @brief Lossless WebP (VP8L) writer, without libwebp
+ *
+ * A first pass collects the distinct colors while there are at most 256.
+ * An image of one color needs no pixel data at all: each of its five
+ * prefix codes holds a single symbol, which takes zero bits, so its file
+ * has the same small size at any resolution. Other images of up to 256
+ * colors are written through the color indexing (palette) transform,
+ * with 2, 4 or 8 pixels bundled into each coded pixel for palettes of at
+ * most 16, 4 or 2 colors. Images with more colors are coded as ARGB
+ * after the subtract-green and predictor (clamped gradient) transforms,
+ * with a color cache whose size is chosen by counting every candidate.
+ * Palettes of more than 16 colors are also coded that way, and the
+ * smaller of the two files is written.
+ *
+ * Backward references cover runs of one coded pixel and spans equal to
+ * the row above, up to 4096 pixels each. Rows the source reports through
+ * RowSource::repeatedRows() are not read again; they become references
+ * to the row above, a few bytes per 4096 pixels.
+ */
+class WebPWriter : public IImageFormat {
+public:
+    WebPWriter() = default;
+    ~WebPWriter() override = default;
+
+    /**
+     * @throws std::invalid_argument for dimensions over 16384
+     * @throws std::runtime_error on write failure
+     */
+    bool write(const std::string& filename,
+               const Color& color,
+               const Resolution& resolution) override;
+
+    /**
+     * @throws std::invalid_argument for dimensions over 16384 or an unsupported channel count
+     * @throws std::runtime_error on write failure
+     */
+    bool write(const std::string& filename, const RowSource& source) override;
+
+    /**
+     * @brief Exact size of the file write() produces for a solid color, without writing it
+     */
+    static uint64_t encodedSize(const Color& color, const Resolution& resolution);
+
+    std::string getFormatName() const override { return "WebP"; }
+    std::string getExtension() const override { return ".webp"; }
+    bool supportsTransparency() const override { return true; }
+
+    /// Source rows requested per call, at most (at least one row)
+    static constexpr size_t READ_BYTES = 1 << 20;
+
+    /// Encoded bytes collected before they are written
+    static constexpr size_t WRITE_BYTES = 1 << 20;
+};
+
+} // namespace ColorGenerator
+
+#endif // WEBPWRITER_HPP
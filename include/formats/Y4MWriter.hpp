@@ -0,0 +1,105 @@
+#ifndef Y4MWRITER_HPP
+#define Y4MWRITER_HPP
+
+#include "../Gradient.hpp"
+#include "../ImageFormat.hpp"
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace ColorGenerator {
+
+/**
+ * @brief YUV4MPEG2 (.y4m) and headerless planar YUV (.yuv) video writer
+ *
+ * Produces synthetic test sources for video encoders: a number of frames
+ * of a solid color, of any RowSource, or of a color sequence that fades
+ * between stops. RGB is converted to limited-range BT.709 (or BT.601)
+ * 8-bit YUV, 4:2:0 with centered chroma (C420jpeg) or 4:4:4; alpha is
+ * ignored. Rows are converted 16 pixels at a time by an SSSE3 kernel
+ * when available, with identical results on every path.
+ *
+ * Frames are written with vectored writes (writev) that gather many
+ * frames per call, to a file or to standard output when the filename
+ * is "-". Consecutive frames with the same content share one set of
+ * planes, which is converted once and written repeatedly.
+ */
+class Y4MWriter : public IImageFormat {
+public:
+    enum class Chroma {
+        YUV420,  ///< Chroma halved in both directions, averaged over 2x2 pixels
+        YUV444   ///< Full resolution chroma
+    };
+
+    enum class Matrix {
+        BT601,
+        BT709
+    };
+
+    struct Options {
+        uint32_t frames = 1;
+        uint32_t frameRateNum = 25;  ///< Frames per second, as a fraction
+        uint32_t frameRateDen = 1;
+        Chroma chroma = Chroma::YUV420;
+        Matrix matrix = Matrix::BT709;
+    };
+
+    /**
+     * @param headerless Write raw planar YUV frames without stream or frame headers
+     */
+    explicit Y4MWriter(bool headerless = false) : headerless_(headerless) {}
+    ~Y4MWriter() override = default;
+
+    /**
+     * @throws std::invalid_argument for zero frames or a zero frame rate
+     */
+    void setOptions(const Options& options);
+    const Options& getOptions() const { return options_; }
+
+    /**
+     * @brief Write getOptions().frames frames of a solid color
+     */
+    bool write(const std::string& filename,
+               const Color& color,
+               const Resolution& resolution) override;
+
+    /**
+     * @brief Write getOptions().frames copies of @p source, converted once
+     */
+    bool write(const std::string& filename, const RowSource& source) override;
+
+    /**
+     * @brief Write solid frames whose color fades through @p stops
+     *
+     * Frame colors are sampled as by Fade. Frames that convert to the same
+     * YUV values reuse the previous planes.
+     *
+     * @throws std::invalid_argument for fewer than two stops
+     */
+    bool writeFade(const std::string& filename, const std::vector<GradientStop>& stops,
+                   const Resolution& resolution);
+
+    /**
+     * @brief Exact size of the output for @p resolution with the current options
+     */
+    uint64_t encodedSize(const Resolution& resolution) const;
+
+    std::string getFormatName() const override { return headerless_ ? "YUV" : "Y4M"; }
+    std::string getExtension() const override { return headerless_ ? ".yuv" : ".y4m"; }
+    bool supportsTransparency() const override { return false; }
+
+    /// Source rows requested per call, at most (at least two rows)
+    static constexpr size_t READ_BYTES = 1 << 20;
+
+    /// Frames gathered into one vectored write, at most
+    static constexpr size_t FRAMES_PER_WRITE = 64;
+
+private:
+    bool headerless_;
+    Options options_;
+};
+
+} // namespace ColorGenerator
+
+#endif // Y4MWRITER_HPP
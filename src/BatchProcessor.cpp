@@ -0,0 +1,359 @@
+#include "../include/BatchProcessor.hpp"
+#include "../include/MappedFile.hpp"
+#include "../include/ThreadPool.hpp"
+#include <algorithm>
+#include <atomic>
+#include <cctype>
+#include <chrono>
+#include <cstring>
+#include <filesystem>
+#include <iomanip>
+#include <iostream>
+#include <iterator>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <stdexcept>
+#include <vector>
+
+namespace ColorGenerator {
+
+namespace {
+
+std::string_view trim(std::string_view s) {
+    while (!s.empty() && std::isspace(static_cast<unsigned char>(s.front()))) s.remove_prefix(1);
+    while (!s.empty() && std::isspace(static_cast<unsigned char>(s.back()))) s.remove_suffix(1);
+    return s;
+}
+
+/**
+ * @brief Whether a line is a "#" comment rather than a job
+ *
+ * CSV jobs start with "#" too, so a line is a job only if it has a comma
+ * and its first field is a hex color of 3, 6 or 8 digits.
+ */
+bool isComment(std::string_view line) {
+    if (line.empty() || line.front() != '#') {
+        return false;
+    }
+    const size_t comma = line.find(',');
+    if (comma == std::string_view::npos) {
+        return true;
+    }
+    const std::string_view digits = trim(line.substr(1, comma - 1));
+    if (digits.size() != 3 && digits.size() != 6 && digits.size() != 8) {
+        return true;
+    }
+    return !std::all_of(digits.begin(), digits.end(),
+                        [](char c) { return std::isxdigit(static_cast<unsigned char>(c)) != 0; });
+}
+
+/**
+ * @brief Split a CSV line; fields may be wrapped in double quotes
+ */
+std::vector<std::string_view> splitCSV(std::string_view line) {
+    std::vector<std::string_view> fields;
+    size_t pos = 0;
+    while (pos <= line.size()) {
+        std::string_view rest = line.substr(pos);
+        size_t lead = 0;
+        while (lead < rest.size() && (rest[lead] == ' ' || rest[lead] == '\t')) ++lead;
+
+        if (lead < rest.size() && rest[lead] == '"') {
+            size_t close = rest.find('"', lead + 1);
+            if (close == std::string_view::npos) {
+                throw std::invalid_argument("Unterminated quoted field");
+            }
+            fields.push_back(rest.substr(lead + 1, close - lead - 1));
+            size_t comma = rest.find(',', close);
+            if (comma == std::string_view::npos) break;
+            pos += comma + 1;
+        } else {
+            size_t comma = rest.find(',');
+            fields.push_back(trim(rest.substr(0, comma)));
+            if (comma == std::string_view::npos) break;
+            pos += comma + 1;
+        }
+    }
+    return fields;
+}
+
+/**
+ * @brief Minimal parser for one flat JSON object per line
+ *
+ * Values may be strings, numbers, booleans or null; they are returned
+ * in their text form. Nested objects and arrays are rejected.
+ */
+class FlatJSONParser {
+public:
+    explicit FlatJSONParser(std::string_view text) : text_(text) {}
+
+    std::map<std::string, std::string> parse() {
+        std::map<std::string, std::string> fields;
+        expect('{');
+        skipSpace();
+        if (peek() == '}') {
+            ++pos_;
+            return fields;
+        }
+        for (;;) {
+            skipSpace();
+            std::string key = parseString();
+            expect(':');
+            skipSpace();
+            fields[key] = peek() == '"' ? parseString() : parseScalar();
+            skipSpace();
+            if (peek() == ',') {
+                ++pos_;
+                continue;
+            }
+            expect('}');
+            break;
+        }
+        skipSpace();
+        if (pos_ != text_.size()) {
+            throw std::invalid_argument("Trailing characters after JSON object");
+        }
+        return fields;
+    }
+
+private:
+    std::string_view text_;
+    size_t pos_ = 0;
+
+    char peek() const { return pos_ < text_.size() ? text_[pos_] : '\0'; }
+
+    void skipSpace() {
+        while (pos_ < text_.size() && std::isspace(static_cast<unsigned char>(text_[pos_]))) ++pos_;
+    }
+
+    void expect(char c) {
+        skipSpace();
+        if (peek() != c) {
+            throw std::invalid_argument(std::string("Malformed JSON: expected '") + c + "'");
+        }
+        ++pos_;
+    }
+
+    std::string parseString() {
+        expect('"');
+        std::string out;
+        while (pos_ < text_.size() && text_[pos_] != '"') {
+            char c = text_[pos_++];
+            if (c != '\\') {
+                out += c;
+                continue;
+            }
+            if (pos_ >= text_.size()) break;
+            char e = text_[pos_++];
+            switch (e) {
+                case '"': case '\\': case '/': out += e; break;
+                case 'b': out += '\b'; break;
+                case 'f': out += '\f'; break;
+                case 'n': out += '\n'; break;
+                case 'r': out += '\r'; break;
+                case 't': out += '\t'; break;
+                case 'u': {
+                    if (pos_ + 4 > text_.size()) {
+                        throw std::invalid_argument("Malformed JSON: bad \\u escape");
+                    }
+                    unsigned long code = std::stoul(std::string(text_.substr(pos_, 4)), nullptr, 16);
+                    pos_ += 4;
+                    if (code >= 0x80) {
+                        throw std::invalid_argument("Malformed JSON: only ASCII \\u escapes are supported");
+                    }
+                    out += static_cast<char>(code);
+                    break;
+                }
+                default:
+                    throw std::invalid_argument("Malformed JSON: bad escape");
+            }
+        }
+        expect('"');
+        return out;
+    }
+
+    std::string parseScalar() {
+        size_t start = pos_;
+        while (pos_ < text_.size() && text_[pos_] != ',' && text_[pos_] != '}' &&
+               !std::isspace(static_cast<unsigned char>(text_[pos_]))) {
+            if (text_[pos_] == '{' || text_[pos_] == '[') {
+                throw std::invalid_argument("Malformed JSON: nested values are not supported");
+            }
+            ++pos_;
+        }
+        if (start == pos_) {
+            throw std::invalid_argument("Malformed JSON: missing value");
+        }
+        return std::string(text_.substr(start, pos_ - start));
+    }
+};
+
+int parseQuality(const std::string& text) {
+    size_t used = 0;
+    int quality = std::stoi(text, &used);
+    if (used != text.size()) {
+        throw std::invalid_argument("Invalid quality: " + text);
+    }
+    return quality < 0 ? 0 : quality > 100 ? 100 : quality;
+}
+
+} // namespace
+
+BatchProcessor::BatchProcessor(const BatchDefaults& defaults, size_t threads, ImageCache* cache)
+    : defaults_(defaults), threads_(threads), cache_(cache) {}
+
+ImageJob BatchProcessor::parseLine(std::string_view line, const BatchDefaults& defaults) {
+    std::string color;
+    std::string resolution;
+    std::string output;
+    std::string quality;
+    std::string format = defaults.format;
+    std::string width;
+    std::string height;
+
+    line = trim(line);
+    if (!line.empty() && line.front() == '{') {
+        std::map<std::string, std::string> fields = FlatJSONParser(line).parse();
+        for (auto& [key, value] : fields) {
+            if (key == "color") color = value;
+            else if (key == "resolution") resolution = value;
+            else if (key == "output") output = value;
+            else if (key == "quality") quality = value;
+            else if (key == "format") format = value;
+            else if (key == "width") width = value;
+            else if (key == "height") height = value;
+            else throw std::invalid_argument("Unknown field: " + key);
+        }
+        if (resolution.empty() && (!width.empty() || !height.empty())) {
+            resolution = width + "x" + height;
+        }
+    } else {
+        std::vector<std::string_view> fields = splitCSV(line);
+        if (fields.size() < 3 || fields.size() > 4) {
+            throw std::invalid_argument("Expected color,resolution,output[,quality]");
+        }
+        color = std::string(fields[0]);
+        resolution = std::string(fields[1]);
+        output = std::string(fields[2]);
+        if (fields.size() == 4) quality = std::string(fields[3]);
+    }
+
+    if (color.empty()) {
+        throw std::invalid_argument("Missing color");
+    }
+    if (output.empty()) {
+        throw std::invalid_argument("Missing output");
+    }
+
+    std::string extension = format.empty()
+        ? std::filesystem::path(output).extension().string()
+        : "." + format;
+    if (extension.empty()) {
+        throw std::invalid_argument("Cannot determine output format for: " + output);
+    }
+
+    return ImageJob{
+        Color(color),
+        resolution.empty() ? defaults.resolution : Resolution::parse(resolution),
+        ImageWriter::getFormatFromExtension(extension),
+        quality.empty() ? defaults.quality : parseQuality(quality),
+        output
+    };
+}
+
+BatchSummary BatchProcessor::run(const std::string& manifest, std::ostream& errors) {
+    const auto start = std::chrono::steady_clock::now();
+
+    // Files are mapped and parsed in place; a pipe has to be read into memory
+    std::unique_ptr<MappedFile> mapping;
+    std::string stdinText;
+    std::string_view text;
+    if (manifest == "-") {
+        stdinText.assign(std::istreambuf_iterator<char>(std::cin), std::istreambuf_iterator<char>());
+        text = stdinText;
+    } else {
+        mapping = std::make_unique<MappedFile>(manifest);
+        text = std::string_view(reinterpret_cast<const char*>(mapping->data()),
+                                static_cast<size_t>(mapping->size()));
+    }
+
+    // Executors are declared before the pool so they outlive its workers
+    const size_t threads = threads_ ? threads_ : ThreadPool::defaultThreadCount();
+    std::vector<std::unique_ptr<JobExecutor>> executors;
+    for (size_t i = 0; i < threads; ++i) {
+        executors.push_back(std::make_unique<JobExecutor>(cache_));
+    }
+
+    std::atomic<uint64_t> succeeded{0};
+    std::atomic<uint64_t> failed{0};
+    std::atomic<uint64_t> bytesWritten{0};
+    std::atomic<uint64_t> pixels{0};
+    std::mutex errorMutex;
+    ThreadPool pool(threads);
+
+    const BatchDefaults& defaults = defaults_;
+    const std::string label = manifest == "-" ? "<stdin>" : manifest;
+    bool firstLine = true;
+    size_t lineNumber = 0;
+
+    for (size_t pos = 0; pos < text.size();) {
+        const char* begin = text.data() + pos;
+        const void* newline = std::memchr(begin, '\n', text.size() - pos);
+        size_t length = newline ? static_cast<size_t>(static_cast<const char*>(newline) - begin)
+                                : text.size() - pos;
+        std::string_view line = trim(std::string_view(begin, length));
+        pos += length + 1;
+        ++lineNumber;
+
+        if (line.empty() || isComment(line)) {
+            continue;
+        }
+        if (firstLine) {
+            firstLine = false;
+            if (line.front() != '{') {
+                std::string first(trim(line.substr(0, line.find(','))));
+                std::transform(first.begin(), first.end(), first.begin(), ::tolower);
+                if (first == "color" || first == "\"color\"") {
+                    continue;
+                }
+            }
+        }
+
+        pool.submit([&, line, lineNumber](size_t worker) {
+            try {
+                ImageJob job = parseLine(line, defaults);
+                uint64_t bytes = executors[worker]->run(job);
+                bytesWritten += bytes;
+                pixels += job.resolution.getPixelCount();
+                ++succeeded;
+            } catch (const std::exception& e) {
+                ++failed;
+                std::lock_guard<std::mutex> lock(errorMutex);
+                errors << label << ":" << lineNumber << ": " << e.what() << "\n";
+            }
+        });
+    }
+    pool.wait();
+
+    BatchSummary summary;
+    summary.succeeded = succeeded;
+    summary.failed = failed;
+    summary.bytesWritten = bytesWritten;
+    summary.pixels = pixels;
+    summary.seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    return summary;
+}
+
+void BatchProcessor::printSummary(const BatchSummary& summary, std::ostream& out) {
+    const double seconds = summary.seconds > 0.0 ? summary.seconds : 1e-9;
+    out << std::fixed << std::setprecision(3)
+        << "Batch complete: " << summary.succeeded << " images written, "
+        << summary.failed << " failed in " << summary.seconds << " s\n"
+        << std::setprecision(1)
+        << "Throughput: " << summary.succeeded / seconds << " images/s, "
+        << summary.bytesWritten / seconds / 1e6 << " MB/s, "
+        << summary.pixels / seconds / 1e6 << " Mpx/s\n";
+}
+
+} // namespace ColorGenerator
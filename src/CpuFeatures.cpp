@@ -0,0 +1,88 @@
+#include "../include/CpuFeatures.hpp"
+#include <cstdint>
+#include <cstdlib>
+#include <string>
+
+#if defined(_MSC_VER) && defined(COLORGEN_X86)
+    #include <intrin.h>
+#elif defined(COLORGEN_X86)
+    #include <cpuid.h>
+#endif
+
+namespace ColorGenerator {
+
+namespace {
+
+#ifdef COLORGEN_X86
+
+void cpuid(uint32_t leaf, uint32_t subleaf, uint32_t regs[4]) {
+#ifdef _MSC_VER
+    int out[4];
+    __cpuidex(out, static_cast<int>(leaf), static_cast<int>(subleaf));
+    for (int i = 0; i < 4; ++i) regs[i] = static_cast<uint32_t>(out[i]);
+#else
+    __cpuid_count(leaf, subleaf, regs[0], regs[1], regs[2], regs[3]);
+#endif
+}
+
+uint64_t xgetbv() {
+#ifdef _MSC_VER
+    return _xgetbv(0);
+#else
+    uint32_t low, high;
+    __asm__ volatile("xgetbv" : "=a"(low), "=d"(high) : "c"(0));
+    return static_cast<uint64_t>(high) << 32 | low;
+#endif
+}
+
+#endif
+
+CpuFeatures detect() {
+    CpuFeatures features;
+#ifdef COLORGEN_X86
+    uint32_t regs[4];
+    cpuid(0, 0, regs);
+    const uint32_t maxLeaf = regs[0];
+
+    cpuid(1, 0, regs);
+    features.sse2 = (regs[3] >> 26) & 1;
+    features.ssse3 = (regs[2] >> 9) & 1;
+    features.sse41 = (regs[2] >> 19) & 1;
+    features.pclmul = (regs[2] >> 1) & 1;
+
+    // AVX state must be enabled by the OS (OSXSAVE, then XCR0 bits)
+    const bool osxsave = (regs[2] >> 27) & 1;
+    const uint64_t xcr0 = osxsave ? xgetbv() : 0;
+    const bool ymmState = (xcr0 & 0x6) == 0x6;
+    const bool zmmState = (xcr0 & 0xE6) == 0xE6;
+
+    if (maxLeaf >= 7) {
+        cpuid(7, 0, regs);
+        features.avx2 = ymmState && ((regs[1] >> 5) & 1);
+        features.avx512 = zmmState && ((regs[1] >> 16) & 1) && ((regs[1] >> 30) & 1);
+    }
+#endif
+
+    // Optional cap for testing and benchmarking
+    if (const char* cap = std::getenv("COLORGEN_SIMD")) {
+        const std::string level(cap);
+        if (level == "scalar") {
+            features = CpuFeatures();
+        } else if (level == "sse2") {
+            features.ssse3 = features.sse41 = features.pclmul = false;
+            features.avx2 = features.avx512 = false;
+        } else if (level == "avx2") {
+            features.avx512 = false;
+        }
+    }
+    return features;
+}
+
+} // namespace
+
+const CpuFeatures& CpuFeatures::get() {
+    static const CpuFeatures features = detect();
+    return features;
+}
+
+} // namespace ColorGenerator
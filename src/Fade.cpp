@@ -0,0 +1,41 @@
+#include "../include/Fade.hpp"
+#include <cmath>
+#include <stdexcept>
+
+namespace ColorGenerator {
+
+Fade::Fade(std::vector<GradientStop> stops, uint32_t frames)
+    : stops_(std::move(stops)), frames_(frames) {
+    if (stops_.size() < 2) {
+        throw std::invalid_argument("A fade needs at least two colors");
+    }
+    if (frames_ == 0) {
+        throw std::invalid_argument("Frame count must be at least 1");
+    }
+}
+
+Color Fade::color(uint32_t index) const {
+    const float t = frames_ > 1 ? static_cast<float>(index) / static_cast<float>(frames_ - 1) : 0.0f;
+    if (t <= stops_.front().position) {
+        return stops_.front().color;
+    }
+    for (size_t i = 1; i < stops_.size(); ++i) {
+        const GradientStop& a = stops_[i - 1];
+        const GradientStop& b = stops_[i];
+        if (t > b.position) {
+            continue;
+        }
+        const float span = b.position - a.position;
+        const float u = span > 0.0f ? (t - a.position) / span : 1.0f;
+        auto mix = [u](uint8_t from, uint8_t to) {
+            return static_cast<uint8_t>(std::lround(from + (to - from) * u));
+        };
+        return Color(mix(a.color.getRed(), b.color.getRed()),
+                     mix(a.color.getGreen(), b.color.getGreen()),
+                     mix(a.color.getBlue(), b.color.getBlue()),
+                     mix(a.color.getAlpha(), b.color.getAlpha()));
+    }
+    return stops_.back().color;
+}
+
+} // namespace ColorGenerator
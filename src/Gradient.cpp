@@ -0,0 +1,774 @@
+#include "../include/Gradient.hpp"
+#include "../include/CpuFeatures.hpp"
+#include "../include/ThreadPool.hpp"
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <cstring>
+#include <stdexcept>
+
+#ifdef COLORGEN_X86
+    #include <immintrin.h>
+#endif
+
+namespace ColorGenerator {
+
+namespace {
+
+constexpr float PI = 3.14159265358979f;
+constexpr float HALF_PI = 1.57079632679490f;
+constexpr float INV_TWO_PI = 0.159154943091895f;
+constexpr float MAX_INDEX = static_cast<float>(Gradient::RAMP_SIZE - 1);
+
+// Pixels whose indices are computed before the ramp lookup pass
+constexpr uint32_t CHUNK = 256;
+
+// Threshold tiles repeat every THRESHOLD_PERIOD pixels
+constexpr int THRESHOLD_PERIOD = 64;
+
+// Smallest band of rows() worth handing to another thread. Streaming
+// encoders ask for about 1 MiB at a time, well below
+// PixelFill::MIN_BYTES_PER_THREAD, and a gradient row costs far more to
+// draw than to fill.
+constexpr uint64_t MIN_ROW_BYTES_PER_THREAD = 256 << 10;
+
+// Linear light -> sRGB table resolution
+constexpr int ENCODE_STEPS = 4096;
+
+// Minimax odd polynomial for atan on [0, 1], max error about 1e-5 rad
+constexpr float ATAN_C0 = 0.99997726f;
+constexpr float ATAN_C1 = -0.33262347f;
+constexpr float ATAN_C2 = 0.19354346f;
+constexpr float ATAN_C3 = -0.11643287f;
+constexpr float ATAN_C4 = 0.05265332f;
+constexpr float ATAN_C5 = -0.01172120f;
+
+// Smallest divisor for the atan ratio, so the center pixel gives 0 / tiny
+constexpr float TINY = 1e-30f;
+
+/**
+ * @brief Per-row constants of one shape; see Gradient::indices
+ */
+struct RowParams {
+    GradientShape shape;
+    float scale;    ///< Ramp indices per unit of the shape's distance
+    float base;     ///< Linear: row offset; conic: start offset in turns (+2)
+    float centerX;
+    float rowTerm;  ///< Radial: dy squared; conic: dy
+};
+
+using IndexKernel = void (*)(const RowParams& params, uint32_t x, uint32_t count, int32_t* out);
+
+const std::array<float, 256>& srgbToLinear() {
+    static const std::array<float, 256> table = [] {
+        std::array<float, 256> t{};
+        for (int i = 0; i < 256; ++i) {
+            const double c = i / 255.0;
+            t[i] = static_cast<float>(c <= 0.04045 ? c / 12.92 : std::pow((c + 0.055) / 1.055, 2.4));
+        }
+        return t;
+    }();
+    return table;
+}
+
+/**
+ * @brief Linear light in [0, 1] to sRGB in [0, 255], interpolating a table
+ */
+float linearToSrgb(float linear) {
+    static const std::array<float, ENCODE_STEPS + 1> table = [] {
+        std::array<float, ENCODE_STEPS + 1> t{};
+        for (int i = 0; i <= ENCODE_STEPS; ++i) {
+            const double l = static_cast<double>(i) / ENCODE_STEPS;
+            t[i] = static_cast<float>(255.0 * (l <= 0.0031308 ? l * 12.92
+                                                               : 1.055 * std::pow(l, 1.0 / 2.4) - 0.055));
+        }
+        return t;
+    }();
+    const float f = std::min(std::max(linear, 0.0f), 1.0f) * ENCODE_STEPS;
+    const int i = std::min(static_cast<int>(f), ENCODE_STEPS - 1);
+    return table[i] + (table[i + 1] - table[i]) * (f - static_cast<float>(i));
+}
+
+/**
+ * @brief 16x16 Bayer matrix, values 0-255
+ */
+uint8_t bayer(uint32_t x, uint32_t y) {
+    uint32_t value = 0;
+    for (int bit = 0; bit < 4; ++bit) {
+        const uint32_t xb = (x >> bit) & 1;
+        const uint32_t yb = (y >> bit) & 1;
+        value |= ((xb ^ yb) << (2 * (3 - bit) + 1)) | (yb << (2 * (3 - bit)));
+    }
+    return static_cast<uint8_t>(value);
+}
+
+/**
+ * @brief 64x64 blue-noise threshold tile, values 0-255
+ *
+ * Built once with Ulichney's void-and-cluster method on a torus: a
+ * relaxed 10% seed pattern is ranked by removing its tightest clusters,
+ * then the remaining pixels are ranked by filling the largest voids.
+ * (The last half is also filled by voids rather than by clusters of the
+ * inverted pattern, which makes no visible difference for dithering.)
+ */
+const std::array<uint8_t, THRESHOLD_PERIOD * THRESHOLD_PERIOD>& blueNoise() {
+    static const std::array<uint8_t, THRESHOLD_PERIOD * THRESHOLD_PERIOD> tile = [] {
+        constexpr int N = THRESHOLD_PERIOD;
+        constexpr int COUNT = N * N;
+        constexpr int R = 6;
+        constexpr float SIGMA = 1.5f;
+
+        float kernel[2 * R + 1][2 * R + 1];
+        for (int dy = -R; dy <= R; ++dy) {
+            for (int dx = -R; dx <= R; ++dx) {
+                kernel[dy + R][dx + R] = std::exp(-static_cast<float>(dx * dx + dy * dy) / (2 * SIGMA * SIGMA));
+            }
+        }
+
+        std::vector<uint8_t> pattern(COUNT, 0);
+        std::vector<float> energy(COUNT, 0.0f);
+        auto splat = [&](std::vector<float>& field, int p, float sign) {
+            const int px = p % N;
+            const int py = p / N;
+            for (int dy = -R; dy <= R; ++dy) {
+                const int row = ((py + dy) & (N - 1)) * N;
+                for (int dx = -R; dx <= R; ++dx) {
+                    field[row + ((px + dx) & (N - 1))] += sign * kernel[dy + R][dx + R];
+                }
+            }
+        };
+        auto extreme = [&](const std::vector<uint8_t>& bits, const std::vector<float>& field, uint8_t state,
+                           bool largest) {
+            int best = -1;
+            for (int i = 0; i < COUNT; ++i) {
+                if (bits[i] == state &&
+                    (best < 0 || (largest ? field[i] > field[best] : field[i] < field[best]))) {
+                    best = i;
+                }
+            }
+            return best;
+        };
+
+        // Deterministic seed pattern
+        const int ones = COUNT / 10;
+        uint32_t state = 0x9E3779B9u;
+        for (int placed = 0; placed < ones;) {
+            state ^= state << 13;
+            state ^= state >> 17;
+            state ^= state << 5;
+            const int p = static_cast<int>(state % COUNT);
+            if (!pattern[p]) {
+                pattern[p] = 1;
+                splat(energy, p, 1.0f);
+                ++placed;
+            }
+        }
+
+        // Move the tightest cluster to the largest void until stable
+        for (int iteration = 0; iteration < COUNT; ++iteration) {
+            const int cluster = extreme(pattern, energy, 1, true);
+            pattern[cluster] = 0;
+            splat(energy, cluster, -1.0f);
+            const int hole = extreme(pattern, energy, 0, false);
+            pattern[hole] = 1;
+            splat(energy, hole, 1.0f);
+            if (hole == cluster) {
+                break;
+            }
+        }
+
+        std::vector<uint16_t> rank(COUNT);
+        std::vector<uint8_t> bits = pattern;
+        std::vector<float> field = energy;
+        for (int r = ones - 1; r >= 0; --r) {
+            const int cluster = extreme(bits, field, 1, true);
+            bits[cluster] = 0;
+            splat(field, cluster, -1.0f);
+            rank[cluster] = static_cast<uint16_t>(r);
+        }
+        for (int r = ones; r < COUNT; ++r) {
+            const int hole = extreme(pattern, energy, 0, false);
+            pattern[hole] = 1;
+            splat(energy, hole, 1.0f);
+            rank[hole] = static_cast<uint16_t>(r);
+        }
+
+        std::array<uint8_t, COUNT> t{};
+        for (int i = 0; i < COUNT; ++i) {
+            t[i] = static_cast<uint8_t>(rank[i] * 256 / COUNT);
+        }
+        return t;
+    }();
+    return tile;
+}
+
+float atanTurns(float dx, float dy) {
+    const float ax = std::fabs(dx);
+    const float ay = std::fabs(dy);
+    const float z = std::min(ax, ay) / std::max(std::max(ax, ay), TINY);
+    const float z2 = z * z;
+    float p = ATAN_C5;
+    p = p * z2 + ATAN_C4;
+    p = p * z2 + ATAN_C3;
+    p = p * z2 + ATAN_C2;
+    p = p * z2 + ATAN_C1;
+    p = p * z2 + ATAN_C0;
+    float r = p * z;
+    if (ay > ax) r = HALF_PI - r;
+    if (dx < 0.0f) r = PI - r;
+    if (dy < 0.0f) r = -r;
+    return r * INV_TWO_PI;
+}
+
+int32_t toIndex(float v) {
+    v = std::min(std::max(v, 0.0f), MAX_INDEX);
+    return static_cast<int32_t>(v + 0.5f);
+}
+
+void indicesScalar(const RowParams& params, uint32_t x, uint32_t count, int32_t* out) {
+    for (uint32_t i = 0; i < count; ++i) {
+        const float fx = static_cast<float>(static_cast<int32_t>(x + i)) + 0.5f;
+        float v;
+        switch (params.shape) {
+            case GradientShape::Linear:
+                v = fx * params.scale + params.base;
+                break;
+            case GradientShape::Radial: {
+                const float dx = fx - params.centerX;
+                v = std::sqrt(dx * dx + params.rowTerm) * params.scale;
+                break;
+            }
+            default: {
+                float a = atanTurns(fx - params.centerX, params.rowTerm) + params.base;
+                a = a - static_cast<float>(static_cast<int32_t>(a));
+                v = a * params.scale;
+                break;
+            }
+        }
+        out[i] = toIndex(v);
+    }
+}
+
+#ifdef COLORGEN_X86
+
+COLORGEN_TARGET("sse2") __m128 selectSSE2(__m128 mask, __m128 a, __m128 b) {
+    return _mm_or_ps(_mm_and_ps(mask, a), _mm_andnot_ps(mask, b));
+}
+
+COLORGEN_TARGET("sse2") __m128 atanTurnsSSE2(__m128 dx, __m128 dy) {
+    const __m128 absMask = _mm_castsi128_ps(_mm_set1_epi32(0x7FFFFFFF));
+    const __m128 zero = _mm_setzero_ps();
+    const __m128 ax = _mm_and_ps(dx, absMask);
+    const __m128 ay = _mm_and_ps(dy, absMask);
+    const __m128 z = _mm_div_ps(_mm_min_ps(ax, ay), _mm_max_ps(_mm_max_ps(ax, ay), _mm_set1_ps(TINY)));
+    const __m128 z2 = _mm_mul_ps(z, z);
+    __m128 p = _mm_set1_ps(ATAN_C5);
+    p = _mm_add_ps(_mm_mul_ps(p, z2), _mm_set1_ps(ATAN_C4));
+    p = _mm_add_ps(_mm_mul_ps(p, z2), _mm_set1_ps(ATAN_C3));
+    p = _mm_add_ps(_mm_mul_ps(p, z2), _mm_set1_ps(ATAN_C2));
+    p = _mm_add_ps(_mm_mul_ps(p, z2), _mm_set1_ps(ATAN_C1));
+    p = _mm_add_ps(_mm_mul_ps(p, z2), _mm_set1_ps(ATAN_C0));
+    __m128 r = _mm_mul_ps(p, z);
+    r = selectSSE2(_mm_cmpgt_ps(ay, ax), _mm_sub_ps(_mm_set1_ps(HALF_PI), r), r);
+    r = selectSSE2(_mm_cmplt_ps(dx, zero), _mm_sub_ps(_mm_set1_ps(PI), r), r);
+    r = selectSSE2(_mm_cmplt_ps(dy, zero), _mm_sub_ps(zero, r), r);
+    return _mm_mul_ps(r, _mm_set1_ps(INV_TWO_PI));
+}
+
+COLORGEN_TARGET("sse2") void indicesSSE2(const RowParams& params, uint32_t x, uint32_t count, int32_t* out) {
+    const __m128 half = _mm_set1_ps(0.5f);
+    const __m128 scale = _mm_set1_ps(params.scale);
+    const __m128 base = _mm_set1_ps(params.base);
+    const __m128 centerX = _mm_set1_ps(params.centerX);
+    const __m128 rowTerm = _mm_set1_ps(params.rowTerm);
+    const __m128 maxIndex = _mm_set1_ps(MAX_INDEX);
+    __m128i xi = _mm_add_epi32(_mm_set1_epi32(static_cast<int32_t>(x)), _mm_setr_epi32(0, 1, 2, 3));
+
+    uint32_t i = 0;
+    for (; i + 4 <= count; i += 4) {
+        const __m128 fx = _mm_add_ps(_mm_cvtepi32_ps(xi), half);
+        __m128 v;
+        switch (params.shape) {
+            case GradientShape::Linear:
+                v = _mm_add_ps(_mm_mul_ps(fx, scale), base);
+                break;
+            case GradientShape::Radial: {
+                const __m128 dx = _mm_sub_ps(fx, centerX);
+                v = _mm_mul_ps(_mm_sqrt_ps(_mm_add_ps(_mm_mul_ps(dx, dx), rowTerm)), scale);
+                break;
+            }
+            default: {
+                __m128 a = _mm_add_ps(atanTurnsSSE2(_mm_sub_ps(fx, centerX), rowTerm), base);
+                a = _mm_sub_ps(a, _mm_cvtepi32_ps(_mm_cvttps_epi32(a)));
+                v = _mm_mul_ps(a, scale);
+                break;
+            }
+        }
+        v = _mm_min_ps(_mm_max_ps(v, _mm_setzero_ps()), maxIndex);
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(out + i), _mm_cvttps_epi32(_mm_add_ps(v, half)));
+        xi = _mm_add_epi32(xi, _mm_set1_epi32(4));
+    }
+    indicesScalar(params, x + i, count - i, out + i);
+}
+
+COLORGEN_TARGET("avx2") __m256 atanTurnsAVX2(__m256 dx, __m256 dy) {
+    const __m256 absMask = _mm256_castsi256_ps(_mm256_set1_epi32(0x7FFFFFFF));
+    const __m256 zero = _mm256_setzero_ps();
+    const __m256 ax = _mm256_and_ps(dx, absMask);
+    const __m256 ay = _mm256_and_ps(dy, absMask);
+    const __m256 z = _mm256_div_ps(_mm256_min_ps(ax, ay),
+                                   _mm256_max_ps(_mm256_max_ps(ax, ay), _mm256_set1_ps(TINY)));
+    const __m256 z2 = _mm256_mul_ps(z, z);
+    __m256 p = _mm256_set1_ps(ATAN_C5);
+    p = _mm256_add_ps(_mm256_mul_ps(p, z2), _mm256_set1_ps(ATAN_C4));
+    p = _mm256_add_ps(_mm256_mul_ps(p, z2), _mm256_set1_ps(ATAN_C3));
+    p = _mm256_add_ps(_mm256_mul_ps(p, z2), _mm256_set1_ps(ATAN_C2));
+    p = _mm256_add_ps(_mm256_mul_ps(p, z2), _mm256_set1_ps(ATAN_C1));
+    p = _mm256_add_ps(_mm256_mul_ps(p, z2), _mm256_set1_ps(ATAN_C0));
+    __m256 r = _mm256_mul_ps(p, z);
+    r = _mm256_blendv_ps(r, _mm256_sub_ps(_mm256_set1_ps(HALF_PI), r), _mm256_cmp_ps(ay, ax, _CMP_GT_OQ));
+    r = _mm256_blendv_ps(r, _mm256_sub_ps(_mm256_set1_ps(PI), r), _mm256_cmp_ps(dx, zero, _CMP_LT_OQ));
+    r = _mm256_blendv_ps(r, _mm256_sub_ps(zero, r), _mm256_cmp_ps(dy, zero, _CMP_LT_OQ));
+    return _mm256_mul_ps(r, _mm256_set1_ps(INV_TWO_PI));
+}
+
+COLORGEN_TARGET("avx2") void indicesAVX2(const RowParams& params, uint32_t x, uint32_t count, int32_t* out) {
+    const __m256 half = _mm256_set1_ps(0.5f);
+    const __m256 scale = _mm256_set1_ps(params.scale);
+    const __m256 base = _mm256_set1_ps(params.base);
+    const __m256 centerX = _mm256_set1_ps(params.centerX);
+    const __m256 rowTerm = _mm256_set1_ps(params.rowTerm);
+    const __m256 maxIndex = _mm256_set1_ps(MAX_INDEX);
+    __m256i xi = _mm256_add_epi32(_mm256_set1_epi32(static_cast<int32_t>(x)),
+                                  _mm256_setr_epi32(0, 1, 2, 3, 4, 5, 6, 7));
+
+    uint32_t i = 0;
+    for (; i + 8 <= count; i += 8) {
+        const __m256 fx = _mm256_add_ps(_mm256_cvtepi32_ps(xi), half);
+        __m256 v;
+        switch (params.shape) {
+            case GradientShape::Linear:
+                v = _mm256_add_ps(_mm256_mul_ps(fx, scale), base);
+                break;
+            case GradientShape::Radial: {
+                const __m256 dx = _mm256_sub_ps(fx, centerX);
+                v = _mm256_mul_ps(_mm256_sqrt_ps(_mm256_add_ps(_mm256_mul_ps(dx, dx), rowTerm)), scale);
+                break;
+            }
+            default: {
+                __m256 a = _mm256_add_ps(atanTurnsAVX2(_mm256_sub_ps(fx, centerX), rowTerm), base);
+                a = _mm256_sub_ps(a, _mm256_cvtepi32_ps(_mm256_cvttps_epi32(a)));
+                v = _mm256_mul_ps(a, scale);
+                break;
+            }
+        }
+        v = _mm256_min_ps(_mm256_max_ps(v, _mm256_setzero_ps()), maxIndex);
+        _mm256_storeu_si256(reinterpret_cast<__m256i*>(out + i), _mm256_cvttps_epi32(_mm256_add_ps(v, half)));
+        xi = _mm256_add_epi32(xi, _mm256_set1_epi32(8));
+    }
+    // The tail runs SSE code; clear the upper halves to avoid transition stalls
+    _mm256_zeroupper();
+    indicesSSE2(params, x + i, count - i, out + i);
+}
+
+#endif
+
+/**
+ * @brief Look up the ramp and round each channel with the row's thresholds
+ *
+ * @p thresholds holds four copies (one per channel) of each of the
+ * THRESHOLD_PERIOD thresholds of the row. Entries are at most 255 * 256,
+ * so adding a threshold below 256 never carries past 16 bits.
+ */
+template <int Channels>
+void colorizeScalar(const uint16_t* ramp, const int32_t* indices, const uint16_t* thresholds,
+                    uint32_t x, uint32_t count, uint8_t* dst) {
+    for (uint32_t i = 0; i < count; ++i) {
+        const uint16_t* entry = ramp + indices[i] * 4;
+        const uint16_t* threshold = thresholds + ((x + i) & (THRESHOLD_PERIOD - 1)) * 4;
+        for (int c = 0; c < Channels; ++c) {
+            dst[i * Channels + c] = static_cast<uint8_t>((entry[c] + threshold[c]) >> 8);
+        }
+    }
+}
+
+#ifdef COLORGEN_X86
+
+/**
+ * @brief Four pixels per step: two ramp entries per register, packed to bytes
+ *
+ * Chunks start at multiples of THRESHOLD_PERIOD and steps at multiples of
+ * four pixels, so a step never wraps around the threshold row.
+ */
+template <int Channels>
+COLORGEN_TARGET("ssse3") void colorizeSSSE3(const uint16_t* ramp, const int32_t* indices,
+                                            const uint16_t* thresholds, uint32_t x, uint32_t count,
+                                            uint8_t* dst) {
+    // RGBA x4 -> RGB x4 in the low 12 bytes
+    const __m128i dropAlpha = _mm_setr_epi8(0, 1, 2, 4, 5, 6, 8, 9, 10, 12, 13, 14, -1, -1, -1, -1);
+
+    uint32_t i = 0;
+    for (; i + 4 <= count; i += 4) {
+        const __m128i e0 = _mm_unpacklo_epi64(
+            _mm_loadl_epi64(reinterpret_cast<const __m128i*>(ramp + indices[i] * 4)),
+            _mm_loadl_epi64(reinterpret_cast<const __m128i*>(ramp + indices[i + 1] * 4)));
+        const __m128i e1 = _mm_unpacklo_epi64(
+            _mm_loadl_epi64(reinterpret_cast<const __m128i*>(ramp + indices[i + 2] * 4)),
+            _mm_loadl_epi64(reinterpret_cast<const __m128i*>(ramp + indices[i + 3] * 4)));
+        const __m128i* threshold = reinterpret_cast<const __m128i*>(
+            thresholds + ((x + i) & (THRESHOLD_PERIOD - 1)) * 4);
+        const __m128i v0 = _mm_srli_epi16(_mm_add_epi16(e0, _mm_loadu_si128(threshold)), 8);
+        const __m128i v1 = _mm_srli_epi16(_mm_add_epi16(e1, _mm_loadu_si128(threshold + 1)), 8);
+        __m128i bytes = _mm_packus_epi16(v0, v1);
+        if (Channels == 4) {
+            _mm_storeu_si128(reinterpret_cast<__m128i*>(dst + i * 4), bytes);
+        } else {
+            bytes = _mm_shuffle_epi8(bytes, dropAlpha);
+            _mm_storel_epi64(reinterpret_cast<__m128i*>(dst + i * 3), bytes);
+            const int32_t tail = _mm_cvtsi128_si32(_mm_srli_si128(bytes, 8));
+            std::memcpy(dst + i * 3 + 8, &tail, 4);
+        }
+    }
+    colorizeScalar<Channels>(ramp, indices + i, thresholds, x + i, count - i, dst + i * Channels);
+}
+
+/**
+ * @brief Eight pixels per step, the ramp entries fetched with two gathers
+ */
+template <int Channels>
+COLORGEN_TARGET("avx2") void colorizeAVX2(const uint16_t* ramp, const int32_t* indices,
+                                          const uint16_t* thresholds, uint32_t x, uint32_t count,
+                                          uint8_t* dst) {
+    const __m256i dropAlpha = _mm256_setr_epi8(0, 1, 2, 4, 5, 6, 8, 9, 10, 12, 13, 14, -1, -1, -1, -1,
+                                               0, 1, 2, 4, 5, 6, 8, 9, 10, 12, 13, 14, -1, -1, -1, -1);
+    const long long* entries = reinterpret_cast<const long long*>(ramp);
+
+    uint32_t i = 0;
+    for (; i + 8 <= count; i += 8) {
+        const __m256i index = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(indices + i));
+        const __m256i e0 = _mm256_i32gather_epi64(entries, _mm256_castsi256_si128(index), 8);
+        const __m256i e1 = _mm256_i32gather_epi64(entries, _mm256_extracti128_si256(index, 1), 8);
+        const __m256i* threshold = reinterpret_cast<const __m256i*>(
+            thresholds + ((x + i) & (THRESHOLD_PERIOD - 1)) * 4);
+        const __m256i v0 = _mm256_srli_epi16(_mm256_add_epi16(e0, _mm256_loadu_si256(threshold)), 8);
+        const __m256i v1 = _mm256_srli_epi16(_mm256_add_epi16(e1, _mm256_loadu_si256(threshold + 1)), 8);
+        // packus works within 128-bit lanes; restore pixel order 0-3, 4-7
+        __m256i bytes = _mm256_permute4x64_epi64(_mm256_packus_epi16(v0, v1), 0xD8);
+        if (Channels == 4) {
+            _mm256_storeu_si256(reinterpret_cast<__m256i*>(dst + i * 4), bytes);
+        } else {
+            bytes = _mm256_shuffle_epi8(bytes, dropAlpha);
+            const __m128i low = _mm256_castsi256_si128(bytes);
+            const __m128i high = _mm256_extracti128_si256(bytes, 1);
+            _mm_storel_epi64(reinterpret_cast<__m128i*>(dst + i * 3), low);
+            int32_t tail = _mm_cvtsi128_si32(_mm_srli_si128(low, 8));
+            std::memcpy(dst + i * 3 + 8, &tail, 4);
+            _mm_storel_epi64(reinterpret_cast<__m128i*>(dst + i * 3 + 12), high);
+            tail = _mm_cvtsi128_si32(_mm_srli_si128(high, 8));
+            std::memcpy(dst + i * 3 + 20, &tail, 4);
+        }
+    }
+    _mm256_zeroupper();
+    colorizeSSSE3<Channels>(ramp, indices + i, thresholds, x + i, count - i, dst + i * Channels);
+}
+
+#endif
+
+using ColorKernel = void (*)(const uint16_t* ramp, const int32_t* indices, const uint16_t* thresholds,
+                             uint32_t x, uint32_t count, uint8_t* dst);
+
+struct Kernels {
+    IndexKernel indices;
+    ColorKernel colorize3;
+    ColorKernel colorize4;
+};
+
+Kernels selectKernels() {
+#ifdef COLORGEN_X86
+    const CpuFeatures& cpu = CpuFeatures::get();
+    if (cpu.avx2) return {indicesAVX2, colorizeAVX2<3>, colorizeAVX2<4>};
+    if (cpu.ssse3) return {indicesSSE2, colorizeSSSE3<3>, colorizeSSSE3<4>};
+    if (cpu.sse2) return {indicesSSE2, colorizeScalar<3>, colorizeScalar<4>};
+#endif
+    return {indicesScalar, colorizeScalar<3>, colorizeScalar<4>};
+}
+
+const Kernels& kernels() {
+    static const Kernels selected = selectKernels();
+    return selected;
+}
+
+float parsePosition(const std::string& text) {
+    size_t used = 0;
+    float value;
+    try {
+        value = std::stof(text, &used);
+    } catch (const std::exception&) {
+        throw std::invalid_argument("Invalid gradient stop position: " + text);
+    }
+    if (used + 1 == text.size() && text[used] == '%') {
+        value /= 100.0f;
+    } else if (used != text.size()) {
+        throw std::invalid_argument("Invalid gradient stop position: " + text);
+    }
+    if (!(value >= 0.0f && value <= 1.0f)) {
+        throw std::invalid_argument("Gradient stop position must be within 0-1 (0%-100%): " + text);
+    }
+    return value;
+}
+
+} // namespace
+
+Gradient::Gradient(std::vector<GradientStop> stops, const Resolution& resolution, const Options& options)
+    : width_(resolution.getWidth()), height_(resolution.getHeight()), channels_(3), options_(options) {
+    if (stops.size() < 2) {
+        throw std::invalid_argument("A gradient needs at least two color stops");
+    }
+    for (size_t i = 0; i < stops.size(); ++i) {
+        if (!(stops[i].position >= 0.0f && stops[i].position <= 1.0f) ||
+            (i > 0 && stops[i].position < stops[i - 1].position)) {
+            throw std::invalid_argument("Gradient stop positions must be non-decreasing within 0-1");
+        }
+        if (!stops[i].color.isOpaque()) {
+            channels_ = 4;
+        }
+    }
+    if (!std::isfinite(options.angle) || !std::isfinite(options.centerX) ||
+        !std::isfinite(options.centerY) || !(options.radius >= 0.0f)) {
+        throw std::invalid_argument("Invalid gradient geometry");
+    }
+
+    // Ramp: premultiplied linear-light interpolation, encoded back to sRGB
+    const std::array<float, 256>& toLinear = srgbToLinear();
+    ramp_.resize(RAMP_SIZE * 4);
+    size_t segment = 0;
+    for (int i = 0; i < RAMP_SIZE; ++i) {
+        const float t = static_cast<float>(i) / MAX_INDEX;
+        while (segment + 2 < stops.size() && t > stops[segment + 1].position) {
+            ++segment;
+        }
+        const GradientStop& a = stops[segment];
+        const GradientStop& b = stops[segment + 1];
+        float f = 0.0f;
+        if (b.position > a.position) {
+            f = std::min(std::max((t - a.position) / (b.position - a.position), 0.0f), 1.0f);
+        } else if (t > a.position) {
+            f = 1.0f;
+        }
+
+        const float alphaA = a.color.getAlpha() / 255.0f;
+        const float alphaB = b.color.getAlpha() / 255.0f;
+        const float alpha = alphaA + (alphaB - alphaA) * f;
+        const uint8_t channelsA[3] = {a.color.getRed(), a.color.getGreen(), a.color.getBlue()};
+        const uint8_t channelsB[3] = {b.color.getRed(), b.color.getGreen(), b.color.getBlue()};
+        uint16_t* entry = ramp_.data() + i * 4;
+        for (int c = 0; c < 3; ++c) {
+            const float premultiplied = toLinear[channelsA[c]] * alphaA +
+                                        (toLinear[channelsB[c]] * alphaB - toLinear[channelsA[c]] * alphaA) * f;
+            const float linear = alpha > 0.0f ? premultiplied / alpha : 0.0f;
+            entry[c] = static_cast<uint16_t>(std::min(linearToSrgb(linear) * 256.0f + 0.5f, 255.0f * 256.0f));
+        }
+        entry[3] = static_cast<uint16_t>(std::min(alpha * 255.0f * 256.0f + 0.5f, 255.0f * 256.0f));
+    }
+
+    // Geometry in pixel-center coordinates, scaled to ramp indices
+    const float w = static_cast<float>(width_);
+    const float h = static_cast<float>(height_);
+    const float radians = options.angle * (PI / 180.0f);
+    centerX_ = options.centerX * w;
+    centerY_ = options.centerY * h;
+    switch (options.shape) {
+        case GradientShape::Linear: {
+            const float dx = std::cos(radians);
+            const float dy = std::sin(radians);
+            const float corners[4] = {0.0f, w * dx, h * dy, w * dx + h * dy};
+            const float low = *std::min_element(corners, corners + 4);
+            const float high = *std::max_element(corners, corners + 4);
+            const float scale = MAX_INDEX / std::max(high - low, TINY);
+            scaleX_ = dx * scale;
+            scaleY_ = dy * scale;
+            offset_ = -low * scale;
+            break;
+        }
+        case GradientShape::Radial: {
+            float radius = options.radius;
+            if (radius == 0.0f) {
+                const float fx = std::max(centerX_, w - centerX_);
+                const float fy = std::max(centerY_, h - centerY_);
+                radius = std::sqrt(fx * fx + fy * fy);
+            }
+            scaleX_ = MAX_INDEX / std::max(radius, TINY);
+            break;
+        }
+        case GradientShape::Conic: {
+            const float turns = options.angle / 360.0f;
+            scaleX_ = MAX_INDEX;
+            offset_ = 2.0f - (turns - std::floor(turns));
+            break;
+        }
+    }
+}
+
+void Gradient::indices(uint32_t y, uint32_t x, uint32_t count, int32_t* out) const {
+    const float fy = static_cast<float>(y) + 0.5f;
+    RowParams params{options_.shape, scaleX_, 0.0f, centerX_, 0.0f};
+    switch (options_.shape) {
+        case GradientShape::Linear:
+            params.base = fy * scaleY_ + offset_;
+            break;
+        case GradientShape::Radial:
+            params.rowTerm = (fy - centerY_) * (fy - centerY_);
+            break;
+        case GradientShape::Conic:
+            params.base = offset_;
+            params.rowTerm = fy - centerY_;
+            break;
+    }
+    kernels().indices(params, x, count, out);
+}
+
+void Gradient::renderRow(uint32_t y, uint8_t* dst) const {
+    uint8_t row[THRESHOLD_PERIOD];
+    switch (options_.dither) {
+        case Dither::Ordered:
+            for (int x = 0; x < THRESHOLD_PERIOD; ++x) {
+                row[x] = bayer(static_cast<uint32_t>(x), y);
+            }
+            break;
+        case Dither::BlueNoise:
+            std::memcpy(row, blueNoise().data() + (y % THRESHOLD_PERIOD) * THRESHOLD_PERIOD, THRESHOLD_PERIOD);
+            break;
+        default:
+            // No dithering: a threshold of one half rounds to nearest
+            std::memset(row, 128, sizeof(row));
+            break;
+    }
+    alignas(32) uint16_t thresholds[THRESHOLD_PERIOD * 4];
+    for (int x = 0; x < THRESHOLD_PERIOD * 4; ++x) {
+        thresholds[x] = row[x / 4];
+    }
+
+    const ColorKernel colorize = channels_ == 4 ? kernels().colorize4 : kernels().colorize3;
+    int32_t index[CHUNK];
+    for (uint32_t x = 0; x < width_; x += CHUNK) {
+        const uint32_t count = std::min(CHUNK, width_ - x);
+        indices(y, x, count, index);
+        colorize(ramp_.data(), index, thresholds, x, count, dst + static_cast<size_t>(x) * channels_);
+    }
+}
+
+void Gradient::renderRows(uint32_t y, uint32_t count, uint8_t* dst) const {
+    const size_t stride = static_cast<size_t>(rowBytes());
+    for (uint32_t i = 0; i < count; ++i) {
+        renderRow(y + i, dst + i * stride);
+    }
+}
+
+const uint8_t* Gradient::rows(uint32_t y, uint32_t count, uint8_t* scratch) const {
+    const size_t stride = static_cast<size_t>(rowBytes());
+    const uint64_t bytes = static_cast<uint64_t>(stride) * count;
+    const size_t threads = static_cast<size_t>(std::min<uint64_t>(
+        {ThreadPool::availableThreads(), bytes / MIN_ROW_BYTES_PER_THREAD, count}));
+    if (threads <= 1) {
+        renderRows(y, count, scratch);
+        return scratch;
+    }
+
+    const uint32_t band = static_cast<uint32_t>((count + threads - 1) / threads);
+    const size_t bands = (count + band - 1) / band;
+    ThreadPool::parallelFor(bands, bands, [&](size_t i, size_t) {
+        const uint32_t first = static_cast<uint32_t>(i) * band;
+        renderRows(y + first, std::min(band, count - first), scratch + first * stride);
+    });
+    return scratch;
+}
+
+void Gradient::fill(PixelBuffer& buffer, size_t threads) const {
+    const size_t stride = static_cast<size_t>(rowBytes());
+    const uint64_t bytes = static_cast<uint64_t>(stride) * height_;
+    buffer.allocate(static_cast<size_t>(bytes));
+
+    if (threads == 0) {
+        threads = ThreadPool::availableThreads();
+    }
+    threads = static_cast<size_t>(std::min<uint64_t>({threads, bytes / PixelFill::MIN_BYTES_PER_THREAD,
+                                                      height_}));
+    if (threads <= 1) {
+        renderRows(0, height_, buffer.data());
+        return;
+    }
+
+    // Contiguous row slices, so each page is first touched by the thread that draws it
+    const uint32_t slice = static_cast<uint32_t>((height_ + threads - 1) / threads);
+    const size_t slices = (height_ + slice - 1) / slice;
+    ThreadPool::parallelFor(slices, slices, [&](size_t i, size_t) {
+        const uint32_t y = static_cast<uint32_t>(i) * slice;
+        renderRows(y, std::min(slice, height_ - y), buffer.data() + y * stride);
+    });
+}
+
+std::vector<GradientStop> Gradient::parseStops(const std::string& spec) {
+    std::vector<GradientStop> stops;
+    std::vector<bool> explicitPosition;
+    size_t start = 0;
+    while (start <= spec.size()) {
+        size_t end = spec.find(',', start);
+        if (end == std::string::npos) {
+            end = spec.size();
+        }
+        const std::string item = spec.substr(start, end - start);
+        const size_t at = item.find('@');
+        stops.push_back({Color(item.substr(0, at)), 0.0f});
+        explicitPosition.push_back(at != std::string::npos);
+        if (at != std::string::npos) {
+            stops.back().position = parsePosition(item.substr(at + 1));
+        }
+        start = end + 1;
+    }
+    if (stops.size() < 2) {
+        throw std::invalid_argument("A gradient needs at least two color stops");
+    }
+
+    if (!explicitPosition.front()) {
+        stops.front().position = 0.0f;
+        explicitPosition.front() = true;
+    }
+    if (!explicitPosition.back()) {
+        stops.back().position = 1.0f;
+        explicitPosition.back() = true;
+    }
+    for (size_t i = 1; i < stops.size(); ++i) {
+        stops[i].position = std::max(stops[i].position, stops[i - 1].position);
+        if (explicitPosition[i]) {
+            continue;
+        }
+        // Spread the run of unpositioned stops evenly up to the next positioned one
+        size_t next = i;
+        while (!explicitPosition[next]) {
+            ++next;
+        }
+        const float from = stops[i - 1].position;
+        const float to = std::max(stops[next].position, from);
+        for (size_t j = i; j < next; ++j) {
+            stops[j].position = from + (to - from) * static_cast<float>(j - i + 1) / static_cast<float>(next - i + 1);
+        }
+        i = next - 1;
+    }
+    return stops;
+}
+
+GradientShape Gradient::parseShape(const std::string& name) {
+    if (name == "linear") return GradientShape::Linear;
+    if (name == "radial") return GradientShape::Radial;
+    if (name == "conic") return GradientShape::Conic;
+    throw std::invalid_argument("Unknown gradient type: " + name + " (expected linear, radial or conic)");
+}
+
+Dither Gradient::parseDither(const std::string& name) {
+    if (name == "none") return Dither::None;
+    if (name == "ordered") return Dither::Ordered;
+    if (name == "blue") return Dither::BlueNoise;
+    throw std::invalid_argument("Unknown dither mode: " + name + " (expected none, ordered or blue)");
+}
+
+} // namespace ColorGenerator
@@ -0,0 +1,477 @@
+#include "../include/ImageCache.hpp"
+#include <cerrno>
+#include <cstdio>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <functional>
+#include <iomanip>
+#include <sstream>
+#include <stdexcept>
+#include <thread>
+
+#ifdef _WIN32
+    #include <windows.h>
+    #include <process.h>
+#else
+    #include <fcntl.h>
+    #include <sys/file.h>
+    #include <sys/stat.h>
+    #include <unistd.h>
+    #ifdef __linux__
+        #include <linux/fs.h>
+        #include <sys/ioctl.h>
+    #elif defined(__APPLE__)
+        #include <sys/clonefile.h>
+    #endif
+#endif
+
+namespace fs = std::filesystem;
+
+namespace ColorGenerator {
+
+namespace {
+
+/**
+ * @brief Advisory whole-file lock held for the lifetime of the object
+ */
+class FileLock {
+public:
+    FileLock(const std::string& path, bool exclusive) {
+#ifdef _WIN32
+        handle_ = CreateFileA(path.c_str(), GENERIC_READ | GENERIC_WRITE,
+                              FILE_SHARE_READ | FILE_SHARE_WRITE, NULL, OPEN_ALWAYS,
+                              FILE_ATTRIBUTE_NORMAL, NULL);
+        if (handle_ == INVALID_HANDLE_VALUE) {
+            throw std::runtime_error("Failed to open cache lock: " + path);
+        }
+        OVERLAPPED overlapped = {};
+        if (!LockFileEx(handle_, exclusive ? LOCKFILE_EXCLUSIVE_LOCK : 0, 0, 1, 0, &overlapped)) {
+            CloseHandle(handle_);
+            throw std::runtime_error("Failed to lock cache entry: " + path);
+        }
+#else
+        fd_ = ::open(path.c_str(), O_RDWR | O_CREAT, 0644);
+        if (fd_ < 0) {
+            throw std::runtime_error("Failed to open cache lock: " + path + " (" + std::strerror(errno) + ")");
+        }
+        int rc;
+        do {
+            rc = ::flock(fd_, exclusive ? LOCK_EX : LOCK_SH);
+        } while (rc != 0 && errno == EINTR);
+        if (rc != 0) {
+            int err = errno;
+            ::close(fd_);
+            throw std::runtime_error("Failed to lock cache entry: " + path + " (" + std::strerror(err) + ")");
+        }
+#endif
+    }
+
+    ~FileLock() {
+#ifdef _WIN32
+        OVERLAPPED overlapped = {};
+        UnlockFileEx(handle_, 0, 1, 0, &overlapped);
+        CloseHandle(handle_);
+#else
+        ::flock(fd_, LOCK_UN);
+        ::close(fd_);
+#endif
+    }
+
+    FileLock(const FileLock&) = delete;
+    FileLock& operator=(const FileLock&) = delete;
+
+private:
+#ifdef _WIN32
+    HANDLE handle_;
+#else
+    int fd_;
+#endif
+};
+
+#if defined(__linux__)
+/**
+ * @brief Copy file contents in the kernel, falling back to read/write
+ */
+void copyContents(int in, int out) {
+    bool kernelCopy = true;
+    while (kernelCopy) {
+        ssize_t n = ::copy_file_range(in, nullptr, out, nullptr, 1 << 30, 0);
+        if (n == 0) {
+            return;
+        }
+        if (n < 0) {
+            if (errno == EINTR) continue;
+            if (errno != EXDEV && errno != ENOSYS && errno != EINVAL && errno != EOPNOTSUPP) {
+                throw std::runtime_error(std::string("copy_file_range failed: ") + std::strerror(errno));
+            }
+            kernelCopy = false;
+        }
+    }
+
+    std::vector<char> buffer(1 << 20);
+    for (;;) {
+        ssize_t n = ::read(in, buffer.data(), buffer.size());
+        if (n == 0) return;
+        if (n < 0) {
+            if (errno == EINTR) continue;
+            throw std::runtime_error(std::string("Cache read failed: ") + std::strerror(errno));
+        }
+        for (ssize_t done = 0; done < n;) {
+            ssize_t w = ::write(out, buffer.data() + done, static_cast<size_t>(n - done));
+            if (w < 0) {
+                if (errno == EINTR) continue;
+                throw std::runtime_error(std::string("Cache write failed: ") + std::strerror(errno));
+            }
+            done += w;
+        }
+    }
+}
+#endif
+
+/**
+ * @brief Make @p dst a copy of @p src as cheaply as the platform allows
+ *
+ * Order of preference: reflink (shares extents, copy-on-write), hardlink
+ * (when allowed), in-kernel copy, user-space copy.
+ */
+void cloneFile(const std::string& src, const std::string& dst, bool allowHardlink) {
+#if defined(__linux__)
+    int in = ::open(src.c_str(), O_RDONLY);
+    if (in < 0) {
+        throw std::runtime_error("Failed to open cache entry: " + src + " (" + std::strerror(errno) + ")");
+    }
+    int out = ::open(dst.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644);
+    if (out < 0) {
+        int err = errno;
+        ::close(in);
+        throw std::runtime_error("Failed to open output file: " + dst + " (" + std::strerror(err) + ")");
+    }
+
+    bool done = false;
+#ifdef FICLONE
+    done = ::ioctl(out, FICLONE, in) == 0;
+#endif
+    if (!done && allowHardlink) {
+        ::close(out);
+        out = -1;
+        ::unlink(dst.c_str());
+        done = ::link(src.c_str(), dst.c_str()) == 0;
+        if (!done) {
+            out = ::open(dst.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644);
+        }
+    }
+    try {
+        if (!done) {
+            if (out < 0) {
+                throw std::runtime_error("Failed to open output file: " + dst);
+            }
+            copyContents(in, out);
+        }
+    } catch (...) {
+        ::close(in);
+        if (out >= 0) ::close(out);
+        throw;
+    }
+
+    ::close(in);
+    if (out >= 0 && ::close(out) != 0) {
+        throw std::runtime_error("Failed to write output file: " + dst);
+    }
+#else
+    std::error_code ec;
+    fs::remove(dst, ec);
+#if defined(__APPLE__)
+    if (::clonefile(src.c_str(), dst.c_str(), 0) == 0) {
+        return;
+    }
+#endif
+    if (allowHardlink) {
+        fs::create_hard_link(src, dst, ec);
+        if (!ec) {
+            return;
+        }
+    }
+    fs::copy_file(src, dst, fs::copy_options::overwrite_existing);
+#endif
+}
+
+void writeBytes(const std::string& filename, const std::vector<uint8_t>& bytes) {
+    std::ofstream file(filename, std::ios::binary | std::ios::trunc);
+    file.write(reinterpret_cast<const char*>(bytes.data()), static_cast<std::streamsize>(bytes.size()));
+    if (!file) {
+        throw std::runtime_error("Failed to write image file: " + filename);
+    }
+}
+
+std::string uniqueSuffix() {
+#ifdef _WIN32
+    unsigned long pid = static_cast<unsigned long>(_getpid());
+#else
+    unsigned long pid = static_cast<unsigned long>(::getpid());
+#endif
+    std::ostringstream oss;
+    oss << ".tmp." << pid << "." << std::hash<std::thread::id>{}(std::this_thread::get_id());
+    return oss.str();
+}
+
+std::string formatBytes(uint64_t bytes) {
+    static const char* units[] = {"B", "KiB", "MiB", "GiB", "TiB"};
+    double value = static_cast<double>(bytes);
+    int unit = 0;
+    while (value >= 1024.0 && unit < 4) {
+        value /= 1024.0;
+        ++unit;
+    }
+    std::ostringstream oss;
+    oss << std::fixed << std::setprecision(unit == 0 ? 0 : 1) << value << " " << units[unit];
+    return oss.str();
+}
+
+void printStatsLine(std::ostream& out, const char* label, const CacheStats& stats) {
+    out << "  " << label << std::fixed << std::setprecision(1)
+        << stats.lookups() << " lookups, hit ratio " << stats.hitRatio() * 100.0 << "%"
+        << " (memory " << stats.memoryHits << ", disk " << stats.diskHits
+        << ", miss " << stats.misses << "), saved " << formatBytes(stats.bytesSaved)
+        << ", stored " << formatBytes(stats.bytesStored) << "\n";
+}
+
+CacheStats readStatsFile(const std::string& path) {
+    CacheStats stats;
+    std::ifstream file(path);
+    std::string name;
+    uint64_t value;
+    while (file >> name >> value) {
+        if (name == "memory_hits") stats.memoryHits = value;
+        else if (name == "disk_hits") stats.diskHits = value;
+        else if (name == "misses") stats.misses = value;
+        else if (name == "bytes_saved") stats.bytesSaved = value;
+        else if (name == "bytes_stored") stats.bytesStored = value;
+    }
+    return stats;
+}
+
+} // namespace
+
+std::string CacheKey::canonical() const {
+    std::ostringstream oss;
+    oss << "v1 " << ImageWriter::getFormatName(format)
+        << " " << color.toHex(true)
+        << " " << resolution.toString()
+        << " q" << (format == FormatType::JPEG ? quality : 0);
+    return oss.str();
+}
+
+std::string CacheKey::digest() const {
+    uint64_t hash = 0xcbf29ce484222325ull;
+    for (unsigned char c : canonical()) {
+        hash ^= c;
+        hash *= 0x100000001b3ull;
+    }
+    std::ostringstream oss;
+    oss << std::hex << std::setfill('0') << std::setw(16) << hash;
+    return oss.str();
+}
+
+CacheStats& CacheStats::operator+=(const CacheStats& other) {
+    memoryHits += other.memoryHits;
+    diskHits += other.diskHits;
+    misses += other.misses;
+    bytesSaved += other.bytesSaved;
+    bytesStored += other.bytesStored;
+    return *this;
+}
+
+ImageCache::ImageCache(const std::string& directory, size_t memoryCapacity)
+    : directory_(directory), memoryCapacity_(memoryCapacity) {
+    std::error_code ec;
+    fs::create_directories(directory_, ec);
+    if (ec || !fs::is_directory(directory_)) {
+        throw std::runtime_error("Failed to create cache directory: " + directory_);
+    }
+}
+
+std::string ImageCache::entryPath(const std::string& digest, const std::string& extension) const {
+    fs::path shard = fs::path(directory_) / digest.substr(0, 2);
+    std::error_code ec;
+    fs::create_directories(shard, ec);
+    if (ec) {
+        throw std::runtime_error("Failed to create cache directory: " + shard.string());
+    }
+    return (shard / (digest + extension)).string();
+}
+
+CacheResult ImageCache::write(IImageFormat& writer, const CacheKey& key, const std::string& filename) {
+    const std::string id = key.digest() + writer.getExtension();
+
+    // An earlier hardlinked hit must not be truncated in place, that would corrupt the entry
+    std::error_code linkEc;
+    if (fs::is_regular_file(filename, linkEc) && fs::hard_link_count(filename, linkEc) > 1) {
+        fs::remove(filename, linkEc);
+    }
+
+    if (Bytes bytes = memoryLookup(id)) {
+        writeBytes(filename, *bytes);
+        record(CacheResult::MemoryHit, bytes->size(), 0);
+        return CacheResult::MemoryHit;
+    }
+
+    const std::string path = entryPath(key.digest(), writer.getExtension());
+    // One lock per shard directory rather than per entry, so lock files never pile up
+    const std::string lockPath = (fs::path(path).parent_path() / ".lock").string();
+
+    {
+        FileLock lock(lockPath, false);
+        std::error_code ec;
+        uint64_t size = fs::file_size(path, ec);
+        if (!ec) {
+            cloneFile(path, filename, allowHardlinks_);
+            memoryInsert(id, path);
+            record(CacheResult::DiskHit, size, 0);
+            return CacheResult::DiskHit;
+        }
+    }
+
+    // Exclusive lock: only one process encodes a given key, the rest wait and hit
+    FileLock lock(lockPath, true);
+    std::error_code ec;
+    uint64_t size = fs::file_size(path, ec);
+    if (!ec) {
+        cloneFile(path, filename, allowHardlinks_);
+        memoryInsert(id, path);
+        record(CacheResult::DiskHit, size, 0);
+        return CacheResult::DiskHit;
+    }
+
+    writer.write(filename, key.color, key.resolution);
+
+    const std::string temp = path + uniqueSuffix();
+    try {
+        cloneFile(filename, temp, false);
+        fs::permissions(temp, fs::perms::owner_read | fs::perms::group_read | fs::perms::others_read);
+        fs::rename(temp, path);
+    } catch (...) {
+        fs::remove(temp, ec);
+        throw;
+    }
+
+    size = fs::file_size(path);
+    memoryInsert(id, path);
+    record(CacheResult::Miss, 0, size);
+    return CacheResult::Miss;
+}
+
+ImageCache::Bytes ImageCache::memoryLookup(const std::string& id) {
+    std::lock_guard<std::mutex> guard(mutex_);
+    auto it = index_.find(id);
+    if (it == index_.end()) {
+        return nullptr;
+    }
+    lru_.splice(lru_.begin(), lru_, it->second);
+    return it->second->second;
+}
+
+void ImageCache::memoryInsert(const std::string& id, const std::string& path) {
+    if (memoryCapacity_ == 0) {
+        return;
+    }
+    // Keep single entries small relative to the tier so it holds a useful working set
+    std::error_code ec;
+    uint64_t size = fs::file_size(path, ec);
+    if (ec || size > memoryCapacity_ / 8) {
+        return;
+    }
+
+    auto bytes = std::make_shared<std::vector<uint8_t>>(static_cast<size_t>(size));
+    std::ifstream file(path, std::ios::binary);
+    if (!file.read(reinterpret_cast<char*>(bytes->data()), static_cast<std::streamsize>(size))) {
+        return;
+    }
+
+    std::lock_guard<std::mutex> guard(mutex_);
+    if (index_.count(id)) {
+        return;
+    }
+    lru_.emplace_front(id, bytes);
+    index_[id] = lru_.begin();
+    memoryUsed_ += bytes->size();
+
+    while (memoryUsed_ > memoryCapacity_ && !lru_.empty()) {
+        memoryUsed_ -= lru_.back().second->size();
+        index_.erase(lru_.back().first);
+        lru_.pop_back();
+    }
+}
+
+void ImageCache::record(CacheResult result, uint64_t bytes, uint64_t stored) {
+    CacheStats delta;
+    switch (result) {
+        case CacheResult::MemoryHit: delta.memoryHits = 1; break;
+        case CacheResult::DiskHit:   delta.diskHits = 1; break;
+        case CacheResult::Miss:      delta.misses = 1; break;
+    }
+    delta.bytesSaved = bytes;
+    delta.bytesStored = stored;
+
+    std::lock_guard<std::mutex> guard(mutex_);
+    session_ += delta;
+    unpersisted_ += delta;
+}
+
+CacheStats ImageCache::getSessionStats() const {
+    std::lock_guard<std::mutex> guard(mutex_);
+    return session_;
+}
+
+CacheStats ImageCache::getPersistentStats() const {
+    const std::string path = (fs::path(directory_) / "stats").string();
+    FileLock lock(path + ".lock", false);
+    return readStatsFile(path);
+}
+
+void ImageCache::persistStats() {
+    CacheStats delta;
+    {
+        std::lock_guard<std::mutex> guard(mutex_);
+        delta = unpersisted_;
+        unpersisted_ = CacheStats();
+    }
+    if (delta.lookups() == 0) {
+        return;
+    }
+
+    const std::string path = (fs::path(directory_) / "stats").string();
+    FileLock lock(path + ".lock", true);
+    CacheStats total = readStatsFile(path);
+    total += delta;
+
+    const std::string temp = path + uniqueSuffix();
+    {
+        std::ofstream file(temp, std::ios::trunc);
+        file << "memory_hits " << total.memoryHits << "\n"
+             << "disk_hits " << total.diskHits << "\n"
+             << "misses " << total.misses << "\n"
+             << "bytes_saved " << total.bytesSaved << "\n"
+             << "bytes_stored " << total.bytesStored << "\n";
+        if (!file) {
+            throw std::runtime_error("Failed to write cache stats: " + temp);
+        }
+    }
+    fs::rename(temp, path);
+}
+
+void ImageCache::printStats(std::ostream& out) const {
+    CacheStats cumulative = getPersistentStats();
+    CacheStats session;
+    {
+        std::lock_guard<std::mutex> guard(mutex_);
+        session = session_;
+        cumulative += unpersisted_;
+    }
+
+    out << "Cache statistics (" << directory_ << "):\n";
+    printStatsLine(out, "Session:    ", session);
+    printStatsLine(out, "Cumulative: ", cumulative);
+}
+
+} // namespace ColorGenerator
@@ -0,0 +1,36 @@
+#include "../include/ImageJob.hpp"
+#include "../include/ImageCache.hpp"
+#include "../include/formats/STBImageWriter.hpp"
+#include <filesystem>
+
+namespace ColorGenerator {
+
+JobExecutor::JobExecutor(ImageCache* cache) : cache_(cache) {}
+
+IImageFormat& JobExecutor::writerFor(FormatType format, int quality) {
+    ImageFormatPtr& writer = writers_[format];
+    if (!writer) {
+        writer = ImageWriter::createWriter(format);
+    }
+    if (format == FormatType::JPEG) {
+        if (auto* stbWriter = dynamic_cast<STBImageWriter*>(writer.get())) {
+            stbWriter->setJPEGQuality(quality);
+        }
+    }
+    return *writer;
+}
+
+uint64_t JobExecutor::run(const ImageJob& job) {
+    IImageFormat& writer = writerFor(job.format, job.quality);
+
+    if (cache_) {
+        CacheKey key{job.color, job.resolution, job.format, job.quality};
+        cache_->write(writer, key, job.output);
+    } else if (!writer.write(job.output, job.color, job.resolution)) {
+        throw std::runtime_error("Failed to write image: " + job.output);
+    }
+
+    return std::filesystem::file_size(job.output);
+}
+
+} // namespace ColorGenerator
@@ -0,0 +1,390 @@
+#include "../include/ImageServer.hpp"
+
+#ifdef _WIN32
+
+#include <stdexcept>
+
+namespace ColorGenerator {
+
+ImageServer::ImageServer(const std::string& socketPath, size_t threads, ImageCache* cache)
+    : socketPath_(socketPath), threads_(threads), cache_(cache) {}
+
+void ImageServer::run() {
+    throw std::runtime_error("--serve requires Unix domain sockets and is not supported on this platform");
+}
+
+} // namespace ColorGenerator
+
+#else
+
+#include "../include/ImageJob.hpp"
+#include "../include/MappedFile.hpp"
+#include "../include/SizeBudget.hpp"
+#include "../include/ThreadPool.hpp"
+#include <cerrno>
+#include <chrono>
+#include <csignal>
+#include <cstring>
+#include <filesystem>
+#include <iostream>
+#include <limits>
+#include <memory>
+#include <mutex>
+#include <stdexcept>
+#include <thread>
+#include <vector>
+
+#include <poll.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+namespace ColorGenerator {
+
+namespace {
+
+using Clock = std::chrono::steady_clock;
+
+constexpr size_t REQUEST_HEADER_SIZE = 26;  // fixed fields before the path
+constexpr uint8_t FLAG_INLINE = 0x01;
+constexpr int ACCEPT_POLL_MS = 200;
+
+std::atomic<bool> signalled{false};
+
+extern "C" void onSignal(int) {
+    signalled = true;
+}
+
+#ifdef MSG_NOSIGNAL
+constexpr int SEND_FLAGS = MSG_NOSIGNAL;
+#else
+constexpr int SEND_FLAGS = 0;
+#endif
+
+/**
+ * @brief Read exactly @p length bytes
+ * @return false on end of stream or error
+ */
+bool readFull(int fd, void* buffer, size_t length) {
+    uint8_t* out = static_cast<uint8_t*>(buffer);
+    while (length > 0) {
+        ssize_t n = ::recv(fd, out, length, 0);
+        if (n < 0 && errno == EINTR) continue;
+        if (n <= 0) return false;
+        out += n;
+        length -= static_cast<size_t>(n);
+    }
+    return true;
+}
+
+bool writeFull(int fd, const void* buffer, size_t length) {
+    const uint8_t* in = static_cast<const uint8_t*>(buffer);
+    while (length > 0) {
+        ssize_t n = ::send(fd, in, length, SEND_FLAGS);
+        if (n < 0 && errno == EINTR) continue;
+        if (n <= 0) return false;
+        in += n;
+        length -= static_cast<size_t>(n);
+    }
+    return true;
+}
+
+uint32_t getU32(const uint8_t* p) {
+    return static_cast<uint32_t>(p[0]) | static_cast<uint32_t>(p[1]) << 8 |
+           static_cast<uint32_t>(p[2]) << 16 | static_cast<uint32_t>(p[3]) << 24;
+}
+
+void putU32(uint8_t* p, uint32_t value) {
+    for (int i = 0; i < 4; ++i) {
+        p[i] = static_cast<uint8_t>(value >> (8 * i));
+    }
+}
+
+/**
+ * @brief One client socket, shared by its reader thread and pending tasks
+ *
+ * The descriptor is closed when the last reference goes away, so late
+ * responses never write to a reused descriptor.
+ */
+struct Connection {
+    int fd;
+    std::mutex writeMutex;
+    std::atomic<bool> finished{false};
+
+    explicit Connection(int socket) : fd(socket) {}
+    ~Connection() { ::close(fd); }
+
+    Connection(const Connection&) = delete;
+    Connection& operator=(const Connection&) = delete;
+
+    /**
+     * @brief Send one response frame; failures mean the client went away
+     */
+    void respond(ImageServer::Status status, uint32_t id, const void* body, size_t length) {
+        uint8_t header[9];
+        putU32(header, static_cast<uint32_t>(5 + length));
+        header[4] = static_cast<uint8_t>(status);
+        putU32(header + 5, id);
+
+        std::lock_guard<std::mutex> lock(writeMutex);
+        if (writeFull(fd, header, sizeof(header)) && length > 0) {
+            writeFull(fd, body, length);
+        }
+    }
+
+    void respond(ImageServer::Status status, uint32_t id, const std::string& message) {
+        respond(status, id, message.data(), message.size());
+    }
+};
+
+struct Request {
+    ImageJob job;
+    bool inlineResult = false;
+    bool hasDeadline = false;
+    Clock::time_point deadline;
+};
+
+/**
+ * @brief Decode a request payload whose version has been checked
+ * @throws std::invalid_argument on malformed fields
+ */
+Request decodeRequest(const uint8_t* p, size_t length, Clock::time_point received) {
+    if (length < REQUEST_HEADER_SIZE) {
+        throw std::invalid_argument("Request too short");
+    }
+
+    Request request;
+    const auto format = static_cast<FormatType>(p[5]);
+    if (!ImageWriter::isFormatSupported(format)) {
+        throw std::invalid_argument("Unsupported format: " + std::to_string(p[5]));
+    }
+    request.inlineResult = (p[6] & FLAG_INLINE) != 0;
+    const int quality = p[7] > 100 ? 100 : p[7];
+    const Color color(p[8], p[9], p[10], p[11]);
+    const Resolution resolution(getU32(p + 12), getU32(p + 16));
+
+    const uint32_t deadlineMs = getU32(p + 20);
+    if (deadlineMs != 0) {
+        request.hasDeadline = true;
+        request.deadline = received + std::chrono::milliseconds(deadlineMs);
+    }
+
+    const size_t pathLength = static_cast<size_t>(p[24]) | static_cast<size_t>(p[25]) << 8;
+    if (REQUEST_HEADER_SIZE + pathLength != length) {
+        throw std::invalid_argument("Path length does not match frame length");
+    }
+    std::string output(reinterpret_cast<const char*>(p + REQUEST_HEADER_SIZE), pathLength);
+    if (!request.inlineResult && output.empty()) {
+        throw std::invalid_argument("Missing output path");
+    }
+
+    request.job = ImageJob{color, resolution, format, quality, std::move(output)};
+    return request;
+}
+
+/**
+ * @brief Warm state owned by one worker thread
+ */
+struct WorkerState {
+    JobExecutor executor;
+    std::string scratchPath;  ///< Reused target for inline results
+
+    WorkerState(ImageCache* cache, std::string scratch)
+        : executor(cache), scratchPath(std::move(scratch)) {}
+};
+
+void process(WorkerState& state, Connection& connection, uint32_t id, Request& request) {
+    using Status = ImageServer::Status;
+
+    if (request.hasDeadline && Clock::now() > request.deadline) {
+        connection.respond(Status::DeadlineExceeded, id, "Deadline passed before the request started");
+        return;
+    }
+
+    if (request.inlineResult) {
+        // Checked before encoding, so an oversized request never reaches the scratch file
+        const ImageJob& job = request.job;
+        if (SizeBudget::encodedSize(job.format, job.color, job.resolution, job.quality) >
+            std::numeric_limits<uint32_t>::max() - 5) {
+            connection.respond(Status::Failed, id, "Image too large to return inline");
+            return;
+        }
+        request.job.output = state.scratchPath;
+    }
+    const uint64_t size = state.executor.run(request.job);
+
+    if (request.hasDeadline && Clock::now() > request.deadline) {
+        connection.respond(Status::DeadlineExceeded, id, "Deadline passed while encoding");
+        return;
+    }
+
+    if (!request.inlineResult) {
+        uint8_t body[8];
+        for (int i = 0; i < 8; ++i) {
+            body[i] = static_cast<uint8_t>(size >> (8 * i));
+        }
+        connection.respond(Status::Ok, id, body, sizeof(body));
+        return;
+    }
+
+    // Sent straight from the page cache; the scratch file is overwritten next time
+    MappedFile encoded(state.scratchPath);
+    connection.respond(Status::Ok, id, encoded.data(), static_cast<size_t>(encoded.size()));
+}
+
+/**
+ * @brief Read frames from one client until it disconnects
+ */
+void serveConnection(const std::shared_ptr<Connection>& connection, ThreadPool& pool,
+                     std::vector<std::unique_ptr<WorkerState>>& workers) {
+    std::vector<uint8_t> frame;
+    for (;;) {
+        uint8_t prefix[4];
+        if (!readFull(connection->fd, prefix, sizeof(prefix))) break;
+        const uint32_t length = getU32(prefix);
+        if (length < 5 || length > ImageServer::MAX_REQUEST_SIZE) break;
+
+        frame.resize(length);
+        if (!readFull(connection->fd, frame.data(), length)) break;
+        const auto received = Clock::now();
+
+        const uint32_t id = getU32(frame.data() + 1);
+        if (frame[0] != ImageServer::PROTOCOL_VERSION) {
+            connection->respond(ImageServer::Status::BadRequest, id,
+                                "Unsupported protocol version: " + std::to_string(frame[0]));
+            continue;
+        }
+
+        std::shared_ptr<Request> request;
+        try {
+            request = std::make_shared<Request>(decodeRequest(frame.data(), frame.size(), received));
+        } catch (const std::exception& e) {
+            connection->respond(ImageServer::Status::BadRequest, id, e.what());
+            continue;
+        }
+
+        // Blocks while the queue is full; this connection stops being read
+        // meanwhile, which pushes back on the client through the socket
+        pool.submit([connection, request, id, &workers](size_t worker) {
+            try {
+                process(*workers[worker], *connection, id, *request);
+            } catch (const std::exception& e) {
+                connection->respond(ImageServer::Status::Failed, id, e.what());
+            }
+        });
+    }
+    connection->finished = true;
+}
+
+struct ConnectionThread {
+    std::shared_ptr<Connection> connection;
+    std::thread thread;
+};
+
+} // namespace
+
+ImageServer::ImageServer(const std::string& socketPath, size_t threads, ImageCache* cache)
+    : socketPath_(socketPath), threads_(threads), cache_(cache) {}
+
+void ImageServer::run() {
+    sockaddr_un address{};
+    address.sun_family = AF_UNIX;
+    if (socketPath_.empty() || socketPath_.size() >= sizeof(address.sun_path)) {
+        throw std::runtime_error("Invalid socket path: " + socketPath_);
+    }
+    std::memcpy(address.sun_path, socketPath_.c_str(), socketPath_.size() + 1);
+
+    int listener = ::socket(AF_UNIX, SOCK_STREAM, 0);
+    if (listener < 0) {
+        throw std::runtime_error(std::string("Failed to create socket (") + std::strerror(errno) + ")");
+    }
+    // A stale socket from a previous run would make bind fail
+    std::error_code ec;
+    if (std::filesystem::is_socket(socketPath_, ec)) {
+        std::filesystem::remove(socketPath_, ec);
+    }
+    // Only the owner may connect: requests can write to any path the server can
+    const mode_t previousMask = ::umask(0177);
+    const bool bound = ::bind(listener, reinterpret_cast<sockaddr*>(&address), sizeof(address)) == 0;
+    ::umask(previousMask);
+    if (!bound || ::listen(listener, SOMAXCONN) != 0) {
+        int err = errno;
+        ::close(listener);
+        throw std::runtime_error("Failed to listen on " + socketPath_ + " (" + std::strerror(err) + ")");
+    }
+
+    signalled = false;
+    auto previousInt = std::signal(SIGINT, onSignal);
+    auto previousTerm = std::signal(SIGTERM, onSignal);
+    auto previousPipe = std::signal(SIGPIPE, SIG_IGN);
+
+    // Worker state is declared before the pool so it outlives the workers
+    const size_t threads = threads_ ? threads_ : ThreadPool::defaultThreadCount();
+    const auto scratchDir = std::filesystem::temp_directory_path();
+    std::vector<std::unique_ptr<WorkerState>> workers;
+    for (size_t i = 0; i < threads; ++i) {
+        std::string scratch = (scratchDir / ("colorgen-serve-" + std::to_string(::getpid()) +
+                                             "-" + std::to_string(i) + ".tmp")).string();
+        workers.push_back(std::make_unique<WorkerState>(cache_, std::move(scratch)));
+    }
+    std::vector<ConnectionThread> connections;
+
+    {
+        ThreadPool pool(threads);
+        std::cout << "Listening on " << socketPath_ << " with " << threads << " workers\n" << std::flush;
+
+        while (!stopping_ && !signalled) {
+            pollfd waiting{listener, POLLIN, 0};
+            int ready = ::poll(&waiting, 1, ACCEPT_POLL_MS);
+
+            // Reap readers whose clients have disconnected
+            for (size_t i = 0; i < connections.size();) {
+                if (connections[i].connection->finished) {
+                    connections[i].thread.join();
+                    connections[i] = std::move(connections.back());
+                    connections.pop_back();
+                } else {
+                    ++i;
+                }
+            }
+
+            if (ready <= 0) continue;
+            int client = ::accept(listener, nullptr, nullptr);
+            if (client < 0) continue;
+            if (connections.size() >= MAX_CONNECTIONS) {
+                ::close(client);
+                continue;
+            }
+
+            auto connection = std::make_shared<Connection>(client);
+            std::thread reader([connection, &pool, &workers] {
+                serveConnection(connection, pool, workers);
+            });
+            connections.push_back(ConnectionThread{std::move(connection), std::move(reader)});
+        }
+
+        // Stop reading new requests, then let queued ones finish and respond
+        ::close(listener);
+        for (ConnectionThread& entry : connections) {
+            ::shutdown(entry.connection->fd, SHUT_RD);
+        }
+        for (ConnectionThread& entry : connections) {
+            entry.thread.join();
+        }
+        pool.wait();
+    }
+
+    for (const auto& worker : workers) {
+        std::filesystem::remove(worker->scratchPath, ec);
+    }
+    std::filesystem::remove(socketPath_, ec);
+
+    std::signal(SIGINT, previousInt);
+    std::signal(SIGTERM, previousTerm);
+    std::signal(SIGPIPE, previousPipe);
+}
+
+} // namespace ColorGenerator
+
+#endif
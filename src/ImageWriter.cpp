@@ -1,5 +1,10 @@
 #include "../include/ImageWriter.hpp"
 #include "../include/formats/STBImageWriter.hpp"
+#include "../include/formats/RawImageWriter.hpp"
+#include "../include/formats/Y4MWriter.hpp"
+#include "../include/formats/GIFWriter.hpp"
+#include "../include/formats/QOIWriter.hpp"
+#include "../include/formats/WebPWriter.hpp"
 #include <algorithm>
 
 namespace ColorGenerator {
@@ -8,12 +13,26 @@ namespace ColorGenerator {
 const std::map<std::string, FormatType> ImageWriter::extensionMap_ = {
     {"png", FormatType::PNG},
     {".png", FormatType::PNG},
+    {"apng", FormatType::PNG},
+    {".apng", FormatType::PNG},
     {"jpg", FormatType::JPEG},
     {".jpg", FormatType::JPEG},
     {"jpeg", FormatType::JPEG},
     {".jpeg", FormatType::JPEG},
     {"bmp", FormatType::BMP},
-    {".bmp", FormatType::BMP}
+    {".bmp", FormatType::BMP},
+    {"raw", FormatType::RAW},
+    {".raw", FormatType::RAW},
+    {"y4m", FormatType::Y4M},
+    {".y4m", FormatType::Y4M},
+    {"yuv", FormatType::YUV},
+    {".yuv", FormatType::YUV},
+    {"gif", FormatType::GIF},
+    {".gif", FormatType::GIF},
+    {"qoi", FormatType::QOI},
+    {".qoi", FormatType::QOI},
+    {"webp", FormatType::WEBP},
+    {".webp", FormatType::WEBP}
 };
 
 ImageFormatPtr ImageWriter::createWriter(FormatType format) {
@@ -24,6 +43,18 @@ ImageFormatPtr ImageWriter::createWriter(FormatType format) {
             return std::make_unique<STBImageWriter>(STBImageWriter::Format::JPEG);
         case FormatType::BMP:
             return std::make_unique<STBImageWriter>(STBImageWriter::Format::BMP);
+        case FormatType::RAW:
+            return std::make_unique<RawImageWriter>();
+        case FormatType::Y4M:
+            return std::make_unique<Y4MWriter>();
+        case FormatType::YUV:
+            return std::make_unique<Y4MWriter>(true);
+        case FormatType::GIF:
+            return std::make_unique<GIFWriter>();
+        case FormatType::QOI:
+            return std::make_unique<QOIWriter>();
+        case FormatType::WEBP:
+            return std::make_unique<WebPWriter>();
         default:
             throw std::invalid_argument("Unsupported format type");
     }
@@ -47,7 +78,7 @@ FormatType ImageWriter::getFormatFromExtension(const std::string& extension) {
 }
 
 std::vector<std::string> ImageWriter::getSupportedExtensions() {
-    return {".png", ".jpg", ".jpeg", ".bmp"};
+    return {".png", ".apng", ".jpg", ".jpeg", ".bmp", ".raw", ".y4m", ".yuv", ".gif", ".qoi", ".webp"};
 }
 
 bool ImageWriter::isFormatSupported(FormatType format) {
@@ -55,6 +86,12 @@ bool ImageWriter::isFormatSupported(FormatType format) {
         case FormatType::PNG:
         case FormatType::JPEG:
         case FormatType::BMP:
+        case FormatType::RAW:
+        case FormatType::Y4M:
+        case FormatType::YUV:
+        case FormatType::GIF:
+        case FormatType::QOI:
+        case FormatType::WEBP:
             return true;
         default:
             return false;
@@ -69,6 +106,18 @@ std::string ImageWriter::getFormatName(FormatType format) {
             return "JPEG";
         case FormatType::BMP:
             return "BMP";
+        case FormatType::RAW:
+            return "RAW";
+        case FormatType::Y4M:
+            return "Y4M";
+        case FormatType::YUV:
+            return "YUV";
+        case FormatType::GIF:
+            return "GIF";
+        case FormatType::QOI:
+            return "QOI";
+        case FormatType::WEBP:
+            return "WebP";
         default:
             return "Unknown";
     }
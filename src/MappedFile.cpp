@@ -0,0 +1,221 @@
+#include "../include/MappedFile.hpp"
+#include <cerrno>
+#include <cstring>
+#include <limits>
+#include <stdexcept>
+
+#ifdef _WIN32
+    #include <windows.h>
+#else
+    #include <fcntl.h>
+    #include <sys/mman.h>
+    #include <sys/stat.h>
+    #include <unistd.h>
+#endif
+
+namespace ColorGenerator {
+
+MappedFile::MappedFile(const std::string& filename, uint64_t size)
+    : size_(size), filename_(filename) {
+    if (size == 0 || size > std::numeric_limits<size_t>::max()) {
+        throw std::runtime_error("Invalid mapped file size for: " + filename);
+    }
+
+#ifdef _WIN32
+    HANDLE file = CreateFileA(filename.c_str(), GENERIC_READ | GENERIC_WRITE, 0, NULL,
+                              CREATE_ALWAYS, FILE_ATTRIBUTE_NORMAL, NULL);
+    if (file == INVALID_HANDLE_VALUE) {
+        throw std::runtime_error("Failed to open output file: " + filename);
+    }
+    file_ = file;
+
+    HANDLE mapping = CreateFileMappingA(file, NULL, PAGE_READWRITE,
+                                        static_cast<DWORD>(size >> 32),
+                                        static_cast<DWORD>(size & 0xFFFFFFFFu), NULL);
+    if (mapping == NULL) {
+        CloseHandle(file);
+        file_ = nullptr;
+        throw std::runtime_error("Failed to size output file: " + filename);
+    }
+    mapping_ = mapping;
+
+    data_ = static_cast<uint8_t*>(MapViewOfFile(mapping, FILE_MAP_WRITE, 0, 0, static_cast<SIZE_T>(size)));
+    if (data_ == nullptr) {
+        CloseHandle(mapping);
+        CloseHandle(file);
+        mapping_ = nullptr;
+        file_ = nullptr;
+        throw std::runtime_error("Failed to map output file: " + filename);
+    }
+#else
+    fd_ = ::open(filename.c_str(), O_RDWR | O_CREAT | O_TRUNC, 0644);
+    if (fd_ < 0) {
+        throw std::runtime_error("Failed to open output file: " + filename + " (" + std::strerror(errno) + ")");
+    }
+
+    if (::ftruncate(fd_, static_cast<off_t>(size)) != 0) {
+        int err = errno;
+        ::close(fd_);
+        fd_ = -1;
+        throw std::runtime_error("Failed to size output file: " + filename + " (" + std::strerror(err) + ")");
+    }
+
+#ifdef __linux__
+    // Reserve the blocks now so a full disk fails here instead of as SIGBUS
+    // while writing through the mapping. Not every filesystem supports it.
+    if (::posix_fallocate(fd_, 0, static_cast<off_t>(size)) == ENOSPC) {
+        ::close(fd_);
+        fd_ = -1;
+        throw std::runtime_error("Not enough disk space for output file: " + filename);
+    }
+#endif
+
+    void* mapped = ::mmap(nullptr, static_cast<size_t>(size), PROT_READ | PROT_WRITE, MAP_SHARED, fd_, 0);
+    if (mapped == MAP_FAILED) {
+        int err = errno;
+        ::close(fd_);
+        fd_ = -1;
+        throw std::runtime_error("Failed to map output file: " + filename + " (" + std::strerror(err) + ")");
+    }
+    data_ = static_cast<uint8_t*>(mapped);
+    ::madvise(mapped, static_cast<size_t>(size), MADV_SEQUENTIAL);
+#endif
+}
+
+MappedFile::MappedFile(const std::string& filename) : filename_(filename) {
+#ifdef _WIN32
+    HANDLE file = CreateFileA(filename.c_str(), GENERIC_READ, FILE_SHARE_READ, NULL,
+                              OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, NULL);
+    if (file == INVALID_HANDLE_VALUE) {
+        throw std::runtime_error("Failed to open file: " + filename);
+    }
+    file_ = file;
+
+    LARGE_INTEGER fileSize;
+    if (!GetFileSizeEx(file, &fileSize)) {
+        close();
+        throw std::runtime_error("Failed to read file size: " + filename);
+    }
+    size_ = static_cast<uint64_t>(fileSize.QuadPart);
+    if (size_ == 0) {
+        return;
+    }
+
+    HANDLE mapping = CreateFileMappingA(file, NULL, PAGE_READONLY, 0, 0, NULL);
+    if (mapping == NULL) {
+        close();
+        throw std::runtime_error("Failed to map file: " + filename);
+    }
+    mapping_ = mapping;
+
+    data_ = static_cast<uint8_t*>(MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0));
+    if (data_ == nullptr) {
+        close();
+        throw std::runtime_error("Failed to map file: " + filename);
+    }
+#else
+    fd_ = ::open(filename.c_str(), O_RDONLY);
+    if (fd_ < 0) {
+        throw std::runtime_error("Failed to open file: " + filename + " (" + std::strerror(errno) + ")");
+    }
+
+    struct stat info;
+    if (::fstat(fd_, &info) != 0) {
+        int err = errno;
+        close();
+        throw std::runtime_error("Failed to read file size: " + filename + " (" + std::strerror(err) + ")");
+    }
+    size_ = static_cast<uint64_t>(info.st_size);
+    if (size_ == 0) {
+        return;
+    }
+    if (size_ > std::numeric_limits<size_t>::max()) {
+        close();
+        throw std::runtime_error("File too large to map: " + filename);
+    }
+
+    void* mapped = ::mmap(nullptr, static_cast<size_t>(size_), PROT_READ, MAP_PRIVATE, fd_, 0);
+    if (mapped == MAP_FAILED) {
+        int err = errno;
+        close();
+        throw std::runtime_error("Failed to map file: " + filename + " (" + std::strerror(err) + ")");
+    }
+    data_ = static_cast<uint8_t*>(mapped);
+    ::madvise(mapped, static_cast<size_t>(size_), MADV_SEQUENTIAL);
+#endif
+}
+
+MappedFile::~MappedFile() {
+    try {
+        close();
+    } catch (...) {
+        // Destructors must not throw; call close() explicitly to observe errors
+    }
+}
+
+void MappedFile::replicate(uint64_t offset, size_t period, uint64_t length) {
+    if (period == 0 || length <= period) {
+        return;
+    }
+    if (offset + length > size_) {
+        throw std::out_of_range("Replicated range exceeds mapped file size");
+    }
+
+    uint8_t* base = data_ + offset;
+    uint64_t filled = period;
+
+    // Double the pattern until it reaches the block size (keeps the source in cache)
+    while (filled < length && filled < REPLICATE_BLOCK_SIZE) {
+        uint64_t n = filled < length - filled ? filled : length - filled;
+        std::memcpy(base + filled, base, static_cast<size_t>(n));
+        filled += n;
+    }
+
+    // Then copy whole multiples of the pattern from the start of the range
+    const uint64_t block = filled - filled % period;
+    while (filled < length) {
+        uint64_t n = block < length - filled ? block : length - filled;
+        std::memcpy(base + filled, base, static_cast<size_t>(n));
+        filled += n;
+    }
+}
+
+void MappedFile::close() {
+#ifdef _WIN32
+    bool ok = true;
+    if (data_) {
+        ok = UnmapViewOfFile(data_) != 0 && ok;
+        data_ = nullptr;
+    }
+    if (mapping_) {
+        CloseHandle(static_cast<HANDLE>(mapping_));
+        mapping_ = nullptr;
+    }
+    if (file_) {
+        ok = CloseHandle(static_cast<HANDLE>(file_)) != 0 && ok;
+        file_ = nullptr;
+    }
+    if (!ok) {
+        throw std::runtime_error("Failed to write image file: " + filename_);
+    }
+#else
+    int err = 0;
+    if (data_) {
+        if (::munmap(data_, static_cast<size_t>(size_)) != 0) {
+            err = errno;
+        }
+        data_ = nullptr;
+    }
+    if (fd_ >= 0) {
+        if (::close(fd_) != 0 && err == 0) {
+            err = errno;
+        }
+        fd_ = -1;
+    }
+    if (err != 0) {
+        throw std::runtime_error("Failed to write image file: " + filename_ + " (" + std::strerror(err) + ")");
+    }
+#endif
+}
+
+} // namespace ColorGenerator
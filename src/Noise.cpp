@@ -0,0 +1,591 @@
+#include "../include/Noise.hpp"
+#include "../include/CpuFeatures.hpp"
+#include "../include/ThreadPool.hpp"
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#ifdef COLORGEN_X86
+    // GCC 12 flags the deliberately undefined pass-through operands of the AVX-512 intrinsics
+    #pragma GCC diagnostic push
+    #pragma GCC diagnostic ignored "-Wuninitialized"
+    #pragma GCC diagnostic ignored "-Wmaybe-uninitialized"
+    #include <immintrin.h>
+    #pragma GCC diagnostic pop
+#endif
+
+namespace ColorGenerator {
+
+namespace {
+
+// Lattice coordinate multipliers for the hash
+constexpr uint32_t PRIME_X = 0x9E3779B1u;
+constexpr uint32_t PRIME_Y = 0x85EBCA77u;
+
+// Simplex skew factors: (sqrt(3) - 1) / 2 and (3 - sqrt(3)) / 6
+constexpr float F2 = 0.366025403784f;
+constexpr float G2 = 0.211324865405f;
+constexpr float G2_TWICE_MINUS_ONE = 2.0f * G2 - 1.0f;
+
+// Scales the simplex corner sum (within about +-1/64 with diagonal gradients) to +-0.5
+constexpr float SIMPLEX_SCALE = 0.5f * 64.0f;
+
+// 2^-24, for 24-bit lattice values
+constexpr float UNIT = 1.0f / 16777216.0f;
+
+// Lattice coordinates stay below this so floats keep a useful fraction
+constexpr float MAX_COORDINATE = 8388608.0f;
+
+struct RowParams {
+    NoiseType type;
+    int octaves;
+    const Noise::Octave* octave;
+    const uint32_t* palette;
+    int channels;
+};
+
+using RowKernel = void (*)(const RowParams& params, uint32_t x, uint32_t y, uint32_t count, uint8_t* dst);
+
+/**
+ * @brief Chris Wellons' lowbias32 integer finalizer
+ */
+uint32_t mix(uint32_t h) {
+    h ^= h >> 16;
+    h *= 0x7FEB352Du;
+    h ^= h >> 15;
+    h *= 0x846CA68Bu;
+    h ^= h >> 16;
+    return h;
+}
+
+uint32_t hashScalar(int32_t ix, int32_t iy, uint32_t key) {
+    return mix((static_cast<uint32_t>(ix) * PRIME_X) ^ ((static_cast<uint32_t>(iy) * PRIME_Y) ^ key));
+}
+
+float gradScalar(uint32_t h, float dx, float dy) {
+    return ((h & 1) ? -dx : dx) + ((h & 2) ? -dy : dy);
+}
+
+float lerp(float a, float b, float t) {
+    return a + t * (b - a);
+}
+
+float fadeQuintic(float t) {
+    return t * t * t * (t * (t * 6.0f - 15.0f) + 10.0f);
+}
+
+float fadeCubic(float t) {
+    return t * t * (3.0f - 2.0f * t);
+}
+
+float simplexCorner(uint32_t h, float dx, float dy) {
+    float c = std::max(0.5f - dx * dx - dy * dy, 0.0f);
+    c = c * c;
+    return c * c * gradScalar(h, dx, dy);
+}
+
+/**
+ * @brief One octave at lattice position (px, py), mapped to [0, 1]
+ */
+float octaveScalar(NoiseType type, float px, float py, uint32_t key) {
+    if (type == NoiseType::Simplex) {
+        const float s = (px + py) * F2;
+        const float fi = std::floor(px + s);
+        const float fj = std::floor(py + s);
+        const float t = (fi + fj) * G2;
+        const float x0 = px - (fi - t);
+        const float y0 = py - (fj - t);
+        const float i1 = x0 > y0 ? 1.0f : 0.0f;
+        const float j1 = x0 > y0 ? 0.0f : 1.0f;
+        const int32_t i = static_cast<int32_t>(fi);
+        const int32_t j = static_cast<int32_t>(fj);
+        const float n0 = simplexCorner(hashScalar(i, j, key), x0, y0);
+        const float n1 = simplexCorner(hashScalar(i + static_cast<int32_t>(i1), j + static_cast<int32_t>(j1), key),
+                                       x0 - i1 + G2, y0 - j1 + G2);
+        const float n2 = simplexCorner(hashScalar(i + 1, j + 1, key),
+                                       x0 + G2_TWICE_MINUS_ONE, y0 + G2_TWICE_MINUS_ONE);
+        return (n0 + n1 + n2) * SIMPLEX_SCALE + 0.5f;
+    }
+
+    const float fx = std::floor(px);
+    const float fy = std::floor(py);
+    const int32_t ix = static_cast<int32_t>(fx);
+    const int32_t iy = static_cast<int32_t>(fy);
+    const float tx = px - fx;
+    const float ty = py - fy;
+    const uint32_t h00 = hashScalar(ix, iy, key);
+    const uint32_t h10 = hashScalar(ix + 1, iy, key);
+    const uint32_t h01 = hashScalar(ix, iy + 1, key);
+    const uint32_t h11 = hashScalar(ix + 1, iy + 1, key);
+
+    if (type == NoiseType::Value) {
+        const float u = fadeCubic(tx);
+        const float v = fadeCubic(ty);
+        const float a = lerp(static_cast<float>(h00 >> 8) * UNIT, static_cast<float>(h10 >> 8) * UNIT, u);
+        const float b = lerp(static_cast<float>(h01 >> 8) * UNIT, static_cast<float>(h11 >> 8) * UNIT, u);
+        return lerp(a, b, v);
+    }
+
+    const float u = fadeQuintic(tx);
+    const float v = fadeQuintic(ty);
+    const float a = lerp(gradScalar(h00, tx, ty), gradScalar(h10, tx - 1.0f, ty), u);
+    const float b = lerp(gradScalar(h01, tx, ty - 1.0f), gradScalar(h11, tx - 1.0f, ty - 1.0f), u);
+    return lerp(a, b, v) * 0.5f + 0.5f;
+}
+
+int32_t toLevel(float sum) {
+    return static_cast<int32_t>(std::min(std::max(sum, 0.0f), 1.0f) * 255.0f + 0.5f);
+}
+
+void rowScalar(const RowParams& params, uint32_t x, uint32_t y, uint32_t count, uint8_t* dst) {
+    const float centerY = static_cast<float>(static_cast<int32_t>(y)) + 0.5f;
+    for (uint32_t i = 0; i < count; ++i) {
+        const float centerX = static_cast<float>(static_cast<int32_t>(x + i)) + 0.5f;
+        float sum = 0.0f;
+        for (int o = 0; o < params.octaves; ++o) {
+            const Noise::Octave& octave = params.octave[o];
+            const float n = octaveScalar(params.type, centerX * octave.frequency,
+                                         centerY * octave.frequency, octave.key);
+            sum = sum + octave.weight * n;
+        }
+        const uint32_t pixel = params.palette[toLevel(sum)];
+        for (int c = 0; c < params.channels; ++c) {
+            dst[i * params.channels + c] = static_cast<uint8_t>(pixel >> (8 * c));
+        }
+    }
+}
+
+#ifdef COLORGEN_X86
+
+// ----- AVX2: 8 pixels per step -----
+
+COLORGEN_TARGET("avx2") inline __m256i hashAVX2(__m256i ix, __m256i rowTerm) {
+    __m256i h = _mm256_xor_si256(_mm256_mullo_epi32(ix, _mm256_set1_epi32(static_cast<int32_t>(PRIME_X))), rowTerm);
+    h = _mm256_xor_si256(h, _mm256_srli_epi32(h, 16));
+    h = _mm256_mullo_epi32(h, _mm256_set1_epi32(0x7FEB352D));
+    h = _mm256_xor_si256(h, _mm256_srli_epi32(h, 15));
+    h = _mm256_mullo_epi32(h, _mm256_set1_epi32(static_cast<int32_t>(0x846CA68Bu)));
+    return _mm256_xor_si256(h, _mm256_srli_epi32(h, 16));
+}
+
+/**
+ * @brief (iy * PRIME_Y) ^ key, the part of the hash input shared by a lattice row
+ */
+COLORGEN_TARGET("avx2") inline __m256i rowTermAVX2(__m256i iy, uint32_t key) {
+    return _mm256_xor_si256(_mm256_mullo_epi32(iy, _mm256_set1_epi32(static_cast<int32_t>(PRIME_Y))),
+                            _mm256_set1_epi32(static_cast<int32_t>(key)));
+}
+
+COLORGEN_TARGET("avx2") inline __m256 gradAVX2(__m256i h, __m256 dx, __m256 dy) {
+    const __m256i one = _mm256_set1_epi32(1);
+    const __m256 sx = _mm256_castsi256_ps(_mm256_slli_epi32(_mm256_and_si256(h, one), 31));
+    const __m256 sy = _mm256_castsi256_ps(_mm256_slli_epi32(_mm256_and_si256(h, _mm256_set1_epi32(2)), 30));
+    return _mm256_add_ps(_mm256_xor_ps(dx, sx), _mm256_xor_ps(dy, sy));
+}
+
+COLORGEN_TARGET("avx2") inline __m256 lerpAVX2(__m256 a, __m256 b, __m256 t) {
+    return _mm256_add_ps(a, _mm256_mul_ps(t, _mm256_sub_ps(b, a)));
+}
+
+COLORGEN_TARGET("avx2") inline __m256 fadeQuinticAVX2(__m256 t) {
+    const __m256 poly = _mm256_add_ps(
+        _mm256_mul_ps(t, _mm256_sub_ps(_mm256_mul_ps(t, _mm256_set1_ps(6.0f)), _mm256_set1_ps(15.0f))),
+        _mm256_set1_ps(10.0f));
+    return _mm256_mul_ps(_mm256_mul_ps(_mm256_mul_ps(t, t), t), poly);
+}
+
+COLORGEN_TARGET("avx2") inline __m256 fadeCubicAVX2(__m256 t) {
+    return _mm256_mul_ps(_mm256_mul_ps(t, t),
+                         _mm256_sub_ps(_mm256_set1_ps(3.0f), _mm256_mul_ps(_mm256_set1_ps(2.0f), t)));
+}
+
+COLORGEN_TARGET("avx2") inline __m256 valueAVX2(__m256i h) {
+    return _mm256_mul_ps(_mm256_cvtepi32_ps(_mm256_srli_epi32(h, 8)), _mm256_set1_ps(UNIT));
+}
+
+COLORGEN_TARGET("avx2") inline __m256 simplexCornerAVX2(__m256i h, __m256 dx, __m256 dy) {
+    __m256 c = _mm256_sub_ps(_mm256_sub_ps(_mm256_set1_ps(0.5f), _mm256_mul_ps(dx, dx)), _mm256_mul_ps(dy, dy));
+    c = _mm256_max_ps(c, _mm256_setzero_ps());
+    c = _mm256_mul_ps(c, c);
+    return _mm256_mul_ps(_mm256_mul_ps(c, c), gradAVX2(h, dx, dy));
+}
+
+COLORGEN_TARGET("avx2") __m256 octaveAVX2(NoiseType type, __m256 px, float py, uint32_t key) {
+    const __m256i one = _mm256_set1_epi32(1);
+    if (type == NoiseType::Simplex) {
+        const __m256 vy = _mm256_set1_ps(py);
+        const __m256 s = _mm256_mul_ps(_mm256_add_ps(px, vy), _mm256_set1_ps(F2));
+        const __m256 fi = _mm256_floor_ps(_mm256_add_ps(px, s));
+        const __m256 fj = _mm256_floor_ps(_mm256_add_ps(vy, s));
+        const __m256 t = _mm256_mul_ps(_mm256_add_ps(fi, fj), _mm256_set1_ps(G2));
+        const __m256 x0 = _mm256_sub_ps(px, _mm256_sub_ps(fi, t));
+        const __m256 y0 = _mm256_sub_ps(vy, _mm256_sub_ps(fj, t));
+        const __m256 upper = _mm256_cmp_ps(x0, y0, _CMP_GT_OQ);
+        const __m256 i1 = _mm256_and_ps(upper, _mm256_set1_ps(1.0f));
+        const __m256 j1 = _mm256_andnot_ps(upper, _mm256_set1_ps(1.0f));
+        const __m256i i = _mm256_cvttps_epi32(fi);
+        const __m256i j = _mm256_cvttps_epi32(fj);
+        const __m256 g2 = _mm256_set1_ps(G2);
+        const __m256 g2m1 = _mm256_set1_ps(G2_TWICE_MINUS_ONE);
+
+        const __m256 n0 = simplexCornerAVX2(hashAVX2(i, rowTermAVX2(j, key)), x0, y0);
+        const __m256 n1 = simplexCornerAVX2(
+            hashAVX2(_mm256_add_epi32(i, _mm256_cvttps_epi32(i1)), rowTermAVX2(_mm256_add_epi32(j, _mm256_cvttps_epi32(j1)), key)),
+            _mm256_add_ps(_mm256_sub_ps(x0, i1), g2), _mm256_add_ps(_mm256_sub_ps(y0, j1), g2));
+        const __m256 n2 = simplexCornerAVX2(
+            hashAVX2(_mm256_add_epi32(i, one), rowTermAVX2(_mm256_add_epi32(j, one), key)),
+            _mm256_add_ps(x0, g2m1), _mm256_add_ps(y0, g2m1));
+        return _mm256_add_ps(_mm256_mul_ps(_mm256_add_ps(_mm256_add_ps(n0, n1), n2), _mm256_set1_ps(SIMPLEX_SCALE)),
+                             _mm256_set1_ps(0.5f));
+    }
+
+    // The lattice row is shared by all lanes
+    const float fy = std::floor(py);
+    const int32_t iy = static_cast<int32_t>(fy);
+    const float ty = py - fy;
+    const __m256i row0 = _mm256_set1_epi32(static_cast<int32_t>((static_cast<uint32_t>(iy) * PRIME_Y) ^ key));
+    const __m256i row1 = _mm256_set1_epi32(static_cast<int32_t>((static_cast<uint32_t>(iy + 1) * PRIME_Y) ^ key));
+
+    const __m256 fx = _mm256_floor_ps(px);
+    const __m256i ix = _mm256_cvttps_epi32(fx);
+    const __m256i ix1 = _mm256_add_epi32(ix, one);
+    const __m256 tx = _mm256_sub_ps(px, fx);
+    const __m256i h00 = hashAVX2(ix, row0);
+    const __m256i h10 = hashAVX2(ix1, row0);
+    const __m256i h01 = hashAVX2(ix, row1);
+    const __m256i h11 = hashAVX2(ix1, row1);
+
+    if (type == NoiseType::Value) {
+        const __m256 u = fadeCubicAVX2(tx);
+        const __m256 v = _mm256_set1_ps(fadeCubic(ty));
+        const __m256 a = lerpAVX2(valueAVX2(h00), valueAVX2(h10), u);
+        const __m256 b = lerpAVX2(valueAVX2(h01), valueAVX2(h11), u);
+        return lerpAVX2(a, b, v);
+    }
+
+    const __m256 vone = _mm256_set1_ps(1.0f);
+    const __m256 u = fadeQuinticAVX2(tx);
+    const __m256 v = _mm256_set1_ps(fadeQuintic(ty));
+    const __m256 vty = _mm256_set1_ps(ty);
+    const __m256 vty1 = _mm256_set1_ps(ty - 1.0f);
+    const __m256 tx1 = _mm256_sub_ps(tx, vone);
+    const __m256 a = lerpAVX2(gradAVX2(h00, tx, vty), gradAVX2(h10, tx1, vty), u);
+    const __m256 b = lerpAVX2(gradAVX2(h01, tx, vty1), gradAVX2(h11, tx1, vty1), u);
+    return _mm256_add_ps(_mm256_mul_ps(lerpAVX2(a, b, v), _mm256_set1_ps(0.5f)), _mm256_set1_ps(0.5f));
+}
+
+COLORGEN_TARGET("avx2") void rowAVX2(const RowParams& params, uint32_t x, uint32_t y, uint32_t count, uint8_t* dst) {
+    const __m256i dropAlpha = _mm256_setr_epi8(0, 1, 2, 4, 5, 6, 8, 9, 10, 12, 13, 14, -1, -1, -1, -1,
+                                               0, 1, 2, 4, 5, 6, 8, 9, 10, 12, 13, 14, -1, -1, -1, -1);
+    const float centerY = static_cast<float>(static_cast<int32_t>(y)) + 0.5f;
+    __m256i xi = _mm256_add_epi32(_mm256_set1_epi32(static_cast<int32_t>(x)), _mm256_setr_epi32(0, 1, 2, 3, 4, 5, 6, 7));
+
+    uint32_t i = 0;
+    for (; i + 8 <= count; i += 8) {
+        const __m256 centerX = _mm256_add_ps(_mm256_cvtepi32_ps(xi), _mm256_set1_ps(0.5f));
+        __m256 sum = _mm256_setzero_ps();
+        for (int o = 0; o < params.octaves; ++o) {
+            const Noise::Octave& octave = params.octave[o];
+            const __m256 n = octaveAVX2(params.type, _mm256_mul_ps(centerX, _mm256_set1_ps(octave.frequency)),
+                                        centerY * octave.frequency, octave.key);
+            sum = _mm256_add_ps(sum, _mm256_mul_ps(_mm256_set1_ps(octave.weight), n));
+        }
+        sum = _mm256_min_ps(_mm256_max_ps(sum, _mm256_setzero_ps()), _mm256_set1_ps(1.0f));
+        const __m256i level = _mm256_cvttps_epi32(
+            _mm256_add_ps(_mm256_mul_ps(sum, _mm256_set1_ps(255.0f)), _mm256_set1_ps(0.5f)));
+        __m256i pixels = _mm256_i32gather_epi32(reinterpret_cast<const int*>(params.palette), level, 4);
+
+        if (params.channels == 4) {
+            _mm256_storeu_si256(reinterpret_cast<__m256i*>(dst + i * 4), pixels);
+        } else {
+            pixels = _mm256_shuffle_epi8(pixels, dropAlpha);
+            const __m128i low = _mm256_castsi256_si128(pixels);
+            const __m128i high = _mm256_extracti128_si256(pixels, 1);
+            _mm_storel_epi64(reinterpret_cast<__m128i*>(dst + i * 3), low);
+            int32_t tail = _mm_cvtsi128_si32(_mm_srli_si128(low, 8));
+            std::memcpy(dst + i * 3 + 8, &tail, 4);
+            _mm_storel_epi64(reinterpret_cast<__m128i*>(dst + i * 3 + 12), high);
+            tail = _mm_cvtsi128_si32(_mm_srli_si128(high, 8));
+            std::memcpy(dst + i * 3 + 20, &tail, 4);
+        }
+        xi = _mm256_add_epi32(xi, _mm256_set1_epi32(8));
+    }
+    // The tail runs SSE code; clear the upper halves to avoid transition stalls
+    _mm256_zeroupper();
+    rowScalar(params, x + i, y, count - i, dst + i * params.channels);
+}
+
+// ----- AVX-512: 16 pixels per step -----
+
+COLORGEN_TARGET("avx512f,avx512bw") inline __m512i hashAVX512(__m512i ix, __m512i rowTerm) {
+    __m512i h = _mm512_xor_si512(_mm512_mullo_epi32(ix, _mm512_set1_epi32(static_cast<int32_t>(PRIME_X))), rowTerm);
+    h = _mm512_xor_si512(h, _mm512_srli_epi32(h, 16));
+    h = _mm512_mullo_epi32(h, _mm512_set1_epi32(0x7FEB352D));
+    h = _mm512_xor_si512(h, _mm512_srli_epi32(h, 15));
+    h = _mm512_mullo_epi32(h, _mm512_set1_epi32(static_cast<int32_t>(0x846CA68Bu)));
+    return _mm512_xor_si512(h, _mm512_srli_epi32(h, 16));
+}
+
+COLORGEN_TARGET("avx512f,avx512bw") inline __m512i rowTermAVX512(__m512i iy, uint32_t key) {
+    return _mm512_xor_si512(_mm512_mullo_epi32(iy, _mm512_set1_epi32(static_cast<int32_t>(PRIME_Y))),
+                            _mm512_set1_epi32(static_cast<int32_t>(key)));
+}
+
+COLORGEN_TARGET("avx512f,avx512bw") inline __m512 gradAVX512(__m512i h, __m512 dx, __m512 dy) {
+    const __m512i sx = _mm512_slli_epi32(_mm512_and_si512(h, _mm512_set1_epi32(1)), 31);
+    const __m512i sy = _mm512_slli_epi32(_mm512_and_si512(h, _mm512_set1_epi32(2)), 30);
+    return _mm512_add_ps(_mm512_castsi512_ps(_mm512_xor_si512(_mm512_castps_si512(dx), sx)),
+                         _mm512_castsi512_ps(_mm512_xor_si512(_mm512_castps_si512(dy), sy)));
+}
+
+COLORGEN_TARGET("avx512f,avx512bw") inline __m512 lerpAVX512(__m512 a, __m512 b, __m512 t) {
+    return _mm512_add_ps(a, _mm512_mul_ps(t, _mm512_sub_ps(b, a)));
+}
+
+COLORGEN_TARGET("avx512f,avx512bw") inline __m512 floorAVX512(__m512 v) {
+    return _mm512_roundscale_ps(v, _MM_FROUND_TO_NEG_INF | _MM_FROUND_NO_EXC);
+}
+
+COLORGEN_TARGET("avx512f,avx512bw") inline __m512 fadeQuinticAVX512(__m512 t) {
+    const __m512 poly = _mm512_add_ps(
+        _mm512_mul_ps(t, _mm512_sub_ps(_mm512_mul_ps(t, _mm512_set1_ps(6.0f)), _mm512_set1_ps(15.0f))),
+        _mm512_set1_ps(10.0f));
+    return _mm512_mul_ps(_mm512_mul_ps(_mm512_mul_ps(t, t), t), poly);
+}
+
+COLORGEN_TARGET("avx512f,avx512bw") inline __m512 fadeCubicAVX512(__m512 t) {
+    return _mm512_mul_ps(_mm512_mul_ps(t, t),
+                         _mm512_sub_ps(_mm512_set1_ps(3.0f), _mm512_mul_ps(_mm512_set1_ps(2.0f), t)));
+}
+
+COLORGEN_TARGET("avx512f,avx512bw") inline __m512 valueAVX512(__m512i h) {
+    return _mm512_mul_ps(_mm512_cvtepi32_ps(_mm512_srli_epi32(h, 8)), _mm512_set1_ps(UNIT));
+}
+
+COLORGEN_TARGET("avx512f,avx512bw") inline __m512 simplexCornerAVX512(__m512i h, __m512 dx, __m512 dy) {
+    __m512 c = _mm512_sub_ps(_mm512_sub_ps(_mm512_set1_ps(0.5f), _mm512_mul_ps(dx, dx)), _mm512_mul_ps(dy, dy));
+    c = _mm512_max_ps(c, _mm512_setzero_ps());
+    c = _mm512_mul_ps(c, c);
+    return _mm512_mul_ps(_mm512_mul_ps(c, c), gradAVX512(h, dx, dy));
+}
+
+COLORGEN_TARGET("avx512f,avx512bw") __m512 octaveAVX512(NoiseType type, __m512 px, float py, uint32_t key) {
+    const __m512i one = _mm512_set1_epi32(1);
+    if (type == NoiseType::Simplex) {
+        const __m512 vy = _mm512_set1_ps(py);
+        const __m512 s = _mm512_mul_ps(_mm512_add_ps(px, vy), _mm512_set1_ps(F2));
+        const __m512 fi = floorAVX512(_mm512_add_ps(px, s));
+        const __m512 fj = floorAVX512(_mm512_add_ps(vy, s));
+        const __m512 t = _mm512_mul_ps(_mm512_add_ps(fi, fj), _mm512_set1_ps(G2));
+        const __m512 x0 = _mm512_sub_ps(px, _mm512_sub_ps(fi, t));
+        const __m512 y0 = _mm512_sub_ps(vy, _mm512_sub_ps(fj, t));
+        const __mmask16 upper = _mm512_cmp_ps_mask(x0, y0, _CMP_GT_OQ);
+        const __m512 i1 = _mm512_maskz_mov_ps(upper, _mm512_set1_ps(1.0f));
+        const __m512 j1 = _mm512_maskz_mov_ps(static_cast<__mmask16>(~upper), _mm512_set1_ps(1.0f));
+        const __m512i i = _mm512_cvttps_epi32(fi);
+        const __m512i j = _mm512_cvttps_epi32(fj);
+        const __m512 g2 = _mm512_set1_ps(G2);
+        const __m512 g2m1 = _mm512_set1_ps(G2_TWICE_MINUS_ONE);
+
+        const __m512 n0 = simplexCornerAVX512(hashAVX512(i, rowTermAVX512(j, key)), x0, y0);
+        const __m512 n1 = simplexCornerAVX512(
+            hashAVX512(_mm512_add_epi32(i, _mm512_cvttps_epi32(i1)), rowTermAVX512(_mm512_add_epi32(j, _mm512_cvttps_epi32(j1)), key)),
+            _mm512_add_ps(_mm512_sub_ps(x0, i1), g2), _mm512_add_ps(_mm512_sub_ps(y0, j1), g2));
+        const __m512 n2 = simplexCornerAVX512(
+            hashAVX512(_mm512_add_epi32(i, one), rowTermAVX512(_mm512_add_epi32(j, one), key)),
+            _mm512_add_ps(x0, g2m1), _mm512_add_ps(y0, g2m1));
+        return _mm512_add_ps(_mm512_mul_ps(_mm512_add_ps(_mm512_add_ps(n0, n1), n2), _mm512_set1_ps(SIMPLEX_SCALE)),
+                             _mm512_set1_ps(0.5f));
+    }
+
+    const float fy = std::floor(py);
+    const int32_t iy = static_cast<int32_t>(fy);
+    const float ty = py - fy;
+    const __m512i row0 = _mm512_set1_epi32(static_cast<int32_t>((static_cast<uint32_t>(iy) * PRIME_Y) ^ key));
+    const __m512i row1 = _mm512_set1_epi32(static_cast<int32_t>((static_cast<uint32_t>(iy + 1) * PRIME_Y) ^ key));
+
+    const __m512 fx = floorAVX512(px);
+    const __m512i ix = _mm512_cvttps_epi32(fx);
+    const __m512i ix1 = _mm512_add_epi32(ix, one);
+    const __m512 tx = _mm512_sub_ps(px, fx);
+    const __m512i h00 = hashAVX512(ix, row0);
+    const __m512i h10 = hashAVX512(ix1, row0);
+    const __m512i h01 = hashAVX512(ix, row1);
+    const __m512i h11 = hashAVX512(ix1, row1);
+
+    if (type == NoiseType::Value) {
+        const __m512 u = fadeCubicAVX512(tx);
+        const __m512 v = _mm512_set1_ps(fadeCubic(ty));
+        const __m512 a = lerpAVX512(valueAVX512(h00), valueAVX512(h10), u);
+        const __m512 b = lerpAVX512(valueAVX512(h01), valueAVX512(h11), u);
+        return lerpAVX512(a, b, v);
+    }
+
+    const __m512 u = fadeQuinticAVX512(tx);
+    const __m512 v = _mm512_set1_ps(fadeQuintic(ty));
+    const __m512 vty = _mm512_set1_ps(ty);
+    const __m512 vty1 = _mm512_set1_ps(ty - 1.0f);
+    const __m512 tx1 = _mm512_sub_ps(tx, _mm512_set1_ps(1.0f));
+    const __m512 a = lerpAVX512(gradAVX512(h00, tx, vty), gradAVX512(h10, tx1, vty), u);
+    const __m512 b = lerpAVX512(gradAVX512(h01, tx, vty1), gradAVX512(h11, tx1, vty1), u);
+    return _mm512_add_ps(_mm512_mul_ps(lerpAVX512(a, b, v), _mm512_set1_ps(0.5f)), _mm512_set1_ps(0.5f));
+}
+
+COLORGEN_TARGET("avx512f,avx512bw") void rowAVX512(const RowParams& params, uint32_t x, uint32_t y,
+                                                   uint32_t count, uint8_t* dst) {
+    const __m512i dropAlpha = _mm512_broadcast_i32x4(
+        _mm_setr_epi8(0, 1, 2, 4, 5, 6, 8, 9, 10, 12, 13, 14, -1, -1, -1, -1));
+    const float centerY = static_cast<float>(static_cast<int32_t>(y)) + 0.5f;
+    __m512i xi = _mm512_add_epi32(_mm512_set1_epi32(static_cast<int32_t>(x)),
+                                  _mm512_setr_epi32(0, 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12, 13, 14, 15));
+
+    uint32_t i = 0;
+    for (; i + 16 <= count; i += 16) {
+        const __m512 centerX = _mm512_add_ps(_mm512_cvtepi32_ps(xi), _mm512_set1_ps(0.5f));
+        __m512 sum = _mm512_setzero_ps();
+        for (int o = 0; o < params.octaves; ++o) {
+            const Noise::Octave& octave = params.octave[o];
+            const __m512 n = octaveAVX512(params.type, _mm512_mul_ps(centerX, _mm512_set1_ps(octave.frequency)),
+                                          centerY * octave.frequency, octave.key);
+            sum = _mm512_add_ps(sum, _mm512_mul_ps(_mm512_set1_ps(octave.weight), n));
+        }
+        sum = _mm512_min_ps(_mm512_max_ps(sum, _mm512_setzero_ps()), _mm512_set1_ps(1.0f));
+        const __m512i level = _mm512_cvttps_epi32(
+            _mm512_add_ps(_mm512_mul_ps(sum, _mm512_set1_ps(255.0f)), _mm512_set1_ps(0.5f)));
+        __m512i pixels = _mm512_i32gather_epi32(level, reinterpret_cast<const int*>(params.palette), 4);
+
+        if (params.channels == 4) {
+            _mm512_storeu_si512(dst + i * 4, pixels);
+        } else {
+            pixels = _mm512_shuffle_epi8(pixels, dropAlpha);
+            uint8_t* out = dst + i * 3;
+            const __m128i lanes[4] = {
+                _mm512_castsi512_si128(pixels), _mm512_extracti32x4_epi32(pixels, 1),
+                _mm512_extracti32x4_epi32(pixels, 2), _mm512_extracti32x4_epi32(pixels, 3)};
+            for (const __m128i& lane : lanes) {
+                _mm_storel_epi64(reinterpret_cast<__m128i*>(out), lane);
+                const int32_t tail = _mm_cvtsi128_si32(_mm_srli_si128(lane, 8));
+                std::memcpy(out + 8, &tail, 4);
+                out += 12;
+            }
+        }
+        xi = _mm512_add_epi32(xi, _mm512_set1_epi32(16));
+    }
+    _mm256_zeroupper();
+    rowScalar(params, x + i, y, count - i, dst + i * params.channels);
+}
+
+#endif
+
+RowKernel selectKernel() {
+#ifdef COLORGEN_X86
+    const CpuFeatures& cpu = CpuFeatures::get();
+    if (cpu.avx512) return rowAVX512;
+    if (cpu.avx2) return rowAVX2;
+#endif
+    return rowScalar;
+}
+
+uint8_t tintChannel(uint8_t base, float level, float amount) {
+    const float value = level < 0.5f ? base * (1.0f - amount * (1.0f - 2.0f * level))
+                                     : base + (255.0f - base) * amount * (2.0f * level - 1.0f);
+    return static_cast<uint8_t>(std::min(std::max(value + 0.5f, 0.0f), 255.0f));
+}
+
+} // namespace
+
+Noise::Noise(const Color& color, const Resolution& resolution, const Options& options)
+    : width_(resolution.getWidth()), height_(resolution.getHeight()),
+      channels_(color.isOpaque() ? 3 : 4), type_(options.type), octaves_(options.octaves) {
+    if (options.octaves < 1 || options.octaves > MAX_OCTAVES) {
+        throw std::invalid_argument("Octaves must be between 1 and " + std::to_string(MAX_OCTAVES));
+    }
+    if (!(options.scale >= 1.0f) || !std::isfinite(options.scale)) {
+        throw std::invalid_argument("Noise scale must be at least 1 pixel");
+    }
+    if (!(options.persistence > 0.0f) || !std::isfinite(options.persistence) ||
+        !(options.lacunarity >= 1.0f) || !std::isfinite(options.lacunarity)) {
+        throw std::invalid_argument("Noise persistence must be positive and lacunarity at least 1");
+    }
+    if (!(options.amount >= 0.0f && options.amount <= 1.0f)) {
+        throw std::invalid_argument("Noise amount must be within 0-1");
+    }
+
+    // Counter-based keys: octave o of seed s is always hashed the same way
+    const uint32_t seedLow = static_cast<uint32_t>(options.seed);
+    const uint32_t seedHigh = static_cast<uint32_t>(options.seed >> 32);
+    float frequency = 1.0f / options.scale;
+    float weight = 1.0f;
+    float totalWeight = 0.0f;
+    for (int o = 0; o < octaves_; ++o) {
+        octave_[o] = {frequency, weight, mix(seedLow ^ mix(seedHigh + static_cast<uint32_t>(o) * 0x9E3779B9u))};
+        totalWeight += weight;
+        frequency *= options.lacunarity;
+        weight *= options.persistence;
+    }
+    for (int o = 0; o < octaves_; ++o) {
+        octave_[o].weight /= totalWeight;
+    }
+    const float extent = static_cast<float>(std::max(width_, height_)) + 1.0f;
+    if (extent * octave_[octaves_ - 1].frequency * (1.0f + F2) >= MAX_COORDINATE) {
+        throw std::invalid_argument("Noise frequency is too high for this resolution");
+    }
+
+    const uint8_t base[3] = {color.getRed(), color.getGreen(), color.getBlue()};
+    for (int level = 0; level < 256; ++level) {
+        const float n = static_cast<float>(level) / 255.0f;
+        uint32_t pixel = static_cast<uint32_t>(color.getAlpha()) << 24;
+        for (int c = 0; c < 3; ++c) {
+            pixel |= static_cast<uint32_t>(tintChannel(base[c], n, options.amount)) << (8 * c);
+        }
+        palette_[level] = pixel;
+    }
+}
+
+void Noise::tile(uint32_t x, uint32_t y, uint32_t tileWidth, uint32_t tileHeight,
+                 uint8_t* dst, size_t stride) const {
+    static const RowKernel kernel = selectKernel();
+
+    const RowParams params{type_, octaves_, octave_, palette_, channels_};
+    for (uint32_t row = 0; row < tileHeight; ++row) {
+        kernel(params, x, y + row, tileWidth, dst + row * stride);
+    }
+}
+
+const uint8_t* Noise::rows(uint32_t y, uint32_t count, uint8_t* scratch) const {
+    tile(0, y, width_, count, scratch, static_cast<size_t>(rowBytes()));
+    return scratch;
+}
+
+void Noise::fill(PixelBuffer& buffer, size_t threads) const {
+    const size_t stride = static_cast<size_t>(rowBytes());
+    const uint64_t bytes = static_cast<uint64_t>(stride) * height_;
+    buffer.allocate(static_cast<size_t>(bytes));
+
+    const uint32_t columns = (width_ + TILE_SIZE - 1) / TILE_SIZE;
+    const uint64_t tiles = static_cast<uint64_t>(columns) * ((height_ + TILE_SIZE - 1) / TILE_SIZE);
+    if (threads == 0) {
+        threads = ThreadPool::availableThreads();
+    }
+    threads = static_cast<size_t>(std::min<uint64_t>({threads, bytes / PixelFill::MIN_BYTES_PER_THREAD, tiles}));
+
+    // Tiles are independent, so threads simply take the next one
+    ThreadPool::parallelFor(static_cast<size_t>(tiles), std::max<size_t>(1, threads), [&](size_t index, size_t) {
+        const uint32_t x = static_cast<uint32_t>(index % columns) * TILE_SIZE;
+        const uint32_t y = static_cast<uint32_t>(index / columns) * TILE_SIZE;
+        tile(x, y, std::min(TILE_SIZE, width_ - x), std::min(TILE_SIZE, height_ - y),
+             buffer.data() + y * stride + static_cast<size_t>(x) * channels_, stride);
+    });
+}
+
+NoiseType Noise::parseType(const std::string& name) {
+    if (name == "value") return NoiseType::Value;
+    if (name == "perlin") return NoiseType::Perlin;
+    if (name == "simplex") return NoiseType::Simplex;
+    throw std::invalid_argument("Unknown noise type: " + name + " (expected value, perlin or simplex)");
+}
+
+} // namespace ColorGenerator
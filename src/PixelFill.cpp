@@ -0,0 +1,217 @@
+#include "../include/PixelFill.hpp"
+#include "../include/CpuFeatures.hpp"
+#include "../include/ThreadPool.hpp"
+#include <algorithm>
+#include <cstring>
+#include <new>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#ifdef COLORGEN_X86
+    #include <immintrin.h>
+#endif
+
+namespace ColorGenerator {
+
+void PixelBuffer::allocate(size_t size) {
+    data_.reset();
+    size_ = 0;
+    if (size == 0) {
+        return;
+    }
+    data_.reset(static_cast<uint8_t*>(::operator new[](size, std::align_val_t(ALIGNMENT))));
+    size_ = size;
+}
+
+void PixelBuffer::AlignedDelete::operator()(uint8_t* p) const {
+    ::operator delete[](p, std::align_val_t(ALIGNMENT));
+}
+
+namespace {
+
+// 192 bytes is a whole number of 3- and 4-byte pixels and of 16/32/64-byte
+// vectors, so every kernel can restart the pattern at any multiple of it
+constexpr size_t PATTERN_SIZE = 192;
+
+// Thread slices are multiples of this (also a multiple of PATTERN_SIZE)
+constexpr size_t SLICE_GRANULE = 64 * PATTERN_SIZE;
+
+// Above this size the data will not stay in cache, so non-temporal
+// stores avoid reading each line before overwriting it
+constexpr size_t STREAMING_THRESHOLD = 8 << 20;
+
+using Kernel = void (*)(uint8_t* dst, size_t bytes, const uint8_t* pattern);
+
+template <int Channels>
+void makePattern(uint8_t (&pattern)[PATTERN_SIZE], const Color& color) {
+    const uint8_t pixel[4] = {color.getRed(), color.getGreen(), color.getBlue(), color.getAlpha()};
+    for (size_t i = 0; i < PATTERN_SIZE; i += Channels) {
+        std::memcpy(pattern + i, pixel, Channels);
+    }
+}
+
+void fillTail(uint8_t* dst, size_t bytes, const uint8_t* pattern) {
+    std::memcpy(dst, pattern, bytes);
+}
+
+template <int Channels>
+void fillScalar(uint8_t* dst, size_t bytes, const uint8_t* pattern) {
+    size_t i = 0;
+    for (; i + PATTERN_SIZE <= bytes; i += PATTERN_SIZE) {
+        std::memcpy(dst + i, pattern, PATTERN_SIZE);
+    }
+    fillTail(dst + i, bytes - i, pattern);
+}
+
+#ifdef COLORGEN_X86
+
+template <int Channels>
+COLORGEN_TARGET("sse2") void fillSSE2(uint8_t* dst, size_t bytes, const uint8_t* pattern) {
+    const __m128i v0 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(pattern));
+    const __m128i v1 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(pattern + 16));
+    const __m128i v2 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(pattern + 32));
+    constexpr size_t step = Channels == 4 ? 64 : 48;
+    const bool stream = bytes >= STREAMING_THRESHOLD && (reinterpret_cast<uintptr_t>(dst) & 15) == 0;
+
+    size_t i = 0;
+    if (stream) {
+        for (; i + step <= bytes; i += step) {
+            __m128i* out = reinterpret_cast<__m128i*>(dst + i);
+            _mm_stream_si128(out, v0);
+            _mm_stream_si128(out + 1, Channels == 4 ? v0 : v1);
+            _mm_stream_si128(out + 2, Channels == 4 ? v0 : v2);
+            if (Channels == 4) _mm_stream_si128(out + 3, v0);
+        }
+        _mm_sfence();
+    } else {
+        for (; i + step <= bytes; i += step) {
+            __m128i* out = reinterpret_cast<__m128i*>(dst + i);
+            _mm_storeu_si128(out, v0);
+            _mm_storeu_si128(out + 1, Channels == 4 ? v0 : v1);
+            _mm_storeu_si128(out + 2, Channels == 4 ? v0 : v2);
+            if (Channels == 4) _mm_storeu_si128(out + 3, v0);
+        }
+    }
+    fillTail(dst + i, bytes - i, pattern);
+}
+
+template <int Channels>
+COLORGEN_TARGET("avx2") void fillAVX2(uint8_t* dst, size_t bytes, const uint8_t* pattern) {
+    const __m256i v0 = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(pattern));
+    const __m256i v1 = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(pattern + 32));
+    const __m256i v2 = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(pattern + 64));
+    constexpr size_t step = Channels == 4 ? 128 : 96;
+    const bool stream = bytes >= STREAMING_THRESHOLD && (reinterpret_cast<uintptr_t>(dst) & 31) == 0;
+
+    size_t i = 0;
+    if (stream) {
+        for (; i + step <= bytes; i += step) {
+            __m256i* out = reinterpret_cast<__m256i*>(dst + i);
+            _mm256_stream_si256(out, v0);
+            _mm256_stream_si256(out + 1, Channels == 4 ? v0 : v1);
+            _mm256_stream_si256(out + 2, Channels == 4 ? v0 : v2);
+            if (Channels == 4) _mm256_stream_si256(out + 3, v0);
+        }
+        _mm_sfence();
+    } else {
+        for (; i + step <= bytes; i += step) {
+            __m256i* out = reinterpret_cast<__m256i*>(dst + i);
+            _mm256_storeu_si256(out, v0);
+            _mm256_storeu_si256(out + 1, Channels == 4 ? v0 : v1);
+            _mm256_storeu_si256(out + 2, Channels == 4 ? v0 : v2);
+            if (Channels == 4) _mm256_storeu_si256(out + 3, v0);
+        }
+    }
+    fillTail(dst + i, bytes - i, pattern);
+}
+
+template <int Channels>
+COLORGEN_TARGET("avx512f,avx512bw") void fillAVX512(uint8_t* dst, size_t bytes, const uint8_t* pattern) {
+    const __m512i v0 = _mm512_loadu_si512(pattern);
+    const __m512i v1 = _mm512_loadu_si512(pattern + 64);
+    const __m512i v2 = _mm512_loadu_si512(pattern + 128);
+    constexpr size_t step = Channels == 4 ? 256 : 192;
+    const bool stream = bytes >= STREAMING_THRESHOLD && (reinterpret_cast<uintptr_t>(dst) & 63) == 0;
+
+    size_t i = 0;
+    if (stream) {
+        for (; i + step <= bytes; i += step) {
+            __m512i* out = reinterpret_cast<__m512i*>(dst + i);
+            _mm512_stream_si512(out, v0);
+            _mm512_stream_si512(out + 1, Channels == 4 ? v0 : v1);
+            _mm512_stream_si512(out + 2, Channels == 4 ? v0 : v2);
+            if (Channels == 4) _mm512_stream_si512(out + 3, v0);
+        }
+        _mm_sfence();
+    } else {
+        for (; i + step <= bytes; i += step) {
+            uint8_t* out = dst + i;
+            _mm512_storeu_si512(out, v0);
+            _mm512_storeu_si512(out + 64, Channels == 4 ? v0 : v1);
+            _mm512_storeu_si512(out + 128, Channels == 4 ? v0 : v2);
+            if (Channels == 4) _mm512_storeu_si512(out + 192, v0);
+        }
+    }
+    // The remainder is shorter than one step; finish it with narrower stores
+    fillSSE2<Channels>(dst + i, bytes - i, pattern);
+}
+
+#endif
+
+template <int Channels>
+Kernel selectKernel() {
+#ifdef COLORGEN_X86
+    const CpuFeatures& cpu = CpuFeatures::get();
+    if (cpu.avx512) return fillAVX512<Channels>;
+    if (cpu.avx2) return fillAVX2<Channels>;
+    if (cpu.sse2) return fillSSE2<Channels>;
+#endif
+    return fillScalar<Channels>;
+}
+
+template <int Channels>
+void fillSpecialized(uint8_t* data, uint64_t pixelCount, const Color& color, size_t threads) {
+    static const Kernel kernel = selectKernel<Channels>();
+
+    alignas(64) uint8_t pattern[PATTERN_SIZE];
+    makePattern<Channels>(pattern, color);
+
+    const uint64_t bytes = pixelCount * Channels;
+    if (threads == 0) {
+        threads = ThreadPool::availableThreads();
+    }
+    threads = static_cast<size_t>(std::min<uint64_t>(threads, bytes / PixelFill::MIN_BYTES_PER_THREAD));
+    if (threads <= 1) {
+        kernel(data, static_cast<size_t>(bytes), pattern);
+        return;
+    }
+
+    // Slices start at multiples of the pattern size, so they all share one pattern
+    uint64_t slice = (bytes + threads - 1) / threads;
+    slice = (slice + SLICE_GRANULE - 1) / SLICE_GRANULE * SLICE_GRANULE;
+
+    const size_t slices = static_cast<size_t>((bytes + slice - 1) / slice);
+    ThreadPool::parallelFor(slices, slices, [&](size_t i, size_t) {
+        const uint64_t offset = i * slice;
+        kernel(data + offset, static_cast<size_t>(std::min(slice, bytes - offset)), pattern);
+    });
+}
+
+} // namespace
+
+void PixelFill::fill(uint8_t* data, uint64_t pixelCount, const Color& color, int channels, size_t threads) {
+    switch (channels) {
+        case 3: fillSpecialized<3>(data, pixelCount, color, threads); break;
+        case 4: fillSpecialized<4>(data, pixelCount, color, threads); break;
+        default: throw std::invalid_argument("Unsupported channel count: " + std::to_string(channels));
+    }
+}
+
+void PixelFill::fill(PixelBuffer& buffer, const Color& color, const Resolution& resolution,
+                     int channels, size_t threads) {
+    buffer.allocate(static_cast<size_t>(resolution.getPixelCount() * channels));
+    fill(buffer.data(), resolution.getPixelCount(), color, channels, threads);
+}
+
+} // namespace ColorGenerator
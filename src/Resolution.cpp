@@ -1,4 +1,6 @@
 #include "../include/Resolution.hpp"
+#include <algorithm>
+#include <cctype>
 #include <sstream>
 
 // Platform-specific headers for screen resolution detection
@@ -42,6 +44,32 @@ std::string Resolution::toString() const {
     return oss.str();
 }
 
+Resolution Resolution::parse(const std::string& str) {
+    std::string lower = str;
+    std::transform(lower.begin(), lower.end(), lower.begin(), ::tolower);
+
+    if (lower == "hd") return HD();
+    if (lower == "fullhd") return FullHD();
+    if (lower == "qhd") return QHD();
+    if (lower == "4k") return UHD4K();
+
+    size_t xPos = lower.find('x');
+    if (xPos == std::string::npos || xPos == 0 || xPos + 1 == lower.size() ||
+        lower.find_first_not_of("0123456789x") != std::string::npos ||
+        lower.find('x', xPos + 1) != std::string::npos ||
+        xPos > 10 || lower.size() - xPos - 1 > 10) {
+        throw std::invalid_argument("Invalid resolution format. Use WIDTHxHEIGHT (e.g., 1920x1080)");
+    }
+
+    unsigned long long width = std::stoull(lower.substr(0, xPos));
+    unsigned long long height = std::stoull(lower.substr(xPos + 1));
+    if (width > MAX_DIMENSION || height > MAX_DIMENSION) {
+        throw std::invalid_argument("Invalid resolution dimensions");
+    }
+
+    return Resolution(static_cast<uint32_t>(width), static_cast<uint32_t>(height));
+}
+
 std::string Resolution::getAspectRatio() const {
     uint32_t divisor = gcd(width_, height_);
     std::ostringstream oss;
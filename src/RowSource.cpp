@@ -0,0 +1,23 @@
+#include "../include/RowSource.hpp"
+#include "../include/PixelFill.hpp"
+#include <cstring>
+
+namespace ColorGenerator {
+
+SolidRowSource::SolidRowSource(const Color& color, const Resolution& resolution, int channels)
+    : width_(resolution.getWidth()), height_(resolution.getHeight()), channels_(channels) {
+    row_.resize(rowBytes());
+    PixelFill::fill(row_.data(), width_, color, channels, 1);
+}
+
+const uint8_t* SolidRowSource::rows(uint32_t, uint32_t count, uint8_t* scratch) const {
+    if (count == 1) {
+        return row_.data();
+    }
+    for (uint32_t i = 0; i < count; ++i) {
+        std::memcpy(scratch + i * row_.size(), row_.data(), row_.size());
+    }
+    return scratch;
+}
+
+} // namespace ColorGenerator
@@ -0,0 +1,107 @@
+#include "../include/SizeBudget.hpp"
+#include "../include/formats/SolidPNGEncoder.hpp"
+#include "../include/formats/SolidJPEGEncoder.hpp"
+#include "../include/formats/SolidBMPEncoder.hpp"
+#include "../include/formats/GIFWriter.hpp"
+#include "../include/formats/QOIWriter.hpp"
+#include "../include/formats/WebPWriter.hpp"
+#include "../include/formats/Y4MWriter.hpp"
+#include <algorithm>
+#include <cmath>
+#include <map>
+#include <stdexcept>
+#include <string>
+
+namespace ColorGenerator {
+
+SizeFit SizeBudget::highestQuality(uint64_t maxBytes, int minQuality, int maxQuality,
+                                   const std::function<uint64_t(int)>& sizeAt) {
+    if (minQuality > maxQuality) {
+        throw std::invalid_argument("Empty quality range");
+    }
+
+    std::map<int, uint64_t> sizes;
+    auto size = [&](int quality) {
+        auto it = sizes.find(quality);
+        if (it == sizes.end()) {
+            it = sizes.emplace(quality, sizeAt(quality)).first;
+        }
+        return it->second;
+    };
+
+    if (size(maxQuality) <= maxBytes) {
+        return {maxQuality, sizes[maxQuality], static_cast<int>(sizes.size())};
+    }
+    if (size(minQuality) > maxBytes) {
+        throw std::runtime_error("Smallest output is " + std::to_string(sizes[minQuality]) +
+                                 " bytes, over the " + std::to_string(maxBytes) + " byte budget");
+    }
+
+    // Invariant: lo fits, hi does not
+    int lo = minQuality;
+    int hi = maxQuality;
+    bool modelStep = true;
+    while (hi - lo > 1) {
+        int quality = lo + (hi - lo) / 2;
+        const double low = std::log(static_cast<double>(std::max<uint64_t>(sizes[lo], 1)));
+        const double high = std::log(static_cast<double>(sizes[hi]));
+        if (modelStep && high > low) {
+            const double t = (std::log(static_cast<double>(maxBytes)) - low) / (high - low);
+            quality = std::clamp(lo + static_cast<int>(t * (hi - lo)), lo + 1, hi - 1);
+        }
+        modelStep = !modelStep;
+
+        if (size(quality) <= maxBytes) {
+            lo = quality;
+        } else {
+            hi = quality;
+        }
+    }
+    return {lo, sizes[lo], static_cast<int>(sizes.size())};
+}
+
+uint64_t SizeBudget::encodedSize(FormatType format, const Color& color, const Resolution& resolution,
+                                 int quality) {
+    // Channel choice mirrors STBImageWriter and RawImageWriter
+    const int channels = color.isOpaque() ? 3 : 4;
+    switch (format) {
+        case FormatType::PNG:
+            return SolidPNGEncoder::encodedSize(color, resolution, channels);
+        case FormatType::JPEG:
+            return SolidJPEGEncoder::encodedSize(color, resolution, quality);
+        case FormatType::BMP:
+            return SolidBMPEncoder::encodedSize(resolution, channels);
+        case FormatType::RAW:
+            return resolution.getPixelCount() * channels;
+        case FormatType::GIF:
+            return GIFWriter::encodedSize(color, resolution);
+        case FormatType::QOI:
+            return QOIWriter::encodedSize(color, resolution);
+        case FormatType::WEBP:
+            return WebPWriter::encodedSize(color, resolution);
+        case FormatType::Y4M:
+        case FormatType::YUV:
+            // One frame with the default layout, as a freshly created writer produces
+            return Y4MWriter(format == FormatType::YUV).encodedSize(resolution);
+        default:
+            throw std::invalid_argument("Unsupported format type");
+    }
+}
+
+SizeFit SizeBudget::fit(FormatType format, const Color& color, const Resolution& resolution,
+                        int quality, uint64_t maxBytes) {
+    if (format == FormatType::JPEG) {
+        return highestQuality(maxBytes, 1, 100, [&](int q) {
+            return encodedSize(format, color, resolution, q);
+        });
+    }
+
+    const uint64_t size = encodedSize(format, color, resolution, quality);
+    if (size > maxBytes) {
+        throw std::runtime_error(ImageWriter::getFormatName(format) + " output is " + std::to_string(size) +
+                                 " bytes, over the " + std::to_string(maxBytes) + " byte budget");
+    }
+    return {quality, size, 1};
+}
+
+} // namespace ColorGenerator
@@ -0,0 +1,172 @@
+#include "../include/TestPattern.hpp"
+#include "../include/PixelFill.hpp"
+#include <algorithm>
+#include <cstring>
+#include <stdexcept>
+
+namespace ColorGenerator {
+
+namespace {
+
+/**
+ * @brief A run of one color ending at @p end, in units of the width divided by a scale
+ */
+struct Span {
+    uint32_t end;
+    Color color;
+};
+
+void fillSpan(std::vector<uint8_t>& row, uint32_t x0, uint32_t x1, const Color& color, int channels) {
+    if (x1 > x0) {
+        PixelFill::fill(row.data() + static_cast<size_t>(x0) * channels, x1 - x0, color, channels, 1);
+    }
+}
+
+std::vector<uint8_t> solidRow(uint32_t width, int channels, const Color& color) {
+    std::vector<uint8_t> row(static_cast<size_t>(width) * channels);
+    fillSpan(row, 0, width, color, channels);
+    return row;
+}
+
+/**
+ * @brief Render consecutive spans whose ends are given in 1/@p scale of the width
+ */
+std::vector<uint8_t> spanRow(uint32_t width, int channels, uint32_t scale, const std::vector<Span>& spans) {
+    std::vector<uint8_t> row(static_cast<size_t>(width) * channels);
+    uint32_t x0 = 0;
+    for (const Span& span : spans) {
+        const uint32_t x1 = static_cast<uint32_t>(static_cast<uint64_t>(width) * span.end / scale);
+        fillSpan(row, x0, x1, span.color, channels);
+        x0 = x1;
+    }
+    return row;
+}
+
+/**
+ * @brief Cells of @p cell pixels alternating between @p first and @p second
+ */
+std::vector<uint8_t> alternatingRow(uint32_t width, int channels, uint32_t cell,
+                                    const Color& first, const Color& second) {
+    std::vector<uint8_t> row(static_cast<size_t>(width) * channels);
+    for (uint32_t x = 0; x < width; x += cell) {
+        fillSpan(row, x, x + std::min(cell, width - x), (x / cell) % 2 ? second : first, channels);
+    }
+    return row;
+}
+
+/**
+ * @brief Period of rows alternating every @p cell rows, or 0 if it does not fit in @p height
+ */
+uint32_t twoCells(uint32_t cell, uint32_t height) {
+    return static_cast<uint64_t>(cell) * 2 < height ? cell * 2 : 0;
+}
+
+} // namespace
+
+TestPattern::TestPattern(const Resolution& resolution, const Options& options)
+    : width_(resolution.getWidth()), height_(resolution.getHeight()) {
+    if (options.cell == 0 || options.lineWidth == 0) {
+        throw std::invalid_argument("Pattern cell size and line width must be at least 1 pixel");
+    }
+    channels_ = options.type != PatternType::Bars &&
+                (!options.foreground.isOpaque() || !options.background.isOpaque()) ? 4 : 3;
+
+    const Color& fg = options.foreground;
+    const Color& bg = options.background;
+    const uint32_t cell = options.cell;
+    rowTemplate_.resize(height_);
+
+    switch (options.type) {
+        case PatternType::Bars: {
+            // 75% bars at 7.5% setup, as 8-bit full-range RGB
+            const Color gray(191, 191, 191), yellow(191, 191, 0), cyan(0, 191, 191), green(0, 191, 0);
+            const Color magenta(191, 0, 191), red(191, 0, 0), blue(0, 0, 191), black(19, 19, 19);
+            templates_.push_back(spanRow(width_, channels_, 7, {
+                {1, gray}, {2, yellow}, {3, cyan}, {4, green}, {5, magenta}, {6, red}, {7, blue}}));
+            templates_.push_back(spanRow(width_, channels_, 7, {
+                {1, blue}, {2, black}, {3, magenta}, {4, black}, {5, cyan}, {6, black}, {7, gray}}));
+            // -I, white, +Q and black are 5/4 of a bar wide, the PLUGE steps 1/3 (84ths of the width)
+            templates_.push_back(spanRow(width_, channels_, 84, {
+                {15, Color(0, 33, 76)}, {30, Color(255, 255, 255)}, {45, Color(50, 0, 106)}, {60, black},
+                {64, Color(9, 9, 9)}, {68, black}, {72, Color(29, 29, 29)}, {84, black}}));
+
+            const uint32_t middle = static_cast<uint32_t>(static_cast<uint64_t>(height_) * 2 / 3);
+            const uint32_t bottom = static_cast<uint32_t>(static_cast<uint64_t>(height_) * 3 / 4);
+            for (uint32_t y = 0; y < height_; ++y) {
+                rowTemplate_[y] = y < middle ? 0 : y < bottom ? 1 : 2;
+            }
+            break;
+        }
+
+        case PatternType::Checkerboard:
+            templates_.push_back(alternatingRow(width_, channels_, cell, fg, bg));
+            templates_.push_back(alternatingRow(width_, channels_, cell, bg, fg));
+            for (uint32_t y = 0; y < height_; ++y) {
+                rowTemplate_[y] = (y / cell) % 2;
+            }
+            period_ = twoCells(cell, height_);
+            break;
+
+        case PatternType::Stripes:
+            templates_.push_back(alternatingRow(width_, channels_, cell, fg, bg));
+            period_ = 1;
+            break;
+
+        case PatternType::HorizontalStripes:
+            templates_.push_back(solidRow(width_, channels_, fg));
+            templates_.push_back(solidRow(width_, channels_, bg));
+            for (uint32_t y = 0; y < height_; ++y) {
+                rowTemplate_[y] = (y / cell) % 2;
+            }
+            period_ = twoCells(cell, height_);
+            break;
+
+        case PatternType::Grid: {
+            templates_.push_back(solidRow(width_, channels_, fg));
+            std::vector<uint8_t> columns = solidRow(width_, channels_, bg);
+            for (uint32_t x = 0; x < width_; x += cell) {
+                fillSpan(columns, x, x + std::min(options.lineWidth, width_ - x), fg, channels_);
+            }
+            templates_.push_back(std::move(columns));
+            for (uint32_t y = 0; y < height_; ++y) {
+                rowTemplate_[y] = y % cell < options.lineWidth ? 0 : 1;
+            }
+            period_ = cell < height_ ? cell : 0;
+            break;
+        }
+    }
+}
+
+const uint8_t* TestPattern::rows(uint32_t y, uint32_t count, uint8_t* scratch) const {
+    if (count == 1) {
+        return templates_[rowTemplate_[y]].data();
+    }
+    const size_t rowBytes = static_cast<size_t>(this->rowBytes());
+    for (uint32_t i = 0; i < count; ++i) {
+        std::memcpy(scratch + i * rowBytes, templates_[rowTemplate_[y + i]].data(), rowBytes);
+    }
+    return scratch;
+}
+
+uint32_t TestPattern::repeatedRows(uint32_t y) const {
+    if (y == 0 || y >= height_) {
+        return 0;
+    }
+    const uint8_t above = rowTemplate_[y - 1];
+    uint32_t end = y;
+    while (end < height_ && rowTemplate_[end] == above) {
+        ++end;
+    }
+    return end - y;
+}
+
+PatternType TestPattern::parseType(const std::string& name) {
+    if (name == "bars") return PatternType::Bars;
+    if (name == "checker") return PatternType::Checkerboard;
+    if (name == "stripes") return PatternType::Stripes;
+    if (name == "hstripes") return PatternType::HorizontalStripes;
+    if (name == "grid") return PatternType::Grid;
+    throw std::invalid_argument("Unknown pattern: " + name + " (expected bars, checker, stripes, hstripes or grid)");
+}
+
+} // namespace ColorGenerator
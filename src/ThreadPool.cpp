@@ -0,0 +1,139 @@
+#include "../include/ThreadPool.hpp"
+#include <algorithm>
+#include <atomic>
+#include <exception>
+
+namespace ColorGenerator {
+
+namespace {
+
+/// Set on pool workers and on threads running a parallelFor()
+thread_local bool nested = false;
+
+} // namespace
+
+ThreadPool::ThreadPool(size_t threads, size_t queueCapacity) {
+    if (threads == 0) {
+        threads = defaultThreadCount();
+    }
+    capacity_ = queueCapacity ? queueCapacity : threads * 4;
+
+    workers_.reserve(threads);
+    for (size_t i = 0; i < threads; ++i) {
+        workers_.emplace_back(&ThreadPool::workerLoop, this, i);
+    }
+}
+
+ThreadPool::~ThreadPool() {
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        stopping_ = true;
+    }
+    taskReady_.notify_all();
+    for (std::thread& worker : workers_) {
+        worker.join();
+    }
+}
+
+size_t ThreadPool::defaultThreadCount() {
+    unsigned int count = std::thread::hardware_concurrency();
+    return count ? count : 1;
+}
+
+size_t ThreadPool::availableThreads() {
+    return nested ? 1 : defaultThreadCount();
+}
+
+void ThreadPool::parallelFor(size_t count, size_t threads,
+                             const std::function<void(size_t index, size_t thread)>& task) {
+    if (threads == 0) {
+        threads = availableThreads();
+    }
+    threads = std::min(threads, count);
+    if (threads <= 1) {
+        for (size_t i = 0; i < count; ++i) {
+            task(i, 0);
+        }
+        return;
+    }
+
+    std::atomic<size_t> next{0};
+    std::exception_ptr error;
+    std::mutex errorMutex;
+    auto work = [&](size_t thread) {
+        const bool outer = nested;
+        nested = true;
+        try {
+            for (size_t i = next++; i < count; i = next++) {
+                task(i, thread);
+            }
+        } catch (...) {
+            next = count;  // the other threads stop after their current index
+            std::lock_guard<std::mutex> lock(errorMutex);
+            if (!error) {
+                error = std::current_exception();
+            }
+        }
+        nested = outer;
+    };
+
+    std::vector<std::thread> workers;
+    workers.reserve(threads - 1);
+    for (size_t t = 1; t < threads; ++t) {
+        workers.emplace_back(work, t);
+    }
+    work(0);
+    for (std::thread& worker : workers) {
+        worker.join();
+    }
+    if (error) {
+        std::rethrow_exception(error);
+    }
+}
+
+void ThreadPool::submit(Task task) {
+    std::unique_lock<std::mutex> lock(mutex_);
+    spaceReady_.wait(lock, [this] { return queue_.size() < capacity_; });
+    queue_.push_back(std::move(task));
+    lock.unlock();
+    taskReady_.notify_one();
+}
+
+void ThreadPool::wait() {
+    std::unique_lock<std::mutex> lock(mutex_);
+    idle_.wait(lock, [this] { return queue_.empty() && active_ == 0; });
+}
+
+void ThreadPool::workerLoop(size_t index) {
+    nested = true;
+    for (;;) {
+        Task task;
+        {
+            std::unique_lock<std::mutex> lock(mutex_);
+            taskReady_.wait(lock, [this] { return stopping_ || !queue_.empty(); });
+            if (queue_.empty()) {
+                return;  // stopping and drained
+            }
+            task = std::move(queue_.front());
+            queue_.pop_front();
+            ++active_;
+        }
+        spaceReady_.notify_one();
+
+        // Tasks report their own errors; never let one take down the worker
+        try {
+            task(index);
+        } catch (...) {
+        }
+
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            --active_;
+            if (queue_.empty() && active_ == 0) {
+                idle_.notify_all();
+            }
+        }
+    }
+}
+
+} // namespace ColorGenerator
@@ -0,0 +1,271 @@
+#include "../../include/formats/APNGEncoder.hpp"
+#include "../../include/formats/ByteSink.hpp"
+#include "../../include/formats/PNGChunk.hpp"
+#include "../../include/formats/Deflate.hpp"
+#include "../../include/ThreadPool.hpp"
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <map>
+#include <numeric>
+#include <stdexcept>
+#include <vector>
+
+namespace ColorGenerator {
+
+namespace {
+
+// PNG scanline filter types
+constexpr uint8_t FILTER_NONE = 0;
+constexpr uint8_t FILTER_UP = 2;
+
+// fcTL dispose and blend operations
+constexpr uint8_t DISPOSE_OP_NONE = 0;
+constexpr uint8_t BLEND_OP_SOURCE = 0;
+
+void putU16BE(uint8_t* dst, uint16_t value) {
+    dst[0] = static_cast<uint8_t>(value >> 8);
+    dst[1] = static_cast<uint8_t>(value);
+}
+
+/**
+ * @brief Deflate tokens of a solid image: filter None on the first row, Up (all zeros) after
+ * @param out DeflateWriter, or DeflateCode::Counts to count the symbols
+ */
+template <typename Out>
+void solidTokens(Out& out, const uint8_t* pixel, int channels, uint32_t width, uint32_t height) {
+    static const uint8_t zero = 0;
+    const size_t rowBytes = static_cast<size_t>(width) * channels;
+
+    out.literal(FILTER_NONE);
+    for (int c = 0; c < channels; ++c) {
+        out.literal(pixel[c]);
+    }
+    out.run(rowBytes - channels, static_cast<uint32_t>(channels), pixel);
+
+    for (uint32_t y = 1; y < height; ++y) {
+        out.literal(FILTER_UP);
+        out.literal(0);
+        out.run(rowBytes - 1, 1, &zero);
+    }
+    out.endOfBlock();
+}
+
+/**
+ * @brief Complete zlib stream of a solid @p width x @p height image of @p pixel
+ */
+std::vector<uint8_t> compressSolid(const uint8_t* pixel, int channels, uint32_t width, uint32_t height) {
+    DeflateCode::Counts counts;
+    solidTokens(counts, pixel, channels, width, height);
+    const DeflateCode code(counts);
+
+    std::vector<uint8_t> zdata = {0x78, 0x01};
+    DeflateWriter deflate(zdata);
+    deflate.beginDynamicBlock(true, code);
+    solidTokens(deflate, pixel, channels, width, height);
+    deflate.flush();
+
+    const size_t rowBytes = static_cast<size_t>(width) * channels;
+    std::vector<uint8_t> firstRow(rowBytes + 1);
+    firstRow[0] = FILTER_NONE;
+    for (size_t i = 0; i < rowBytes; ++i) {
+        firstRow[1 + i] = pixel[i % channels];
+    }
+    Adler32 adler;
+    adler.update(firstRow.data(), firstRow.size());
+    for (uint32_t y = 1; y < height; ++y) {
+        adler.updateByte(FILTER_UP);
+        adler.updateZeros(rowBytes);
+    }
+
+    uint8_t trailer[4];
+    putU32BE(trailer, adler.value());
+    zdata.insert(zdata.end(), trailer, trailer + 4);
+    return zdata;
+}
+
+/**
+ * @brief One fcTL frame: a color held for a delay of num/den seconds
+ */
+struct Frame {
+    size_t color;   ///< Index into the distinct colors
+    uint16_t delayNum;
+    uint16_t delayDen;
+    bool hold;      ///< 1x1 continuation of the previous frame's delay
+};
+
+/**
+ * @brief Frames showing @p color for @p count frame periods
+ *
+ * The delay is exact when it fits the 16-bit fraction, otherwise rounded
+ * to milliseconds and split across hold frames of at most 65.535 s.
+ */
+void appendFrames(std::vector<Frame>& frames, size_t color, uint64_t count, const APNGEncoder::Options& options) {
+    uint64_t num = count * options.frameRateDen;
+    uint64_t den = options.frameRateNum;
+    const uint64_t divisor = std::gcd(num, den);
+    num /= divisor;
+    den /= divisor;
+    if (num <= 0xFFFF && den <= 0xFFFF) {
+        frames.push_back({color, static_cast<uint16_t>(num), static_cast<uint16_t>(den), false});
+        return;
+    }
+
+    uint64_t ms = static_cast<uint64_t>(std::llround(static_cast<long double>(num) * 1000 / den));
+    bool hold = false;
+    do {
+        const uint64_t piece = std::min<uint64_t>(ms, 0xFFFF);
+        frames.push_back({color, static_cast<uint16_t>(piece), 1000, hold});
+        ms -= piece;
+        hold = true;
+    } while (ms > 0);
+}
+
+} // namespace
+
+void APNGEncoder::write(const std::string& filename, const Fade& fade, const Resolution& resolution,
+                        const Options& options) {
+    if (options.frameRateNum == 0 || options.frameRateDen == 0) {
+        throw std::invalid_argument("Frame rate must be positive");
+    }
+    const uint32_t width = resolution.getWidth();
+    const uint32_t height = resolution.getHeight();
+
+    // Distinct colors in order of appearance, and frames as runs of one color
+    std::vector<Color> colors;
+    std::map<uint32_t, size_t> colorIndex;
+    std::vector<Frame> frames;
+    size_t runColor = 0;
+    uint64_t run = 0;
+    for (uint32_t i = 0; i < fade.frames(); ++i) {
+        const Color color = fade.color(i);
+        const uint32_t key = static_cast<uint32_t>(color.getRed()) << 24 | color.getGreen() << 16 |
+                             color.getBlue() << 8 | color.getAlpha();
+        auto it = colorIndex.find(key);
+        if (it == colorIndex.end()) {
+            it = colorIndex.emplace(key, colors.size()).first;
+            colors.push_back(color);
+        }
+        if (run > 0 && it->second == runColor) {
+            ++run;
+            continue;
+        }
+        if (run > 0) {
+            appendFrames(frames, runColor, run, options);
+        }
+        runColor = it->second;
+        run = 1;
+    }
+    appendFrames(frames, runColor, run, options);
+
+    const bool palette = colors.size() <= 256;
+    const bool translucent = std::any_of(colors.begin(), colors.end(),
+                                         [](const Color& c) { return !c.isOpaque(); });
+    const int channels = palette ? 1 : translucent ? 4 : 3;
+    auto pixelOf = [&](size_t index, uint8_t* pixel) {
+        const Color& c = colors[index];
+        if (palette) {
+            pixel[0] = static_cast<uint8_t>(index);
+        } else {
+            pixel[0] = c.getRed();
+            pixel[1] = c.getGreen();
+            pixel[2] = c.getBlue();
+            pixel[3] = c.getAlpha();
+        }
+    };
+
+    // Each distinct color is compressed once, on whichever thread gets to it
+    std::vector<std::vector<uint8_t>> compressed(colors.size());
+    size_t threads = options.threads;
+    if (threads == 0) {
+        threads = ThreadPool::availableThreads();
+    }
+    threads = std::max<size_t>(1, std::min(threads, colors.size() / MIN_COLORS_PER_THREAD));
+    ThreadPool::parallelFor(colors.size(), threads, [&](size_t i, size_t) {
+        uint8_t pixel[4];
+        pixelOf(i, pixel);
+        compressed[i] = compressSolid(pixel, channels, width, height);
+    });
+
+    FileSink sink(filename, IDAT_CHUNK_SIZE);
+    sink.write(PNGChunk::SIGNATURE, sizeof(PNGChunk::SIGNATURE));
+
+    uint8_t ihdr[13];
+    putU32BE(ihdr, width);
+    putU32BE(ihdr + 4, height);
+    ihdr[8] = 8;                                           // bit depth
+    ihdr[9] = palette ? 3 : channels == 4 ? 6 : 2;          // color type: palette, RGBA or RGB
+    ihdr[10] = 0;                                          // compression
+    ihdr[11] = 0;                                          // filter method
+    ihdr[12] = 0;                                          // interlace
+    PNGChunk::write(sink, "IHDR", ihdr, sizeof(ihdr));
+
+    uint8_t actl[8];
+    putU32BE(actl, static_cast<uint32_t>(frames.size()));
+    putU32BE(actl + 4, options.loops);
+    PNGChunk::write(sink, "acTL", actl, sizeof(actl));
+
+    if (palette) {
+        std::vector<uint8_t> plte;
+        std::vector<uint8_t> trns;
+        for (const Color& c : colors) {
+            plte.insert(plte.end(), {c.getRed(), c.getGreen(), c.getBlue()});
+            trns.push_back(c.getAlpha());
+        }
+        PNGChunk::write(sink, "PLTE", plte.data(), plte.size());
+        // Entries after the last translucent one default to opaque
+        while (!trns.empty() && trns.back() == 255) {
+            trns.pop_back();
+        }
+        if (!trns.empty()) {
+            PNGChunk::write(sink, "tRNS", trns.data(), trns.size());
+        }
+    }
+
+    // Sequence numbers are shared by fcTL and fdAT chunks
+    uint32_t sequence = 0;
+    std::vector<uint8_t> chunk;
+    for (size_t f = 0; f < frames.size(); ++f) {
+        const Frame& frame = frames[f];
+        const uint32_t frameWidth = frame.hold ? 1 : width;
+        const uint32_t frameHeight = frame.hold ? 1 : height;
+
+        uint8_t fctl[26];
+        putU32BE(fctl, sequence++);
+        putU32BE(fctl + 4, frameWidth);
+        putU32BE(fctl + 8, frameHeight);
+        putU32BE(fctl + 12, 0);  // x offset
+        putU32BE(fctl + 16, 0);  // y offset
+        putU16BE(fctl + 20, frame.delayNum);
+        putU16BE(fctl + 22, frame.delayDen);
+        fctl[24] = DISPOSE_OP_NONE;
+        fctl[25] = BLEND_OP_SOURCE;
+        PNGChunk::write(sink, "fcTL", fctl, sizeof(fctl));
+
+        std::vector<uint8_t> hold;
+        if (frame.hold) {
+            uint8_t pixel[4];
+            pixelOf(frame.color, pixel);
+            hold = compressSolid(pixel, channels, 1, 1);
+        }
+        const std::vector<uint8_t>& zdata = frame.hold ? hold : compressed[frame.color];
+
+        // The first frame is the default image (IDAT); later ones carry sequence numbers (fdAT)
+        for (size_t offset = 0; offset < zdata.size(); offset += IDAT_CHUNK_SIZE) {
+            const size_t length = std::min(IDAT_CHUNK_SIZE, zdata.size() - offset);
+            if (f == 0) {
+                PNGChunk::write(sink, "IDAT", zdata.data() + offset, length);
+                continue;
+            }
+            chunk.resize(4 + length);
+            putU32BE(chunk.data(), sequence++);
+            std::memcpy(chunk.data() + 4, zdata.data() + offset, length);
+            PNGChunk::write(sink, "fdAT", chunk.data(), chunk.size());
+        }
+    }
+
+    PNGChunk::write(sink, "IEND", nullptr, 0);
+    sink.finish();
+}
+
+} // namespace ColorGenerator
@@ -0,0 +1,122 @@
+#include "../../include/formats/BMPEncoder.hpp"
+#include "../../include/formats/ByteSink.hpp"
+#include <algorithm>
+#include <cstring>
+#include <limits>
+#include <stdexcept>
+#include <vector>
+
+namespace ColorGenerator {
+
+namespace {
+
+constexpr size_t FILE_HEADER_SIZE = 14;
+constexpr size_t INFO_HEADER_SIZE = 40;
+constexpr size_t V4_HEADER_SIZE = 108;
+
+void putU16LE(uint8_t*& dst, uint16_t value) {
+    dst[0] = static_cast<uint8_t>(value);
+    dst[1] = static_cast<uint8_t>(value >> 8);
+    dst += 2;
+}
+
+void putU32LE(uint8_t*& dst, uint32_t value) {
+    dst[0] = static_cast<uint8_t>(value);
+    dst[1] = static_cast<uint8_t>(value >> 8);
+    dst[2] = static_cast<uint8_t>(value >> 16);
+    dst[3] = static_cast<uint8_t>(value >> 24);
+    dst += 4;
+}
+
+size_t headerSize(int channels) {
+    return FILE_HEADER_SIZE + (channels == 4 ? V4_HEADER_SIZE : INFO_HEADER_SIZE);
+}
+
+uint64_t rowStride(uint32_t width, int channels) {
+    return (static_cast<uint64_t>(width) * channels + 3) & ~static_cast<uint64_t>(3);
+}
+
+} // namespace
+
+uint64_t BMPEncoder::fileSize(uint32_t width, uint32_t height, int channels) {
+    if (channels != 3 && channels != 4) {
+        throw std::invalid_argument("BMP channel count must be 3 or 4");
+    }
+    return headerSize(channels) + rowStride(width, channels) * height;
+}
+
+size_t BMPEncoder::writeHeaders(uint8_t* dst, uint32_t width, uint32_t height, int channels) {
+    const uint64_t size = fileSize(width, height, channels);
+    const size_t header = headerSize(channels);
+    uint8_t* p = dst;
+
+    // BITMAPFILEHEADER; sizes above 4 GiB cannot be represented and are left 0
+    *p++ = 'B';
+    *p++ = 'M';
+    putU32LE(p, size <= std::numeric_limits<uint32_t>::max() ? static_cast<uint32_t>(size) : 0);
+    putU16LE(p, 0);
+    putU16LE(p, 0);
+    putU32LE(p, static_cast<uint32_t>(header));
+
+    // BITMAPINFOHEADER fields (shared prefix of the V4 header)
+    putU32LE(p, static_cast<uint32_t>(header - FILE_HEADER_SIZE));
+    putU32LE(p, width);
+    putU32LE(p, height);               // positive height: bottom-up rows
+    putU16LE(p, 1);                    // planes
+    putU16LE(p, static_cast<uint16_t>(channels * 8));
+    putU32LE(p, channels == 4 ? 3 : 0); // BI_BITFIELDS or BI_RGB
+    for (int i = 0; i < 5; ++i) {
+        putU32LE(p, 0);                // image size, resolution, palette
+    }
+    if (channels == 4) {
+        putU32LE(p, 0x00FF0000u);      // red mask
+        putU32LE(p, 0x0000FF00u);      // green mask
+        putU32LE(p, 0x000000FFu);      // blue mask
+        putU32LE(p, 0xFF000000u);      // alpha mask
+        std::memset(p, 0, V4_HEADER_SIZE - INFO_HEADER_SIZE - 16);
+    }
+    return header;
+}
+
+void BMPEncoder::write(const std::string& filename, const RowSource& source) {
+    const int channels = source.channels();
+    const uint32_t width = source.width();
+    const uint32_t height = source.height();
+    const size_t stride = static_cast<size_t>(rowStride(width, channels));
+    const size_t rowBytes = static_cast<size_t>(source.rowBytes());
+
+    uint8_t header[MAX_HEADER_SIZE];
+    FileSink sink(filename);
+    sink.write(header, writeHeaders(header, width, height, channels));
+
+    const uint32_t batchRows = static_cast<uint32_t>(
+        std::max<size_t>(1, std::min<size_t>(height, READ_BYTES / rowBytes)));
+    std::vector<uint8_t> scratch(static_cast<size_t>(batchRows) * rowBytes);
+    std::vector<uint8_t> out(static_cast<size_t>(batchRows) * stride, 0);
+
+    // File rows run bottom-up, so read batches from the bottom of the image
+    for (uint32_t end = height; end > 0;) {
+        const uint32_t count = std::min(batchRows, end);
+        const uint32_t y0 = end - count;
+        const uint8_t* rows = source.rows(y0, count, scratch.data());
+
+        for (uint32_t i = 0; i < count; ++i) {
+            const uint8_t* src = rows + static_cast<size_t>(count - 1 - i) * rowBytes;
+            uint8_t* dst = out.data() + static_cast<size_t>(i) * stride;
+            for (size_t x = 0; x < rowBytes; x += channels) {
+                dst[x] = src[x + 2];
+                dst[x + 1] = src[x + 1];
+                dst[x + 2] = src[x];
+                if (channels == 4) {
+                    dst[x + 3] = src[x + 3];
+                }
+            }
+        }
+        sink.write(out.data(), static_cast<size_t>(count) * stride);
+        end = y0;
+    }
+
+    sink.finish();
+}
+
+} // namespace ColorGenerator
@@ -0,0 +1,307 @@
+#include "../../include/formats/Checksum.hpp"
+#include "../../include/CpuFeatures.hpp"
+#include <array>
+
+#ifdef COLORGEN_X86
+    #include <immintrin.h>
+#endif
+
+namespace ColorGenerator {
+
+namespace {
+
+// Largest byte count whose Adler-32 sums cannot overflow 32 bits
+constexpr size_t ADLER_NMAX = 5552;
+
+/**
+ * @brief Slicing-by-8 tables: table[k][n] is the CRC of byte n followed by k zeros
+ */
+using CrcTables = std::array<std::array<uint32_t, 256>, 8>;
+
+const CrcTables& crcTables() {
+    static const CrcTables tables = [] {
+        CrcTables t{};
+        for (uint32_t n = 0; n < 256; ++n) {
+            uint32_t c = n;
+            for (int k = 0; k < 8; ++k) {
+                c = (c & 1) ? 0xEDB88320u ^ (c >> 1) : c >> 1;
+            }
+            t[0][n] = c;
+        }
+        for (uint32_t n = 0; n < 256; ++n) {
+            for (int k = 1; k < 8; ++k) {
+                t[k][n] = (t[k - 1][n] >> 8) ^ t[0][t[k - 1][n] & 0xFF];
+            }
+        }
+        return t;
+    }();
+    return tables;
+}
+
+/**
+ * @brief Slicing-by-8 on the inverted CRC register
+ */
+uint32_t crcSlicing(uint32_t crc, const uint8_t* data, size_t length) {
+    const CrcTables& t = crcTables();
+    while (length >= 8) {
+        const uint32_t one = crc ^ (data[0] | data[1] << 8 | data[2] << 16 | static_cast<uint32_t>(data[3]) << 24);
+        const uint32_t two = data[4] | data[5] << 8 | data[6] << 16 | static_cast<uint32_t>(data[7]) << 24;
+        crc = t[7][one & 0xFF] ^ t[6][(one >> 8) & 0xFF] ^ t[5][(one >> 16) & 0xFF] ^ t[4][one >> 24] ^
+              t[3][two & 0xFF] ^ t[2][(two >> 8) & 0xFF] ^ t[1][(two >> 16) & 0xFF] ^ t[0][two >> 24];
+        data += 8;
+        length -= 8;
+    }
+    while (length--) {
+        crc = t[0][(crc ^ *data++) & 0xFF] ^ (crc >> 8);
+    }
+    return crc;
+}
+
+uint32_t adlerScalar(uint32_t adler, const uint8_t* data, size_t length) {
+    uint32_t a = adler & 0xFFFF;
+    uint32_t b = adler >> 16;
+    while (length > 0) {
+        size_t block = length < ADLER_NMAX ? length : ADLER_NMAX;
+        length -= block;
+        while (block--) {
+            a += *data++;
+            b += a;
+        }
+        a %= Adler32::MOD;
+        b %= Adler32::MOD;
+    }
+    return b << 16 | a;
+}
+
+#ifdef COLORGEN_X86
+
+COLORGEN_TARGET("sse2") inline __m128i load128(const uint8_t* p) {
+    return _mm_loadu_si128(reinterpret_cast<const __m128i*>(p));
+}
+
+/**
+ * @brief Fold one 128-bit lane forward by the distance encoded in @p k and add @p next
+ */
+COLORGEN_TARGET("sse2,pclmul") inline __m128i fold128(__m128i x, __m128i k, __m128i next) {
+    const __m128i low = _mm_clmulepi64_si128(x, k, 0x00);
+    const __m128i high = _mm_clmulepi64_si128(x, k, 0x11);
+    return _mm_xor_si128(_mm_xor_si128(low, high), next);
+}
+
+/**
+ * @brief CRC folding with carry-less multiplies (Intel's "Fast CRC
+ *        Computation Using PCLMULQDQ"), on the inverted CRC register
+ *
+ * Four 128-bit lanes are folded 64 bytes at a time, reduced to one lane,
+ * then to 32 bits with a Barrett reduction. @p length must be a multiple
+ * of 16 and at least 64.
+ */
+COLORGEN_TARGET("sse2,pclmul") uint32_t crcFoldPCLMUL(uint32_t crc, const uint8_t* data, size_t length) {
+    alignas(16) static const uint64_t k1k2[2] = {0x0154442BD4, 0x01C6E41596};
+    alignas(16) static const uint64_t k3k4[2] = {0x01751997D0, 0x00CCAA009E};
+    alignas(16) static const uint64_t k5k0[2] = {0x0163CD6124, 0x0000000000};
+    alignas(16) static const uint64_t poly[2] = {0x01DB710641, 0x01F7011641};
+
+    __m128i x1 = load128(data);
+    __m128i x2 = load128(data + 16);
+    __m128i x3 = load128(data + 32);
+    __m128i x4 = load128(data + 48);
+    x1 = _mm_xor_si128(x1, _mm_cvtsi32_si128(static_cast<int>(crc)));
+    __m128i k = _mm_load_si128(reinterpret_cast<const __m128i*>(k1k2));
+    data += 64;
+    length -= 64;
+
+    while (length >= 64) {
+        x1 = fold128(x1, k, load128(data));
+        x2 = fold128(x2, k, load128(data + 16));
+        x3 = fold128(x3, k, load128(data + 32));
+        x4 = fold128(x4, k, load128(data + 48));
+        data += 64;
+        length -= 64;
+    }
+
+    // Fold the four lanes into one, then any remaining 16-byte blocks
+    k = _mm_load_si128(reinterpret_cast<const __m128i*>(k3k4));
+    x1 = fold128(x1, k, x2);
+    x1 = fold128(x1, k, x3);
+    x1 = fold128(x1, k, x4);
+    while (length >= 16) {
+        x1 = fold128(x1, k, load128(data));
+        data += 16;
+        length -= 16;
+    }
+
+    // 128 -> 64 bits
+    const __m128i mask32 = _mm_setr_epi32(~0, 0, ~0, 0);
+    __m128i x0 = _mm_clmulepi64_si128(x1, k, 0x10);
+    x1 = _mm_xor_si128(_mm_srli_si128(x1, 8), x0);
+    k = _mm_loadl_epi64(reinterpret_cast<const __m128i*>(k5k0));
+    x0 = _mm_srli_si128(x1, 4);
+    x1 = _mm_and_si128(x1, mask32);
+    x1 = _mm_xor_si128(_mm_clmulepi64_si128(x1, k, 0x00), x0);
+
+    // Barrett reduction to 32 bits
+    k = _mm_load_si128(reinterpret_cast<const __m128i*>(poly));
+    x0 = _mm_and_si128(x1, mask32);
+    x0 = _mm_clmulepi64_si128(x0, k, 0x10);
+    x0 = _mm_and_si128(x0, mask32);
+    x0 = _mm_clmulepi64_si128(x0, k, 0x00);
+    x1 = _mm_xor_si128(x1, x0);
+    return static_cast<uint32_t>(_mm_cvtsi128_si32(_mm_srli_si128(x1, 4)));
+}
+
+uint32_t crcPCLMUL(uint32_t crc, const uint8_t* data, size_t length) {
+    if (length >= 64) {
+        const size_t folded = length & ~static_cast<size_t>(15);
+        crc = crcFoldPCLMUL(crc, data, folded);
+        data += folded;
+        length -= folded;
+    }
+    return crcSlicing(crc, data, length);
+}
+
+/**
+ * @brief Adler-32 over 32-byte blocks: a via sum-of-absolute-differences,
+ *        b via multiply-add against the weights 32..1
+ *
+ * The running a at the start of each block is accumulated separately
+ * and added to b as 32 times its sum once per NMAX chunk.
+ */
+COLORGEN_TARGET("ssse3") uint32_t adlerSSSE3(uint32_t adler, const uint8_t* data, size_t length) {
+    constexpr size_t BLOCK = 32;
+    uint32_t a = adler & 0xFFFF;
+    uint32_t b = adler >> 16;
+
+    const __m128i tap1 = _mm_setr_epi8(32, 31, 30, 29, 28, 27, 26, 25, 24, 23, 22, 21, 20, 19, 18, 17);
+    const __m128i tap2 = _mm_setr_epi8(16, 15, 14, 13, 12, 11, 10, 9, 8, 7, 6, 5, 4, 3, 2, 1);
+    const __m128i zero = _mm_setzero_si128();
+    const __m128i ones = _mm_set1_epi16(1);
+
+    size_t blocks = length / BLOCK;
+    length -= blocks * BLOCK;
+    while (blocks > 0) {
+        size_t n = ADLER_NMAX / BLOCK;
+        if (n > blocks) n = blocks;
+        blocks -= n;
+
+        __m128i prefix = _mm_cvtsi32_si128(static_cast<int>(a * n));
+        __m128i sumB = _mm_cvtsi32_si128(static_cast<int>(b));
+        __m128i sumA = zero;
+        do {
+            const __m128i bytes1 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(data));
+            const __m128i bytes2 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(data + 16));
+            prefix = _mm_add_epi32(prefix, sumA);
+            sumA = _mm_add_epi32(sumA, _mm_sad_epu8(bytes1, zero));
+            sumB = _mm_add_epi32(sumB, _mm_madd_epi16(_mm_maddubs_epi16(bytes1, tap1), ones));
+            sumA = _mm_add_epi32(sumA, _mm_sad_epu8(bytes2, zero));
+            sumB = _mm_add_epi32(sumB, _mm_madd_epi16(_mm_maddubs_epi16(bytes2, tap2), ones));
+            data += BLOCK;
+        } while (--n);
+        sumB = _mm_add_epi32(sumB, _mm_slli_epi32(prefix, 5));
+
+        sumA = _mm_add_epi32(sumA, _mm_shuffle_epi32(sumA, _MM_SHUFFLE(2, 3, 0, 1)));
+        sumA = _mm_add_epi32(sumA, _mm_shuffle_epi32(sumA, _MM_SHUFFLE(1, 0, 3, 2)));
+        a += static_cast<uint32_t>(_mm_cvtsi128_si32(sumA));
+        sumB = _mm_add_epi32(sumB, _mm_shuffle_epi32(sumB, _MM_SHUFFLE(2, 3, 0, 1)));
+        sumB = _mm_add_epi32(sumB, _mm_shuffle_epi32(sumB, _MM_SHUFFLE(1, 0, 3, 2)));
+        b = static_cast<uint32_t>(_mm_cvtsi128_si32(sumB));
+
+        a %= Adler32::MOD;
+        b %= Adler32::MOD;
+    }
+    return adlerScalar(b << 16 | a, data, length);
+}
+
+/**
+ * @brief AVX2 version of adlerSSSE3 with one 32-byte load per block
+ */
+COLORGEN_TARGET("avx2") uint32_t adlerAVX2(uint32_t adler, const uint8_t* data, size_t length) {
+    constexpr size_t BLOCK = 32;
+    uint32_t a = adler & 0xFFFF;
+    uint32_t b = adler >> 16;
+
+    const __m256i tap = _mm256_setr_epi8(32, 31, 30, 29, 28, 27, 26, 25, 24, 23, 22, 21, 20, 19, 18, 17,
+                                         16, 15, 14, 13, 12, 11, 10, 9, 8, 7, 6, 5, 4, 3, 2, 1);
+    const __m256i zero = _mm256_setzero_si256();
+    const __m256i ones = _mm256_set1_epi16(1);
+
+    size_t blocks = length / BLOCK;
+    length -= blocks * BLOCK;
+    while (blocks > 0) {
+        size_t n = ADLER_NMAX / BLOCK;
+        if (n > blocks) n = blocks;
+        blocks -= n;
+
+        __m256i prefix = _mm256_setr_epi32(static_cast<int>(a * n), 0, 0, 0, 0, 0, 0, 0);
+        __m256i sumB = _mm256_setr_epi32(static_cast<int>(b), 0, 0, 0, 0, 0, 0, 0);
+        __m256i sumA = zero;
+        do {
+            const __m256i bytes = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(data));
+            prefix = _mm256_add_epi32(prefix, sumA);
+            sumA = _mm256_add_epi32(sumA, _mm256_sad_epu8(bytes, zero));
+            sumB = _mm256_add_epi32(sumB, _mm256_madd_epi16(_mm256_maddubs_epi16(bytes, tap), ones));
+            data += BLOCK;
+        } while (--n);
+        sumB = _mm256_add_epi32(sumB, _mm256_slli_epi32(prefix, 5));
+
+        __m128i lowA = _mm_add_epi32(_mm256_castsi256_si128(sumA), _mm256_extracti128_si256(sumA, 1));
+        lowA = _mm_add_epi32(lowA, _mm_shuffle_epi32(lowA, _MM_SHUFFLE(1, 0, 3, 2)));
+        a += static_cast<uint32_t>(_mm_cvtsi128_si32(lowA));
+        __m128i lowB = _mm_add_epi32(_mm256_castsi256_si128(sumB), _mm256_extracti128_si256(sumB, 1));
+        lowB = _mm_add_epi32(lowB, _mm_shuffle_epi32(lowB, _MM_SHUFFLE(2, 3, 0, 1)));
+        lowB = _mm_add_epi32(lowB, _mm_shuffle_epi32(lowB, _MM_SHUFFLE(1, 0, 3, 2)));
+        b = static_cast<uint32_t>(_mm_cvtsi128_si32(lowB));
+
+        a %= Adler32::MOD;
+        b %= Adler32::MOD;
+    }
+    return adlerScalar(b << 16 | a, data, length);
+}
+
+#endif
+
+using Kernel = uint32_t (*)(uint32_t, const uint8_t*, size_t);
+
+Kernel selectCrc() {
+#ifdef COLORGEN_X86
+    const CpuFeatures& cpu = CpuFeatures::get();
+    if (cpu.pclmul && cpu.sse2) return crcPCLMUL;
+#endif
+    return crcSlicing;
+}
+
+Kernel selectAdler() {
+#ifdef COLORGEN_X86
+    const CpuFeatures& cpu = CpuFeatures::get();
+    if (cpu.avx2) return adlerAVX2;
+    if (cpu.ssse3) return adlerSSSE3;
+#endif
+    return adlerScalar;
+}
+
+} // namespace
+
+uint32_t Crc32::update(uint32_t crc, const uint8_t* data, size_t length) {
+    static const Kernel kernel = selectCrc();
+    return ~kernel(~crc, data, length);
+}
+
+void Adler32::update(const uint8_t* data, size_t length) {
+    static const Kernel kernel = selectAdler();
+    const uint32_t adler = kernel(value(), data, length);
+    a_ = adler & 0xFFFF;
+    b_ = adler >> 16;
+}
+
+uint32_t Adler32::combine(uint32_t first, uint32_t second, uint64_t secondLength) {
+    const uint64_t rem = secondLength % MOD;
+    uint64_t a = first & 0xFFFF;
+    uint64_t b = (rem * a) % MOD;
+    a += (second & 0xFFFF) + MOD - 1;
+    b += (first >> 16) + (second >> 16) + MOD - rem;
+    a %= MOD;
+    b %= MOD;
+    return static_cast<uint32_t>(b << 16 | a);
+}
+
+} // namespace ColorGenerator
@@ -0,0 +1,800 @@
+#include "../../include/formats/Deflate.hpp"
+#include "../../include/ThreadPool.hpp"
+#include <algorithm>
+#include <array>
+#include <cstring>
+#include <stdexcept>
+
+namespace ColorGenerator {
+
+namespace {
+
+constexpr size_t MAX_MATCH = 258;
+constexpr size_t MIN_MATCH = 3;
+constexpr uint32_t MAX_DISTANCE = 32768;
+
+// Matches at least this long are taken without looking one byte ahead
+constexpr size_t GOOD_MATCH = 32;
+
+constexpr int HASH_BITS = 15;
+constexpr uint32_t HASH_SIZE = 1u << HASH_BITS;
+
+using Code = DeflateCode::Code;
+
+uint32_t reverseBits(uint32_t value, int length) {
+    uint32_t result = 0;
+    for (int i = 0; i < length; ++i) {
+        result = (result << 1) | (value & 1);
+        value >>= 1;
+    }
+    return result;
+}
+
+const uint16_t LENGTH_BASE[29] = {
+    3, 4, 5, 6, 7, 8, 9, 10, 11, 13, 15, 17, 19, 23, 27, 31,
+    35, 43, 51, 59, 67, 83, 99, 115, 131, 163, 195, 227, 258
+};
+const uint8_t LENGTH_EXTRA[29] = {
+    0, 0, 0, 0, 0, 0, 0, 0, 1, 1, 1, 1, 2, 2, 2, 2,
+    3, 3, 3, 3, 4, 4, 4, 4, 5, 5, 5, 5, 0
+};
+const uint16_t DIST_BASE[30] = {
+    1, 2, 3, 4, 5, 7, 9, 13, 17, 25, 33, 49, 65, 97, 129, 193,
+    257, 385, 513, 769, 1025, 1537, 2049, 3073, 4097, 6145, 8193, 12289, 16385, 24577
+};
+const uint8_t DIST_EXTRA[30] = {
+    0, 0, 0, 0, 1, 1, 2, 2, 3, 3, 4, 4, 5, 5, 6, 6,
+    7, 7, 8, 8, 9, 9, 10, 10, 11, 11, 12, 12, 13, 13
+};
+
+/**
+ * @brief Length and distance code lookups (zlib's _length_code and _dist_code)
+ */
+struct CodeTables {
+    uint8_t length[MAX_MATCH + 1];
+    uint8_t distance[512];
+
+    CodeTables() {
+        int lc = 0;
+        for (size_t len = MIN_MATCH; len <= MAX_MATCH; ++len) {
+            while (lc < 28 && LENGTH_BASE[lc + 1] <= len) ++lc;
+            length[len] = static_cast<uint8_t>(lc);
+        }
+        // Distances up to 256 index directly, larger ones by (distance - 1) >> 7
+        int dc = 0;
+        for (uint32_t d = 1; d <= 256; ++d) {
+            while (dc < 29 && DIST_BASE[dc + 1] <= d) ++dc;
+            distance[d - 1] = static_cast<uint8_t>(dc);
+        }
+        for (uint32_t i = 2; i < 256; ++i) {
+            const uint32_t d = (i << 7) + 1;
+            while (dc < 29 && DIST_BASE[dc + 1] <= d) ++dc;
+            distance[256 + i] = static_cast<uint8_t>(dc);
+        }
+    }
+
+    int distanceCode(uint32_t d) const {
+        return d <= 256 ? distance[d - 1] : distance[256 + ((d - 1) >> 7)];
+    }
+};
+
+const CodeTables& codeTables() {
+    static const CodeTables tables;
+    return tables;
+}
+
+size_t matchLength(const uint8_t* a, const uint8_t* b, size_t limit) {
+    size_t n = 0;
+    while (n + 8 <= limit) {
+        uint64_t x, y;
+        std::memcpy(&x, a + n, 8);
+        std::memcpy(&y, b + n, 8);
+        if (x != y) break;
+        n += 8;
+    }
+    while (n < limit && a[n] == b[n]) ++n;
+    return n;
+}
+
+/**
+ * @brief Hash-chain LZ77 over one stripe, reused across stripes by a worker
+ */
+class StripeCompressor {
+public:
+    explicit StripeCompressor(int quality)
+        : head_(HASH_SIZE), maxChain_(2 * static_cast<size_t>(std::max(quality, 5))) {}
+
+    /**
+     * @brief Deflate data[begin, end) as one fixed-Huffman block
+     *
+     * Up to WINDOW_SIZE bytes before @p begin are hashed first so they
+     * can be referenced. A non-final stripe ends with a sync flush.
+     */
+    void compress(const uint8_t* data, size_t begin, size_t end, bool final,
+                  std::vector<uint8_t>& out) {
+        data_ = data;
+        end_ = end;
+        base_ = begin > ParallelDeflate::WINDOW_SIZE ? begin - ParallelDeflate::WINDOW_SIZE : 0;
+        std::fill(head_.begin(), head_.end(), -1);
+        prev_.resize(end - base_);
+
+        for (size_t pos = base_; pos < begin; ++pos) {
+            insert(pos);
+        }
+
+        out.clear();
+        out.reserve((end - begin) / 2 + 64);
+        DeflateWriter writer(out);
+        writer.beginFixedBlock(final);
+
+        size_t pos = begin;
+        Match current = find(pos);
+        while (pos < end) {
+            insert(pos);
+            if (current.length < MIN_MATCH) {
+                writer.literal(data[pos]);
+                ++pos;
+                current = find(pos);
+                continue;
+            }
+
+            // Lazy evaluation: prefer a literal if the next position matches longer
+            if (current.length < GOOD_MATCH) {
+                Match next = find(pos + 1);
+                if (next.length > current.length) {
+                    writer.literal(data[pos]);
+                    ++pos;
+                    current = next;
+                    continue;
+                }
+            }
+
+            writer.match(current.length, current.distance);
+            for (size_t i = 1; i < current.length; ++i) {
+                insert(pos + i);
+            }
+            pos += current.length;
+            current = find(pos);
+        }
+
+        writer.endOfBlock();
+        if (final) {
+            writer.flush();
+        } else {
+            writer.syncFlush();
+        }
+
+        // Like stb, store incompressible data instead of letting it grow
+        const size_t length = end - begin;
+        const size_t blocks = std::max<size_t>(1, (length + MAX_STORED - 1) / MAX_STORED);
+        if (out.size() > length + blocks * 5) {
+            store(data + begin, length, final, out);
+        }
+    }
+
+private:
+    static constexpr size_t MAX_STORED = 65535;
+
+    struct Match {
+        size_t length = 0;
+        uint32_t distance = 0;
+    };
+
+    std::vector<int32_t> head_;
+    std::vector<int32_t> prev_;
+    size_t maxChain_;
+    const uint8_t* data_ = nullptr;
+    size_t base_ = 0;
+    size_t end_ = 0;
+
+    /**
+     * @brief Replace @p out with stored blocks; stripes start byte aligned
+     */
+    static void store(const uint8_t* data, size_t length, bool final, std::vector<uint8_t>& out) {
+        out.clear();
+        size_t done = 0;
+        do {
+            const size_t block = std::min(MAX_STORED, length - done);
+            const bool last = done + block == length;
+            out.push_back(final && last ? 1 : 0);  // BFINAL, BTYPE = 00 (stored)
+            out.push_back(static_cast<uint8_t>(block));
+            out.push_back(static_cast<uint8_t>(block >> 8));
+            out.push_back(static_cast<uint8_t>(~block));
+            out.push_back(static_cast<uint8_t>(~block >> 8));
+            out.insert(out.end(), data + done, data + done + block);
+            done += block;
+        } while (done < length);
+    }
+
+    static uint32_t hash(const uint8_t* p) {
+        return ((static_cast<uint32_t>(p[0]) << 10) ^ (static_cast<uint32_t>(p[1]) << 5) ^ p[2])
+               & (HASH_SIZE - 1);
+    }
+
+    void insert(size_t pos) {
+        if (pos + MIN_MATCH > end_) return;
+        const uint32_t h = hash(data_ + pos);
+        const int32_t local = static_cast<int32_t>(pos - base_);
+        prev_[local] = head_[h];
+        head_[h] = local;
+    }
+
+    Match find(size_t pos) const {
+        Match best;
+        if (pos + MIN_MATCH > end_) return best;
+
+        const size_t limit = std::min(MAX_MATCH, end_ - pos);
+        size_t bestLength = MIN_MATCH - 1;
+        int32_t candidate = head_[hash(data_ + pos)];
+        for (size_t chain = maxChain_; candidate >= 0 && chain > 0; --chain) {
+            const size_t from = base_ + static_cast<size_t>(candidate);
+            const size_t distance = pos - from;
+            if (distance > MAX_DISTANCE) break;
+
+            if (data_[from + bestLength] == data_[pos + bestLength]) {
+                const size_t length = matchLength(data_ + from, data_ + pos, limit);
+                if (length > bestLength) {
+                    bestLength = length;
+                    best.length = length;
+                    best.distance = static_cast<uint32_t>(distance);
+                    if (length == limit) break;
+                }
+            }
+            candidate = prev_[candidate];
+        }
+        return best;
+    }
+};
+
+/**
+ * @brief Literal or back-reference that re-creates part of a repeated pattern
+ */
+struct RepeatToken {
+    uint32_t length;    ///< 1 for a literal
+    uint32_t distance;  ///< 0 for a literal
+    uint8_t value;      ///< Literal byte
+};
+
+// Distances tried for runs inside a repeated pattern; codes up to 4 have no extra bits
+constexpr size_t REPEAT_RUN_DISTANCES = 8;
+
+// A copy from the previous pattern stops where a run at least this long starts
+constexpr uint32_t REPEAT_RUN_BREAK = 16;
+
+/**
+ * @brief Tokens that re-create one copy of @p pattern following another copy of it
+ */
+std::vector<RepeatToken> repeatTokens(const uint8_t* pattern, size_t length) {
+    // Longest run at each position that repeats the bytes 1..8 back; the
+    // previous copy precedes the pattern, so the comparison wraps around
+    std::vector<uint32_t> run(length, 0);
+    std::vector<uint32_t> runDistance(length, 0);
+    for (size_t d = 1; d <= std::min(REPEAT_RUN_DISTANCES, length); ++d) {
+        uint32_t current = 0;
+        for (size_t i = length; i-- > 0;) {
+            current = pattern[i] == pattern[(i + length - d) % length] ? current + 1 : 0;
+            if (current > run[i]) {
+                run[i] = current;
+                runDistance[i] = static_cast<uint32_t>(d);
+            }
+        }
+    }
+
+    std::vector<RepeatToken> tokens;
+    for (size_t i = 0; i < length;) {
+        if (run[i] >= MIN_MATCH) {
+            const uint32_t n = std::min<uint32_t>(run[i], MAX_MATCH);
+            tokens.push_back({n, runDistance[i], 0});
+            i += n;
+            continue;
+        }
+        if (length <= MAX_DISTANCE) {
+            const size_t limit = std::min(length - i, MAX_MATCH);
+            size_t n = 1;
+            while (n < limit && run[i + n] < REPEAT_RUN_BREAK) {
+                ++n;
+            }
+            if (n >= MIN_MATCH) {
+                tokens.push_back({static_cast<uint32_t>(n), static_cast<uint32_t>(length), 0});
+                i += n;
+                continue;
+            }
+        }
+        tokens.push_back({1, 0, pattern[i]});
+        ++i;
+    }
+    return tokens;
+}
+
+} // namespace
+
+void DeflateCode::huffmanLengths(const uint64_t* counts, int symbols, int limit, uint8_t* lengths) {
+    std::vector<uint64_t> weight(counts, counts + symbols);
+    int used = 0;
+    for (int i = 0; i < symbols; ++i) {
+        used += weight[i] > 0;
+    }
+    for (int i = 0; used < 2 && i < symbols; ++i) {
+        if (weight[i] == 0) {
+            weight[i] = 1;
+            ++used;
+        }
+    }
+
+    for (;;) {
+        // Nodes: leaves first, then internal nodes in order of creation
+        std::vector<std::pair<uint64_t, int>> heap;
+        std::vector<int> parent(2 * symbols, -1);
+        for (int i = 0; i < symbols; ++i) {
+            if (weight[i] > 0) heap.push_back({weight[i], i});
+        }
+        auto greater = [](const std::pair<uint64_t, int>& a, const std::pair<uint64_t, int>& b) {
+            return a.first != b.first ? a.first > b.first : a.second > b.second;
+        };
+        std::make_heap(heap.begin(), heap.end(), greater);
+        int next = symbols;
+        while (heap.size() > 1) {
+            std::pop_heap(heap.begin(), heap.end(), greater);
+            const auto a = heap.back();
+            heap.pop_back();
+            std::pop_heap(heap.begin(), heap.end(), greater);
+            const auto b = heap.back();
+            heap.pop_back();
+            parent[a.second] = parent[b.second] = next;
+            heap.push_back({a.first + b.first, next++});
+            std::push_heap(heap.begin(), heap.end(), greater);
+        }
+
+        int deepest = 0;
+        for (int i = 0; i < symbols; ++i) {
+            int depth = 0;
+            for (int node = i; weight[i] > 0 && parent[node] >= 0; node = parent[node]) {
+                ++depth;
+            }
+            lengths[i] = static_cast<uint8_t>(depth);
+            deepest = std::max(deepest, depth);
+        }
+        if (deepest <= limit) {
+            return;
+        }
+        for (uint64_t& w : weight) {
+            if (w > 0) w = (w >> 1) | 1;
+        }
+    }
+}
+
+void DeflateCode::canonicalCodes(const uint8_t* lengths, int symbols, Code* codes) {
+    int count[16] = {};
+    for (int i = 0; i < symbols; ++i) {
+        ++count[lengths[i]];
+    }
+    count[0] = 0;
+    uint32_t nextCode[16] = {};
+    uint32_t code = 0;
+    for (int bits = 1; bits < 16; ++bits) {
+        code = (code + count[bits - 1]) << 1;
+        nextCode[bits] = code;
+    }
+    for (int i = 0; i < symbols; ++i) {
+        const int length = lengths[i];
+        codes[i] = {length ? reverseBits(nextCode[length]++, length) : 0, length};
+    }
+}
+
+std::vector<DeflateCode::LengthToken> DeflateCode::runLengthTokens(const uint8_t* lengths, size_t count) {
+    std::vector<LengthToken> tokens;
+    for (size_t i = 0; i < count;) {
+        const uint8_t length = lengths[i];
+        size_t run = 1;
+        while (i + run < count && lengths[i + run] == length) ++run;
+        size_t done = 0;
+        if (length == 0) {
+            while (run - done >= 11) {
+                const size_t n = std::min<size_t>(run - done, 138);
+                tokens.push_back({18, static_cast<uint32_t>(n - 11)});
+                done += n;
+            }
+            if (run - done >= 3) {
+                tokens.push_back({17, static_cast<uint32_t>(run - done - 3)});
+                done = run;
+            }
+        } else {
+            tokens.push_back({length, 0});
+            done = 1;
+            while (run - done >= 3) {
+                const size_t n = std::min<size_t>(run - done, 6);
+                tokens.push_back({16, static_cast<uint32_t>(n - 3)});
+                done += n;
+            }
+        }
+        for (; done < run; ++done) {
+            tokens.push_back({length, 0});
+        }
+        i += run;
+    }
+    return tokens;
+}
+
+const DeflateCode& DeflateCode::fixed() {
+    static const DeflateCode code = [] {
+        DeflateCode c;
+        for (uint32_t sym = 0; sym < 288; ++sym) {
+            if (sym < 144)      c.literal_[sym] = {reverseBits(0x30 + sym, 8), 8};
+            else if (sym < 256) c.literal_[sym] = {reverseBits(0x190 + sym - 144, 9), 9};
+            else if (sym < 280) c.literal_[sym] = {reverseBits(sym - 256, 7), 7};
+            else                c.literal_[sym] = {reverseBits(0xC0 + sym - 280, 8), 8};
+        }
+        for (uint32_t sym = 0; sym < 30; ++sym) {
+            c.distance_[sym] = {reverseBits(sym, 5), 5};
+        }
+        return c;
+    }();
+    return code;
+}
+
+DeflateCode::DeflateCode(const Counts& counts) {
+    uint8_t lengths[286 + 30];
+    huffmanLengths(counts.literals, 286, 15, lengths);
+    huffmanLengths(counts.distances, 30, 15, lengths + 286);
+    canonicalCodes(lengths, 286, literal_.data());
+    canonicalCodes(lengths + 286, 30, distance_.data());
+
+    int hlit = 286;
+    while (hlit > 257 && lengths[hlit - 1] == 0) --hlit;
+    int hdist = 30;
+    while (hdist > 1 && lengths[286 + hdist - 1] == 0) --hdist;
+    std::vector<uint8_t> sequence(lengths, lengths + hlit);
+    sequence.insert(sequence.end(), lengths + 286, lengths + 286 + hdist);
+
+    const std::vector<LengthToken> tokens = runLengthTokens(sequence.data(), sequence.size());
+    uint64_t clCounts[19] = {};
+    for (const LengthToken& token : tokens) {
+        ++clCounts[token.symbol];
+    }
+
+    uint8_t clLengths[19];
+    Code clCodes[19];
+    huffmanLengths(clCounts, 19, 7, clLengths);
+    canonicalCodes(clLengths, 19, clCodes);
+
+    static const uint8_t ORDER[19] = {16, 17, 18, 0, 8, 7, 9, 6, 10, 5, 11, 4, 12, 3, 13, 2, 14, 1, 15};
+    int hclen = 19;
+    while (hclen > 4 && clLengths[ORDER[hclen - 1]] == 0) --hclen;
+
+    header_.push_back({static_cast<uint32_t>(hlit - 257), 5});
+    header_.push_back({static_cast<uint32_t>(hdist - 1), 5});
+    header_.push_back({static_cast<uint32_t>(hclen - 4), 4});
+    for (int i = 0; i < hclen; ++i) {
+        header_.push_back({clLengths[ORDER[i]], 3});
+    }
+    static const int EXTRA_BITS[3] = {2, 3, 7};
+    for (const LengthToken& token : tokens) {
+        header_.push_back(clCodes[token.symbol]);
+        if (token.symbol >= 16) {
+            header_.push_back({token.extra, EXTRA_BITS[token.symbol - 16]});
+        }
+    }
+}
+
+void DeflateCode::Counts::match(size_t length, uint32_t distance) {
+    ++literals[257 + codeTables().length[length]];
+    ++distances[codeTables().distanceCode(distance)];
+}
+
+void DeflateCode::Counts::run(uint64_t length, uint32_t distance, const uint8_t* pattern) {
+    // The same tokens as DeflateWriter::run
+    uint64_t done = 0;
+    if (length >= MAX_MATCH + MIN_MATCH) {
+        const uint64_t full = (length - MAX_MATCH - MIN_MATCH) / MAX_MATCH + 1;
+        literals[285] += full;
+        distances[codeTables().distanceCode(distance)] += full;
+        done = full * MAX_MATCH;
+    }
+    while (length - done >= MIN_MATCH) {
+        uint64_t remaining = length - done;
+        size_t len = remaining <= MAX_MATCH ? static_cast<size_t>(remaining)
+                                            : static_cast<size_t>(remaining - MIN_MATCH);
+        match(len, distance);
+        done += len;
+    }
+    for (; done < length; ++done) {
+        literal(pattern[done % distance]);
+    }
+}
+
+void DeflateWriter::beginDynamicBlock(bool final, const DeflateCode& code) {
+    putBits(final ? 1 : 0, 1);
+    putBits(2, 2);
+    for (const DeflateCode::Code& c : code.header_) {
+        putBits(c.bits, c.length);
+    }
+    code_ = &code;
+}
+
+void DeflateWriter::match(size_t length, uint32_t distance) {
+    const CodeTables& tables = codeTables();
+    const int lc = tables.length[length];
+    const Code& c = code_->literal_[257 + lc];
+    putBits(c.bits, c.length);
+    if (LENGTH_EXTRA[lc]) {
+        putBits(static_cast<uint32_t>(length - LENGTH_BASE[lc]), LENGTH_EXTRA[lc]);
+    }
+
+    const int dc = tables.distanceCode(distance);
+    const Code& d = code_->distance_[dc];
+    putBits(d.bits, d.length);
+    if (DIST_EXTRA[dc]) {
+        putBits(distance - DIST_BASE[dc], DIST_EXTRA[dc]);
+    }
+}
+
+void DeflateWriter::run(uint64_t length, uint32_t distance, const uint8_t* pattern) {
+    // Every maximal match has the same bit pattern, so build it once
+    const Code& maxLen = code_->literal_[285];
+    const int dc = codeTables().distanceCode(distance);
+    const Code& dist = code_->distance_[dc];
+    const bool packed = DIST_EXTRA[dc] == 0;
+    const uint32_t maxBits = maxLen.bits | (dist.bits << maxLen.length);
+    const int maxCount = maxLen.length + dist.length;
+
+    uint64_t done = 0;
+    while (length - done >= MAX_MATCH + MIN_MATCH) {
+        if (packed) {
+            putBits(maxBits, maxCount);
+        } else {
+            match(MAX_MATCH, distance);
+        }
+        done += MAX_MATCH;
+    }
+    // Split the tail so no match is shorter than the minimum length
+    while (length - done >= MIN_MATCH) {
+        uint64_t remaining = length - done;
+        size_t len = remaining <= MAX_MATCH ? static_cast<size_t>(remaining)
+                                            : static_cast<size_t>(remaining - MIN_MATCH);
+        match(len, distance);
+        done += len;
+    }
+    for (; done < length; ++done) {
+        literal(pattern[done % distance]);
+    }
+}
+
+void DeflateWriter::syncFlush() {
+    putBits(0, 3);  // BFINAL = 0, BTYPE = 00 (stored)
+    flush();
+    static const uint8_t emptyStored[4] = {0x00, 0x00, 0xFF, 0xFF};
+    out_.insert(out_.end(), emptyStored, emptyStored + 4);
+}
+
+void DeflateWriter::flush() {
+    while (used_ > 0) {
+        out_.push_back(static_cast<uint8_t>(acc_));
+        acc_ >>= 8;
+        used_ = used_ > 8 ? used_ - 8 : 0;
+    }
+    acc_ = 0;
+}
+
+std::vector<uint8_t> ParallelDeflate::compress(const uint8_t* data, size_t length,
+                                               int quality, size_t threads) {
+    const size_t stripes = std::max<size_t>(1, (length + STRIPE_SIZE - 1) / STRIPE_SIZE);
+    std::vector<std::vector<uint8_t>> parts(stripes);
+    std::vector<uint32_t> checksums(stripes);
+
+    if (threads == 0) {
+        threads = ThreadPool::availableThreads();
+    }
+    threads = std::min(threads, stripes);
+    std::vector<StripeCompressor> compressors(threads, StripeCompressor(quality));
+    ThreadPool::parallelFor(stripes, threads, [&](size_t i, size_t thread) {
+        const size_t begin = i * STRIPE_SIZE;
+        const size_t end = std::min(length, begin + STRIPE_SIZE);
+        compressors[thread].compress(data, begin, end, i + 1 == stripes, parts[i]);
+
+        Adler32 adler;
+        adler.update(data + begin, end - begin);
+        checksums[i] = adler.value();
+    });
+
+    size_t total = 2 + 4;
+    for (const std::vector<uint8_t>& part : parts) {
+        total += part.size();
+    }
+
+    // zlib header (deflate, 32K window, default level), as stb writes it
+    std::vector<uint8_t> out;
+    out.reserve(total);
+    out.push_back(0x78);
+    out.push_back(0x5E);
+
+    uint32_t adler = 1;
+    for (size_t i = 0; i < stripes; ++i) {
+        out.insert(out.end(), parts[i].begin(), parts[i].end());
+        const size_t begin = i * STRIPE_SIZE;
+        adler = Adler32::combine(adler, checksums[i], std::min(length, begin + STRIPE_SIZE) - begin);
+    }
+
+    out.push_back(static_cast<uint8_t>(adler >> 24));
+    out.push_back(static_cast<uint8_t>(adler >> 16));
+    out.push_back(static_cast<uint8_t>(adler >> 8));
+    out.push_back(static_cast<uint8_t>(adler));
+    return out;
+}
+
+struct DeflateStream::State {
+    int quality;
+    size_t threads;
+    size_t batchStripes;
+    std::vector<uint8_t> buffer;  ///< Dictionary window followed by pending input
+    size_t window = 0;            ///< Bytes of buffer that are dictionary only
+    uint32_t adler = 1;
+    bool started = false;
+    std::vector<StripeCompressor> compressors;
+    std::vector<std::vector<uint8_t>> parts;
+    std::vector<uint32_t> checksums;
+};
+
+DeflateStream::DeflateStream(int quality, size_t threads) : state_(std::make_unique<State>()) {
+    if (threads == 0) {
+        threads = ThreadPool::availableThreads();
+    }
+    state_->quality = quality;
+    state_->threads = threads;
+    state_->batchStripes = 4 * threads;
+    state_->buffer.reserve(ParallelDeflate::WINDOW_SIZE + (state_->batchStripes + 1) * ParallelDeflate::STRIPE_SIZE);
+    state_->parts.resize(state_->batchStripes);
+    state_->checksums.resize(state_->batchStripes);
+}
+
+DeflateStream::~DeflateStream() = default;
+
+void DeflateStream::write(const uint8_t* data, size_t length, std::vector<uint8_t>& out) {
+    State& s = *state_;
+    const size_t batchBytes = s.batchStripes * ParallelDeflate::STRIPE_SIZE;
+    while (length > 0) {
+        // Hold back one stripe beyond the batch so the final stripe is always
+        // compressed by finish(), as the last stripe of ParallelDeflate is
+        const size_t room = s.window + batchBytes + ParallelDeflate::STRIPE_SIZE - s.buffer.size();
+        const size_t n = std::min(length, room);
+        s.buffer.insert(s.buffer.end(), data, data + n);
+        data += n;
+        length -= n;
+        if (n == room) {
+            compressStripes(s.batchStripes, false, out);
+        }
+    }
+}
+
+void DeflateStream::repeat(const uint8_t* pattern, size_t length, uint64_t count, std::vector<uint8_t>& out) {
+    State& s = *state_;
+    if (s.buffer.empty()) {
+        throw std::invalid_argument("Only input that has been written can be repeated");
+    }
+    if (length == 0 || count == 0) {
+        return;
+    }
+
+    const size_t pending = s.buffer.size() - s.window;
+    if (pending > 0) {
+        compressStripes((pending + ParallelDeflate::STRIPE_SIZE - 1) / ParallelDeflate::STRIPE_SIZE, false, out);
+    }
+
+    if (length <= ParallelDeflate::WINDOW_SIZE) {
+        const std::vector<RepeatToken> tokens = repeatTokens(pattern, length);
+        DeflateWriter writer(out);
+        writer.beginFixedBlock(false);
+        for (uint64_t copy = 0; copy < count; ++copy) {
+            for (const RepeatToken& token : tokens) {
+                if (token.distance) {
+                    writer.match(token.length, token.distance);
+                } else {
+                    writer.literal(token.value);
+                }
+            }
+        }
+        writer.endOfBlock();
+        writer.syncFlush();
+    } else {
+        // Every copy follows the same window, the end of the copy before it,
+        // so one copy compressed after that window decodes correctly anywhere
+        std::vector<uint8_t> copy(pattern + length - ParallelDeflate::WINDOW_SIZE, pattern + length);
+        copy.insert(copy.end(), pattern, pattern + length);
+        const size_t stripes = (length + ParallelDeflate::STRIPE_SIZE - 1) / ParallelDeflate::STRIPE_SIZE;
+        deflateStripes(copy.data(), ParallelDeflate::WINDOW_SIZE, copy.size(), stripes, false);
+
+        std::vector<uint8_t> compressed;
+        for (size_t i = 0; i < stripes; ++i) {
+            compressed.insert(compressed.end(), s.parts[i].begin(), s.parts[i].end());
+        }
+        out.reserve(out.size() + compressed.size() * count);
+        for (uint64_t c = 0; c < count; ++c) {
+            out.insert(out.end(), compressed.begin(), compressed.end());
+        }
+    }
+
+    // Checksum of the copies by repeated doubling
+    Adler32 single;
+    single.update(pattern, length);
+    uint32_t power = single.value();
+    uint64_t powerLength = length;
+    for (uint64_t copies = count; copies > 0; copies >>= 1) {
+        if (copies & 1) {
+            s.adler = Adler32::combine(s.adler, power, powerLength);
+        }
+        power = Adler32::combine(power, power, powerLength);
+        powerLength *= 2;
+    }
+
+    // The end of the copies becomes the dictionary of the next stripe
+    const uint64_t total = static_cast<uint64_t>(length) * count;
+    const uint64_t appended = std::min<uint64_t>(total, ParallelDeflate::WINDOW_SIZE);
+    for (uint64_t i = total - appended; i < total; ++i) {
+        s.buffer.push_back(pattern[static_cast<size_t>(i % length)]);
+    }
+    const size_t keep = std::min(s.buffer.size(), ParallelDeflate::WINDOW_SIZE);
+    s.buffer.erase(s.buffer.begin(), s.buffer.end() - static_cast<std::ptrdiff_t>(keep));
+    s.window = keep;
+}
+
+void DeflateStream::finish(std::vector<uint8_t>& out) {
+    State& s = *state_;
+    const size_t pending = s.buffer.size() - s.window;
+    compressStripes(std::max<size_t>(1, (pending + ParallelDeflate::STRIPE_SIZE - 1) / ParallelDeflate::STRIPE_SIZE),
+                    true, out);
+    out.push_back(static_cast<uint8_t>(s.adler >> 24));
+    out.push_back(static_cast<uint8_t>(s.adler >> 16));
+    out.push_back(static_cast<uint8_t>(s.adler >> 8));
+    out.push_back(static_cast<uint8_t>(s.adler));
+}
+
+void DeflateStream::compressStripes(size_t stripes, bool final, std::vector<uint8_t>& out) {
+    State& s = *state_;
+    if (!s.started) {
+        // Same zlib header as ParallelDeflate::compress
+        out.push_back(0x78);
+        out.push_back(0x5E);
+        s.started = true;
+    }
+
+    const size_t end = s.buffer.size();
+    auto stripeBegin = [&](size_t i) { return s.window + i * ParallelDeflate::STRIPE_SIZE; };
+    auto stripeEnd = [&](size_t i) { return std::min(end, stripeBegin(i) + ParallelDeflate::STRIPE_SIZE); };
+    deflateStripes(s.buffer.data(), s.window, end, stripes, final);
+
+    for (size_t i = 0; i < stripes; ++i) {
+        out.insert(out.end(), s.parts[i].begin(), s.parts[i].end());
+        s.adler = Adler32::combine(s.adler, s.checksums[i], stripeEnd(i) - stripeBegin(i));
+    }
+
+    // Keep the last WINDOW_SIZE bytes as the next batch's dictionary
+    const size_t consumed = stripeEnd(stripes - 1);
+    const size_t keep = std::min(consumed, ParallelDeflate::WINDOW_SIZE);
+    s.buffer.erase(s.buffer.begin(), s.buffer.begin() + static_cast<std::ptrdiff_t>(consumed - keep));
+    s.window = keep;
+}
+
+void DeflateStream::deflateStripes(const uint8_t* data, size_t begin, size_t end, size_t stripes, bool final) {
+    State& s = *state_;
+    if (s.parts.size() < stripes) {
+        s.parts.resize(stripes);
+        s.checksums.resize(stripes);
+    }
+
+    auto stripeBegin = [&](size_t i) { return begin + i * ParallelDeflate::STRIPE_SIZE; };
+    auto stripeEnd = [&](size_t i) { return std::min(end, stripeBegin(i) + ParallelDeflate::STRIPE_SIZE); };
+
+    const size_t threads = std::min(s.threads, stripes);
+    while (s.compressors.size() < threads) {
+        s.compressors.emplace_back(s.quality);
+    }
+
+    ThreadPool::parallelFor(stripes, threads, [&](size_t i, size_t thread) {
+        s.compressors[thread].compress(data, stripeBegin(i), stripeEnd(i), final && i + 1 == stripes, s.parts[i]);
+
+        Adler32 adler;
+        adler.update(data + stripeBegin(i), stripeEnd(i) - stripeBegin(i));
+        s.checksums[i] = adler.value();
+    });
+}
+
+} // namespace ColorGenerator
@@ -0,0 +1,586 @@
+#include "../../include/formats/GIFWriter.hpp"
+#include "../../include/formats/ByteSink.hpp"
+#include <algorithm>
+#include <cmath>
+#include <stdexcept>
+#include <unordered_map>
+#include <vector>
+
+namespace ColorGenerator {
+
+namespace {
+
+constexpr uint8_t EXTENSION_INTRODUCER = 0x21;
+constexpr uint8_t GRAPHIC_CONTROL_LABEL = 0xF9;
+constexpr uint8_t APPLICATION_LABEL = 0xFF;
+constexpr uint8_t IMAGE_SEPARATOR = 0x2C;
+constexpr uint8_t TRAILER = 0x3B;
+
+// Graphic control disposal methods
+constexpr uint8_t DISPOSE_UNSPECIFIED = 0;
+constexpr uint8_t DISPOSE_NONE = 1;  ///< Leave the frame in place
+
+// Pixels with less alpha than this are transparent
+constexpr int ALPHA_THRESHOLD = 128;
+constexpr uint32_t TRANSPARENT_KEY = 1u << 24;
+
+// Smallest LZW code size GIF allows, used by two- and four-color palettes
+constexpr int MIN_CODE_SIZE = 2;
+
+// Codes are assigned below this, leaving the last 12-bit code unused as giflib does
+constexpr uint32_t MAX_CODE = 4095;
+constexpr int MAX_CODE_WIDTH = 12;
+
+// 6x7x6 color cube for images with more than 256 colors
+constexpr int CUBE_RED = 6;
+constexpr int CUBE_GREEN = 7;
+constexpr int CUBE_BLUE = 6;
+constexpr uint8_t CUBE_TRANSPARENT = CUBE_RED * CUBE_GREEN * CUBE_BLUE;
+
+const uint8_t BAYER[8][8] = {
+    { 0, 32,  8, 40,  2, 34, 10, 42},
+    {48, 16, 56, 24, 50, 18, 58, 26},
+    {12, 44,  4, 36, 14, 46,  6, 38},
+    {60, 28, 52, 20, 62, 30, 54, 22},
+    { 3, 35, 11, 43,  1, 33,  9, 41},
+    {51, 19, 59, 27, 49, 17, 57, 25},
+    {15, 47,  7, 39, 13, 45,  5, 37},
+    {63, 31, 55, 23, 61, 29, 53, 21}};
+
+/**
+ * @brief Appends the encoded bytes to a buffer, for streams written more than once
+ */
+struct VectorSink {
+    std::vector<uint8_t>& bytes;
+
+    void write(const uint8_t* data, size_t size) { bytes.insert(bytes.end(), data, data + size); }
+};
+
+void putU16LE(uint8_t* dst, uint32_t value) {
+    dst[0] = static_cast<uint8_t>(value);
+    dst[1] = static_cast<uint8_t>(value >> 8);
+}
+
+void checkDimensions(uint32_t width, uint32_t height) {
+    if (width == 0 || height == 0 || width > 65535 || height > 65535) {
+        throw std::invalid_argument("Invalid GIF image dimensions");
+    }
+}
+
+/**
+ * @brief Bits of the smallest color table (at least two entries) that holds @p entries
+ */
+int tableBits(size_t entries) {
+    int bits = 1;
+    while ((size_t{1} << bits) < entries) {
+        ++bits;
+    }
+    return bits;
+}
+
+/**
+ * @brief RGB triples padded with black to a table of tableBits() entries
+ */
+std::vector<uint8_t> colorTable(std::vector<uint8_t> rgb) {
+    rgb.resize(3 * (size_t{1} << tableBits(rgb.size() / 3)));
+    return rgb;
+}
+
+/**
+ * @brief 24-bit RGB of a source pixel, or TRANSPARENT_KEY
+ */
+uint32_t pixelKey(const uint8_t* pixel, int channels) {
+    switch (channels) {
+        case 1:
+            return pixel[0] * 0x010101u;
+        case 2:
+            return pixel[1] < ALPHA_THRESHOLD ? TRANSPARENT_KEY : pixel[0] * 0x010101u;
+        case 3:
+            return static_cast<uint32_t>(pixel[0]) << 16 | pixel[1] << 8 | pixel[2];
+        default:
+            return pixel[3] < ALPHA_THRESHOLD
+                ? TRANSPARENT_KEY : static_cast<uint32_t>(pixel[0]) << 16 | pixel[1] << 8 | pixel[2];
+    }
+}
+
+/**
+ * @brief Logical screen descriptor and optional global color table, after the signature
+ */
+template <typename Sink>
+void writeScreen(Sink& sink, uint32_t width, uint32_t height, const std::vector<uint8_t>& palette) {
+    uint8_t header[13] = {'G', 'I', 'F', '8', '9', 'a'};
+    putU16LE(header + 6, width);
+    putU16LE(header + 8, height);
+    // Global table flag, 8-bit color resolution, table size
+    header[10] = palette.empty() ? 0x70 : static_cast<uint8_t>(0xF0 | (tableBits(palette.size() / 3) - 1));
+    header[11] = 0;  // background color index
+    header[12] = 0;  // pixel aspect ratio
+    sink.write(header, sizeof(header));
+    sink.write(palette.data(), palette.size());
+}
+
+template <typename Sink>
+void writeGraphicControl(Sink& sink, uint32_t delay, int transparentIndex, uint8_t disposal) {
+    uint8_t block[8] = {EXTENSION_INTRODUCER, GRAPHIC_CONTROL_LABEL, 4};
+    block[3] = static_cast<uint8_t>(disposal << 2 | (transparentIndex >= 0 ? 1 : 0));
+    putU16LE(block + 4, delay);
+    block[6] = static_cast<uint8_t>(transparentIndex >= 0 ? transparentIndex : 0);
+    block[7] = 0;  // block terminator
+    sink.write(block, sizeof(block));
+}
+
+template <typename Sink>
+void writeImageDescriptor(Sink& sink, uint32_t width, uint32_t height, const std::vector<uint8_t>& localPalette) {
+    uint8_t descriptor[10] = {IMAGE_SEPARATOR};
+    putU16LE(descriptor + 1, 0);  // left
+    putU16LE(descriptor + 3, 0);  // top
+    putU16LE(descriptor + 5, width);
+    putU16LE(descriptor + 7, height);
+    descriptor[9] = localPalette.empty()
+        ? 0 : static_cast<uint8_t>(0x80 | (tableBits(localPalette.size() / 3) - 1));
+    sink.write(descriptor, sizeof(descriptor));
+    sink.write(localPalette.data(), localPalette.size());
+}
+
+/**
+ * @brief Packs codes LSB first into the length-prefixed sub-blocks of GIF image data
+ */
+template <typename Sink>
+class SubBlockWriter {
+public:
+    explicit SubBlockWriter(Sink& sink) : sink_(sink) {}
+
+    void put(uint32_t code, int width) {
+        bits_ |= static_cast<uint64_t>(code) << count_;
+        count_ += width;
+        while (count_ >= 8) {
+            byte(static_cast<uint8_t>(bits_));
+            bits_ >>= 8;
+            count_ -= 8;
+        }
+    }
+
+    /**
+     * @brief Write the partial last byte, the last sub-block and the block terminator
+     */
+    void finish() {
+        if (count_ > 0) {
+            byte(static_cast<uint8_t>(bits_));
+        }
+        if (length_ > 0) {
+            flushBlock();
+        }
+        const uint8_t terminator = 0;
+        sink_.write(&terminator, 1);
+    }
+
+private:
+    void byte(uint8_t value) {
+        block_[1 + length_++] = value;
+        if (length_ == 255) {
+            flushBlock();
+        }
+    }
+
+    void flushBlock() {
+        block_[0] = static_cast<uint8_t>(length_);
+        sink_.write(block_, length_ + 1);
+        length_ = 0;
+    }
+
+    Sink& sink_;
+    uint64_t bits_ = 0;
+    int count_ = 0;
+    size_t length_ = 0;
+    uint8_t block_[256];
+};
+
+/**
+ * @brief Variable-width LZW coder for GIF image data, fed one palette index at a time
+ *
+ * Writes the minimum code size byte, a clear code, the codes and the end
+ * code. A full table is kept while each window of TABLE_CHECK_CODES codes
+ * covers at least as many pixels per code as the codes emitted while the
+ * table was filling; when a window falls short, the next code is followed
+ * by a clear code and the table is rebuilt.
+ */
+template <typename Sink>
+class LZWEncoder {
+public:
+    LZWEncoder(Sink& sink, int minCodeSize)
+        : bits_(sink), minCodeSize_(minCodeSize), clear_(1u << minCodeSize), keys_(HASH_SIZE), codes_(HASH_SIZE) {
+        const uint8_t size = static_cast<uint8_t>(minCodeSize);
+        sink.write(&size, 1);
+        width_ = minCodeSize_ + 1;
+        restart();
+    }
+
+    void put(uint8_t index) {
+        if (length_ == 0) {
+            current_ = index;
+            length_ = 1;
+            return;
+        }
+
+        // Extend the current string while the table has it
+        const uint32_t key = (current_ << 8 | index) + 1;
+        size_t slot = static_cast<size_t>((key * 0x9E3779B1u) >> (32 - HASH_BITS));
+        while (keys_[slot] != 0 && keys_[slot] != key) {
+            slot = (slot + 1) & (HASH_SIZE - 1);
+        }
+        if (keys_[slot] == key) {
+            current_ = codes_[slot];
+            ++length_;
+            return;
+        }
+
+        emitString();
+        if (next_ < MAX_CODE) {
+            keys_[slot] = key;
+            codes_[slot] = static_cast<uint16_t>(next_);
+            grow();
+        } else if (clearPending_) {
+            restart();
+        }
+        current_ = index;
+        length_ = 1;
+    }
+
+    /**
+     * @brief Code @p count pixels of @p index as put() would, from the lengths of the strings alone
+     *
+     * Only valid as the whole input of the encoder. A run codes as
+     * strings of 1, 2, 3... pixels, each adding the next longer one to the
+     * table, then as repeats of the longest once the table is full.
+     */
+    void solid(uint8_t index, uint64_t count) {
+        auto code = [&](uint64_t length) {
+            return length == 1 ? index : clear_ + static_cast<uint32_t>(length);
+        };
+        uint64_t length = 1;
+        while (count > length && next_ < MAX_CODE) {
+            current_ = code(length);
+            length_ = length;
+            emitString();
+            grow();
+            count -= length;
+            ++length;
+        }
+        while (count > length) {
+            current_ = code(length);
+            length_ = length;
+            emitString();
+            count -= length;
+        }
+        current_ = code(count);
+        length_ = count;
+    }
+
+    void finish() {
+        if (length_ > 0) {
+            emitString();
+        }
+        emit(clear_ + 1);  // end of information
+        bits_.finish();
+    }
+
+private:
+    static constexpr int HASH_BITS = 13;
+    static constexpr size_t HASH_SIZE = size_t{1} << HASH_BITS;
+
+    void emit(uint32_t code) {
+        bits_.put(code, width_);
+        // The decoder widens its codes when it adds the entry this code completes
+        if (next_ >= (1u << width_) && width_ < MAX_CODE_WIDTH) {
+            ++width_;
+        }
+    }
+
+    void emitString() {
+        emit(current_);
+        pixels_ += length_;
+        ++strings_;
+        if (next_ < MAX_CODE) {
+            return;
+        }
+        windowPixels_ += length_;
+        if (++windowCodes_ == GIFWriter::TABLE_CHECK_CODES) {
+            if (windowPixels_ * fillCodes_ < fillPixels_ * windowCodes_) {
+                clearPending_ = true;
+            }
+            windowPixels_ = 0;
+            windowCodes_ = 0;
+        }
+    }
+
+    void grow() {
+        if (++next_ == MAX_CODE) {
+            fillPixels_ = pixels_;
+            fillCodes_ = strings_;
+        }
+    }
+
+    void restart() {
+        emit(clear_);
+        std::fill(keys_.begin(), keys_.end(), 0);
+        width_ = minCodeSize_ + 1;
+        next_ = clear_ + 2;
+        pixels_ = 0;
+        strings_ = 0;
+        windowPixels_ = 0;
+        windowCodes_ = 0;
+        clearPending_ = false;
+    }
+
+    SubBlockWriter<Sink> bits_;
+    int minCodeSize_;
+    uint32_t clear_;
+    int width_;
+    uint32_t next_ = 0;
+    uint32_t current_ = 0;
+    uint64_t length_ = 0;
+
+    // Pixels and codes since the clear, when the table filled, and in the current window
+    uint64_t pixels_ = 0;
+    uint64_t strings_ = 0;
+    uint64_t fillPixels_ = 0;
+    uint64_t fillCodes_ = 0;
+    uint64_t windowPixels_ = 0;
+    uint64_t windowCodes_ = 0;
+    bool clearPending_ = false;
+
+    // Open-addressed table from (prefix code, index) + 1 to code; 0 marks an empty slot
+    std::vector<uint32_t> keys_;
+    std::vector<uint16_t> codes_;
+};
+
+/**
+ * @brief Encode a solid image into @p sink (FileSink or CountingSink)
+ */
+template <typename Sink>
+void encodeSolid(Sink& sink, const Color& color, const Resolution& resolution) {
+    const uint32_t width = resolution.getWidth();
+    const uint32_t height = resolution.getHeight();
+    checkDimensions(width, height);
+
+    writeScreen(sink, width, height, colorTable({color.getRed(), color.getGreen(), color.getBlue()}));
+    if (color.getAlpha() < ALPHA_THRESHOLD) {
+        writeGraphicControl(sink, 0, 0, DISPOSE_UNSPECIFIED);
+    }
+    writeImageDescriptor(sink, width, height, {});
+
+    LZWEncoder<Sink> lzw(sink, MIN_CODE_SIZE);
+    lzw.solid(0, resolution.getPixelCount());
+    lzw.finish();
+
+    sink.write(&TRAILER, 1);
+    sink.finish();
+}
+
+} // namespace
+
+bool GIFWriter::write(const std::string& filename,
+                      const Color& color,
+                      const Resolution& resolution) {
+    FileSink sink(filename);
+    encodeSolid(sink, color, resolution);
+    return true;
+}
+
+uint64_t GIFWriter::encodedSize(const Color& color, const Resolution& resolution) {
+    CountingSink sink;
+    encodeSolid(sink, color, resolution);
+    return sink.size;
+}
+
+bool GIFWriter::write(const std::string& filename, const RowSource& source) {
+    const uint32_t width = source.width();
+    const uint32_t height = source.height();
+    checkDimensions(width, height);
+    const int channels = source.channels();
+    if (channels < 1 || channels > 4) {
+        throw std::invalid_argument("GIF channel count must be 1 to 4");
+    }
+
+    const size_t rowBytes = static_cast<size_t>(source.rowBytes());
+    const uint32_t batchRows = static_cast<uint32_t>(
+        std::max<size_t>(1, std::min<size_t>(height, READ_BYTES / rowBytes)));
+    std::vector<uint8_t> scratch(static_cast<size_t>(batchRows) * rowBytes);
+
+    // First pass: the distinct colors in order of appearance, while they fit a palette
+    std::unordered_map<uint32_t, uint8_t> palette;
+    std::vector<uint32_t> keys;
+    bool exact = true;
+    for (uint32_t y = 0; y < height && exact;) {
+        if (const uint32_t repeated = source.repeatedRows(y)) {
+            y += repeated;
+            continue;
+        }
+        const uint32_t count = std::min(batchRows, height - y);
+        const uint8_t* rows = source.rows(y, count, scratch.data());
+        uint32_t last = ~0u;
+        for (size_t i = 0; i < count * rowBytes && exact; i += channels) {
+            const uint32_t key = pixelKey(rows + i, channels);
+            if (key != last && palette.find(key) == palette.end()) {
+                exact = keys.size() < 256;
+                palette.emplace(key, static_cast<uint8_t>(keys.size()));
+                keys.push_back(key);
+            }
+            last = key;
+        }
+        y += count;
+    }
+
+    std::vector<uint8_t> rgb;
+    int transparentIndex = -1;
+    if (exact) {
+        for (size_t i = 0; i < keys.size(); ++i) {
+            if (keys[i] == TRANSPARENT_KEY) {
+                transparentIndex = static_cast<int>(i);
+            }
+            const uint32_t key = keys[i] == TRANSPARENT_KEY ? 0 : keys[i];
+            rgb.insert(rgb.end(), {static_cast<uint8_t>(key >> 16), static_cast<uint8_t>(key >> 8),
+                                   static_cast<uint8_t>(key)});
+        }
+    } else {
+        for (int r = 0; r < CUBE_RED; ++r) {
+            for (int g = 0; g < CUBE_GREEN; ++g) {
+                for (int b = 0; b < CUBE_BLUE; ++b) {
+                    rgb.insert(rgb.end(), {static_cast<uint8_t>((r * 255 + (CUBE_RED - 1) / 2) / (CUBE_RED - 1)),
+                                           static_cast<uint8_t>((g * 255 + (CUBE_GREEN - 1) / 2) / (CUBE_GREEN - 1)),
+                                           static_cast<uint8_t>((b * 255 + (CUBE_BLUE - 1) / 2) / (CUBE_BLUE - 1))});
+                }
+            }
+        }
+        if (channels == 2 || channels == 4) {
+            transparentIndex = CUBE_TRANSPARENT;
+        }
+    }
+    const std::vector<uint8_t> table = colorTable(rgb);
+    const int bits = tableBits(table.size() / 3);
+
+    FileSink sink(filename);
+    writeScreen(sink, width, height, table);
+    if (transparentIndex >= 0) {
+        writeGraphicControl(sink, 0, transparentIndex, DISPOSE_UNSPECIFIED);
+    }
+    writeImageDescriptor(sink, width, height, {});
+
+    // Second pass: palette indices, exact or dithered into the color cube
+    LZWEncoder<FileSink> lzw(sink, std::max(MIN_CODE_SIZE, bits));
+    for (uint32_t y = 0; y < height;) {
+        const uint32_t count = std::min(batchRows, height - y);
+        const uint8_t* rows = source.rows(y, count, scratch.data());
+        uint32_t last = ~0u;
+        uint8_t lastIndex = 0;
+        for (uint32_t r = 0; r < count; ++r) {
+            const uint8_t* row = rows + r * rowBytes;
+            const uint8_t* bayer = BAYER[(y + r) & 7];
+            for (uint32_t x = 0; x < width; ++x) {
+                const uint32_t key = pixelKey(row + static_cast<size_t>(x) * channels, channels);
+                if (exact) {
+                    if (key != last) {
+                        last = key;
+                        lastIndex = palette.find(key)->second;
+                    }
+                    lzw.put(lastIndex);
+                } else if (key == TRANSPARENT_KEY) {
+                    lzw.put(CUBE_TRANSPARENT);
+                } else {
+                    // Ordered dither: the threshold rounds each channel down or up to a cube level
+                    const uint32_t d = (2u * bayer[x & 7] + 1) * 255 / 128;
+                    const uint32_t red = ((key >> 16) * (CUBE_RED - 1) + d) / 255;
+                    const uint32_t green = (((key >> 8) & 0xFF) * (CUBE_GREEN - 1) + d) / 255;
+                    const uint32_t blue = ((key & 0xFF) * (CUBE_BLUE - 1) + d) / 255;
+                    lzw.put(static_cast<uint8_t>((red * CUBE_GREEN + green) * CUBE_BLUE + blue));
+                }
+            }
+        }
+        y += count;
+    }
+    lzw.finish();
+
+    sink.write(&TRAILER, 1);
+    sink.finish();
+    return true;
+}
+
+void GIFWriter::writeFade(const std::string& filename, const Fade& fade, const Resolution& resolution,
+                          const AnimationOptions& options) {
+    if (options.frameRateNum == 0 || options.frameRateDen == 0) {
+        throw std::invalid_argument("Frame rate must be positive");
+    }
+    if (options.loops > 65536) {
+        throw std::invalid_argument("A GIF animation plays at most 65536 times");
+    }
+    const uint32_t width = resolution.getWidth();
+    const uint32_t height = resolution.getHeight();
+    checkDimensions(width, height);
+
+    // Every frame is index 0 of its own two-color palette, so all share one stream
+    std::vector<uint8_t> canvas;
+    std::vector<uint8_t> holdPixel;
+    {
+        VectorSink sink{canvas};
+        LZWEncoder<VectorSink> lzw(sink, MIN_CODE_SIZE);
+        lzw.solid(0, resolution.getPixelCount());
+        lzw.finish();
+    }
+    {
+        VectorSink sink{holdPixel};
+        LZWEncoder<VectorSink> lzw(sink, MIN_CODE_SIZE);
+        lzw.solid(0, 1);
+        lzw.finish();
+    }
+
+    FileSink sink(filename);
+    writeScreen(sink, width, height, {});
+    if (options.loops != 1) {
+        // Netscape looping extension: repeats after the first play, 0 = forever
+        uint8_t loop[19] = {EXTENSION_INTRODUCER, APPLICATION_LABEL, 11,
+                            'N', 'E', 'T', 'S', 'C', 'A', 'P', 'E', '2', '.', '0', 3, 1};
+        putU16LE(loop + 16, options.loops == 0 ? 0 : options.loops - 1);
+        loop[18] = 0;
+        sink.write(loop, sizeof(loop));
+    }
+
+    // Frame boundaries in centiseconds, rounded from the exact times so errors do not add up
+    auto centiseconds = [&](uint64_t frame) {
+        return static_cast<uint64_t>(std::llround(static_cast<long double>(frame) * options.frameRateDen * 100 /
+                                                  options.frameRateNum));
+    };
+    auto transparent = [](const Color& color) { return color.getAlpha() < ALPHA_THRESHOLD; };
+    auto sameColor = [&](const Color& a, const Color& b) {
+        if (transparent(a) || transparent(b)) {
+            return transparent(a) == transparent(b);
+        }
+        return a.getRed() == b.getRed() && a.getGreen() == b.getGreen() && a.getBlue() == b.getBlue();
+    };
+
+    for (uint32_t start = 0; start < fade.frames();) {
+        const Color color = fade.color(start);
+        uint32_t end = start + 1;
+        while (end < fade.frames() && sameColor(fade.color(end), color)) {
+            ++end;
+        }
+
+        const std::vector<uint8_t> palette = colorTable({color.getRed(), color.getGreen(), color.getBlue()});
+        uint64_t delay = centiseconds(end) - centiseconds(start);
+        bool hold = false;
+        do {
+            const uint64_t piece = std::min<uint64_t>(delay, 0xFFFF);
+            writeGraphicControl(sink, static_cast<uint32_t>(piece), transparent(color) ? 0 : -1, DISPOSE_NONE);
+            writeImageDescriptor(sink, hold ? 1 : width, hold ? 1 : height, palette);
+            const std::vector<uint8_t>& data = hold ? holdPixel : canvas;
+            sink.write(data.data(), data.size());
+            delay -= piece;
+            hold = true;
+        } while (delay > 0);
+        start = end;
+    }
+
+    sink.write(&TRAILER, 1);
+    sink.finish();
+}
+
+} // namespace ColorGenerator
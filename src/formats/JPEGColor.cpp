@@ -0,0 +1,261 @@
+#include "../../include/formats/JPEGColor.hpp"
+#include "../../include/CpuFeatures.hpp"
+#include <algorithm>
+
+#ifdef COLORGEN_X86
+    #include <immintrin.h>
+#endif
+
+namespace ColorGenerator {
+namespace JPEG {
+
+namespace {
+
+constexpr int SCALE_BITS = 15;
+
+inline uint8_t luma(const ColorMatrix& m, int r, int g, int b) {
+    return static_cast<uint8_t>((m.yR * r + m.yG * g + m.yB * b + (m.yOffset << SCALE_BITS) +
+                                 (1 << (SCALE_BITS - 1))) >> SCALE_BITS);
+}
+
+/**
+ * @brief Chroma of the summed RGB of 2^@p log2Count pixels
+ *
+ * Rounds half down so the largest value stays 255.
+ */
+inline uint8_t chroma(int kR, int kG, int kB, int r, int g, int b, int log2Count) {
+    const int shift = SCALE_BITS + log2Count;
+    return static_cast<uint8_t>((kR * r + kG * g + kB * b + (128 << shift) + (1 << (shift - 1)) - 1) >> shift);
+}
+
+/**
+ * @brief Source row with the last pixel repeated past the right edge
+ */
+struct SourceRow {
+    const uint8_t* data;
+    uint32_t width;
+    int channels;
+
+    void rgb(size_t x, int& r, int& g, int& b) const {
+        const uint8_t* p = data + std::min<size_t>(x, width - 1) * channels;
+        r = p[0];
+        g = p[channels > 2 ? 1 : 0];
+        b = p[channels > 2 ? 2 : 0];
+    }
+};
+
+/**
+ * @brief Convert columns [start, planeWidth) of one luma row (two for 4:2:0)
+ */
+void convertScalar(const SourceRow& row0, const SourceRow& row1, size_t start, size_t planeWidth,
+                   Subsampling subsampling, const ColorMatrix& m, uint8_t* y0, uint8_t* y1, uint8_t* cb, uint8_t* cr) {
+    int r, g, b;
+    if (subsampling == Subsampling::YUV444) {
+        for (size_t x = start; x < planeWidth; ++x) {
+            row0.rgb(x, r, g, b);
+            y0[x] = luma(m, r, g, b);
+            cb[x] = chroma(m.cbR, m.cbG, m.cbB, r, g, b, 0);
+            cr[x] = chroma(m.crR, m.crG, m.crB, r, g, b, 0);
+        }
+        return;
+    }
+
+    const bool vertical = subsampling == Subsampling::YUV420;
+    for (size_t c = start / 2; c < planeWidth / 2; ++c) {
+        int sumR = 0, sumG = 0, sumB = 0;
+        for (size_t x = c * 2; x < c * 2 + 2; ++x) {
+            row0.rgb(x, r, g, b);
+            y0[x] = luma(m, r, g, b);
+            sumR += r;
+            sumG += g;
+            sumB += b;
+            if (vertical) {
+                row1.rgb(x, r, g, b);
+                y1[x] = luma(m, r, g, b);
+                sumR += r;
+                sumG += g;
+                sumB += b;
+            }
+        }
+        const int log2Count = vertical ? 2 : 1;
+        cb[c] = chroma(m.cbR, m.cbG, m.cbB, sumR, sumG, sumB, log2Count);
+        cr[c] = chroma(m.crR, m.crG, m.crB, sumR, sumG, sumB, log2Count);
+    }
+}
+
+using Kernel = size_t (*)(const SourceRow&, const SourceRow&, Subsampling, const ColorMatrix&, uint8_t*, uint8_t*, uint8_t*, uint8_t*);
+
+#ifdef COLORGEN_X86
+
+/**
+ * @brief Load 16 RGB or RGBA pixels as 16-bit R, G and B (low and high 8 pixels)
+ */
+COLORGEN_TARGET("ssse3") void loadPixels(const uint8_t* p, int channels, __m128i* r, __m128i* g, __m128i* b) {
+    const __m128i zero = _mm_setzero_si128();
+    if (channels == 3) {
+        const __m128i a = _mm_loadu_si128(reinterpret_cast<const __m128i*>(p));
+        const __m128i m = _mm_loadu_si128(reinterpret_cast<const __m128i*>(p + 16));
+        const __m128i z = _mm_loadu_si128(reinterpret_cast<const __m128i*>(p + 32));
+        const __m128i r8 = _mm_or_si128(_mm_or_si128(
+            _mm_shuffle_epi8(a, _mm_setr_epi8(0, 3, 6, 9, 12, 15, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1)),
+            _mm_shuffle_epi8(m, _mm_setr_epi8(-1, -1, -1, -1, -1, -1, 2, 5, 8, 11, 14, -1, -1, -1, -1, -1))),
+            _mm_shuffle_epi8(z, _mm_setr_epi8(-1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, 1, 4, 7, 10, 13)));
+        const __m128i g8 = _mm_or_si128(_mm_or_si128(
+            _mm_shuffle_epi8(a, _mm_setr_epi8(1, 4, 7, 10, 13, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1)),
+            _mm_shuffle_epi8(m, _mm_setr_epi8(-1, -1, -1, -1, -1, 0, 3, 6, 9, 12, 15, -1, -1, -1, -1, -1))),
+            _mm_shuffle_epi8(z, _mm_setr_epi8(-1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, 2, 5, 8, 11, 14)));
+        const __m128i b8 = _mm_or_si128(_mm_or_si128(
+            _mm_shuffle_epi8(a, _mm_setr_epi8(2, 5, 8, 11, 14, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1)),
+            _mm_shuffle_epi8(m, _mm_setr_epi8(-1, -1, -1, -1, -1, 1, 4, 7, 10, 13, -1, -1, -1, -1, -1, -1))),
+            _mm_shuffle_epi8(z, _mm_setr_epi8(-1, -1, -1, -1, -1, -1, -1, -1, -1, -1, 0, 3, 6, 9, 12, 15)));
+        r[0] = _mm_unpacklo_epi8(r8, zero);
+        r[1] = _mm_unpackhi_epi8(r8, zero);
+        g[0] = _mm_unpacklo_epi8(g8, zero);
+        g[1] = _mm_unpackhi_epi8(g8, zero);
+        b[0] = _mm_unpacklo_epi8(b8, zero);
+        b[1] = _mm_unpackhi_epi8(b8, zero);
+    } else {
+        const __m128i mask = _mm_set1_epi32(0xFF);
+        for (int half = 0; half < 2; ++half) {
+            const __m128i v0 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(p + half * 32));
+            const __m128i v1 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(p + half * 32 + 16));
+            r[half] = _mm_packs_epi32(_mm_and_si128(v0, mask), _mm_and_si128(v1, mask));
+            g[half] = _mm_packs_epi32(_mm_and_si128(_mm_srli_epi32(v0, 8), mask),
+                                      _mm_and_si128(_mm_srli_epi32(v1, 8), mask));
+            b[half] = _mm_packs_epi32(_mm_and_si128(_mm_srli_epi32(v0, 16), mask),
+                                      _mm_and_si128(_mm_srli_epi32(v1, 16), mask));
+        }
+    }
+}
+
+/**
+ * @brief Weighted sum of 8 16-bit R, G, B values plus @p bias, shifted right by @p shift
+ */
+COLORGEN_TARGET("ssse3") __m128i weigh(__m128i r, __m128i g, __m128i b, int kR, int kG, int kB,
+                                       int bias, int shift) {
+    const __m128i kRG = _mm_set1_epi32(static_cast<int>((static_cast<uint32_t>(kG) << 16) | static_cast<uint16_t>(kR)));
+    const __m128i kB0 = _mm_set1_epi32(static_cast<uint16_t>(kB));
+    const __m128i add = _mm_set1_epi32(bias);
+    const __m128i count = _mm_cvtsi32_si128(shift);
+    const __m128i zero = _mm_setzero_si128();
+
+    const __m128i lo = _mm_add_epi32(_mm_add_epi32(_mm_madd_epi16(_mm_unpacklo_epi16(r, g), kRG),
+                                                   _mm_madd_epi16(_mm_unpacklo_epi16(b, zero), kB0)), add);
+    const __m128i hi = _mm_add_epi32(_mm_add_epi32(_mm_madd_epi16(_mm_unpackhi_epi16(r, g), kRG),
+                                                   _mm_madd_epi16(_mm_unpackhi_epi16(b, zero), kB0)), add);
+    return _mm_packs_epi32(_mm_sra_epi32(lo, count), _mm_sra_epi32(hi, count));
+}
+
+COLORGEN_TARGET("ssse3") void storeLuma(uint8_t* out, const ColorMatrix& m, const __m128i* r, const __m128i* g, const __m128i* b) {
+    const int bias = (m.yOffset << SCALE_BITS) + (1 << (SCALE_BITS - 1));
+    const __m128i lo = weigh(r[0], g[0], b[0], m.yR, m.yG, m.yB, bias, SCALE_BITS);
+    const __m128i hi = weigh(r[1], g[1], b[1], m.yR, m.yG, m.yB, bias, SCALE_BITS);
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(out), _mm_packus_epi16(lo, hi));
+}
+
+COLORGEN_TARGET("ssse3") __m128i chromaSSSE3(__m128i r, __m128i g, __m128i b, int kR, int kG, int kB, int log2Count) {
+    const int shift = SCALE_BITS + log2Count;
+    return weigh(r, g, b, kR, kG, kB, (128 << shift) + (1 << (shift - 1)) - 1, shift);
+}
+
+COLORGEN_TARGET("ssse3") size_t convertSSSE3(const SourceRow& row0, const SourceRow& row1, Subsampling subsampling,
+                                             const ColorMatrix& m, uint8_t* y0, uint8_t* y1, uint8_t* cb, uint8_t* cr) {
+    const int channels = row0.channels;
+    if (channels < 3) {
+        return 0;
+    }
+
+    const size_t end = row0.width & ~static_cast<size_t>(15);
+    for (size_t x = 0; x < end; x += 16) {
+        __m128i r[2], g[2], b[2];
+        loadPixels(row0.data + x * channels, channels, r, g, b);
+        storeLuma(y0 + x, m, r, g, b);
+
+        if (subsampling == Subsampling::YUV444) {
+            _mm_storeu_si128(reinterpret_cast<__m128i*>(cb + x),
+                             _mm_packus_epi16(chromaSSSE3(r[0], g[0], b[0], m.cbR, m.cbG, m.cbB, 0),
+                                              chromaSSSE3(r[1], g[1], b[1], m.cbR, m.cbG, m.cbB, 0)));
+            _mm_storeu_si128(reinterpret_cast<__m128i*>(cr + x),
+                             _mm_packus_epi16(chromaSSSE3(r[0], g[0], b[0], m.crR, m.crG, m.crB, 0),
+                                              chromaSSSE3(r[1], g[1], b[1], m.crR, m.crG, m.crB, 0)));
+            continue;
+        }
+
+        int log2Count = 1;
+        if (subsampling == Subsampling::YUV420) {
+            __m128i r1[2], g1[2], b1[2];
+            loadPixels(row1.data + x * channels, channels, r1, g1, b1);
+            storeLuma(y1 + x, m, r1, g1, b1);
+            for (int i = 0; i < 2; ++i) {
+                r[i] = _mm_add_epi16(r[i], r1[i]);
+                g[i] = _mm_add_epi16(g[i], g1[i]);
+                b[i] = _mm_add_epi16(b[i], b1[i]);
+            }
+            log2Count = 2;
+        }
+
+        // Sum horizontal pairs: 16 pixels become 8 chroma samples
+        const __m128i sumR = _mm_hadd_epi16(r[0], r[1]);
+        const __m128i sumG = _mm_hadd_epi16(g[0], g[1]);
+        const __m128i sumB = _mm_hadd_epi16(b[0], b[1]);
+        const __m128i u = chromaSSSE3(sumR, sumG, sumB, m.cbR, m.cbG, m.cbB, log2Count);
+        const __m128i v = chromaSSSE3(sumR, sumG, sumB, m.crR, m.crG, m.crB, log2Count);
+        _mm_storel_epi64(reinterpret_cast<__m128i*>(cb + x / 2), _mm_packus_epi16(u, u));
+        _mm_storel_epi64(reinterpret_cast<__m128i*>(cr + x / 2), _mm_packus_epi16(v, v));
+    }
+    return end;
+}
+
+#endif
+
+size_t convertNone(const SourceRow&, const SourceRow&, Subsampling, const ColorMatrix&, uint8_t*, uint8_t*, uint8_t*, uint8_t*) {
+    return 0;
+}
+
+Kernel selectKernel() {
+#ifdef COLORGEN_X86
+    if (CpuFeatures::get().ssse3) return convertSSSE3;
+#endif
+    return convertNone;
+}
+
+} // namespace
+
+void convertRows(const uint8_t* row0, const uint8_t* row1, uint32_t width, int channels,
+                 Subsampling subsampling, const ColorMatrix& matrix, size_t planeWidth,
+                 uint8_t* y0, uint8_t* y1, uint8_t* cb, uint8_t* cr) {
+    static const Kernel kernel = selectKernel();
+
+    const SourceRow source0{row0, width, channels};
+    const SourceRow source1{row1, width, channels};
+    const size_t done = kernel(source0, source1, subsampling, matrix, y0, y1, cb, cr);
+    convertScalar(source0, source1, done, planeWidth, subsampling, matrix, y0, y1, cb, cr);
+}
+
+void convertStripe(const SourceImage& image, uint32_t y0, Subsampling subsampling, size_t planeWidth,
+                   uint8_t* luma, uint8_t* cb, uint8_t* cr) {
+    const size_t rowBytes = static_cast<size_t>(image.width) * image.channels;
+    auto row = [&](uint32_t y) {
+        return image.pixels + std::min(y, image.height - 1) * rowBytes;
+    };
+
+    const size_t chromaStride = subsampling == Subsampling::YUV444 ? planeWidth : planeWidth / 2;
+    const bool vertical = subsampling == Subsampling::YUV420;
+
+    // One chroma row per iteration: one luma row, or two for 4:2:0
+    for (uint32_t i = 0; i < 8; ++i) {
+        const uint32_t lumaRow = vertical ? i * 2 : i;
+        const uint8_t* row0 = row(y0 + lumaRow);
+        const uint8_t* row1 = vertical ? row(y0 + lumaRow + 1) : row0;
+        uint8_t* out0 = luma + lumaRow * planeWidth;
+        uint8_t* out1 = vertical ? out0 + planeWidth : nullptr;
+        uint8_t* outCb = cb + i * chromaStride;
+        uint8_t* outCr = cr + i * chromaStride;
+
+        convertRows(row0, row1, image.width, image.channels, subsampling, BT601_FULL, planeWidth,
+                    out0, out1, outCb, outCr);
+    }
+}
+
+} // namespace JPEG
+} // namespace ColorGenerator
@@ -0,0 +1,290 @@
+#include "../../include/formats/JPEGCommon.hpp"
+#include <algorithm>
+
+namespace ColorGenerator {
+namespace JPEG {
+
+const uint8_t ZIGZAG[64] = {
+    0, 1, 5, 6, 14, 15, 27, 28, 2, 4, 7, 13, 16, 26, 29, 42,
+    3, 8, 12, 17, 25, 30, 41, 43, 9, 11, 18, 24, 31, 40, 44, 53,
+    10, 19, 23, 32, 39, 45, 52, 54, 20, 22, 33, 38, 46, 51, 55, 60,
+    21, 34, 37, 47, 50, 56, 59, 61, 35, 36, 48, 49, 57, 58, 62, 63
+};
+
+const int LUMA_QUANT[64] = {
+    16, 11, 10, 16, 24, 40, 51, 61, 12, 12, 14, 19, 26, 58, 60, 55,
+    14, 13, 16, 24, 40, 57, 69, 56, 14, 17, 22, 29, 51, 87, 80, 62,
+    18, 22, 37, 56, 68, 109, 103, 77, 24, 35, 55, 64, 81, 104, 113, 92,
+    49, 64, 78, 87, 103, 121, 120, 101, 72, 92, 95, 98, 112, 100, 103, 99
+};
+const int CHROMA_QUANT[64] = {
+    17, 18, 24, 47, 99, 99, 99, 99, 18, 21, 26, 66, 99, 99, 99, 99,
+    24, 26, 56, 99, 99, 99, 99, 99, 47, 66, 99, 99, 99, 99, 99, 99,
+    99, 99, 99, 99, 99, 99, 99, 99, 99, 99, 99, 99, 99, 99, 99, 99,
+    99, 99, 99, 99, 99, 99, 99, 99, 99, 99, 99, 99, 99, 99, 99, 99
+};
+
+namespace {
+
+const uint8_t DC_VALUES[12] = {0, 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11};
+
+const uint8_t AC_LUMA_VALUES[162] = {
+    0x01, 0x02, 0x03, 0x00, 0x04, 0x11, 0x05, 0x12, 0x21, 0x31, 0x41, 0x06, 0x13, 0x51, 0x61, 0x07,
+    0x22, 0x71, 0x14, 0x32, 0x81, 0x91, 0xa1, 0x08, 0x23, 0x42, 0xb1, 0xc1, 0x15, 0x52, 0xd1, 0xf0,
+    0x24, 0x33, 0x62, 0x72, 0x82, 0x09, 0x0a, 0x16, 0x17, 0x18, 0x19, 0x1a, 0x25, 0x26, 0x27, 0x28,
+    0x29, 0x2a, 0x34, 0x35, 0x36, 0x37, 0x38, 0x39, 0x3a, 0x43, 0x44, 0x45, 0x46, 0x47, 0x48, 0x49,
+    0x4a, 0x53, 0x54, 0x55, 0x56, 0x57, 0x58, 0x59, 0x5a, 0x63, 0x64, 0x65, 0x66, 0x67, 0x68, 0x69,
+    0x6a, 0x73, 0x74, 0x75, 0x76, 0x77, 0x78, 0x79, 0x7a, 0x83, 0x84, 0x85, 0x86, 0x87, 0x88, 0x89,
+    0x8a, 0x92, 0x93, 0x94, 0x95, 0x96, 0x97, 0x98, 0x99, 0x9a, 0xa2, 0xa3, 0xa4, 0xa5, 0xa6, 0xa7,
+    0xa8, 0xa9, 0xaa, 0xb2, 0xb3, 0xb4, 0xb5, 0xb6, 0xb7, 0xb8, 0xb9, 0xba, 0xc2, 0xc3, 0xc4, 0xc5,
+    0xc6, 0xc7, 0xc8, 0xc9, 0xca, 0xd2, 0xd3, 0xd4, 0xd5, 0xd6, 0xd7, 0xd8, 0xd9, 0xda, 0xe1, 0xe2,
+    0xe3, 0xe4, 0xe5, 0xe6, 0xe7, 0xe8, 0xe9, 0xea, 0xf1, 0xf2, 0xf3, 0xf4, 0xf5, 0xf6, 0xf7, 0xf8,
+    0xf9, 0xfa
+};
+
+const uint8_t AC_CHROMA_VALUES[162] = {
+    0x00, 0x01, 0x02, 0x03, 0x11, 0x04, 0x05, 0x21, 0x31, 0x06, 0x12, 0x41, 0x51, 0x07, 0x61, 0x71,
+    0x13, 0x22, 0x32, 0x81, 0x08, 0x14, 0x42, 0x91, 0xa1, 0xb1, 0xc1, 0x09, 0x23, 0x33, 0x52, 0xf0,
+    0x15, 0x62, 0x72, 0xd1, 0x0a, 0x16, 0x24, 0x34, 0xe1, 0x25, 0xf1, 0x17, 0x18, 0x19, 0x1a, 0x26,
+    0x27, 0x28, 0x29, 0x2a, 0x35, 0x36, 0x37, 0x38, 0x39, 0x3a, 0x43, 0x44, 0x45, 0x46, 0x47, 0x48,
+    0x49, 0x4a, 0x53, 0x54, 0x55, 0x56, 0x57, 0x58, 0x59, 0x5a, 0x63, 0x64, 0x65, 0x66, 0x67, 0x68,
+    0x69, 0x6a, 0x73, 0x74, 0x75, 0x76, 0x77, 0x78, 0x79, 0x7a, 0x82, 0x83, 0x84, 0x85, 0x86, 0x87,
+    0x88, 0x89, 0x8a, 0x92, 0x93, 0x94, 0x95, 0x96, 0x97, 0x98, 0x99, 0x9a, 0xa2, 0xa3, 0xa4, 0xa5,
+    0xa6, 0xa7, 0xa8, 0xa9, 0xaa, 0xb2, 0xb3, 0xb4, 0xb5, 0xb6, 0xb7, 0xb8, 0xb9, 0xba, 0xc2, 0xc3,
+    0xc4, 0xc5, 0xc6, 0xc7, 0xc8, 0xc9, 0xca, 0xd2, 0xd3, 0xd4, 0xd5, 0xd6, 0xd7, 0xd8, 0xd9, 0xda,
+    0xe2, 0xe3, 0xe4, 0xe5, 0xe6, 0xe7, 0xe8, 0xe9, 0xea, 0xf2, 0xf3, 0xf4, 0xf5, 0xf6, 0xf7, 0xf8,
+    0xf9, 0xfa
+};
+
+} // namespace
+
+const HuffmanSpec DC_LUMA = {{0, 1, 5, 1, 1, 1, 1, 1, 1, 0, 0, 0, 0, 0, 0, 0}, DC_VALUES, 12};
+const HuffmanSpec AC_LUMA = {{0, 2, 1, 3, 3, 2, 4, 3, 5, 5, 4, 4, 0, 0, 1, 0x7d}, AC_LUMA_VALUES, 162};
+const HuffmanSpec DC_CHROMA = {{0, 3, 1, 1, 1, 1, 1, 1, 1, 1, 1, 0, 0, 0, 0, 0}, DC_VALUES, 12};
+const HuffmanSpec AC_CHROMA = {{0, 2, 1, 2, 4, 4, 3, 4, 7, 5, 4, 4, 0, 1, 2, 0x77}, AC_CHROMA_VALUES, 162};
+
+CodeTable buildCodes(const HuffmanSpec& spec) {
+    CodeTable codes{};
+    uint32_t code = 0;
+    size_t k = 0;
+    for (int len = 1; len <= 16; ++len) {
+        for (int i = 0; i < spec.counts[len - 1]; ++i) {
+            codes[spec.values[k++]] = {code++, len};
+        }
+        code <<= 1;
+    }
+    return codes;
+}
+
+HuffmanSpec buildOptimalTable(const SymbolCounts& counts, std::array<uint8_t, 256>& values) {
+    constexpr int RESERVED = 256;
+    constexpr int MAX_LENGTH = 32;
+
+    uint64_t frequency[257];
+    int codeSize[257] = {};
+    int next[257];
+    for (int i = 0; i < 256; ++i) {
+        frequency[i] = counts[i];
+    }
+    frequency[RESERVED] = 1;
+    std::fill(next, next + 257, -1);
+
+    // Repeatedly merge the two least frequent trees; ties go to the larger symbol
+    for (;;) {
+        int c1 = -1, c2 = -1;
+        for (int i = 0; i <= RESERVED; ++i) {
+            if (frequency[i] && (c1 < 0 || frequency[i] <= frequency[c1])) {
+                c1 = i;
+            }
+        }
+        for (int i = 0; i <= RESERVED; ++i) {
+            if (frequency[i] && i != c1 && (c2 < 0 || frequency[i] <= frequency[c2])) {
+                c2 = i;
+            }
+        }
+        if (c2 < 0) {
+            break;
+        }
+
+        frequency[c1] += frequency[c2];
+        frequency[c2] = 0;
+        for (++codeSize[c1]; next[c1] >= 0; ++codeSize[c1]) {
+            c1 = next[c1];
+        }
+        next[c1] = c2;
+        for (++codeSize[c2]; next[c2] >= 0; ++codeSize[c2]) {
+            c2 = next[c2];
+        }
+    }
+
+    int lengthCounts[MAX_LENGTH + 1] = {};
+    for (int i = 0; i <= RESERVED; ++i) {
+        if (codeSize[i]) {
+            ++lengthCounts[codeSize[i]];
+        }
+    }
+
+    // Limit lengths to 16 bits: move pairs of long codes up, splitting a shorter one
+    for (int length = MAX_LENGTH; length > 16; --length) {
+        while (lengthCounts[length] > 0) {
+            int j = length - 2;
+            while (lengthCounts[j] == 0) {
+                --j;
+            }
+            lengthCounts[length] -= 2;
+            ++lengthCounts[length - 1];
+            lengthCounts[j + 1] += 2;
+            --lengthCounts[j];
+        }
+    }
+
+    // Drop the reserved symbol, which has the longest code
+    int longest = 16;
+    while (longest > 0 && lengthCounts[longest] == 0) {
+        --longest;
+    }
+    if (longest > 0) {
+        --lengthCounts[longest];
+    }
+
+    HuffmanSpec spec{};
+    for (int length = 1; length <= 16; ++length) {
+        spec.counts[length - 1] = static_cast<uint8_t>(lengthCounts[length]);
+    }
+    size_t k = 0;
+    for (int length = 1; length <= MAX_LENGTH; ++length) {
+        for (int i = 0; i < 256; ++i) {
+            if (codeSize[i] == length) {
+                values[k++] = static_cast<uint8_t>(i);
+            }
+        }
+    }
+    spec.values = values.data();
+    spec.valueCount = k;
+    return spec;
+}
+
+int qualityScale(int quality) {
+    quality = quality ? quality : 90;
+    quality = quality < 1 ? 1 : quality > 100 ? 100 : quality;
+    return quality < 50 ? 5000 / quality : 200 - quality * 2;
+}
+
+std::array<uint8_t, 64> scaleQuantTable(const int* base, int scale) {
+    std::array<uint8_t, 64> table{};
+    for (int i = 0; i < 64; ++i) {
+        int value = (base[i] * scale + 50) / 100;
+        table[ZIGZAG[i]] = static_cast<uint8_t>(value < 1 ? 1 : value > 255 ? 255 : value);
+    }
+    return table;
+}
+
+namespace {
+
+void putMarker(std::vector<uint8_t>& out, uint8_t marker, size_t payloadLength) {
+    size_t length = payloadLength + 2;
+    out.push_back(0xFF);
+    out.push_back(marker);
+    out.push_back(static_cast<uint8_t>(length >> 8));
+    out.push_back(static_cast<uint8_t>(length));
+}
+
+} // namespace
+
+void writeHeaders(std::vector<uint8_t>& out, const FrameHeader& header) {
+    const bool gray = header.components == 1;
+
+    // SOI + JFIF APP0
+    static const uint8_t jfif[] = {
+        0xFF, 0xD8, 0xFF, 0xE0, 0, 0x10, 'J', 'F', 'I', 'F', 0, 1, 1, 0, 0, 1, 0, 1, 0, 0
+    };
+    out.insert(out.end(), jfif, jfif + sizeof(jfif));
+
+    // DQT
+    putMarker(out, 0xDB, gray ? 65 : 130);
+    out.push_back(0);
+    out.insert(out.end(), header.lumaQuant, header.lumaQuant + 64);
+    if (!gray) {
+        out.push_back(1);
+        out.insert(out.end(), header.chromaQuant, header.chromaQuant + 64);
+    }
+
+    // SOF0
+    putMarker(out, 0xC0, 6 + 3 * header.components);
+    out.push_back(8);
+    out.push_back(static_cast<uint8_t>(header.height >> 8));
+    out.push_back(static_cast<uint8_t>(header.height));
+    out.push_back(static_cast<uint8_t>(header.width >> 8));
+    out.push_back(static_cast<uint8_t>(header.width));
+    out.push_back(static_cast<uint8_t>(header.components));
+    if (gray) {
+        const uint8_t component[] = {1, 0x11, 0};
+        out.insert(out.end(), component, component + 3);
+    } else {
+        const uint8_t component[] = {1, header.lumaSampling, 0, 2, 0x11, 1, 3, 0x11, 1};
+        out.insert(out.end(), component, component + 9);
+    }
+
+    // DHT
+    const uint8_t classIds[] = {0x00, 0x10, 0x01, 0x11};
+    const int tableCount = gray ? 2 : 4;
+    size_t dhtLength = 0;
+    for (int t = 0; t < tableCount; ++t) {
+        dhtLength += 17 + header.huffman[t]->valueCount;
+    }
+    putMarker(out, 0xC4, dhtLength);
+    for (int t = 0; t < tableCount; ++t) {
+        const HuffmanSpec& spec = *header.huffman[t];
+        out.push_back(classIds[t]);
+        out.insert(out.end(), spec.counts, spec.counts + 16);
+        out.insert(out.end(), spec.values, spec.values + spec.valueCount);
+    }
+
+    // DRI
+    if (header.restartInterval) {
+        putMarker(out, 0xDD, 2);
+        out.push_back(static_cast<uint8_t>(header.restartInterval >> 8));
+        out.push_back(static_cast<uint8_t>(header.restartInterval));
+    }
+
+    // SOS
+    putMarker(out, 0xDA, 4 + 2 * header.components);
+    out.push_back(static_cast<uint8_t>(header.components));
+    if (gray) {
+        const uint8_t component[] = {1, 0x00};
+        out.insert(out.end(), component, component + 2);
+    } else {
+        const uint8_t component[] = {1, 0x00, 2, 0x11, 3, 0x11};
+        out.insert(out.end(), component, component + 6);
+    }
+    out.push_back(0);
+    out.push_back(63);
+    out.push_back(0);
+}
+
+void BitWriter::flush() {
+    const int used = 64 - free_;
+    putStuffed(acc_, used);
+    free_ = 64 - (used & 7);
+    out_.resize(pos_);
+}
+
+void BitWriter::putStuffed(uint64_t word, int count) {
+    if (out_.size() - pos_ < 16) {
+        grow();
+    }
+    for (int shift = count - 8; shift >= 0; shift -= 8) {
+        const uint8_t byte = static_cast<uint8_t>(word >> shift);
+        out_[pos_++] = byte;
+        if (byte == 0xFF) {
+            out_[pos_++] = 0x00;
+        }
+    }
+}
+
+void BitWriter::grow() {
+    out_.resize(std::max<size_t>(out_.size() * 2, pos_ + 4096));
+}
+
+} // namespace JPEG
+} // namespace ColorGenerator
@@ -0,0 +1,457 @@
+#include "../../include/formats/JPEGEncoder.hpp"
+#include "../../include/formats/JPEGCommon.hpp"
+#include "../../include/formats/ByteSink.hpp"
+#include "../../include/ThreadPool.hpp"
+#include <algorithm>
+#include <array>
+#include <fstream>
+#include <stdexcept>
+
+namespace ColorGenerator {
+
+using namespace JPEG;
+
+namespace {
+
+enum HuffmanTable { DC_LUMA_TABLE, AC_LUMA_TABLE, DC_CHROMA_TABLE, AC_CHROMA_TABLE, TABLE_COUNT };
+
+/**
+ * @brief Per-image quantization and Huffman state shared by all segments
+ */
+struct EncoderTables {
+    std::array<uint8_t, 64> lumaQuant;
+    std::array<uint8_t, 64> chromaQuant;
+    Quantizer luma;
+    Quantizer chroma;
+    HuffmanSpec huffman[TABLE_COUNT];
+    CodeTable codes[TABLE_COUNT];
+    DCTMethod dct;
+    Subsampling subsampling;
+
+    EncoderTables(int quality, DCTMethod method, Subsampling chroma)
+        : lumaQuant(scaleQuantTable(LUMA_QUANT, qualityScale(quality))),
+          chromaQuant(scaleQuantTable(CHROMA_QUANT, qualityScale(quality))),
+          luma(lumaQuant.data()),
+          chroma(chromaQuant.data()),
+          huffman{DC_LUMA, AC_LUMA, DC_CHROMA, AC_CHROMA},
+          dct(method),
+          subsampling(resolveSubsampling(chroma, quality)) {
+        buildAllCodes();
+    }
+
+    /**
+     * @brief Replace the Annex K Huffman tables with ones built from symbol counts
+     */
+    void optimize(const SymbolCounts* counts) {
+        for (int t = 0; t < TABLE_COUNT; ++t) {
+            huffman[t] = buildOptimalTable(counts[t], optimizedValues_[t]);
+        }
+        buildAllCodes();
+    }
+
+private:
+    void buildAllCodes() {
+        for (int t = 0; t < TABLE_COUNT; ++t) {
+            codes[t] = buildCodes(huffman[t]);
+        }
+    }
+
+    std::array<uint8_t, 256> optimizedValues_[TABLE_COUNT];
+};
+
+/**
+ * @brief Emits one component's symbols as Huffman codes
+ */
+struct HuffmanCoder {
+    BitWriter& bits;
+    const CodeTable& dcCodes;
+    const CodeTable& acCodes;
+
+    void dc(int diff) { bits.dc(diff, dcCodes); }
+    void ac(int zeros, int value) { bits.ac(zeros, value, acCodes); }
+    void symbol(uint8_t value) { bits.put(acCodes[value]); }
+};
+
+/**
+ * @brief Counts one component's symbols instead of coding them
+ */
+struct SymbolCounter {
+    SymbolCounts& dcCounts;
+    SymbolCounts& acCounts;
+
+    void dc(int diff) { ++dcCounts[BitWriter::magnitudeCategory(diff)]; }
+    void ac(int zeros, int value) { ++acCounts[(zeros << 4) + BitWriter::magnitudeCategory(value)]; }
+    void symbol(uint8_t value) { ++acCounts[value]; }
+};
+
+/**
+ * @brief Index of the lowest set bit of a non-zero @p mask
+ */
+inline int lowestBit(uint64_t mask) {
+#if defined(__GNUC__) || defined(__clang__)
+    return __builtin_ctzll(mask);
+#else
+    int index = 0;
+    while (!(mask & 1)) {
+        mask >>= 1;
+        ++index;
+    }
+    return index;
+#endif
+}
+
+/**
+ * @brief Entropy code (or count the symbols of) one block of zigzag-ordered coefficients
+ *
+ * Non-zero AC coefficients are visited through a bitmap, so runs of
+ * zeros cost one bit scan instead of a loop iteration per coefficient.
+ *
+ * @return The block's DC value, the predictor for the next block
+ */
+template <typename Coder>
+int encodeBlock(Coder& coder, const int16_t* coefficients, int previousDC) {
+    coder.dc(coefficients[0] - previousDC);
+
+    uint64_t nonzero = 0;
+    for (int i = 1; i < 64; ++i) {
+        nonzero |= static_cast<uint64_t>(coefficients[i] != 0) << i;
+    }
+
+    int previous = 0;
+    while (nonzero) {
+        const int i = lowestBit(nonzero);
+        nonzero &= nonzero - 1;
+
+        int zeros = i - previous - 1;
+        for (; zeros >= 16; zeros -= 16) {
+            coder.symbol(0xF0);  // ZRL
+        }
+        coder.ac(zeros, coefficients[i]);
+        previous = i;
+    }
+    if (previous != 63) {
+        coder.symbol(0x00);  // EOB
+    }
+    return coefficients[0];
+}
+
+/**
+ * @brief Y, Cb and Cr planes of one MCU row, plus coefficients for a chunk of its MCUs
+ *
+ * The row's scanlines are fetched from the source, converted in one
+ * pass, then transformed and entropy coded CHUNK_MCUS at a time so the
+ * coefficients stay in cache while they are coded. Planes are padded to
+ * whole MCUs by the converter.
+ */
+class RowWorkspace {
+public:
+    RowWorkspace(const RowSource& source, const EncoderTables& tables, uint32_t mcusPerRow)
+        : source_(source), tables_(tables),
+          mcuWidth_(mcuWidth(tables.subsampling)),
+          mcuHeight_(mcuHeight(tables.subsampling)),
+          stride_(static_cast<size_t>(mcusPerRow) * mcuWidth_),
+          chromaStride_(tables.subsampling == Subsampling::YUV444 ? stride_ : stride_ / 2),
+          mcusPerRow_(mcusPerRow),
+          y_(stride_ * mcuHeight_), cb_(chromaStride_ * 8), cr_(chromaStride_ * 8),
+          yCoefficients_(CHUNK_MCUS * mcuWidth_ * mcuHeight_),
+          cbCoefficients_(CHUNK_MCUS * 64), crCoefficients_(CHUNK_MCUS * 64),
+          scanlines_(mcuHeight_ * source.rowBytes()) {}
+
+    /**
+     * @brief Convert, transform and entropy code MCU row @p mcuRow
+     */
+    template <typename Coder>
+    void encode(uint32_t mcuRow, Coder& luma, Coder& chroma, int& dcY, int& dcCb, int& dcCr) {
+        // The stripe is its own image: rows past its end repeat its last row
+        const uint32_t y0 = mcuRow * static_cast<uint32_t>(mcuHeight_);
+        const uint32_t count = std::min(static_cast<uint32_t>(mcuHeight_), source_.height() - y0);
+        const SourceImage stripe{source_.rows(y0, count, scanlines_.data()), source_.width(), count,
+                                 source_.channels()};
+        convertStripe(stripe, 0, tables_.subsampling, stride_, y_.data(), cb_.data(), cr_.data());
+
+        const size_t lumaColumns = mcuWidth_ / 8;
+        const size_t lumaRows = mcuHeight_ / 8;
+
+        for (size_t first = 0; first < mcusPerRow_; first += CHUNK_MCUS) {
+            const size_t count = std::min(CHUNK_MCUS, mcusPerRow_ - first);
+            const size_t lumaBlocks = count * lumaColumns;
+
+            for (size_t row = 0; row < lumaRows; ++row) {
+                transformBlocks(y_.data() + row * 8 * stride_ + first * mcuWidth_, stride_, lumaBlocks,
+                                tables_.luma, tables_.dct, yCoefficients_.data() + row * lumaBlocks * 64);
+            }
+            transformBlocks(cb_.data() + first * 8, chromaStride_, count, tables_.chroma, tables_.dct,
+                            cbCoefficients_.data());
+            transformBlocks(cr_.data() + first * 8, chromaStride_, count, tables_.chroma, tables_.dct,
+                            crCoefficients_.data());
+
+            for (size_t mcu = 0; mcu < count; ++mcu) {
+                for (size_t row = 0; row < lumaRows; ++row) {
+                    const int16_t* blocks = yCoefficients_.data() + (row * lumaBlocks + mcu * lumaColumns) * 64;
+                    for (size_t column = 0; column < lumaColumns; ++column) {
+                        dcY = encodeBlock(luma, blocks + column * 64, dcY);
+                    }
+                }
+                dcCb = encodeBlock(chroma, cbCoefficients_.data() + mcu * 64, dcCb);
+                dcCr = encodeBlock(chroma, crCoefficients_.data() + mcu * 64, dcCr);
+            }
+        }
+    }
+
+private:
+    static constexpr size_t CHUNK_MCUS = 32;
+
+    const RowSource& source_;
+    const EncoderTables& tables_;
+    size_t mcuWidth_;
+    size_t mcuHeight_;
+    size_t stride_;
+    size_t chromaStride_;
+    size_t mcusPerRow_;
+    std::vector<uint8_t> y_, cb_, cr_;
+    std::vector<int16_t> yCoefficients_, cbCoefficients_, crCoefficients_;
+    std::vector<uint8_t> scanlines_;
+};
+
+/**
+ * @brief Appends encoded bytes to a vector
+ */
+struct VectorSink {
+    std::vector<uint8_t>& out;
+
+    void write(const uint8_t* data, size_t size) { out.insert(out.end(), data, data + size); }
+};
+
+/**
+ * @brief Encode MCU rows [firstRow, endRow) as one restart segment into @p out
+ *
+ * With a @p sink, complete bytes are moved to it whenever DRAIN_BYTES have
+ * collected, so a segment covering the whole image needs O(width) memory.
+ */
+template <typename Sink>
+void encodeSegment(const RowSource& source, const EncoderTables& tables, uint32_t mcusPerRow,
+                   uint32_t firstRow, uint32_t endRow, std::vector<uint8_t>& out, Sink* sink) {
+    constexpr size_t DRAIN_BYTES = 256 * 1024;
+
+    RowWorkspace workspace(source, tables, mcusPerRow);
+    BitWriter bits(out);
+    HuffmanCoder luma{bits, tables.codes[DC_LUMA_TABLE], tables.codes[AC_LUMA_TABLE]};
+    HuffmanCoder chroma{bits, tables.codes[DC_CHROMA_TABLE], tables.codes[AC_CHROMA_TABLE]};
+    int dcY = 0, dcCb = 0, dcCr = 0;
+
+    for (uint32_t mcuRow = firstRow; mcuRow < endRow; ++mcuRow) {
+        workspace.encode(mcuRow, luma, chroma, dcY, dcCb, dcCr);
+        if (sink && bits.size() >= DRAIN_BYTES) {
+            bits.flush();
+            sink->write(out.data(), out.size());
+            bits.discardOutput();
+        }
+    }
+    bits.padToByte();
+    if (sink) {
+        sink->write(out.data(), out.size());
+        bits.discardOutput();
+    }
+}
+
+/**
+ * @brief Count the symbols of every @p step-th MCU row in [firstRow, endRow)
+ *
+ * DC predictors are reset at the segment start exactly as when encoding.
+ * With a step above 1 the skipped rows break the DC prediction chain, so
+ * the DC counts are an approximation.
+ */
+void countSegment(const RowSource& source, const EncoderTables& tables, uint32_t mcusPerRow,
+                  uint32_t firstRow, uint32_t endRow, uint32_t step, SymbolCounts* counts) {
+    RowWorkspace workspace(source, tables, mcusPerRow);
+    SymbolCounter luma{counts[DC_LUMA_TABLE], counts[AC_LUMA_TABLE]};
+    SymbolCounter chroma{counts[DC_CHROMA_TABLE], counts[AC_CHROMA_TABLE]};
+    int dcY = 0, dcCb = 0, dcCr = 0;
+
+    for (uint32_t mcuRow = firstRow; mcuRow < endRow; ++mcuRow) {
+        if (mcuRow % step == 0) {
+            workspace.encode(mcuRow, luma, chroma, dcY, dcCb, dcCr);
+        }
+    }
+}
+
+/**
+ * @brief Count every symbol a baseline 8-bit coder can emit once
+ *
+ * Used when statistics come from a sample of the rows, so symbols that
+ * only occur in skipped rows still get a (long) code.
+ */
+void addEverySymbol(SymbolCounts* counts) {
+    for (int category = 0; category <= 11; ++category) {
+        ++counts[DC_LUMA_TABLE][category];
+        ++counts[DC_CHROMA_TABLE][category];
+    }
+    for (int table : {AC_LUMA_TABLE, AC_CHROMA_TABLE}) {
+        ++counts[table][0x00];
+        ++counts[table][0xF0];
+        for (int zeros = 0; zeros < 16; ++zeros) {
+            for (int category = 1; category <= 10; ++category) {
+                ++counts[table][(zeros << 4) + category];
+            }
+        }
+    }
+}
+
+/**
+ * @brief Run @p task(i) for every segment index on up to @p threads (> 0) threads
+ */
+template <typename Task>
+void forEachSegment(uint32_t segments, size_t threads, const Task& task) {
+    ThreadPool::parallelFor(segments, threads, [&](size_t i, size_t) {
+        task(static_cast<uint32_t>(i));
+    });
+}
+
+/**
+ * @brief Encode @p source into @p sink
+ *
+ * Restart segments are encoded in waves of a few per thread and written
+ * in order as each wave completes, so only one wave's output is held in
+ * memory; without restart markers the single segment drains to the sink
+ * as it goes.
+ */
+template <typename Sink>
+void encodeImage(const RowSource& source, const JPEGEncoder::Options& options, Sink& sink) {
+    const uint32_t width = source.width();
+    const uint32_t height = source.height();
+    if (width == 0 || height == 0 || width > 65535 || height > 65535) {
+        throw std::invalid_argument("Invalid JPEG image dimensions");
+    }
+    if (source.channels() < 1 || source.channels() > 4) {
+        throw std::invalid_argument("JPEG channel count must be 1 to 4");
+    }
+
+    EncoderTables tables(options.quality, options.dct, options.subsampling);
+
+    const uint32_t mcuW = mcuWidth(tables.subsampling);
+    const uint32_t mcuH = mcuHeight(tables.subsampling);
+    const uint32_t mcusPerRow = (width + mcuW - 1) / mcuW;
+    const uint32_t mcuRows = (height + mcuH - 1) / mcuH;
+
+    // The DRI interval counts MCUs and must fit in 16 bits
+    uint32_t restartRows = std::min(options.restartRows, std::max(1u, 65535 / mcusPerRow));
+    if (restartRows >= mcuRows) {
+        restartRows = 0;
+    }
+    const uint32_t segments = restartRows ? (mcuRows + restartRows - 1) / restartRows : 1;
+    const uint32_t rowsPerSegment = restartRows ? restartRows : mcuRows;
+
+    size_t threads = options.threads;
+    if (threads == 0) {
+        threads = ThreadPool::availableThreads();
+    }
+    // Segments are processed in waves of a few per thread to bound memory
+    const uint32_t wave = static_cast<uint32_t>(std::min<size_t>(segments, 4 * threads));
+
+    // First pass: count symbols per segment; the integer totals do not
+    // depend on the order, so the tables do not depend on the thread count
+    if (options.optimizeHuffman) {
+        const uint32_t step = std::max(1u, options.huffmanSampleStep);
+        std::vector<std::array<SymbolCounts, TABLE_COUNT>> segmentCounts(wave);
+        std::array<SymbolCounts, TABLE_COUNT> counts{};
+
+        for (uint32_t first = 0; first < segments; first += wave) {
+            const uint32_t count = std::min(wave, segments - first);
+            forEachSegment(count, threads, [&](uint32_t i) {
+                for (SymbolCounts& tableCounts : segmentCounts[i]) {
+                    tableCounts.fill(0);
+                }
+                const uint32_t row = (first + i) * rowsPerSegment;
+                countSegment(source, tables, mcusPerRow, row, std::min(mcuRows, row + rowsPerSegment), step,
+                             segmentCounts[i].data());
+            });
+            for (uint32_t i = 0; i < count; ++i) {
+                for (int t = 0; t < TABLE_COUNT; ++t) {
+                    for (int symbol = 0; symbol < 256; ++symbol) {
+                        counts[t][symbol] += segmentCounts[i][t][symbol];
+                    }
+                }
+            }
+        }
+        if (step > 1) {
+            addEverySymbol(counts.data());
+        }
+        tables.optimize(counts.data());
+    }
+
+    std::vector<uint8_t> headers;
+    FrameHeader header{width, height, 3, lumaSampling(tables.subsampling),
+                       tables.lumaQuant.data(), tables.chromaQuant.data(),
+                       {&tables.huffman[DC_LUMA_TABLE], &tables.huffman[AC_LUMA_TABLE],
+                        &tables.huffman[DC_CHROMA_TABLE], &tables.huffman[AC_CHROMA_TABLE]},
+                       static_cast<uint16_t>(restartRows * mcusPerRow)};
+    writeHeaders(headers, header);
+    sink.write(headers.data(), headers.size());
+
+    if (segments == 1) {
+        std::vector<uint8_t> buffer;
+        encodeSegment(source, tables, mcusPerRow, 0, mcuRows, buffer, &sink);
+    } else {
+        std::vector<std::vector<uint8_t>> parts(wave);
+
+        for (uint32_t first = 0; first < segments; first += wave) {
+            const uint32_t count = std::min(wave, segments - first);
+            forEachSegment(count, threads, [&](uint32_t i) {
+                const uint32_t row = (first + i) * rowsPerSegment;
+                parts[i].clear();
+                encodeSegment<Sink>(source, tables, mcusPerRow, row, std::min(mcuRows, row + rowsPerSegment),
+                                    parts[i], nullptr);
+            });
+            for (uint32_t i = 0; i < count; ++i) {
+                sink.write(parts[i].data(), parts[i].size());
+                const uint32_t segment = first + i;
+                if (segment + 1 < segments) {
+                    const uint8_t marker[2] = {0xFF, static_cast<uint8_t>(0xD0 + (segment & 7))};  // RSTn
+                    sink.write(marker, sizeof(marker));
+                }
+            }
+        }
+    }
+
+    static const uint8_t eoi[2] = {0xFF, 0xD9};
+    sink.write(eoi, sizeof(eoi));
+}
+
+} // namespace
+
+std::vector<uint8_t> JPEGEncoder::encode(const RowSource& source, const Options& options) {
+    std::vector<uint8_t> out;
+    VectorSink sink{out};
+    encodeImage(source, options, sink);
+    return out;
+}
+
+std::vector<uint8_t> JPEGEncoder::encode(const uint8_t* pixels, uint32_t width, uint32_t height,
+                                         int channels, const Options& options) {
+    if (pixels == nullptr) {
+        throw std::invalid_argument("Invalid JPEG image dimensions");
+    }
+    return encode(BufferRowSource(pixels, width, height, channels), options);
+}
+
+void JPEGEncoder::write(const std::string& filename, const RowSource& source, const Options& options) {
+    FileSink sink(filename);
+    encodeImage(source, options, sink);
+    sink.finish();
+}
+
+uint64_t JPEGEncoder::encodedSize(const RowSource& source, const Options& options) {
+    CountingSink sink;
+    encodeImage(source, options, sink);
+    return sink.size;
+}
+
+void JPEGEncoder::write(const std::string& filename, const uint8_t* pixels, uint32_t width,
+                        uint32_t height, int channels, const Options& options) {
+    if (pixels == nullptr) {
+        throw std::invalid_argument("Invalid JPEG image dimensions");
+    }
+    write(filename, BufferRowSource(pixels, width, height, channels), options);
+}
+
+} // namespace ColorGenerator
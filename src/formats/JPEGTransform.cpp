@@ -0,0 +1,560 @@
+#include "../../include/formats/JPEGTransform.hpp"
+#include "../../include/formats/JPEGCommon.hpp"
+#include "../../include/CpuFeatures.hpp"
+#include <cstdlib>
+#include <cstring>
+
+#ifdef COLORGEN_X86
+    #include <immintrin.h>
+#endif
+
+namespace ColorGenerator {
+namespace JPEG {
+
+namespace {
+
+// AAN DCT output scale factors (times sqrt(8)), folded into the quantizer
+const float AAN_SCALE[8] = {
+    1.0f * 2.828427125f, 1.387039845f * 2.828427125f, 1.306562965f * 2.828427125f, 1.175875602f * 2.828427125f,
+    1.0f * 2.828427125f, 0.785694958f * 2.828427125f, 0.541196100f * 2.828427125f, 0.275899379f * 2.828427125f
+};
+
+// islow fixed-point constants, 13 fractional bits
+constexpr int CONST_BITS = 13;
+constexpr int PASS1_BITS = 2;
+constexpr int FIX_0_298631336 = 2446;
+constexpr int FIX_0_390180644 = 3196;
+constexpr int FIX_0_541196100 = 4433;
+constexpr int FIX_0_765366865 = 6270;
+constexpr int FIX_0_899976223 = 7373;
+constexpr int FIX_1_175875602 = 9633;
+constexpr int FIX_1_501321110 = 12299;
+constexpr int FIX_1_847759065 = 15137;
+constexpr int FIX_1_961570560 = 16069;
+constexpr int FIX_2_053119869 = 16819;
+constexpr int FIX_2_562915447 = 20995;
+constexpr int FIX_3_072711026 = 25172;
+
+/**
+ * @brief Round half away from zero, as stb does when quantizing
+ */
+inline int roundHalfAway(float v) {
+    return static_cast<int>(v < 0 ? v - 0.5f : v + 0.5f);
+}
+
+/**
+ * @brief One-dimensional float AAN forward DCT over 8 values @p stride apart
+ */
+void floatDCT(float* d, int stride) {
+    float d0 = d[0], d1 = d[stride], d2 = d[stride * 2], d3 = d[stride * 3];
+    float d4 = d[stride * 4], d5 = d[stride * 5], d6 = d[stride * 6], d7 = d[stride * 7];
+
+    float tmp0 = d0 + d7;
+    float tmp7 = d0 - d7;
+    float tmp1 = d1 + d6;
+    float tmp6 = d1 - d6;
+    float tmp2 = d2 + d5;
+    float tmp5 = d2 - d5;
+    float tmp3 = d3 + d4;
+    float tmp4 = d3 - d4;
+
+    // Even part
+    float tmp10 = tmp0 + tmp3;
+    float tmp13 = tmp0 - tmp3;
+    float tmp11 = tmp1 + tmp2;
+    float tmp12 = tmp1 - tmp2;
+
+    d[0] = tmp10 + tmp11;
+    d[stride * 4] = tmp10 - tmp11;
+
+    float z1 = (tmp12 + tmp13) * 0.707106781f;
+    d[stride * 2] = tmp13 + z1;
+    d[stride * 6] = tmp13 - z1;
+
+    // Odd part
+    tmp10 = tmp4 + tmp5;
+    tmp11 = tmp5 + tmp6;
+    tmp12 = tmp6 + tmp7;
+
+    float z5 = (tmp10 - tmp12) * 0.382683433f;
+    float z2 = tmp10 * 0.541196100f + z5;
+    float z4 = tmp12 * 1.306562965f + z5;
+    float z3 = tmp11 * 0.707106781f;
+
+    float z11 = tmp7 + z3;
+    float z13 = tmp7 - z3;
+
+    d[stride * 5] = z13 + z2;
+    d[stride * 3] = z13 - z2;
+    d[stride] = z11 + z4;
+    d[stride * 7] = z11 - z4;
+}
+
+/**
+ * @brief One islow pass over 8 values @p stride apart
+ * @param first True for the row pass, which keeps PASS1_BITS of extra precision
+ */
+void integerDCT(int32_t* d, int stride, bool first) {
+    const int32_t tmp0 = d[0] + d[stride * 7];
+    const int32_t tmp7 = d[0] - d[stride * 7];
+    const int32_t tmp1 = d[stride] + d[stride * 6];
+    const int32_t tmp6 = d[stride] - d[stride * 6];
+    const int32_t tmp2 = d[stride * 2] + d[stride * 5];
+    const int32_t tmp5 = d[stride * 2] - d[stride * 5];
+    const int32_t tmp3 = d[stride * 3] + d[stride * 4];
+    const int32_t tmp4 = d[stride * 3] - d[stride * 4];
+
+    const int evenShift = first ? 0 : PASS1_BITS;
+    const int shift = first ? CONST_BITS - PASS1_BITS : CONST_BITS + PASS1_BITS;
+    const int32_t round = 1 << (shift - 1);
+    const int32_t evenRound = first ? 0 : 1 << (PASS1_BITS - 1);
+
+    // Even part
+    const int32_t tmp10 = tmp0 + tmp3;
+    const int32_t tmp13 = tmp0 - tmp3;
+    const int32_t tmp11 = tmp1 + tmp2;
+    const int32_t tmp12 = tmp1 - tmp2;
+
+    if (first) {
+        d[0] = (tmp10 + tmp11) * (1 << PASS1_BITS);
+        d[stride * 4] = (tmp10 - tmp11) * (1 << PASS1_BITS);
+    } else {
+        d[0] = (tmp10 + tmp11 + evenRound) >> evenShift;
+        d[stride * 4] = (tmp10 - tmp11 + evenRound) >> evenShift;
+    }
+
+    const int32_t z1 = (tmp12 + tmp13) * FIX_0_541196100;
+    d[stride * 2] = (z1 + tmp13 * FIX_0_765366865 + round) >> shift;
+    d[stride * 6] = (z1 - tmp12 * FIX_1_847759065 + round) >> shift;
+
+    // Odd part
+    const int32_t z5 = (tmp4 + tmp5 + tmp6 + tmp7) * FIX_1_175875602;
+    const int32_t o1 = (tmp4 + tmp7) * -FIX_0_899976223;
+    const int32_t o2 = (tmp5 + tmp6) * -FIX_2_562915447;
+    const int32_t o3 = (tmp4 + tmp6) * -FIX_1_961570560 + z5;
+    const int32_t o4 = (tmp5 + tmp7) * -FIX_0_390180644 + z5;
+
+    d[stride * 7] = (tmp4 * FIX_0_298631336 + o1 + o3 + round) >> shift;
+    d[stride * 5] = (tmp5 * FIX_2_053119869 + o2 + o4 + round) >> shift;
+    d[stride * 3] = (tmp6 * FIX_3_072711026 + o2 + o3 + round) >> shift;
+    d[stride] = (tmp7 * FIX_1_501321110 + o1 + o4 + round) >> shift;
+}
+
+using Kernel = size_t (*)(const uint8_t*, size_t, size_t, const Quantizer&, int16_t*);
+
+size_t floatScalar(const uint8_t* samples, size_t stride, size_t count, const Quantizer& quantizer, int16_t* out) {
+    for (size_t i = 0; i < count; ++i, samples += 8, out += 64) {
+        float block[64];
+        for (int y = 0; y < 8; ++y) {
+            for (int x = 0; x < 8; ++x) {
+                block[y * 8 + x] = samples[y * stride + x] - 128.0f;
+            }
+        }
+        for (int row = 0; row < 8; ++row) {
+            floatDCT(block + row * 8, 1);
+        }
+        for (int col = 0; col < 8; ++col) {
+            floatDCT(block + col, 8);
+        }
+        for (int j = 0; j < 64; ++j) {
+            out[ZIGZAG[j]] = static_cast<int16_t>(roundHalfAway(block[j] * quantizer.scale[j]));
+        }
+    }
+    return count;
+}
+
+size_t integerScalar(const uint8_t* samples, size_t stride, size_t count, const Quantizer& quantizer, int16_t* out) {
+    for (size_t i = 0; i < count; ++i, samples += 8, out += 64) {
+        int32_t block[64];
+        for (int y = 0; y < 8; ++y) {
+            for (int x = 0; x < 8; ++x) {
+                block[y * 8 + x] = samples[y * stride + x] - 128;
+            }
+        }
+        for (int row = 0; row < 8; ++row) {
+            integerDCT(block + row * 8, 1, true);
+        }
+        for (int col = 0; col < 8; ++col) {
+            integerDCT(block + col, 8, false);
+        }
+        for (int j = 0; j < 64; ++j) {
+            const int32_t divisor = static_cast<int32_t>(quantizer.divisor[j]);
+            const int32_t q = (std::abs(block[j]) + divisor / 2) / divisor;
+            out[ZIGZAG[j]] = static_cast<int16_t>(block[j] < 0 ? -q : q);
+        }
+    }
+    return count;
+}
+
+#ifdef COLORGEN_X86
+
+// Vector kernels keep one block per lane: d[r * 8 + c] holds sample (r, c)
+// of every block in the batch, so the butterflies are plain vertical ops.
+
+COLORGEN_TARGET("sse2") void transpose4(__m128* v) {
+    _MM_TRANSPOSE4_PS(v[0], v[1], v[2], v[3]);
+}
+
+COLORGEN_TARGET("sse2") void loadSSE2(const uint8_t* samples, size_t stride, __m128* d) {
+    const __m128i zero = _mm_setzero_si128();
+    const __m128 shift = _mm_set1_ps(128.0f);
+    for (int r = 0; r < 8; ++r) {
+        const uint8_t* row = samples + r * stride;
+        for (int half = 0; half < 2; ++half) {
+            __m128 v[4];
+            for (int b = 0; b < 4; ++b) {
+                int32_t bytes;
+                std::memcpy(&bytes, row + b * 8 + half * 4, 4);
+                const __m128i words = _mm_unpacklo_epi8(_mm_cvtsi32_si128(bytes), zero);
+                v[b] = _mm_sub_ps(_mm_cvtepi32_ps(_mm_unpacklo_epi16(words, zero)), shift);
+            }
+            transpose4(v);
+            for (int c = 0; c < 4; ++c) {
+                d[r * 8 + half * 4 + c] = v[c];
+            }
+        }
+    }
+}
+
+COLORGEN_TARGET("sse2") void dctSSE2(__m128* d, int stride) {
+    __m128 tmp0 = _mm_add_ps(d[0], d[stride * 7]);
+    __m128 tmp7 = _mm_sub_ps(d[0], d[stride * 7]);
+    __m128 tmp1 = _mm_add_ps(d[stride], d[stride * 6]);
+    __m128 tmp6 = _mm_sub_ps(d[stride], d[stride * 6]);
+    __m128 tmp2 = _mm_add_ps(d[stride * 2], d[stride * 5]);
+    __m128 tmp5 = _mm_sub_ps(d[stride * 2], d[stride * 5]);
+    __m128 tmp3 = _mm_add_ps(d[stride * 3], d[stride * 4]);
+    __m128 tmp4 = _mm_sub_ps(d[stride * 3], d[stride * 4]);
+
+    __m128 tmp10 = _mm_add_ps(tmp0, tmp3);
+    __m128 tmp13 = _mm_sub_ps(tmp0, tmp3);
+    __m128 tmp11 = _mm_add_ps(tmp1, tmp2);
+    __m128 tmp12 = _mm_sub_ps(tmp1, tmp2);
+
+    d[0] = _mm_add_ps(tmp10, tmp11);
+    d[stride * 4] = _mm_sub_ps(tmp10, tmp11);
+
+    __m128 z1 = _mm_mul_ps(_mm_add_ps(tmp12, tmp13), _mm_set1_ps(0.707106781f));
+    d[stride * 2] = _mm_add_ps(tmp13, z1);
+    d[stride * 6] = _mm_sub_ps(tmp13, z1);
+
+    tmp10 = _mm_add_ps(tmp4, tmp5);
+    tmp11 = _mm_add_ps(tmp5, tmp6);
+    tmp12 = _mm_add_ps(tmp6, tmp7);
+
+    __m128 z5 = _mm_mul_ps(_mm_sub_ps(tmp10, tmp12), _mm_set1_ps(0.382683433f));
+    __m128 z2 = _mm_add_ps(_mm_mul_ps(tmp10, _mm_set1_ps(0.541196100f)), z5);
+    __m128 z4 = _mm_add_ps(_mm_mul_ps(tmp12, _mm_set1_ps(1.306562965f)), z5);
+    __m128 z3 = _mm_mul_ps(tmp11, _mm_set1_ps(0.707106781f));
+
+    __m128 z11 = _mm_add_ps(tmp7, z3);
+    __m128 z13 = _mm_sub_ps(tmp7, z3);
+
+    d[stride * 5] = _mm_add_ps(z13, z2);
+    d[stride * 3] = _mm_sub_ps(z13, z2);
+    d[stride] = _mm_add_ps(z11, z4);
+    d[stride * 7] = _mm_sub_ps(z11, z4);
+}
+
+/**
+ * @brief Turn per-position vectors (indexed by zigzag position) into 4 blocks of int16
+ */
+COLORGEN_TARGET("sse2") void storeSSE2(const __m128i* zigzag, int16_t* out) {
+    for (int z = 0; z < 64; z += 8) {
+        __m128 lo[4], hi[4];
+        for (int i = 0; i < 4; ++i) {
+            lo[i] = _mm_castsi128_ps(zigzag[z + i]);
+            hi[i] = _mm_castsi128_ps(zigzag[z + 4 + i]);
+        }
+        transpose4(lo);
+        transpose4(hi);
+        for (int b = 0; b < 4; ++b) {
+            const __m128i packed = _mm_packs_epi32(_mm_castps_si128(lo[b]), _mm_castps_si128(hi[b]));
+            _mm_storeu_si128(reinterpret_cast<__m128i*>(out + b * 64 + z), packed);
+        }
+    }
+}
+
+COLORGEN_TARGET("sse2") size_t floatSSE2(const uint8_t* samples, size_t stride, size_t count,
+                                         const Quantizer& quantizer, int16_t* out) {
+    const __m128 sign = _mm_set1_ps(-0.0f);
+    const __m128 half = _mm_set1_ps(0.5f);
+    __m128 d[64];
+    __m128i zigzag[64];
+
+    size_t i = 0;
+    for (; i + 4 <= count; i += 4) {
+        loadSSE2(samples + i * 8, stride, d);
+        for (int row = 0; row < 8; ++row) {
+            dctSSE2(d + row * 8, 1);
+        }
+        for (int col = 0; col < 8; ++col) {
+            dctSSE2(d + col, 8);
+        }
+        for (int j = 0; j < 64; ++j) {
+            const __m128 v = _mm_mul_ps(d[j], _mm_set1_ps(quantizer.scale[j]));
+            const __m128 rounded = _mm_add_ps(v, _mm_or_ps(_mm_and_ps(v, sign), half));
+            zigzag[ZIGZAG[j]] = _mm_cvttps_epi32(rounded);
+        }
+        storeSSE2(zigzag, out + i * 64);
+    }
+    return i;
+}
+
+COLORGEN_TARGET("avx2") void transpose8(__m256* v) {
+    const __m256 t0 = _mm256_unpacklo_ps(v[0], v[1]);
+    const __m256 t1 = _mm256_unpackhi_ps(v[0], v[1]);
+    const __m256 t2 = _mm256_unpacklo_ps(v[2], v[3]);
+    const __m256 t3 = _mm256_unpackhi_ps(v[2], v[3]);
+    const __m256 t4 = _mm256_unpacklo_ps(v[4], v[5]);
+    const __m256 t5 = _mm256_unpackhi_ps(v[4], v[5]);
+    const __m256 t6 = _mm256_unpacklo_ps(v[6], v[7]);
+    const __m256 t7 = _mm256_unpackhi_ps(v[6], v[7]);
+
+    const __m256 s0 = _mm256_shuffle_ps(t0, t2, 0x44);
+    const __m256 s1 = _mm256_shuffle_ps(t0, t2, 0xEE);
+    const __m256 s2 = _mm256_shuffle_ps(t1, t3, 0x44);
+    const __m256 s3 = _mm256_shuffle_ps(t1, t3, 0xEE);
+    const __m256 s4 = _mm256_shuffle_ps(t4, t6, 0x44);
+    const __m256 s5 = _mm256_shuffle_ps(t4, t6, 0xEE);
+    const __m256 s6 = _mm256_shuffle_ps(t5, t7, 0x44);
+    const __m256 s7 = _mm256_shuffle_ps(t5, t7, 0xEE);
+
+    v[0] = _mm256_permute2f128_ps(s0, s4, 0x20);
+    v[1] = _mm256_permute2f128_ps(s1, s5, 0x20);
+    v[2] = _mm256_permute2f128_ps(s2, s6, 0x20);
+    v[3] = _mm256_permute2f128_ps(s3, s7, 0x20);
+    v[4] = _mm256_permute2f128_ps(s0, s4, 0x31);
+    v[5] = _mm256_permute2f128_ps(s1, s5, 0x31);
+    v[6] = _mm256_permute2f128_ps(s2, s6, 0x31);
+    v[7] = _mm256_permute2f128_ps(s3, s7, 0x31);
+}
+
+COLORGEN_TARGET("avx2") void loadAVX2(const uint8_t* samples, size_t stride, __m256* d) {
+    const __m256 shift = _mm256_set1_ps(128.0f);
+    for (int r = 0; r < 8; ++r) {
+        const uint8_t* row = samples + r * stride;
+        __m256* v = d + r * 8;
+        for (int b = 0; b < 8; ++b) {
+            const __m128i bytes = _mm_loadl_epi64(reinterpret_cast<const __m128i*>(row + b * 8));
+            v[b] = _mm256_sub_ps(_mm256_cvtepi32_ps(_mm256_cvtepu8_epi32(bytes)), shift);
+        }
+        transpose8(v);
+    }
+}
+
+/**
+ * @brief Turn per-position vectors (indexed by zigzag position) into 8 blocks of int16
+ */
+COLORGEN_TARGET("avx2") void storeAVX2(const __m256i* zigzag, int16_t* out) {
+    for (int z = 0; z < 64; z += 8) {
+        __m256 v[8];
+        for (int i = 0; i < 8; ++i) {
+            v[i] = _mm256_castsi256_ps(zigzag[z + i]);
+        }
+        transpose8(v);
+        for (int b = 0; b < 8; ++b) {
+            const __m256i lanes = _mm256_castps_si256(v[b]);
+            const __m128i packed = _mm_packs_epi32(_mm256_castsi256_si128(lanes),
+                                                   _mm256_extracti128_si256(lanes, 1));
+            _mm_storeu_si128(reinterpret_cast<__m128i*>(out + b * 64 + z), packed);
+        }
+    }
+}
+
+COLORGEN_TARGET("avx2") void dctAVX2(__m256* d, int stride) {
+    __m256 tmp0 = _mm256_add_ps(d[0], d[stride * 7]);
+    __m256 tmp7 = _mm256_sub_ps(d[0], d[stride * 7]);
+    __m256 tmp1 = _mm256_add_ps(d[stride], d[stride * 6]);
+    __m256 tmp6 = _mm256_sub_ps(d[stride], d[stride * 6]);
+    __m256 tmp2 = _mm256_add_ps(d[stride * 2], d[stride * 5]);
+    __m256 tmp5 = _mm256_sub_ps(d[stride * 2], d[stride * 5]);
+    __m256 tmp3 = _mm256_add_ps(d[stride * 3], d[stride * 4]);
+    __m256 tmp4 = _mm256_sub_ps(d[stride * 3], d[stride * 4]);
+
+    __m256 tmp10 = _mm256_add_ps(tmp0, tmp3);
+    __m256 tmp13 = _mm256_sub_ps(tmp0, tmp3);
+    __m256 tmp11 = _mm256_add_ps(tmp1, tmp2);
+    __m256 tmp12 = _mm256_sub_ps(tmp1, tmp2);
+
+    d[0] = _mm256_add_ps(tmp10, tmp11);
+    d[stride * 4] = _mm256_sub_ps(tmp10, tmp11);
+
+    __m256 z1 = _mm256_mul_ps(_mm256_add_ps(tmp12, tmp13), _mm256_set1_ps(0.707106781f));
+    d[stride * 2] = _mm256_add_ps(tmp13, z1);
+    d[stride * 6] = _mm256_sub_ps(tmp13, z1);
+
+    tmp10 = _mm256_add_ps(tmp4, tmp5);
+    tmp11 = _mm256_add_ps(tmp5, tmp6);
+    tmp12 = _mm256_add_ps(tmp6, tmp7);
+
+    __m256 z5 = _mm256_mul_ps(_mm256_sub_ps(tmp10, tmp12), _mm256_set1_ps(0.382683433f));
+    __m256 z2 = _mm256_add_ps(_mm256_mul_ps(tmp10, _mm256_set1_ps(0.541196100f)), z5);
+    __m256 z4 = _mm256_add_ps(_mm256_mul_ps(tmp12, _mm256_set1_ps(1.306562965f)), z5);
+    __m256 z3 = _mm256_mul_ps(tmp11, _mm256_set1_ps(0.707106781f));
+
+    __m256 z11 = _mm256_add_ps(tmp7, z3);
+    __m256 z13 = _mm256_sub_ps(tmp7, z3);
+
+    d[stride * 5] = _mm256_add_ps(z13, z2);
+    d[stride * 3] = _mm256_sub_ps(z13, z2);
+    d[stride] = _mm256_add_ps(z11, z4);
+    d[stride * 7] = _mm256_sub_ps(z11, z4);
+}
+
+COLORGEN_TARGET("avx2") size_t floatAVX2(const uint8_t* samples, size_t stride, size_t count,
+                                         const Quantizer& quantizer, int16_t* out) {
+    const __m256 sign = _mm256_set1_ps(-0.0f);
+    const __m256 half = _mm256_set1_ps(0.5f);
+    __m256 d[64];
+    __m256i zigzag[64];
+
+    size_t i = 0;
+    for (; i + 8 <= count; i += 8) {
+        loadAVX2(samples + i * 8, stride, d);
+        for (int row = 0; row < 8; ++row) {
+            dctAVX2(d + row * 8, 1);
+        }
+        for (int col = 0; col < 8; ++col) {
+            dctAVX2(d + col, 8);
+        }
+        for (int j = 0; j < 64; ++j) {
+            const __m256 v = _mm256_mul_ps(d[j], _mm256_set1_ps(quantizer.scale[j]));
+            const __m256 rounded = _mm256_add_ps(v, _mm256_or_ps(_mm256_and_ps(v, sign), half));
+            zigzag[ZIGZAG[j]] = _mm256_cvttps_epi32(rounded);
+        }
+        storeAVX2(zigzag, out + i * 64);
+    }
+    return i;
+}
+
+COLORGEN_TARGET("avx2") inline __m256i descale(__m256i x, __m256i round, int shift) {
+    return _mm256_srai_epi32(_mm256_add_epi32(x, round), shift);
+}
+
+COLORGEN_TARGET("avx2") inline __m256i mulConst(__m256i x, int constant) {
+    return _mm256_mullo_epi32(x, _mm256_set1_epi32(constant));
+}
+
+COLORGEN_TARGET("avx2") void islowAVX2(__m256i* d, int stride, bool first) {
+    const __m256i tmp0 = _mm256_add_epi32(d[0], d[stride * 7]);
+    const __m256i tmp7 = _mm256_sub_epi32(d[0], d[stride * 7]);
+    const __m256i tmp1 = _mm256_add_epi32(d[stride], d[stride * 6]);
+    const __m256i tmp6 = _mm256_sub_epi32(d[stride], d[stride * 6]);
+    const __m256i tmp2 = _mm256_add_epi32(d[stride * 2], d[stride * 5]);
+    const __m256i tmp5 = _mm256_sub_epi32(d[stride * 2], d[stride * 5]);
+    const __m256i tmp3 = _mm256_add_epi32(d[stride * 3], d[stride * 4]);
+    const __m256i tmp4 = _mm256_sub_epi32(d[stride * 3], d[stride * 4]);
+
+    const int shift = first ? CONST_BITS - PASS1_BITS : CONST_BITS + PASS1_BITS;
+    const __m256i round = _mm256_set1_epi32(1 << (shift - 1));
+
+    // Even part
+    const __m256i tmp10 = _mm256_add_epi32(tmp0, tmp3);
+    const __m256i tmp13 = _mm256_sub_epi32(tmp0, tmp3);
+    const __m256i tmp11 = _mm256_add_epi32(tmp1, tmp2);
+    const __m256i tmp12 = _mm256_sub_epi32(tmp1, tmp2);
+
+    if (first) {
+        d[0] = _mm256_slli_epi32(_mm256_add_epi32(tmp10, tmp11), PASS1_BITS);
+        d[stride * 4] = _mm256_slli_epi32(_mm256_sub_epi32(tmp10, tmp11), PASS1_BITS);
+    } else {
+        const __m256i evenRound = _mm256_set1_epi32(1 << (PASS1_BITS - 1));
+        d[0] = descale(_mm256_add_epi32(tmp10, tmp11), evenRound, PASS1_BITS);
+        d[stride * 4] = descale(_mm256_sub_epi32(tmp10, tmp11), evenRound, PASS1_BITS);
+    }
+
+    const __m256i z1 = mulConst(_mm256_add_epi32(tmp12, tmp13), FIX_0_541196100);
+    d[stride * 2] = descale(_mm256_add_epi32(z1, mulConst(tmp13, FIX_0_765366865)), round, shift);
+    d[stride * 6] = descale(_mm256_sub_epi32(z1, mulConst(tmp12, FIX_1_847759065)), round, shift);
+
+    // Odd part
+    const __m256i z5 = mulConst(_mm256_add_epi32(_mm256_add_epi32(tmp4, tmp5), _mm256_add_epi32(tmp6, tmp7)),
+                                FIX_1_175875602);
+    const __m256i o1 = mulConst(_mm256_add_epi32(tmp4, tmp7), -FIX_0_899976223);
+    const __m256i o2 = mulConst(_mm256_add_epi32(tmp5, tmp6), -FIX_2_562915447);
+    const __m256i o3 = _mm256_add_epi32(mulConst(_mm256_add_epi32(tmp4, tmp6), -FIX_1_961570560), z5);
+    const __m256i o4 = _mm256_add_epi32(mulConst(_mm256_add_epi32(tmp5, tmp7), -FIX_0_390180644), z5);
+
+    d[stride * 7] = descale(_mm256_add_epi32(mulConst(tmp4, FIX_0_298631336), _mm256_add_epi32(o1, o3)), round, shift);
+    d[stride * 5] = descale(_mm256_add_epi32(mulConst(tmp5, FIX_2_053119869), _mm256_add_epi32(o2, o4)), round, shift);
+    d[stride * 3] = descale(_mm256_add_epi32(mulConst(tmp6, FIX_3_072711026), _mm256_add_epi32(o2, o3)), round, shift);
+    d[stride] = descale(_mm256_add_epi32(mulConst(tmp7, FIX_1_501321110), _mm256_add_epi32(o1, o4)), round, shift);
+}
+
+COLORGEN_TARGET("avx2") size_t integerAVX2(const uint8_t* samples, size_t stride, size_t count,
+                                           const Quantizer& quantizer, int16_t* out) {
+    __m256 f[64];
+    __m256i d[64];
+    __m256i zigzag[64];
+
+    size_t i = 0;
+    for (; i + 8 <= count; i += 8) {
+        loadAVX2(samples + i * 8, stride, f);
+        for (int j = 0; j < 64; ++j) {
+            d[j] = _mm256_cvttps_epi32(f[j]);  // exact, the samples are integers
+        }
+        for (int row = 0; row < 8; ++row) {
+            islowAVX2(d + row * 8, 1, true);
+        }
+        for (int col = 0; col < 8; ++col) {
+            islowAVX2(d + col, 8, false);
+        }
+        // (|x| + q/2) / q in float: both operands are integers below 2^24,
+        // so the truncated, correctly rounded quotient is the exact integer one
+        for (int j = 0; j < 64; ++j) {
+            const __m256 magnitude = _mm256_add_ps(_mm256_cvtepi32_ps(_mm256_abs_epi32(d[j])),
+                                                   _mm256_set1_ps(quantizer.divisor[j] * 0.5f));
+            const __m256i q = _mm256_cvttps_epi32(_mm256_div_ps(magnitude, _mm256_set1_ps(quantizer.divisor[j])));
+            zigzag[ZIGZAG[j]] = _mm256_sign_epi32(q, d[j]);
+        }
+        storeAVX2(zigzag, out + i * 64);
+    }
+    return i;
+}
+
+#endif
+
+Kernel selectFloat() {
+#ifdef COLORGEN_X86
+    const CpuFeatures& cpu = CpuFeatures::get();
+    if (cpu.avx2) return floatAVX2;
+    if (cpu.sse2) return floatSSE2;
+#endif
+    return floatScalar;
+}
+
+Kernel selectInteger() {
+#ifdef COLORGEN_X86
+    const CpuFeatures& cpu = CpuFeatures::get();
+    if (cpu.avx2) return integerAVX2;
+#endif
+    return integerScalar;
+}
+
+} // namespace
+
+Quantizer::Quantizer(const uint8_t* table) {
+    for (int row = 0, k = 0; row < 8; ++row) {
+        for (int col = 0; col < 8; ++col, ++k) {
+            scale[k] = 1 / (table[ZIGZAG[k]] * AAN_SCALE[row] * AAN_SCALE[col]);
+            divisor[k] = static_cast<float>(table[ZIGZAG[k]] * 8);
+        }
+    }
+}
+
+void transformBlocks(const uint8_t* samples, size_t stride, size_t count,
+                     const Quantizer& quantizer, DCTMethod method, int16_t* out) {
+    static const Kernel floatKernel = selectFloat();
+    static const Kernel integerKernel = selectInteger();
+
+    const bool integer = method == DCTMethod::Integer;
+    const size_t done = (integer ? integerKernel : floatKernel)(samples, stride, count, quantizer, out);
+    if (done < count) {
+        (integer ? integerScalar : floatScalar)(samples + done * 8, stride, count - done,
+                                                quantizer, out + done * 64);
+    }
+}
+
+} // namespace JPEG
+} // namespace ColorGenerator
@@ -0,0 +1,26 @@
+#include "../../include/formats/PNGChunk.hpp"
+#include "../../include/formats/Checksum.hpp"
+#include <cstring>
+
+namespace ColorGenerator {
+
+void putU32BE(uint8_t* dst, uint32_t value) {
+    dst[0] = static_cast<uint8_t>(value >> 24);
+    dst[1] = static_cast<uint8_t>(value >> 16);
+    dst[2] = static_cast<uint8_t>(value >> 8);
+    dst[3] = static_cast<uint8_t>(value);
+}
+
+const uint8_t PNGChunk::SIGNATURE[8] = {0x89, 'P', 'N', 'G', '\r', '\n', 0x1A, '\n'};
+
+void PNGChunk::frame(const char* type, const uint8_t* data, size_t length,
+                     uint8_t* header, uint8_t* trailer) {
+    putU32BE(header, static_cast<uint32_t>(length));
+    std::memcpy(header + 4, type, 4);
+
+    uint32_t crc = Crc32::update(0, header + 4, 4);
+    crc = Crc32::update(crc, data, length);
+    putU32BE(trailer, crc);
+}
+
+} // namespace ColorGenerator
@@ -0,0 +1,216 @@
+#include "../../include/formats/PNGEncoder.hpp"
+#include "../../include/formats/ByteSink.hpp"
+#include "../../include/formats/PNGChunk.hpp"
+#include "../../include/formats/Deflate.hpp"
+#include <algorithm>
+#include <cstdlib>
+#include <cstring>
+#include <stdexcept>
+#include <vector>
+
+namespace ColorGenerator {
+
+namespace {
+
+uint8_t paeth(int a, int b, int c) {
+    const int p = a + b - c;
+    const int pa = std::abs(p - a);
+    const int pb = std::abs(p - b);
+    const int pc = std::abs(p - c);
+    if (pa <= pb && pa <= pc) return static_cast<uint8_t>(a);
+    if (pb <= pc) return static_cast<uint8_t>(b);
+    return static_cast<uint8_t>(c);
+}
+
+/**
+ * @brief Apply one PNG filter to a row, as stbiw__encode_png_line does
+ *
+ * On the first row stb substitutes filters that need no row above
+ * (Up -> None, Average and Paeth -> their left-only forms) but still
+ * records the requested type, which decodes the same way.
+ *
+ * @param above Previous row, or nullptr for the first row
+ */
+void filterRow(const uint8_t* row, const uint8_t* above, size_t rowBytes, int n, int filter, uint8_t* out) {
+    static const int firstRowMap[] = {0, 1, 0, 5, 6};
+    const int type = above ? filter : firstRowMap[filter];
+    size_t i = 0;
+    switch (type) {
+        case 0:
+            std::memcpy(out, row, rowBytes);
+            break;
+        case 1:
+            for (; i < static_cast<size_t>(n); ++i) out[i] = row[i];
+            for (; i < rowBytes; ++i) out[i] = static_cast<uint8_t>(row[i] - row[i - n]);
+            break;
+        case 2:
+            for (; i < rowBytes; ++i) out[i] = static_cast<uint8_t>(row[i] - above[i]);
+            break;
+        case 3:
+            for (; i < static_cast<size_t>(n); ++i) out[i] = static_cast<uint8_t>(row[i] - (above[i] >> 1));
+            for (; i < rowBytes; ++i) out[i] = static_cast<uint8_t>(row[i] - ((row[i - n] + above[i]) >> 1));
+            break;
+        case 4:
+            for (; i < static_cast<size_t>(n); ++i) out[i] = static_cast<uint8_t>(row[i] - paeth(0, above[i], 0));
+            for (; i < rowBytes; ++i) {
+                out[i] = static_cast<uint8_t>(row[i] - paeth(row[i - n], above[i], above[i - n]));
+            }
+            break;
+        case 5:
+            for (; i < static_cast<size_t>(n); ++i) out[i] = row[i];
+            for (; i < rowBytes; ++i) out[i] = static_cast<uint8_t>(row[i] - (row[i - n] >> 1));
+            break;
+        case 6:
+            for (; i < static_cast<size_t>(n); ++i) out[i] = row[i];
+            for (; i < rowBytes; ++i) out[i] = static_cast<uint8_t>(row[i] - paeth(row[i - n], 0, 0));
+            break;
+    }
+}
+
+/**
+ * @brief stb's filter heuristic: the smallest sum of absolute signed residuals wins
+ */
+uint64_t residualCost(const uint8_t* line, size_t length) {
+    uint64_t cost = 0;
+    for (size_t i = 0; i < length; ++i) {
+        cost += static_cast<uint64_t>(std::abs(static_cast<int>(static_cast<int8_t>(line[i]))));
+    }
+    return cost;
+}
+
+} // namespace
+
+void PNGEncoder::write(const std::string& filename, const RowSource& source, const Options& options) {
+    static const uint8_t colorTypes[5] = {0, 0, 4, 2, 6};  // gray, gray + alpha, RGB, RGBA
+    const int channels = source.channels();
+    if (channels < 1 || channels > 4) {
+        throw std::invalid_argument("PNG channel count must be 1 to 4");
+    }
+    if (options.filter < -1 || options.filter > 4) {
+        throw std::invalid_argument("PNG filter must be -1 to 4");
+    }
+
+    const uint32_t width = source.width();
+    const uint32_t height = source.height();
+    const size_t rowBytes = static_cast<size_t>(source.rowBytes());
+    const uint32_t batchRows = static_cast<uint32_t>(
+        std::max<size_t>(1, std::min<size_t>(height, READ_BYTES / rowBytes)));
+
+    FileSink sink(filename);
+    sink.write(PNGChunk::SIGNATURE, sizeof(PNGChunk::SIGNATURE));
+
+    uint8_t ihdr[13];
+    putU32BE(ihdr, width);
+    putU32BE(ihdr + 4, height);
+    ihdr[8] = 8;                     // bit depth
+    ihdr[9] = colorTypes[channels];  // color type
+    ihdr[10] = 0;                    // compression
+    ihdr[11] = 0;                    // filter method
+    ihdr[12] = 0;                    // interlace
+    PNGChunk::write(sink, "IHDR", ihdr, sizeof(ihdr));
+
+    std::vector<uint8_t> scratch(batchRows * rowBytes);
+    std::vector<uint8_t> previous(rowBytes);  // last row of the previous batch
+    std::vector<uint8_t> line(rowBytes + 1);
+    std::vector<uint8_t> trial(options.filter < 0 ? rowBytes : 0);
+    std::vector<uint8_t> zdata;
+    zdata.reserve(IDAT_CHUNK_SIZE + 64 * 1024);
+    DeflateStream deflate(options.compressionLevel, options.threads);
+
+    // From row period + 1 on, every row and the row above it equal those one
+    // period earlier, so the filtered lines of rows 1..period repeat
+    const uint32_t period = source.rowPeriod();
+    const uint64_t periodBytes = static_cast<uint64_t>(period) * line.size();
+    const uint32_t periodStart = period > 0 && 2 * static_cast<uint64_t>(period) + 1 <= height
+                                 && periodBytes <= MAX_PERIOD_BYTES ? period + 1 : height;
+    const bool periodic = periodStart < height;
+    std::vector<uint8_t> periodLines;
+    periodLines.reserve(periodic ? static_cast<size_t>(periodBytes) : 0);
+
+    for (uint32_t y0 = 0; y0 < height;) {
+        const uint32_t limit = y0 < periodStart ? periodStart : height;
+        // Rows the source reports as repeats of the row above are neither read nor searched for matches
+        const uint32_t repeats = y0 == 0 ? 0 : std::min(source.repeatedRows(y0), limit - y0);
+        if (y0 == periodStart) {
+            const uint64_t copies = (height - periodStart) / period;
+            const uint64_t perCall = std::max<uint64_t>(1, REPEAT_BYTES / periodLines.size());
+            for (uint64_t done = 0; done < copies;) {
+                const uint64_t n = std::min(perCall, copies - done);
+                deflate.repeat(periodLines.data(), periodLines.size(), n, zdata);
+                done += n;
+                if (zdata.size() >= IDAT_CHUNK_SIZE) {
+                    PNGChunk::write(sink, "IDAT", zdata.data(), zdata.size());
+                    zdata.clear();
+                }
+            }
+            // Row period is still in previous, and it equals the row above
+            y0 += static_cast<uint32_t>(copies * period);
+        } else if (repeats > 0) {
+            if (options.filter < 0) {
+                // Up leaves every byte of a repeated row zero
+                line[0] = 2;
+                std::fill(line.begin() + 1, line.end(), 0);
+            } else {
+                line[0] = static_cast<uint8_t>(options.filter);
+                filterRow(previous.data(), previous.data(), rowBytes, channels, options.filter, line.data() + 1);
+            }
+            deflate.write(line.data(), line.size(), zdata);
+
+            // Every further repeat has the same row above, so it filters to the same line
+            deflate.repeat(line.data(), line.size(), repeats - 1, zdata);
+            if (periodic && y0 < periodStart) {
+                for (uint32_t i = 0; i < repeats; ++i) {
+                    periodLines.insert(periodLines.end(), line.begin(), line.end());
+                }
+            }
+            y0 += repeats;
+        } else {
+            uint32_t count = std::min(batchRows, limit - y0);
+            const uint8_t* rows = source.rows(y0, count, scratch.data());
+
+            for (uint32_t i = 0; i < count; ++i) {
+                if (i > 0 && source.repeatedRows(y0 + i) > 0) {
+                    count = i;
+                    break;
+                }
+                const uint8_t* row = rows + i * rowBytes;
+                const uint8_t* above = y0 + i == 0 ? nullptr : i == 0 ? previous.data() : row - rowBytes;
+
+                int filter = options.filter;
+                if (filter < 0) {
+                    uint64_t bestCost = UINT64_MAX;
+                    for (int candidate = 0; candidate < 5; ++candidate) {
+                        filterRow(row, above, rowBytes, channels, candidate, trial.data());
+                        const uint64_t cost = residualCost(trial.data(), rowBytes);
+                        if (cost < bestCost) {
+                            bestCost = cost;
+                            filter = candidate;
+                            std::memcpy(line.data() + 1, trial.data(), rowBytes);
+                        }
+                    }
+                } else {
+                    filterRow(row, above, rowBytes, channels, filter, line.data() + 1);
+                }
+                line[0] = static_cast<uint8_t>(filter);
+                deflate.write(line.data(), line.size(), zdata);
+                if (periodic && y0 + i > 0 && y0 < periodStart) {
+                    periodLines.insert(periodLines.end(), line.begin(), line.end());
+                }
+            }
+            std::memcpy(previous.data(), rows + (count - 1) * rowBytes, rowBytes);
+            y0 += count;
+        }
+
+        if (zdata.size() >= IDAT_CHUNK_SIZE) {
+            PNGChunk::write(sink, "IDAT", zdata.data(), zdata.size());
+            zdata.clear();
+        }
+    }
+
+    deflate.finish(zdata);
+    PNGChunk::write(sink, "IDAT", zdata.data(), zdata.size());
+    PNGChunk::write(sink, "IEND", nullptr, 0);
+    sink.finish();
+}
+
+} // namespace ColorGenerator
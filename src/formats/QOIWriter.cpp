@@ -0,0 +1,265 @@
+#include "../../include/formats/QOIWriter.hpp"
+#include "../../include/formats/ByteSink.hpp"
+#include "../../include/formats/PNGChunk.hpp"
+#include <algorithm>
+#include <cstring>
+#include <stdexcept>
+#include <vector>
+
+namespace ColorGenerator {
+
+namespace {
+
+constexpr uint8_t QOI_OP_INDEX = 0x00;
+constexpr uint8_t QOI_OP_DIFF = 0x40;
+constexpr uint8_t QOI_OP_LUMA = 0x80;
+constexpr uint8_t QOI_OP_RUN = 0xC0;
+constexpr uint8_t QOI_OP_RGB = 0xFE;
+constexpr uint8_t QOI_OP_RGBA = 0xFF;
+
+constexpr uint32_t MAX_RUN = 62;
+constexpr uint8_t FULL_RUN = QOI_OP_RUN | (MAX_RUN - 1);
+
+// Largest encoding of one pixel (QOI_OP_RGBA)
+constexpr size_t MAX_PIXEL_BYTES = 5;
+
+/**
+ * @brief Pixel as R | G << 8 | B << 16 | A << 24, gray expanded to RGB
+ */
+template <int Channels>
+uint32_t loadPixel(const uint8_t* p) {
+    if (Channels == 1) {
+        return p[0] * 0x010101u | 0xFF000000u;
+    }
+    if (Channels == 2) {
+        return p[0] * 0x010101u | static_cast<uint32_t>(p[1]) << 24;
+    }
+    if (Channels == 3) {
+        return p[0] | p[1] << 8 | p[2] << 16 | 0xFF000000u;
+    }
+    return p[0] | p[1] << 8 | p[2] << 16 | static_cast<uint32_t>(p[3]) << 24;
+}
+
+/**
+ * @brief Whether every pixel of @p row equals the first
+ */
+bool uniformRow(const uint8_t* row, size_t rowBytes, int channels) {
+    for (size_t i = channels; i < rowBytes; i += channels) {
+        if (std::memcmp(row + i, row, channels) != 0) {
+            return false;
+        }
+    }
+    return true;
+}
+
+/**
+ * @brief QOI encoder state over a sink (FileSink or CountingSink), fed pixels in order
+ */
+template <typename Sink>
+class QOIStream {
+public:
+    explicit QOIStream(Sink& sink) : sink_(sink) {
+        buffer_.reserve(QOIWriter::WRITE_BYTES + 64 * 1024);
+    }
+
+    void header(uint32_t width, uint32_t height, int channels) {
+        uint8_t header[14] = {'q', 'o', 'i', 'f'};
+        putU32BE(header + 4, width);
+        putU32BE(header + 8, height);
+        header[12] = static_cast<uint8_t>(channels);
+        header[13] = 0;  // sRGB with linear alpha
+        buffer_.insert(buffer_.end(), header, header + sizeof(header));
+    }
+
+    template <int Channels>
+    void pixels(const uint8_t* data, size_t count) {
+        const size_t start = buffer_.size();
+        buffer_.resize(start + count * MAX_PIXEL_BYTES);
+        uint8_t* out = buffer_.data() + start;
+
+        for (size_t i = 0; i < count; ++i) {
+            const uint32_t px = loadPixel<Channels>(data + i * Channels);
+            if (px == previous_) {
+                if (++run_ == MAX_RUN) {
+                    *out++ = FULL_RUN;
+                    run_ = 0;
+                }
+                continue;
+            }
+            if (run_ > 0) {
+                *out++ = static_cast<uint8_t>(QOI_OP_RUN | (run_ - 1));
+                run_ = 0;
+            }
+
+            const uint8_t r = static_cast<uint8_t>(px);
+            const uint8_t g = static_cast<uint8_t>(px >> 8);
+            const uint8_t b = static_cast<uint8_t>(px >> 16);
+            const uint8_t a = static_cast<uint8_t>(px >> 24);
+            const uint32_t hash = (r * 3 + g * 5 + b * 7 + a * 11) & 63;
+            if (index_[hash] == px) {
+                *out++ = static_cast<uint8_t>(QOI_OP_INDEX | hash);
+            } else {
+                index_[hash] = px;
+                if (a == previous_ >> 24) {
+                    // Differences wrap around, as in the reference encoder
+                    const int dr = static_cast<int8_t>(r - static_cast<uint8_t>(previous_));
+                    const int dg = static_cast<int8_t>(g - static_cast<uint8_t>(previous_ >> 8));
+                    const int db = static_cast<int8_t>(b - static_cast<uint8_t>(previous_ >> 16));
+                    const int drg = dr - dg;
+                    const int dbg = db - dg;
+                    if (dr >= -2 && dr <= 1 && dg >= -2 && dg <= 1 && db >= -2 && db <= 1) {
+                        *out++ = static_cast<uint8_t>(QOI_OP_DIFF | (dr + 2) << 4 | (dg + 2) << 2 | (db + 2));
+                    } else if (dg >= -32 && dg <= 31 && drg >= -8 && drg <= 7 && dbg >= -8 && dbg <= 7) {
+                        *out++ = static_cast<uint8_t>(QOI_OP_LUMA | (dg + 32));
+                        *out++ = static_cast<uint8_t>((drg + 8) << 4 | (dbg + 8));
+                    } else {
+                        *out++ = QOI_OP_RGB;
+                        *out++ = r;
+                        *out++ = g;
+                        *out++ = b;
+                    }
+                } else {
+                    *out++ = QOI_OP_RGBA;
+                    *out++ = r;
+                    *out++ = g;
+                    *out++ = b;
+                    *out++ = a;
+                }
+            }
+            previous_ = px;
+        }
+        buffer_.resize(out - buffer_.data());
+    }
+
+    void pixels(const uint8_t* data, size_t count, int channels) {
+        switch (channels) {
+            case 1: pixels<1>(data, count); break;
+            case 2: pixels<2>(data, count); break;
+            case 3: pixels<3>(data, count); break;
+            default: pixels<4>(data, count); break;
+        }
+    }
+
+    /**
+     * @brief @p count more pixels equal to the previous one
+     */
+    void run(uint64_t count) {
+        const uint64_t total = run_ + count;
+        const uint64_t fullRuns = total / MAX_RUN;
+        run_ = static_cast<uint32_t>(total % MAX_RUN);
+        if (fullRuns > 0) {
+            flush();
+            sink_.repeat(&FULL_RUN, 1, fullRuns);
+        }
+    }
+
+    /**
+     * @brief Encoded bytes not yet written to the sink
+     */
+    std::vector<uint8_t>& buffer() { return buffer_; }
+
+    void flush() {
+        sink_.write(buffer_.data(), buffer_.size());
+        buffer_.clear();
+    }
+
+    void finish() {
+        if (run_ > 0) {
+            buffer_.push_back(static_cast<uint8_t>(QOI_OP_RUN | (run_ - 1)));
+            run_ = 0;
+        }
+        static const uint8_t end[8] = {0, 0, 0, 0, 0, 0, 0, 1};
+        buffer_.insert(buffer_.end(), end, end + sizeof(end));
+        flush();
+        sink_.finish();
+    }
+
+private:
+    Sink& sink_;
+    std::vector<uint8_t> buffer_;
+    uint32_t index_[64] = {};
+    uint32_t previous_ = 0xFF000000u;  // opaque black
+    uint32_t run_ = 0;
+};
+
+template <typename Sink>
+void encodeImage(const RowSource& source, Sink& sink) {
+    const uint32_t width = source.width();
+    const uint32_t height = source.height();
+    const int channels = source.channels();
+    if (channels < 1 || channels > 4) {
+        throw std::invalid_argument("QOI channel count must be 1 to 4");
+    }
+    const size_t rowBytes = static_cast<size_t>(source.rowBytes());
+    const uint32_t batchRows = static_cast<uint32_t>(
+        std::max<size_t>(1, std::min<size_t>(height, QOIWriter::READ_BYTES / std::max<size_t>(rowBytes, 1))));
+
+    QOIStream<Sink> qoi(sink);
+    qoi.header(width, height, channels == 1 || channels == 3 ? 3 : 4);
+
+    std::vector<uint8_t> scratch(batchRows * rowBytes);
+    std::vector<uint8_t> previous(rowBytes);  // last row of the previous batch
+    for (uint32_t y0 = 0; y0 < height;) {
+        const uint32_t repeats = y0 == 0 ? 0 : std::min(source.repeatedRows(y0), height - y0);
+        if (repeats > 0) {
+            if (uniformRow(previous.data(), rowBytes, channels)) {
+                // Every pixel repeats the last one coded
+                qoi.run(static_cast<uint64_t>(repeats) * width);
+            } else {
+                // After one repeat, the previous pixel, run and color table are those before it,
+                // so every further repeat codes to the bytes of the second
+                qoi.pixels(previous.data(), width, channels);
+                if (repeats > 1) {
+                    qoi.flush();
+                    qoi.pixels(previous.data(), width, channels);
+                    sink.repeat(qoi.buffer().data(), qoi.buffer().size(), repeats - 1);
+                    qoi.buffer().clear();
+                }
+            }
+            y0 += repeats;
+        } else {
+            uint32_t count = std::min(batchRows, height - y0);
+            const uint8_t* rows = source.rows(y0, count, scratch.data());
+            for (uint32_t i = 1; i < count; ++i) {
+                if (source.repeatedRows(y0 + i) > 0) {
+                    count = i;
+                    break;
+                }
+            }
+            qoi.pixels(rows, static_cast<size_t>(count) * width, channels);
+            std::memcpy(previous.data(), rows + (count - 1) * rowBytes, rowBytes);
+            y0 += count;
+        }
+
+        if (qoi.buffer().size() >= QOIWriter::WRITE_BYTES) {
+            qoi.flush();
+        }
+    }
+    qoi.finish();
+}
+
+} // namespace
+
+bool QOIWriter::write(const std::string& filename,
+                      const Color& color,
+                      const Resolution& resolution) {
+    const SolidRowSource source(color, resolution, color.isOpaque() ? 3 : 4);
+    FileSink sink(filename);
+    encodeImage(source, sink);
+    return true;
+}
+
+bool QOIWriter::write(const std::string& filename, const RowSource& source) {
+    FileSink sink(filename);
+    encodeImage(source, sink);
+    return true;
+}
+
+uint64_t QOIWriter::encodedSize(const Color& color, const Resolution& resolution) {
+    const SolidRowSource source(color, resolution, color.isOpaque() ? 3 : 4);
+    CountingSink sink;
+    encodeImage(source, sink);
+    return sink.size;
+}
+
+} // namespace ColorGenerator
@@ -0,0 +1,42 @@
+#include "../../include/formats/RawImageWriter.hpp"
+#include "../../include/MappedFile.hpp"
+#include "../../include/formats/ByteSink.hpp"
+#include <algorithm>
+#include <cstring>
+#include <vector>
+
+namespace ColorGenerator {
+
+bool RawImageWriter::write(const std::string& filename,
+                           const Color& color,
+                           const Resolution& resolution) {
+    const int channels = color.isOpaque() ? 3 : 4;
+    const uint64_t size = resolution.getPixelCount() * channels;
+
+    MappedFile file(filename, size);
+
+    const uint8_t pixel[4] = {color.getRed(), color.getGreen(), color.getBlue(), color.getAlpha()};
+    std::memcpy(file.data(), pixel, channels);
+    file.replicate(0, channels, size);
+
+    file.close();
+    return true;
+}
+
+bool RawImageWriter::write(const std::string& filename, const RowSource& source) {
+    const uint32_t height = source.height();
+    const size_t rowBytes = static_cast<size_t>(source.rowBytes());
+    const uint32_t batchRows = static_cast<uint32_t>(
+        std::max<size_t>(1, std::min<size_t>(height, READ_BYTES / std::max<size_t>(rowBytes, 1))));
+    std::vector<uint8_t> scratch(static_cast<size_t>(batchRows) * rowBytes);
+
+    FileSink sink(filename);
+    for (uint32_t y = 0; y < height; y += batchRows) {
+        const uint32_t count = std::min(batchRows, height - y);
+        sink.write(source.rows(y, count, scratch.data()), count * rowBytes);
+    }
+    sink.finish();
+    return true;
+}
+
+} // namespace ColorGenerator
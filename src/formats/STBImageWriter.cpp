@@ -1,7 +1,10 @@
-#define STB_IMAGE_WRITE_IMPLEMENTATION
-#include "../../include/stb_image_write.h"
 #include "../../include/formats/STBImageWriter.hpp"
-#include <vector>
+#include "../../include/formats/SolidPNGEncoder.hpp"
+#include "../../include/formats/SolidJPEGEncoder.hpp"
+#include "../../include/formats/JPEGEncoder.hpp"
+#include "../../include/formats/SolidBMPEncoder.hpp"
+#include "../../include/formats/PNGEncoder.hpp"
+#include "../../include/formats/BMPEncoder.hpp"
 #include <stdexcept>
 
 namespace ColorGenerator {
@@ -38,43 +41,31 @@ std::string STBImageWriter::getExtension() const {
 }
 
 bool STBImageWriter::supportsTransparency() const {
-    // PNG and BMP support transparency via stb_image_write
-    // JPEG does not support transparency
+    // PNG and BMP are written with alpha; JPEG has none
     return format_ == Format::PNG || format_ == Format::BMP;
 }
 
-void STBImageWriter::fillPixelBuffer(std::vector<uint8_t>& buffer,
+JPEGEncoder::Options STBImageWriter::getJPEGOptions() const {
+    JPEGEncoder::Options options;
+    options.quality = jpegQuality_;
+    options.restartRows = JPEGEncoder::DEFAULT_RESTART_ROWS;
+    options.subsampling = jpegSubsampling_;
+    options.dct = jpegDCT_;
+    options.optimizeHuffman = jpegOptimizeHuffman_;
+    options.huffmanSampleStep = jpegHuffmanSampleStep_;
+    return options;
+}
+
+void STBImageWriter::fillPixelBuffer(PixelBuffer& buffer,
                                      const Color& color,
                                      const Resolution& resolution,
-                                     int channels) const {
-    uint32_t width = resolution.getWidth();
-    uint32_t height = resolution.getHeight();
-    size_t pixelCount = static_cast<size_t>(width) * height;
-
-    buffer.resize(pixelCount * channels);
-
-    uint8_t r = color.getRed();
-    uint8_t g = color.getGreen();
-    uint8_t b = color.getBlue();
-    uint8_t a = color.getAlpha();
-
-    // Fill buffer with solid color
-    for (size_t i = 0; i < pixelCount; ++i) {
-        buffer[i * channels + 0] = r;
-        buffer[i * channels + 1] = g;
-        buffer[i * channels + 2] = b;
-        if (channels == 4) {
-            buffer[i * channels + 3] = a;
-        }
-    }
+                                     int channels) {
+    PixelFill::fill(buffer, color, resolution, channels);
 }
 
 bool STBImageWriter::write(const std::string& filename,
                            const Color& color,
                            const Resolution& resolution) {
-    uint32_t width = resolution.getWidth();
-    uint32_t height = resolution.getHeight();
-
     // Determine number of channels based on format and transparency
     int channels;
     if (format_ == Format::JPEG) {
@@ -83,37 +74,42 @@ bool STBImageWriter::write(const std::string& filename,
         channels = color.isOpaque() ? 3 : 4;
     }
 
-    // Allocate and fill pixel buffer
-    std::vector<uint8_t> pixels;
-    fillPixelBuffer(pixels, color, resolution, channels);
-
-    // Write image using stb_image_write
-    int result = 0;
+    // Solid images are encoded analytically without a pixel buffer
     switch (format_) {
         case Format::PNG:
-            result = stbi_write_png(filename.c_str(), width, height,
-                                   channels, pixels.data(), width * channels);
-            break;
+            SolidPNGEncoder::write(filename, color, resolution, channels);
+            return true;
 
         case Format::JPEG:
-            result = stbi_write_jpg(filename.c_str(), width, height,
-                                   channels, pixels.data(), jpegQuality_);
-            break;
+            SolidJPEGEncoder::write(filename, color, resolution, jpegQuality_);
+            return true;
 
         case Format::BMP:
-            result = stbi_write_bmp(filename.c_str(), width, height,
-                                   channels, pixels.data());
-            break;
+            SolidBMPEncoder::write(filename, color, resolution, channels);
+            return true;
 
         default:
             throw std::runtime_error("Unsupported image format");
     }
+}
 
-    if (result == 0) {
-        throw std::runtime_error("Failed to write image file: " + filename);
-    }
+bool STBImageWriter::write(const std::string& filename, const RowSource& source) {
+    switch (format_) {
+        case Format::PNG:
+            PNGEncoder::write(filename, source, PNGEncoder::Options{});
+            return true;
+
+        case Format::JPEG:
+            JPEGEncoder::write(filename, source, getJPEGOptions());
+            return true;
+
+        case Format::BMP:
+            BMPEncoder::write(filename, source);
+            return true;
 
-    return true;
+        default:
+            throw std::runtime_error("Unsupported image format");
+    }
 }
 
 } // namespace ColorGenerator
@@ -0,0 +1,42 @@
+#include "../../include/formats/SolidBMPEncoder.hpp"
+#include "../../include/formats/BMPEncoder.hpp"
+#include "../../include/MappedFile.hpp"
+#include <cstring>
+#include <stdexcept>
+
+namespace ColorGenerator {
+
+uint64_t SolidBMPEncoder::encodedSize(const Resolution& resolution, int channels) {
+    return BMPEncoder::fileSize(resolution.getWidth(), resolution.getHeight(), channels);
+}
+
+void SolidBMPEncoder::write(const std::string& filename,
+                            const Color& color,
+                            const Resolution& resolution,
+                            int channels) {
+    if (channels != 3 && channels != 4) {
+        throw std::invalid_argument("BMP channel count must be 3 or 4");
+    }
+
+    const uint32_t width = resolution.getWidth();
+    const uint32_t height = resolution.getHeight();
+    const size_t rowBytes = static_cast<size_t>(width) * channels;
+    const size_t rowStride = (rowBytes + 3) & ~static_cast<size_t>(3);
+    const uint64_t pixelBytes = static_cast<uint64_t>(rowStride) * height;
+
+    MappedFile file(filename, encodedSize(resolution, channels));
+    const size_t headerSize = BMPEncoder::writeHeaders(file.data(), width, height, channels);
+    uint8_t* p = file.data() + headerSize;
+
+    // One padded row of BGR(A) pixels, then replicate it over the image
+    const uint8_t pixel[4] = {color.getBlue(), color.getGreen(), color.getRed(), color.getAlpha()};
+    for (size_t x = 0; x < rowBytes; x += channels) {
+        std::memcpy(p + x, pixel, channels);
+    }
+    std::memset(p + rowBytes, 0, rowStride - rowBytes);
+    file.replicate(headerSize, rowStride, pixelBytes);
+
+    file.close();
+}
+
+} // namespace ColorGenerator
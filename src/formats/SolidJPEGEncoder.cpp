@@ -0,0 +1,154 @@
+#include "../../include/formats/SolidJPEGEncoder.hpp"
+#include "../../include/formats/JPEGCommon.hpp"
+#include "../../include/formats/ByteSink.hpp"
+#include <array>
+#include <cstdint>
+#include <vector>
+
+namespace ColorGenerator {
+
+using namespace JPEG;
+
+namespace {
+
+/**
+ * @brief Quantized DC coefficient of a block filled with @p value
+ *
+ * The DC term of the forward DCT is 8x the (level shifted) block mean.
+ */
+int quantizedDC(double value, int quant) {
+    double v = 8.0 * value / quant;
+    return static_cast<int>(v < 0 ? v - 0.5 : v + 0.5);
+}
+
+/**
+ * @brief Encode one block whose only non-zero coefficient is the DC
+ */
+void dcOnlyBlock(BitWriter& bits, int diff, const CodeTable& dc, const CodeTable& ac) {
+    bits.dc(diff, dc);
+    bits.put(ac[0x00]);  // EOB
+}
+
+/**
+ * @brief Encode a solid image into @p sink (FileSink or CountingSink)
+ */
+template <typename Sink>
+void encodeSolid(Sink& sink, const Color& color, const Resolution& resolution, int quality) {
+    const uint32_t width = resolution.getWidth();
+    const uint32_t height = resolution.getHeight();
+    const double r = color.getRed();
+    const double g = color.getGreen();
+    const double b = color.getBlue();
+    const bool gray = color.getRed() == color.getGreen() && color.getGreen() == color.getBlue();
+
+    // Same quality mapping and tables as stb_image_write
+    const int scale = qualityScale(quality);
+    const std::array<uint8_t, 64> lumaTable = scaleQuantTable(LUMA_QUANT, scale);
+    const std::array<uint8_t, 64> chromaTable = scaleQuantTable(CHROMA_QUANT, scale);
+
+    const CodeTable dcLuma = buildCodes(DC_LUMA);
+    const CodeTable acLuma = buildCodes(AC_LUMA);
+    const CodeTable dcChroma = buildCodes(DC_CHROMA);
+    const CodeTable acChroma = buildCodes(AC_CHROMA);
+
+    std::vector<uint8_t> out;
+    out.reserve(4096);
+
+    // Color uses 4:2:0 since chroma subsampling is lossless for a flat image
+    FrameHeader header{width, height, gray ? 1 : 3, 0x22, lumaTable.data(), chromaTable.data(),
+                       {&DC_LUMA, &AC_LUMA, &DC_CHROMA, &AC_CHROMA}, 0};
+    writeHeaders(out, header);
+
+    BitWriter bits(out);
+    uint64_t mcuCount;
+    if (gray) {
+        mcuCount = static_cast<uint64_t>((width + 7) / 8) * ((height + 7) / 8);
+        dcOnlyBlock(bits, quantizedDC(r - 128.0, lumaTable[0]), dcLuma, acLuma);
+    } else {
+        mcuCount = static_cast<uint64_t>((width + 15) / 16) * ((height + 15) / 16);
+        const double y = 0.29900 * r + 0.58700 * g + 0.11400 * b - 128.0;
+        const double cb = -0.16874 * r - 0.33126 * g + 0.50000 * b;
+        const double cr = 0.50000 * r - 0.41869 * g - 0.08131 * b;
+        dcOnlyBlock(bits, quantizedDC(y, lumaTable[0]), dcLuma, acLuma);
+        for (int i = 0; i < 3; ++i) {
+            dcOnlyBlock(bits, 0, dcLuma, acLuma);
+        }
+        dcOnlyBlock(bits, quantizedDC(cb, chromaTable[0]), dcChroma, acChroma);
+        dcOnlyBlock(bits, quantizedDC(cr, chromaTable[0]), dcChroma, acChroma);
+    }
+
+    // Bit pattern of an MCU whose blocks all repeat the previous DC value
+    Code repeat{0, 0};
+    auto append = [&repeat](const Code& c) {
+        repeat.bits = (repeat.bits << c.length) | c.bits;
+        repeat.length += c.length;
+    };
+    for (int i = 0; i < (gray ? 1 : 4); ++i) {
+        append(dcLuma[0]);
+        append(acLuma[0x00]);
+    }
+    for (int i = 0; i < (gray ? 0 : 2); ++i) {
+        append(dcChroma[0]);
+        append(acChroma[0x00]);
+    }
+
+    // After 8/gcd(bits, 8) MCUs the bit alignment (and thus the output) repeats
+    int cycleMCUs = 8;
+    while (cycleMCUs > 1 && (repeat.length * (cycleMCUs / 2)) % 8 == 0) {
+        cycleMCUs /= 2;
+    }
+
+    uint64_t remaining = mcuCount - 1;
+    uint64_t warmup = remaining < static_cast<uint64_t>(cycleMCUs) ? remaining : cycleMCUs;
+    for (uint64_t i = 0; i < warmup; ++i) {
+        bits.put(repeat);
+    }
+    remaining -= warmup;
+
+    // Bytes of out already passed to the sink
+    size_t written = 0;
+    if (remaining >= static_cast<uint64_t>(cycleMCUs)) {
+        bits.flush();
+        sink.write(out.data(), out.size());
+        written = out.size();
+
+        // Capture one steady-state cycle, then replicate it in large blocks
+        for (int i = 0; i < cycleMCUs; ++i) {
+            bits.put(repeat);
+        }
+        bits.flush();
+        uint64_t cycles = remaining / cycleMCUs;
+        remaining %= cycleMCUs;
+
+        sink.repeat(out.data() + written, out.size() - written, cycles);
+        written = out.size();
+    }
+
+    for (uint64_t i = 0; i < remaining; ++i) {
+        bits.put(repeat);
+    }
+    bits.padToByte();
+    out.push_back(0xFF);
+    out.push_back(0xD9);  // EOI
+
+    sink.write(out.data() + written, out.size() - written);
+    sink.finish();
+}
+
+} // namespace
+
+void SolidJPEGEncoder::write(const std::string& filename,
+                             const Color& color,
+                             const Resolution& resolution,
+                             int quality) {
+    FileSink sink(filename, WRITE_BLOCK_SIZE);
+    encodeSolid(sink, color, resolution, quality);
+}
+
+uint64_t SolidJPEGEncoder::encodedSize(const Color& color, const Resolution& resolution, int quality) {
+    CountingSink sink;
+    encodeSolid(sink, color, resolution, quality);
+    return sink.size;
+}
+
+} // namespace ColorGenerator
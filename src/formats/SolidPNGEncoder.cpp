@@ -0,0 +1,115 @@
+#include "../../include/formats/SolidPNGEncoder.hpp"
+#include "../../include/formats/Deflate.hpp"
+#include "../../include/formats/ByteSink.hpp"
+#include "../../include/formats/PNGChunk.hpp"
+#include <cstdint>
+#include <stdexcept>
+#include <vector>
+
+namespace ColorGenerator {
+
+namespace {
+
+// PNG scanline filter types
+constexpr uint8_t FILTER_NONE = 0;
+constexpr uint8_t FILTER_UP = 2;
+
+/**
+ * @brief Encode a solid image into @p sink (FileSink or CountingSink)
+ */
+template <typename Sink>
+void encodeSolid(Sink& sink, const Color& color, const Resolution& resolution, int channels,
+                 size_t idatChunkSize) {
+    const uint32_t width = resolution.getWidth();
+    const uint32_t height = resolution.getHeight();
+    const size_t rowBytes = static_cast<size_t>(width) * channels;
+
+    sink.write(PNGChunk::SIGNATURE, sizeof(PNGChunk::SIGNATURE));
+
+    uint8_t ihdr[13];
+    putU32BE(ihdr, width);
+    putU32BE(ihdr + 4, height);
+    ihdr[8] = 8;                          // bit depth
+    ihdr[9] = channels == 4 ? 6 : 2;      // color type: RGBA or RGB
+    ihdr[10] = 0;                         // compression
+    ihdr[11] = 0;                         // filter method
+    ihdr[12] = 0;                         // interlace
+    PNGChunk::write(sink, "IHDR", ihdr, sizeof(ihdr));
+
+    const uint8_t pixel[4] = {color.getRed(), color.getGreen(), color.getBlue(), color.getAlpha()};
+    static const uint8_t zero = 0;
+
+    std::vector<uint8_t> zdata;
+    zdata.reserve(idatChunkSize + 64 * 1024);
+    DeflateWriter deflate(zdata);
+    Adler32 adler;
+
+    // zlib header (deflate, 32K window, fastest), then a single final fixed-Huffman block
+    zdata.push_back(0x78);
+    zdata.push_back(0x01);
+    deflate.beginFixedBlock(true);
+
+    // First row: filter None followed by the pixel repeated across the row
+    std::vector<uint8_t> firstRow(rowBytes + 1);
+    firstRow[0] = FILTER_NONE;
+    for (size_t i = 0; i < rowBytes; ++i) {
+        firstRow[1 + i] = pixel[i % channels];
+    }
+    adler.update(firstRow.data(), firstRow.size());
+
+    deflate.literal(FILTER_NONE);
+    for (int c = 0; c < channels; ++c) {
+        deflate.literal(pixel[c]);
+    }
+    deflate.run(rowBytes - channels, static_cast<uint32_t>(channels), pixel);
+
+    // Remaining rows: filter Up, which leaves every byte zero
+    for (uint32_t y = 1; y < height; ++y) {
+        deflate.literal(FILTER_UP);
+        deflate.literal(0);
+        deflate.run(rowBytes - 1, 1, &zero);
+
+        adler.updateByte(FILTER_UP);
+        adler.updateZeros(rowBytes);
+
+        if (zdata.size() >= idatChunkSize) {
+            PNGChunk::write(sink, "IDAT", zdata.data(), zdata.size());
+            zdata.clear();
+        }
+    }
+
+    // End-of-block symbol, byte alignment and the big-endian Adler-32 trailer
+    deflate.endOfBlock();
+    deflate.flush();
+    uint8_t trailer[4];
+    putU32BE(trailer, adler.value());
+    zdata.insert(zdata.end(), trailer, trailer + 4);
+
+    PNGChunk::write(sink, "IDAT", zdata.data(), zdata.size());
+    PNGChunk::write(sink, "IEND", nullptr, 0);
+    sink.finish();
+}
+
+} // namespace
+
+void SolidPNGEncoder::write(const std::string& filename,
+                            const Color& color,
+                            const Resolution& resolution,
+                            int channels) {
+    if (channels != 3 && channels != 4) {
+        throw std::invalid_argument("PNG channel count must be 3 or 4");
+    }
+    FileSink sink(filename, IDAT_CHUNK_SIZE);
+    encodeSolid(sink, color, resolution, channels, IDAT_CHUNK_SIZE);
+}
+
+uint64_t SolidPNGEncoder::encodedSize(const Color& color, const Resolution& resolution, int channels) {
+    if (channels != 3 && channels != 4) {
+        throw std::invalid_argument("PNG channel count must be 3 or 4");
+    }
+    CountingSink sink;
+    encodeSolid(sink, color, resolution, channels, IDAT_CHUNK_SIZE);
+    return sink.size;
+}
+
+} // namespace ColorGenerator
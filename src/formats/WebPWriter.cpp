@@ -0,0 +1,975 @@
+#include "../../include/formats/WebPWriter.hpp"
+#include "../../include/formats/ByteSink.hpp"
+#include "../../include/formats/Deflate.hpp"
+#include <algorithm>
+#include <array>
+#include <cstring>
+#include <memory>
+#include <stdexcept>
+#include <type_traits>
+#include <unordered_map>
+#include <vector>
+
+namespace ColorGenerator {
+
+namespace {
+
+using Code = DeflateCode::Code;
+
+constexpr uint32_t MAX_DIMENSION = 16384;
+constexpr uint8_t VP8L_SIGNATURE = 0x2F;
+constexpr uint32_t PREDICTOR_TRANSFORM = 0;
+constexpr uint32_t SUBTRACT_GREEN_TRANSFORM = 2;
+constexpr uint32_t COLOR_INDEXING_TRANSFORM = 3;
+
+// Predictor blocks of 512x512 pixels (the largest), all predicting L + T - TL per channel
+constexpr int PREDICTOR_BLOCK_BITS = 9;
+constexpr uint32_t PREDICTOR_CLAMPED_GRADIENT = 12;
+
+constexpr int NUM_LITERALS = 256;
+constexpr int NUM_LENGTH_CODES = 24;
+constexpr int NUM_DISTANCE_CODES = 40;
+constexpr int MAX_CODE_LENGTH = 15;
+
+// Longest backward reference, and the shortest worth more than its literals
+constexpr uint32_t MAX_COPY = 4096;
+constexpr uint32_t MIN_COPY = 3;
+
+// Color cache sizes tried on images with more than 256 colors (0 = no cache)
+constexpr int CACHE_BITS[] = {0, 4, 6, 8, 10};
+
+// The five prefix codes of an entropy-coded image, in stream order
+enum Alphabet { GREEN, RED, BLUE, ALPHA, DISTANCE, ALPHABETS };
+
+void putU32LE(uint8_t* dst, uint32_t value) {
+    dst[0] = static_cast<uint8_t>(value);
+    dst[1] = static_cast<uint8_t>(value >> 8);
+    dst[2] = static_cast<uint8_t>(value >> 16);
+    dst[3] = static_cast<uint8_t>(value >> 24);
+}
+
+/**
+ * @brief Pixel as A << 24 | R << 16 | G << 8 | B, gray expanded to RGB
+ */
+uint32_t loadARGB(const uint8_t* p, int channels) {
+    switch (channels) {
+        case 1:
+            return 0xFF000000u | p[0] * 0x010101u;
+        case 2:
+            return static_cast<uint32_t>(p[1]) << 24 | p[0] * 0x010101u;
+        case 3:
+            return 0xFF000000u | p[0] << 16 | p[1] << 8 | p[2];
+        default:
+            return static_cast<uint32_t>(p[3]) << 24 | p[0] << 16 | p[1] << 8 | p[2];
+    }
+}
+
+uint32_t colorARGB(const Color& color) {
+    return static_cast<uint32_t>(color.getAlpha()) << 24 | color.getRed() << 16 |
+           color.getGreen() << 8 | color.getBlue();
+}
+
+/**
+ * @brief Per-channel difference a - b, modulo 256
+ */
+uint32_t subPixels(uint32_t a, uint32_t b) {
+    const uint32_t alphaGreen = 0x00FF00FFu + (a & 0xFF00FF00u) - (b & 0xFF00FF00u);
+    const uint32_t redBlue = 0xFF00FF00u + (a & 0x00FF00FFu) - (b & 0x00FF00FFu);
+    return (alphaGreen & 0xFF00FF00u) | (redBlue & 0x00FF00FFu);
+}
+
+/**
+ * @brief Source row as ARGB with green subtracted from red and blue (the subtract green transform)
+ * @return Whether any pixel is not opaque
+ */
+bool loadRow(const uint8_t* pixels, uint32_t width, int channels, uint32_t* row) {
+    uint32_t alpha = 0xFF;
+    switch (channels) {
+        case 1:
+            for (uint32_t x = 0; x < width; ++x) {
+                row[x] = 0xFF000000u | static_cast<uint32_t>(pixels[x]) << 8;
+            }
+            break;
+        case 2:
+            for (uint32_t x = 0; x < width; ++x) {
+                row[x] = static_cast<uint32_t>(pixels[2 * x + 1]) << 24 | pixels[2 * x] << 8;
+                alpha &= pixels[2 * x + 1];
+            }
+            break;
+        default:
+            for (uint32_t x = 0; x < width; ++x) {
+                const uint8_t* p = pixels + static_cast<size_t>(x) * channels;
+                const uint32_t a = channels == 4 ? p[3] : 0xFF;
+                row[x] = a << 24 | static_cast<uint8_t>(p[0] - p[1]) << 16 | p[1] << 8 |
+                         static_cast<uint8_t>(p[2] - p[1]);
+                alpha &= a;
+            }
+            break;
+    }
+    return alpha != 0xFF;
+}
+
+/**
+ * @brief Prediction residuals of @p row
+ *
+ * The top row predicts from the pixel to the left (the first pixel from
+ * opaque black), the left column from the pixel above, and every other
+ * pixel by left + top - top-left, clamped to 0-255 (predictor mode 12).
+ * All channels get the same arithmetic, so the rows are processed as bytes.
+ */
+void predictRow(const uint32_t* row, const uint32_t* above, uint32_t width, uint32_t* residuals) {
+    const uint8_t* cur = reinterpret_cast<const uint8_t*>(row);
+    uint8_t* out = reinterpret_cast<uint8_t*>(residuals);
+    const size_t bytes = static_cast<size_t>(width) * 4;
+    if (!above) {
+        residuals[0] = subPixels(row[0], 0xFF000000u);
+        for (size_t i = 4; i < bytes; ++i) {
+            out[i] = static_cast<uint8_t>(cur[i] - cur[i - 4]);
+        }
+        return;
+    }
+    const uint8_t* up = reinterpret_cast<const uint8_t*>(above);
+    residuals[0] = subPixels(row[0], above[0]);
+    for (size_t i = 4; i < bytes; ++i) {
+        const int prediction = cur[i - 4] + up[i] - up[i - 4];
+        out[i] = static_cast<uint8_t>(cur[i] - std::clamp(prediction, 0, 255));
+    }
+}
+
+/**
+ * @brief Prefix symbol and extra bits of a length or distance code value (at least 1)
+ */
+struct Prefix {
+    int symbol;
+    int extraBits;
+    uint32_t extra;
+};
+
+Prefix prefixOf(uint32_t value) {
+    if (value <= 4) {
+        return {static_cast<int>(value - 1), 0, 0};
+    }
+    const uint32_t offset = value - 1;
+    const int highest = 31 - __builtin_clz(offset);
+    const int second = (offset >> (highest - 1)) & 1;
+    const int extraBits = highest - 1;
+    return {2 * highest + second, extraBits, offset & ((1u << extraBits) - 1)};
+}
+
+/**
+ * @brief Distance code of a backward reference in an image @p xsize coded pixels wide
+ *
+ * Codes 1 to 120 stand for nearby 2-D offsets, among them the pixel above
+ * (code 1) and the pixel to the left (code 2); others are the distance + 120.
+ */
+uint32_t distanceCode(uint32_t distance, uint32_t xsize) {
+    if (distance == xsize) {
+        return 1;
+    }
+    if (distance == 1) {
+        return 2;
+    }
+    return distance + 120;
+}
+
+/**
+ * @brief Number of leading pixels, up to @p limit, that @p a and @p b share
+ */
+uint32_t matchLength(const uint32_t* a, const uint32_t* b, uint32_t limit) {
+    uint32_t n = 0;
+    while (n + 2 <= limit) {
+        uint64_t x, y;
+        std::memcpy(&x, a + n, 8);
+        std::memcpy(&y, b + n, 8);
+        if (x != y) break;
+        n += 2;
+    }
+    while (n < limit && a[n] == b[n]) ++n;
+    return n;
+}
+
+/**
+ * @brief Number of leading pixels of @p a, up to @p limit, equal to @p value
+ */
+uint32_t runLength(const uint32_t* a, uint32_t value, uint32_t limit) {
+    const uint64_t pair = static_cast<uint64_t>(value) << 32 | value;
+    uint32_t n = 0;
+    while (n + 2 <= limit) {
+        uint64_t x;
+        std::memcpy(&x, a + n, 8);
+        if (x != pair) break;
+        n += 2;
+    }
+    while (n < limit && a[n] == value) ++n;
+    return n;
+}
+
+/**
+ * @brief Recently coded colors by hash, kept in step with the decoder's cache
+ *
+ * Slots that were never filled match no color, so the encoder does not
+ * rely on how a decoder initializes them.
+ */
+class ColorCache {
+public:
+    explicit ColorCache(int bits) : bits_(bits), slots_(bits > 0 ? size_t{1} << bits : 0, EMPTY) {}
+
+    /// Slot holding @p argb, or -1
+    int find(uint32_t argb) const {
+        if (bits_ == 0) {
+            return -1;
+        }
+        const uint32_t slot = key(argb);
+        return slots_[slot] == argb ? static_cast<int>(slot) : -1;
+    }
+
+    void insert(uint32_t argb) {
+        if (bits_ > 0) {
+            slots_[key(argb)] = argb;
+        }
+    }
+
+    void insert(const uint32_t* pixels, uint32_t count) {
+        for (uint32_t i = 0; bits_ > 0 && i < count; ++i) {
+            slots_[key(pixels[i])] = pixels[i];
+        }
+    }
+
+private:
+    static constexpr uint64_t EMPTY = ~uint64_t{0};
+
+    uint32_t key(uint32_t argb) const { return (0x1E35A7BDu * argb) >> (32 - bits_); }
+
+    int bits_;
+    std::vector<uint64_t> slots_;
+};
+
+/**
+ * @brief Symbol counts of an entropy-coded image, gathered by calling the same
+ *        pixel(), copy() sequence as on EntropyWriter
+ */
+struct Histogram {
+    explicit Histogram(int cacheBits) : cacheBits(cacheBits), cache(cacheBits) {
+        counts[GREEN].assign(NUM_LITERALS + NUM_LENGTH_CODES + (cacheBits > 0 ? 1 << cacheBits : 0), 0);
+        counts[RED].assign(NUM_LITERALS, 0);
+        counts[BLUE].assign(NUM_LITERALS, 0);
+        counts[ALPHA].assign(NUM_LITERALS, 0);
+        counts[DISTANCE].assign(NUM_DISTANCE_CODES, 0);
+    }
+
+    void pixel(uint32_t argb) {
+        const int slot = cache.find(argb);
+        if (slot >= 0) {
+            ++counts[GREEN][NUM_LITERALS + NUM_LENGTH_CODES + slot];
+            return;
+        }
+        cache.insert(argb);
+        ++counts[GREEN][(argb >> 8) & 0xFF];
+        ++counts[RED][(argb >> 16) & 0xFF];
+        ++counts[BLUE][argb & 0xFF];
+        ++counts[ALPHA][argb >> 24];
+    }
+
+    /**
+     * @param pixels The copied pixels, for the color cache; null if they are already in it
+     */
+    void copy(uint32_t length, uint32_t distance, const uint32_t* pixels) {
+        const Prefix l = prefixOf(length);
+        const Prefix d = prefixOf(distance);
+        ++counts[GREEN][NUM_LITERALS + l.symbol];
+        ++counts[DISTANCE][d.symbol];
+        extraBits += l.extraBits + d.extraBits;
+        if (pixels) {
+            cache.insert(pixels, length);
+        }
+    }
+
+    int cacheBits;
+    ColorCache cache;
+    std::array<std::vector<uint64_t>, ALPHABETS> counts;
+    uint64_t extraBits = 0;
+};
+
+/**
+ * @brief Several histograms fed the same tokens, one per color cache size
+ */
+struct Candidates {
+    std::vector<Histogram> histograms;
+
+    void pixel(uint32_t argb) {
+        for (Histogram& h : histograms) h.pixel(argb);
+    }
+
+    void copy(uint32_t length, uint32_t distance, const uint32_t* pixels) {
+        for (Histogram& h : histograms) h.copy(length, distance, pixels);
+    }
+};
+
+/**
+ * @brief A prefix code fitted to one alphabet of a histogram
+ */
+struct PrefixCode {
+    std::vector<Code> codes;
+    std::vector<uint8_t> lengths;
+    int simpleSymbol = -1;  ///< The only symbol, sent as a simple code that takes zero bits
+};
+
+using PrefixCodes = std::array<PrefixCode, ALPHABETS>;
+
+PrefixCode buildCode(const std::vector<uint64_t>& counts) {
+    const int symbols = static_cast<int>(counts.size());
+    PrefixCode code;
+    code.codes.assign(symbols, Code{0, 0});
+    int used = 0;
+    int last = 0;
+    for (int i = 0; i < symbols; ++i) {
+        if (counts[i] > 0) {
+            ++used;
+            last = i;
+        }
+    }
+    // A simple code names its symbol in at most 8 bits
+    if (used <= 1 && last < NUM_LITERALS) {
+        code.simpleSymbol = last;
+        return code;
+    }
+    code.lengths.resize(symbols);
+    DeflateCode::huffmanLengths(counts.data(), symbols, MAX_CODE_LENGTH, code.lengths.data());
+    DeflateCode::canonicalCodes(code.lengths.data(), symbols, code.codes.data());
+    return code;
+}
+
+PrefixCodes buildCodes(const Histogram& histogram) {
+    PrefixCodes codes;
+    for (int a = 0; a < ALPHABETS; ++a) {
+        codes[a] = buildCode(histogram.counts[a]);
+    }
+    return codes;
+}
+
+/**
+ * @brief Bits of the pixel data coded with @p codes
+ */
+uint64_t dataBits(const Histogram& histogram, const PrefixCodes& codes) {
+    uint64_t bits = histogram.extraBits;
+    for (int a = 0; a < ALPHABETS; ++a) {
+        const std::vector<uint64_t>& counts = histogram.counts[a];
+        for (size_t i = 0; i < counts.size(); ++i) {
+            bits += counts[i] * codes[a].codes[i].length;
+        }
+    }
+    return bits;
+}
+
+/**
+ * @brief LSB-first bit packer writing whole bytes to a sink (FileSink or CountingSink)
+ */
+template <typename Sink>
+class BitWriter {
+public:
+    explicit BitWriter(Sink& sink) : sink_(sink) {}
+
+    void put(uint32_t bits, int count) {
+        acc_ |= static_cast<uint64_t>(bits) << used_;
+        used_ += count;
+        total_ += count;
+        if (used_ >= 32) {
+            const uint32_t word = static_cast<uint32_t>(acc_);
+            bytes_.insert(bytes_.end(), {static_cast<uint8_t>(word), static_cast<uint8_t>(word >> 8),
+                                         static_cast<uint8_t>(word >> 16), static_cast<uint8_t>(word >> 24)});
+            acc_ >>= 32;
+            used_ -= 32;
+            if (bytes_.size() >= WebPWriter::WRITE_BYTES) {
+                drain();
+            }
+        }
+    }
+
+    void put(const Code& code) { put(code.bits, code.length); }
+
+    /// Bits put so far
+    uint64_t bits() const { return total_; }
+
+    /**
+     * @brief Pad to a byte boundary and write everything
+     */
+    void finish() {
+        for (; used_ > 0; used_ -= std::min(used_, 8)) {
+            bytes_.push_back(static_cast<uint8_t>(acc_));
+            acc_ >>= 8;
+        }
+        used_ = 0;
+        drain();
+    }
+
+private:
+    void drain() {
+        sink_.write(bytes_.data(), bytes_.size());
+        bytes_.clear();
+    }
+
+    Sink& sink_;
+    std::vector<uint8_t> bytes_;
+    uint64_t acc_ = 0;
+    int used_ = 0;
+    uint64_t total_ = 0;
+};
+
+/**
+ * @brief Describe @p code: a simple code, or code lengths run-length coded as in deflate
+ */
+template <typename Bits>
+void writeCode(Bits& out, const PrefixCode& code) {
+    if (code.simpleSymbol >= 0) {
+        out.put(1, 1);  // simple code
+        out.put(0, 1);  // of one symbol
+        if (code.simpleSymbol < 2) {
+            out.put(0, 1);
+            out.put(static_cast<uint32_t>(code.simpleSymbol), 1);
+        } else {
+            out.put(1, 1);
+            out.put(static_cast<uint32_t>(code.simpleSymbol), 8);
+        }
+        return;
+    }
+
+    const std::vector<DeflateCode::LengthToken> tokens =
+        DeflateCode::runLengthTokens(code.lengths.data(), code.lengths.size());
+    uint64_t clCounts[19] = {};
+    for (const DeflateCode::LengthToken& token : tokens) {
+        ++clCounts[token.symbol];
+    }
+    uint8_t clLengths[19];
+    Code clCodes[19];
+    DeflateCode::huffmanLengths(clCounts, 19, 7, clLengths);
+    DeflateCode::canonicalCodes(clLengths, 19, clCodes);
+
+    static const uint8_t ORDER[19] = {17, 18, 0, 1, 2, 3, 4, 5, 16, 6, 7, 8, 9, 10, 11, 12, 13, 14, 15};
+    int count = 19;
+    while (count > 4 && clLengths[ORDER[count - 1]] == 0) --count;
+
+    out.put(0, 1);  // normal code
+    out.put(static_cast<uint32_t>(count - 4), 4);
+    for (int i = 0; i < count; ++i) {
+        out.put(clLengths[ORDER[i]], 3);
+    }
+    out.put(0, 1);  // lengths are given for the whole alphabet
+    static const int EXTRA_BITS[3] = {2, 3, 7};
+    for (const DeflateCode::LengthToken& token : tokens) {
+        out.put(clCodes[token.symbol]);
+        if (token.symbol >= 16) {
+            out.put(token.extra, EXTRA_BITS[token.symbol - 16]);
+        }
+    }
+}
+
+template <typename Bits>
+void writeCodes(Bits& out, const PrefixCodes& codes) {
+    for (const PrefixCode& code : codes) {
+        writeCode(out, code);
+    }
+}
+
+/**
+ * @brief Codes the pixels and backward references of an entropy-coded image
+ */
+template <typename Bits>
+class EntropyWriter {
+public:
+    EntropyWriter(Bits& out, const PrefixCodes& codes, int cacheBits)
+        : out_(out), codes_(codes), cache_(cacheBits) {}
+
+    void pixel(uint32_t argb) {
+        const int slot = cache_.find(argb);
+        if (slot >= 0) {
+            out_.put(codes_[GREEN].codes[NUM_LITERALS + NUM_LENGTH_CODES + slot]);
+            return;
+        }
+        cache_.insert(argb);
+        out_.put(codes_[GREEN].codes[(argb >> 8) & 0xFF]);
+        out_.put(codes_[RED].codes[(argb >> 16) & 0xFF]);
+        out_.put(codes_[BLUE].codes[argb & 0xFF]);
+        out_.put(codes_[ALPHA].codes[argb >> 24]);
+    }
+
+    void copy(uint32_t length, uint32_t distance, const uint32_t* pixels) {
+        const Prefix l = prefixOf(length);
+        const Prefix d = prefixOf(distance);
+        out_.put(codes_[GREEN].codes[NUM_LITERALS + l.symbol]);
+        out_.put(l.extra, l.extraBits);
+        out_.put(codes_[DISTANCE].codes[d.symbol]);
+        out_.put(d.extra, d.extraBits);
+        if (pixels) {
+            cache_.insert(pixels, length);
+        }
+    }
+
+private:
+    Bits& out_;
+    const PrefixCodes& codes_;
+    ColorCache cache_;
+};
+
+/**
+ * @brief Turns rows of coded pixels into pixels and backward references for
+ *        @p Out (Histogram, Candidates or EntropyWriter)
+ *
+ * A span is copied when at least MIN_COPY pixels repeat the pixel before
+ * them or match the row above, whichever covers more.
+ */
+template <typename Out>
+class Tokenizer {
+public:
+    Tokenizer(Out& out, uint32_t width) : out_(out), width_(width), above_(width) {}
+
+    void row(const uint32_t* pixels) {
+        const uint32_t* above = first_ ? nullptr : above_.data();
+        for (uint32_t x = 0; x < width_;) {
+            const uint32_t limit = std::min(width_ - x, MAX_COPY);
+            const uint32_t up = above ? matchLength(pixels + x, above + x, limit) : 0;
+            uint32_t run = 0;
+            if (up < limit && (x > 0 || above)) {
+                run = runLength(pixels + x, x > 0 ? pixels[x - 1] : above[width_ - 1], limit);
+            }
+
+            const uint32_t length = std::max(up, run);
+            if (length >= MIN_COPY) {
+                out_.copy(length, distanceCode(up >= run ? width_ : 1, width_), pixels + x);
+                x += length;
+            } else {
+                out_.pixel(pixels[x]);
+                ++x;
+            }
+        }
+        std::copy(pixels, pixels + width_, above_.begin());
+        first_ = false;
+    }
+
+    /**
+     * @brief @p rows more copies of the last row
+     */
+    void repeat(uint64_t rows) {
+        // Copying the last row inserts its pixels into the color cache in
+        // the same order as coding it did, which leaves the cache unchanged
+        for (uint64_t left = rows * width_; left > 0;) {
+            const uint32_t length = static_cast<uint32_t>(std::min<uint64_t>(left, MAX_COPY));
+            out_.copy(length, distanceCode(width_, width_), nullptr);
+            left -= length;
+        }
+    }
+
+private:
+    Out& out_;
+    uint32_t width_;
+    std::vector<uint32_t> above_;
+    bool first_ = true;
+};
+
+/**
+ * @brief Palette indices of the distinct rows of a source with at most 256 colors
+ */
+struct IndexedImage {
+    std::vector<uint32_t> colors;   ///< ARGB, in order of appearance
+    std::vector<uint8_t> indices;   ///< One row of indices per entry of repeats
+    std::vector<uint32_t> repeats;  ///< Copies following each stored row
+};
+
+/**
+ * @brief Read @p source once, stopping with false at a 257th color
+ */
+bool indexColors(const RowSource& source, IndexedImage& image) {
+    const uint32_t width = source.width();
+    const uint32_t height = source.height();
+    const int channels = source.channels();
+    const size_t rowBytes = static_cast<size_t>(source.rowBytes());
+    const uint32_t batchRows = static_cast<uint32_t>(
+        std::max<size_t>(1, std::min<size_t>(height, WebPWriter::READ_BYTES / rowBytes)));
+    std::vector<uint8_t> scratch(static_cast<size_t>(batchRows) * rowBytes);
+
+    std::unordered_map<uint32_t, uint8_t> palette;
+    for (uint32_t y = 0; y < height;) {
+        if (const uint32_t repeated = y == 0 ? 0 : std::min(source.repeatedRows(y), height - y)) {
+            image.repeats.back() += repeated;
+            y += repeated;
+            continue;
+        }
+        uint32_t count = std::min(batchRows, height - y);
+        const uint8_t* rows = source.rows(y, count, scratch.data());
+        for (uint32_t i = 1; i < count; ++i) {
+            if (source.repeatedRows(y + i) > 0) {
+                count = i;
+                break;
+            }
+        }
+
+        const size_t start = image.indices.size();
+        image.indices.resize(start + static_cast<size_t>(count) * width);
+        uint8_t* out = image.indices.data() + start;
+        uint32_t last = ~loadARGB(rows, channels);  // differs from the first pixel
+        uint8_t lastIndex = 0;
+        for (size_t i = 0; i < static_cast<size_t>(count) * width; ++i) {
+            const uint32_t argb = loadARGB(rows + i * channels, channels);
+            if (argb != last) {
+                auto it = palette.find(argb);
+                if (it == palette.end()) {
+                    if (image.colors.size() == 256) {
+                        return false;
+                    }
+                    it = palette.emplace(argb, static_cast<uint8_t>(image.colors.size())).first;
+                    image.colors.push_back(argb);
+                }
+                last = argb;
+                lastIndex = it->second;
+            }
+            out[i] = lastIndex;
+        }
+        image.repeats.insert(image.repeats.end(), count, 0);
+        y += count;
+    }
+    return true;
+}
+
+/**
+ * @brief VP8L header: signature, dimensions, alpha hint and version
+ */
+template <typename Bits>
+void writeImageHeader(Bits& out, uint32_t width, uint32_t height, bool alpha) {
+    out.put(VP8L_SIGNATURE, 8);
+    out.put(width - 1, 14);
+    out.put(height - 1, 14);
+    out.put(alpha ? 1 : 0, 1);
+    out.put(0, 3);  // version
+}
+
+/**
+ * @brief Write a RIFF file around one VP8L chunk
+ *
+ * @p header writes everything up to the pixel data of the main image,
+ * and is called twice: once to count its bits, which with @p dataBits
+ * give the chunk size, then into the file. @p data writes the pixel data.
+ */
+template <typename Sink, typename Header, typename Data>
+void writeFile(Sink& sink, uint64_t dataBits, Header header, Data data) {
+    CountingSink counter;
+    BitWriter<CountingSink> probe(counter);
+    header(probe);
+    const uint64_t chunkBytes = (probe.bits() + dataBits + 7) / 8;
+    if (chunkBytes > 0xFFFFFFFFu - 20) {
+        throw std::runtime_error("WebP image exceeds the 4 GiB RIFF limit");
+    }
+
+    uint8_t riff[20] = {'R', 'I', 'F', 'F', 0, 0, 0, 0, 'W', 'E', 'B', 'P', 'V', 'P', '8', 'L'};
+    putU32LE(riff + 4, static_cast<uint32_t>(4 + 8 + chunkBytes + (chunkBytes & 1)));
+    putU32LE(riff + 16, static_cast<uint32_t>(chunkBytes));
+    sink.write(riff, sizeof(riff));
+
+    BitWriter<Sink> bits(sink);
+    header(bits);
+    data(bits);
+    bits.finish();
+    if (chunkBytes & 1) {
+        const uint8_t pad = 0;
+        sink.write(&pad, 1);
+    }
+    sink.finish();
+}
+
+/**
+ * @brief Prefix codes of an image of one color: each has a single symbol, so there is no pixel data
+ */
+template <typename Bits>
+void writeUniformCodes(Bits& out, uint32_t argb) {
+    Histogram histogram(0);
+    histogram.pixel(argb);
+    writeCodes(out, buildCodes(histogram));
+}
+
+template <typename Sink>
+void encodeUniform(Sink& sink, uint32_t argb, uint32_t width, uint32_t height) {
+    writeFile(sink, 0, [&](auto& out) {
+        writeImageHeader(out, width, height, argb >> 24 != 0xFF);
+        out.put(0, 1);  // no transform
+        out.put(0, 1);  // no color cache
+        out.put(0, 1);  // no meta prefix codes
+        writeUniformCodes(out, argb);
+    }, [](auto&) {});
+}
+
+/**
+ * @brief Bits of the VP8L stream up to the pixel data, as written by @p header
+ */
+template <typename Header>
+uint64_t headerBits(Header header) {
+    CountingSink counter;
+    BitWriter<CountingSink> probe(counter);
+    header(probe);
+    return probe.bits();
+}
+
+/**
+ * @brief Up to 256 colors: color indexing transform, pixels bundled when the palette is small
+ *
+ * The constructor counts the symbols; write() codes them.
+ */
+class IndexedEncoder {
+public:
+    IndexedEncoder(const IndexedImage& image, uint32_t width, uint32_t height)
+        : image_(image), width_(width), height_(height), histogram_(0) {
+        // Sorted colors delta-code into small values
+        colors_ = image.colors;
+        std::sort(colors_.begin(), colors_.end());
+        for (size_t i = 0; i < image.colors.size(); ++i) {
+            remap_[i] = static_cast<uint8_t>(
+                std::lower_bound(colors_.begin(), colors_.end(), image.colors[i]) - colors_.begin());
+        }
+        alpha_ = std::any_of(colors_.begin(), colors_.end(), [](uint32_t c) { return c >> 24 != 0xFF; });
+
+        // Each palette entry is coded as its difference from the previous one
+        Histogram paletteHistogram(0);
+        for (size_t i = 0; i < colors_.size(); ++i) {
+            deltas_.push_back(subPixels(colors_[i], i > 0 ? colors_[i - 1] : 0));
+            paletteHistogram.pixel(deltas_.back());
+        }
+        paletteCodes_ = buildCodes(paletteHistogram);
+
+        // 8, 4 or 2 indices per coded pixel for palettes of up to 2, 4 or 16 colors
+        const size_t size = colors_.size();
+        widthBits_ = size <= 2 ? 3 : size <= 4 ? 2 : size <= 16 ? 1 : 0;
+        xsize_ = (width + (1u << widthBits_) - 1) >> widthBits_;
+
+        tokenize(histogram_);
+        codes_ = buildCodes(histogram_);
+    }
+
+    uint64_t bits() const {
+        return headerBits([&](auto& out) { writeHeader(out); }) + dataBits(histogram_, codes_);
+    }
+
+    template <typename Sink>
+    void write(Sink& sink) const {
+        writeFile(sink, dataBits(histogram_, codes_), [&](auto& out) { writeHeader(out); }, [&](auto& out) {
+            EntropyWriter<std::remove_reference_t<decltype(out)>> writer(out, codes_, 0);
+            tokenize(writer);
+        });
+    }
+
+private:
+    template <typename Out>
+    void tokenize(Out& out) const {
+        const int indexBits = 8 >> widthBits_;
+        std::vector<uint32_t> row(xsize_);
+        Tokenizer<Out> tokens(out, xsize_);
+        for (size_t r = 0; r < image_.repeats.size(); ++r) {
+            const uint8_t* indices = image_.indices.data() + r * width_;
+            std::fill(row.begin(), row.end(), 0xFF000000u);
+            for (uint32_t x = 0; x < width_; ++x) {
+                row[x >> widthBits_] |= static_cast<uint32_t>(remap_[indices[x]])
+                                        << (8 + (x & ((1u << widthBits_) - 1)) * indexBits);
+            }
+            tokens.row(row.data());
+            if (image_.repeats[r] > 0) {
+                tokens.repeat(image_.repeats[r]);
+            }
+        }
+    }
+
+    template <typename Bits>
+    void writeHeader(Bits& out) const {
+        writeImageHeader(out, width_, height_, alpha_);
+        out.put(1, 1);  // transform present
+        out.put(COLOR_INDEXING_TRANSFORM, 2);
+        out.put(static_cast<uint32_t>(colors_.size() - 1), 8);
+        out.put(0, 1);  // palette image: no color cache
+        writeCodes(out, paletteCodes_);
+        EntropyWriter<Bits> palette(out, paletteCodes_, 0);
+        for (uint32_t delta : deltas_) {
+            palette.pixel(delta);
+        }
+        out.put(0, 1);  // no more transforms
+        out.put(0, 1);  // no color cache
+        out.put(0, 1);  // no meta prefix codes
+        writeCodes(out, codes_);
+    }
+
+    const IndexedImage& image_;
+    uint32_t width_;
+    uint32_t height_;
+    std::vector<uint32_t> colors_;
+    uint8_t remap_[256] = {};
+    bool alpha_ = false;
+    std::vector<uint32_t> deltas_;
+    PrefixCodes paletteCodes_;
+    int widthBits_ = 0;
+    uint32_t xsize_ = 0;
+    Histogram histogram_;
+    PrefixCodes codes_;
+};
+
+/**
+ * @brief Any image: subtract green and predictor transforms, then ARGB
+ *        residuals with the color cache size that codes smallest
+ *
+ * The constructor reads the source and counts the symbols for every cache
+ * size; write() reads it again and codes them.
+ */
+class ARGBEncoder {
+public:
+    explicit ARGBEncoder(const RowSource& source) : source_(source) {
+        Candidates candidates;
+        for (int bits : CACHE_BITS) {
+            candidates.histograms.emplace_back(bits);
+        }
+        tokenize(candidates);
+
+        uint64_t bestBits = 0;
+        for (Histogram& histogram : candidates.histograms) {
+            PrefixCodes codes = buildCodes(histogram);
+            const uint64_t bits = headerBits([&](auto& out) { writeCodes(out, codes); }) + dataBits(histogram, codes);
+            if (!histogram_ || bits < bestBits) {
+                histogram_ = std::make_unique<Histogram>(std::move(histogram));
+                codes_ = std::move(codes);
+                bestBits = bits;
+            }
+        }
+    }
+
+    uint64_t bits() const {
+        return headerBits([&](auto& out) { writeHeader(out); }) + dataBits(*histogram_, codes_);
+    }
+
+    template <typename Sink>
+    void write(Sink& sink) {
+        writeFile(sink, dataBits(*histogram_, codes_), [&](auto& out) { writeHeader(out); }, [&](auto& out) {
+            EntropyWriter<std::remove_reference_t<decltype(out)>> writer(out, codes_, histogram_->cacheBits);
+            tokenize(writer);
+        });
+    }
+
+private:
+    template <typename Out>
+    void tokenize(Out& out) {
+        const uint32_t width = source_.width();
+        const uint32_t height = source_.height();
+        const int channels = source_.channels();
+        const size_t rowBytes = static_cast<size_t>(source_.rowBytes());
+        const uint32_t batchRows = static_cast<uint32_t>(
+            std::max<size_t>(1, std::min<size_t>(height, WebPWriter::READ_BYTES / rowBytes)));
+        std::vector<uint8_t> scratch(static_cast<size_t>(batchRows) * rowBytes);
+        std::vector<uint32_t> row(width);
+        std::vector<uint32_t> above(width);
+        std::vector<uint32_t> residuals(width);
+
+        Tokenizer<Out> tokens(out, width);
+        for (uint32_t y = 0; y < height;) {
+            if (const uint32_t repeated = y == 0 ? 0 : std::min(source_.repeatedRows(y), height - y)) {
+                // A row equal to the one above predicts exactly; later copies repeat the zeros
+                std::fill(residuals.begin(), residuals.end(), 0);
+                tokens.row(residuals.data());
+                if (repeated > 1) {
+                    tokens.repeat(repeated - 1);
+                }
+                y += repeated;
+                continue;
+            }
+            uint32_t count = std::min(batchRows, height - y);
+            const uint8_t* rows = source_.rows(y, count, scratch.data());
+            for (uint32_t i = 1; i < count; ++i) {
+                if (source_.repeatedRows(y + i) > 0) {
+                    count = i;
+                    break;
+                }
+            }
+            for (uint32_t r = 0; r < count; ++r) {
+                alpha_ |= loadRow(rows + r * rowBytes, width, channels, row.data());
+                predictRow(row.data(), y + r == 0 ? nullptr : above.data(), width, residuals.data());
+                tokens.row(residuals.data());
+                row.swap(above);
+            }
+            y += count;
+        }
+    }
+
+    template <typename Bits>
+    void writeHeader(Bits& out) const {
+        writeImageHeader(out, source_.width(), source_.height(), alpha_);
+        out.put(1, 1);  // transform present
+        out.put(SUBTRACT_GREEN_TRANSFORM, 2);
+        out.put(1, 1);  // transform present
+        out.put(PREDICTOR_TRANSFORM, 2);
+        out.put(PREDICTOR_BLOCK_BITS - 2, 3);
+        out.put(0, 1);  // predictor image: no color cache
+        writeUniformCodes(out, 0xFF000000u | PREDICTOR_CLAMPED_GRADIENT << 8);
+        out.put(0, 1);  // no more transforms
+        const int cacheBits = histogram_->cacheBits;
+        out.put(cacheBits > 0 ? 1 : 0, 1);
+        if (cacheBits > 0) {
+            out.put(static_cast<uint32_t>(cacheBits), 4);
+        }
+        out.put(0, 1);  // no meta prefix codes
+        writeCodes(out, codes_);
+    }
+
+    const RowSource& source_;
+    bool alpha_ = false;
+    std::unique_ptr<Histogram> histogram_;
+    PrefixCodes codes_;
+};
+
+void checkDimensions(uint32_t width, uint32_t height) {
+    if (width == 0 || height == 0 || width > MAX_DIMENSION || height > MAX_DIMENSION) {
+        throw std::invalid_argument("WebP dimensions must be 1 to 16384 pixels");
+    }
+}
+
+} // namespace
+
+bool WebPWriter::write(const std::string& filename,
+                       const Color& color,
+                       const Resolution& resolution) {
+    checkDimensions(resolution.getWidth(), resolution.getHeight());
+    FileSink sink(filename);
+    encodeUniform(sink, colorARGB(color), resolution.getWidth(), resolution.getHeight());
+    return true;
+}
+
+bool WebPWriter::write(const std::string& filename, const RowSource& source) {
+    checkDimensions(source.width(), source.height());
+    const int channels = source.channels();
+    if (channels < 1 || channels > 4) {
+        throw std::invalid_argument("WebP channel count must be 1 to 4");
+    }
+
+    IndexedImage image;
+    const bool indexed = indexColors(source, image);
+    FileSink sink(filename);
+    if (indexed && image.colors.size() == 1) {
+        encodeUniform(sink, image.colors[0], source.width(), source.height());
+        return true;
+    }
+    if (!indexed) {
+        image = IndexedImage{};  // release the partial scan
+        ARGBEncoder(source).write(sink);
+        return true;
+    }
+
+    // Small palettes bundle pixels and always win; with larger ones, prediction often codes smaller
+    IndexedEncoder indexedEncoder(image, source.width(), source.height());
+    if (image.colors.size() > 16) {
+        ARGBEncoder argbEncoder(source);
+        if (argbEncoder.bits() < indexedEncoder.bits()) {
+            argbEncoder.write(sink);
+            return true;
+        }
+    }
+    indexedEncoder.write(sink);
+    return true;
+}
+
+uint64_t WebPWriter::encodedSize(const Color& color, const Resolution& resolution) {
+    checkDimensions(resolution.getWidth(), resolution.getHeight());
+    CountingSink sink;
+    encodeUniform(sink, colorARGB(color), resolution.getWidth(), resolution.getHeight());
+    return sink.size;
+}
+
+} // namespace ColorGenerator
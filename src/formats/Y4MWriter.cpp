@@ -0,0 +1,371 @@
+#include "../../include/formats/Y4MWriter.hpp"
+#include "../../include/formats/JPEGColor.hpp"
+#include "../../include/Fade.hpp"
+#include <algorithm>
+#include <cerrno>
+#include <cstdio>
+#include <cstring>
+#include <stdexcept>
+
+#include <fcntl.h>
+#include <sys/stat.h>
+
+#ifdef _WIN32
+    #include <io.h>
+#else
+    #include <sys/uio.h>
+    #include <unistd.h>
+#endif
+
+namespace ColorGenerator {
+
+namespace {
+
+/**
+ * @brief Plane sizes of one frame
+ */
+struct FrameLayout {
+    uint32_t width;
+    uint32_t height;
+    uint32_t chromaWidth;
+    uint32_t chromaHeight;
+
+    FrameLayout(const Resolution& resolution, Y4MWriter::Chroma chroma)
+        : width(resolution.getWidth()), height(resolution.getHeight()) {
+        const bool subsampled = chroma == Y4MWriter::Chroma::YUV420;
+        chromaWidth = subsampled ? (width + 1) / 2 : width;
+        chromaHeight = subsampled ? (height + 1) / 2 : height;
+    }
+
+    size_t lumaBytes() const { return static_cast<size_t>(width) * height; }
+    size_t chromaBytes() const { return static_cast<size_t>(chromaWidth) * chromaHeight; }
+    size_t frameBytes() const { return lumaBytes() + 2 * chromaBytes(); }
+};
+
+const JPEG::ColorMatrix& colorMatrix(Y4MWriter::Matrix matrix) {
+    return matrix == Y4MWriter::Matrix::BT601 ? JPEG::BT601_LIMITED : JPEG::BT709_LIMITED;
+}
+
+JPEG::Subsampling subsampling(Y4MWriter::Chroma chroma) {
+    return chroma == Y4MWriter::Chroma::YUV420 ? JPEG::Subsampling::YUV420 : JPEG::Subsampling::YUV444;
+}
+
+std::string streamHeader(const FrameLayout& layout, const Y4MWriter::Options& options) {
+    return "YUV4MPEG2 W" + std::to_string(layout.width) + " H" + std::to_string(layout.height) +
+           " F" + std::to_string(options.frameRateNum) + ":" + std::to_string(options.frameRateDen) +
+           " Ip A1:1 " + (options.chroma == Y4MWriter::Chroma::YUV420 ? "C420jpeg" : "C444") +
+           " XCOLORRANGE=LIMITED\n";
+}
+
+const char FRAME_HEADER[] = "FRAME\n";
+constexpr size_t FRAME_HEADER_BYTES = sizeof(FRAME_HEADER) - 1;
+
+/**
+ * @brief Y, Cb and Cr of @p color, as a frame filled with it would convert
+ */
+void convertColor(const Color& color, const Y4MWriter::Options& options, uint8_t yuv[3]) {
+    const uint8_t pixels[6] = {color.getRed(), color.getGreen(), color.getBlue(),
+                               color.getRed(), color.getGreen(), color.getBlue()};
+    uint8_t luma[4];
+    uint8_t cb[2];
+    uint8_t cr[2];
+    JPEG::convertRows(pixels, pixels, 2, 3, subsampling(options.chroma), colorMatrix(options.matrix), 2,
+                      luma, luma + 2, cb, cr);
+    yuv[0] = luma[0];
+    yuv[1] = cb[0];
+    yuv[2] = cr[0];
+}
+
+/**
+ * @brief Unbuffered output that gathers queued buffers into vectored writes
+ *
+ * Queued buffers are referenced, not copied: they must stay unchanged
+ * until the next flush().
+ */
+class VideoOutput {
+public:
+    /**
+     * @param filename Output path, or "-" for standard output
+     * @throws std::runtime_error if the file cannot be created
+     */
+    explicit VideoOutput(const std::string& filename) : filename_(filename) {
+        if (filename == "-") {
+#ifdef _WIN32
+            _setmode(_fileno(stdout), _O_BINARY);
+#endif
+            fd_ = 1;
+            return;
+        }
+#ifdef _WIN32
+        fd_ = ::_open(filename.c_str(), _O_WRONLY | _O_CREAT | _O_TRUNC | _O_BINARY, _S_IREAD | _S_IWRITE);
+#else
+        fd_ = ::open(filename.c_str(), O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+#endif
+        if (fd_ < 0) {
+            throw std::runtime_error("Failed to open output file: " + filename + " (" + std::strerror(errno) + ")");
+        }
+        owned_ = true;
+    }
+
+    ~VideoOutput() {
+        if (owned_) {
+#ifdef _WIN32
+            ::_close(fd_);
+#else
+            ::close(fd_);
+#endif
+        }
+    }
+
+    VideoOutput(const VideoOutput&) = delete;
+    VideoOutput& operator=(const VideoOutput&) = delete;
+
+    void queue(const uint8_t* data, size_t size) {
+        if (size == 0) {
+            return;
+        }
+        if (pending_.size() == MAX_BUFFERS) {
+            flush();
+        }
+        pending_.push_back({data, size});
+    }
+
+    void flush() {
+#ifdef _WIN32
+        for (const Buffer& buffer : pending_) {
+            const uint8_t* data = buffer.data;
+            size_t size = buffer.size;
+            while (size > 0) {
+                const int n = ::_write(fd_, data, static_cast<unsigned>(std::min<size_t>(size, 1u << 30)));
+                if (n <= 0) {
+                    fail();
+                }
+                data += n;
+                size -= static_cast<size_t>(n);
+            }
+        }
+#else
+        std::vector<iovec> iov(pending_.size());
+        for (size_t i = 0; i < pending_.size(); ++i) {
+            iov[i].iov_base = const_cast<uint8_t*>(pending_[i].data);
+            iov[i].iov_len = pending_[i].size;
+        }
+        iovec* next = iov.data();
+        int count = static_cast<int>(iov.size());
+        while (count > 0) {
+            ssize_t n = ::writev(fd_, next, count);
+            if (n < 0 && errno == EINTR) continue;
+            if (n <= 0) {
+                fail();
+            }
+            // Skip what was written, resuming mid-buffer after a short write
+            while (count > 0 && static_cast<size_t>(n) >= next->iov_len) {
+                n -= static_cast<ssize_t>(next->iov_len);
+                ++next;
+                --count;
+            }
+            if (count > 0) {
+                next->iov_base = static_cast<uint8_t*>(next->iov_base) + n;
+                next->iov_len -= static_cast<size_t>(n);
+            }
+        }
+#endif
+        pending_.clear();
+    }
+
+    /**
+     * @throws std::runtime_error if any write failed
+     */
+    void finish() {
+        flush();
+        if (owned_) {
+            owned_ = false;
+#ifdef _WIN32
+            const int rc = ::_close(fd_);
+#else
+            const int rc = ::close(fd_);
+#endif
+            if (rc != 0) {
+                fail();
+            }
+        }
+    }
+
+private:
+    struct Buffer {
+        const uint8_t* data;
+        size_t size;
+    };
+
+    /// Below IOV_MAX (1024 on Linux and macOS)
+    static constexpr size_t MAX_BUFFERS = 2 * Y4MWriter::FRAMES_PER_WRITE;
+
+    [[noreturn]] void fail() {
+        throw std::runtime_error("Failed to write video file: " + filename_ + " (" + std::strerror(errno) + ")");
+    }
+
+    std::string filename_;
+    int fd_ = -1;
+    bool owned_ = false;
+    std::vector<Buffer> pending_;
+};
+
+/**
+ * @brief One converted frame and the output it is written to
+ */
+class FrameWriter {
+public:
+    FrameWriter(const std::string& filename, const Resolution& resolution,
+                const Y4MWriter::Options& options, bool headerless)
+        : layout_(resolution, options.chroma), headerless_(headerless), out_(filename),
+          planes_(layout_.frameBytes()) {
+        if (!headerless_) {
+            header_ = streamHeader(layout_, options);
+            out_.queue(reinterpret_cast<const uint8_t*>(header_.data()), header_.size());
+        }
+    }
+
+    const FrameLayout& layout() const { return layout_; }
+
+    /**
+     * @brief The planes, Y then Cb then Cr, to be filled before emit()
+     *
+     * Flushes first: frames already queued may still reference them.
+     */
+    uint8_t* planes() {
+        out_.flush();
+        return planes_.data();
+    }
+
+    /**
+     * @brief Queue @p count more frames of the current planes
+     */
+    void emit(uint64_t count) {
+        for (; count > 0; --count) {
+            if (!headerless_) {
+                out_.queue(reinterpret_cast<const uint8_t*>(FRAME_HEADER), FRAME_HEADER_BYTES);
+            }
+            out_.queue(planes_.data(), planes_.size());
+        }
+    }
+
+    void finish() { out_.finish(); }
+
+private:
+    FrameLayout layout_;
+    bool headerless_;
+    std::string header_;
+    VideoOutput out_;
+    std::vector<uint8_t> planes_;
+};
+
+/**
+ * @brief Fill @p planes with a single color
+ */
+void fillPlanes(const FrameLayout& layout, const uint8_t yuv[3], uint8_t* planes) {
+    std::memset(planes, yuv[0], layout.lumaBytes());
+    std::memset(planes + layout.lumaBytes(), yuv[1], layout.chromaBytes());
+    std::memset(planes + layout.lumaBytes() + layout.chromaBytes(), yuv[2], layout.chromaBytes());
+}
+
+} // namespace
+
+void Y4MWriter::setOptions(const Options& options) {
+    if (options.frames == 0) {
+        throw std::invalid_argument("Frame count must be at least 1");
+    }
+    if (options.frameRateNum == 0 || options.frameRateDen == 0) {
+        throw std::invalid_argument("Frame rate must be positive");
+    }
+    options_ = options;
+}
+
+bool Y4MWriter::write(const std::string& filename,
+                      const Color& color,
+                      const Resolution& resolution) {
+    return writeFade(filename, {{color, 0.0f}, {color, 1.0f}}, resolution);
+}
+
+bool Y4MWriter::write(const std::string& filename, const RowSource& source) {
+    const Resolution resolution(source.width(), source.height());
+    FrameWriter writer(filename, resolution, options_, headerless_);
+    const FrameLayout& layout = writer.layout();
+    const JPEG::Subsampling mode = subsampling(options_.chroma);
+    const JPEG::ColorMatrix& matrix = colorMatrix(options_.matrix);
+    const bool vertical = options_.chroma == Chroma::YUV420;
+
+    // Luma is converted into padded rows, chroma straight into its planes
+    const size_t planeWidth = vertical ? static_cast<size_t>(layout.chromaWidth) * 2 : layout.width;
+    std::vector<uint8_t> luma(planeWidth * 2);
+
+    const size_t rowBytes = static_cast<size_t>(source.rowBytes());
+    const uint32_t batchRows = static_cast<uint32_t>(
+        std::max<size_t>(2, READ_BYTES / std::max<size_t>(rowBytes, 1)) & ~static_cast<size_t>(1));
+    std::vector<uint8_t> scratch(static_cast<size_t>(batchRows) * rowBytes);
+
+    uint8_t* planes = writer.planes();
+    uint8_t* yPlane = planes;
+    uint8_t* cbPlane = planes + layout.lumaBytes();
+    uint8_t* crPlane = cbPlane + layout.chromaBytes();
+    const uint32_t step = vertical ? 2 : 1;
+
+    for (uint32_t y0 = 0; y0 < layout.height; y0 += batchRows) {
+        const uint32_t count = std::min(batchRows, layout.height - y0);
+        const uint8_t* rows = source.rows(y0, count, scratch.data());
+        for (uint32_t i = 0; i < count; i += step) {
+            const uint32_t y = y0 + i;
+            const uint8_t* row0 = rows + i * rowBytes;
+            const uint8_t* row1 = i + 1 < count ? row0 + rowBytes : row0;  // Odd height repeats the last row
+            const size_t chromaRow = static_cast<size_t>(y / step) * layout.chromaWidth;
+            JPEG::convertRows(row0, row1, layout.width, source.channels(), mode, matrix, planeWidth,
+                              luma.data(), luma.data() + planeWidth, cbPlane + chromaRow, crPlane + chromaRow);
+            std::memcpy(yPlane + static_cast<size_t>(y) * layout.width, luma.data(), layout.width);
+            if (vertical && y + 1 < layout.height) {
+                std::memcpy(yPlane + static_cast<size_t>(y + 1) * layout.width, luma.data() + planeWidth,
+                            layout.width);
+            }
+        }
+    }
+
+    writer.emit(options_.frames);
+    writer.finish();
+    return true;
+}
+
+bool Y4MWriter::writeFade(const std::string& filename, const std::vector<GradientStop>& stops,
+                          const Resolution& resolution) {
+    const Fade fade(stops, options_.frames);
+    FrameWriter writer(filename, resolution, options_, headerless_);
+    uint8_t current[3] = {};
+    uint64_t run = 0;
+
+    for (uint32_t frame = 0; frame < fade.frames(); ++frame) {
+        uint8_t yuv[3];
+        convertColor(fade.color(frame), options_, yuv);
+
+        // Runs of identical frames share one conversion and one set of planes
+        if (run > 0 && std::equal(yuv, yuv + 3, current)) {
+            ++run;
+            continue;
+        }
+        writer.emit(run);
+        fillPlanes(writer.layout(), yuv, writer.planes());
+        std::copy(yuv, yuv + 3, current);
+        run = 1;
+    }
+
+    writer.emit(run);
+    writer.finish();
+    return true;
+}
+
+uint64_t Y4MWriter::encodedSize(const Resolution& resolution) const {
+    const FrameLayout layout(resolution, options_.chroma);
+    if (headerless_) {
+        return static_cast<uint64_t>(options_.frames) * layout.frameBytes();
+    }
+    return streamHeader(layout, options_).size() +
+           static_cast<uint64_t>(options_.frames) * (FRAME_HEADER_BYTES + layout.frameBytes());
+}
+
+} // namespace ColorGenerator
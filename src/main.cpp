@@ -1,7 +1,19 @@
 #include "../include/Color.hpp"
 #include "../include/Resolution.hpp"
 #include "../include/ImageWriter.hpp"
+#include "../include/ImageCache.hpp"
+#include "../include/BatchProcessor.hpp"
+#include "../include/ImageServer.hpp"
+#include "../include/SizeBudget.hpp"
+#include "../include/Gradient.hpp"
+#include "../include/Noise.hpp"
+#include "../include/TestPattern.hpp"
 #include "../include/formats/STBImageWriter.hpp"
+#include "../include/formats/Y4MWriter.hpp"
+#include "../include/formats/APNGEncoder.hpp"
+#include "../include/formats/GIFWriter.hpp"
+#include <filesystem>
+#include <iomanip>
 #include <iostream>
 #include <string>
 #include <algorithm>
@@ -24,9 +36,56 @@ void printUsage(const char* programName) {
     std::cout << "  -o, --output <file>      Output file path (extension determines format)\n";
     std::cout << "  -r, --resolution <WxH>   Resolution (e.g., 1920x1080)\n";
     std::cout << "  -a, --auto               Use screen resolution (default)\n";
-    std::cout << "  -f, --format <format>    Output format (png, jpg, bmp)\n";
+    std::cout << "  -o -                     Write .y4m/.yuv video to standard output (needs -f)\n";
+    std::cout << "  -f, --format <format>    Output format (png, jpg, bmp, gif, qoi, webp,\n";
+    std::cout << "                           raw, y4m, yuv)\n";
+    std::cout << "                           gif: 256 colors (dithered beyond), alpha below 128 transparent\n";
+    std::cout << "                           qoi: lossless, much faster to encode and decode than PNG\n";
+    std::cout << "                           webp: lossless; tiny for solid and few-color images\n";
+    std::cout << "                           raw: headerless RGB, or RGBA with transparency\n";
+    std::cout << "                           y4m/yuv: video frames with or without YUV4MPEG2 headers\n";
     std::cout << "                           Note: JPEG does not support transparency\n";
     std::cout << "  -q, --quality <0-100>    JPEG quality (default: 95)\n";
+    std::cout << "  --subsampling <mode>     JPEG chroma subsampling of drawn images: 444, 422 or 420\n";
+    std::cout << "                           (default: 420 at quality 90 and below, else 444)\n";
+    std::cout << "  --dct <float|int>        JPEG forward DCT: float (default) or libjpeg's integer\n";
+    std::cout << "                           DCT, identical on every CPU\n";
+    std::cout << "  --optimize-huffman       Build JPEG Huffman tables for the drawn image and report\n";
+    std::cout << "                           the saving (counted with one more encoding pass)\n";
+    std::cout << "  --huffman-sample <n>     Optimize Huffman tables from every nth MCU row only\n";
+    std::cout << "  -g, --gradient <stops>   Draw a gradient instead of a solid color: comma-separated\n";
+    std::cout << "                           colors, each with an optional @position (0-1 or %)\n";
+    std::cout << "  --gradient-type <type>   linear (default), radial or conic\n";
+    std::cout << "  --angle <degrees>        Linear direction / conic start, clockwise from\n";
+    std::cout << "                           left-to-right (default: 0)\n";
+    std::cout << "  --center <x,y>           Radial/conic center as fractions (default: 0.5,0.5)\n";
+    std::cout << "  --dither <mode>          Gradient dithering: none (default), ordered or blue\n";
+    std::cout << "  --noise <type>           Draw value, perlin or simplex noise tinted with -c\n";
+    std::cout << "  --seed <n>               Noise seed (default: 0)\n";
+    std::cout << "  --noise-scale <px>       Size of the coarsest noise features (default: 64)\n";
+    std::cout << "  --octaves <n>            Noise octaves, each at twice the frequency (1-8, default: 1)\n";
+    std::cout << "  --noise-amount <0-1>     How far noise moves the color towards black/white\n";
+    std::cout << "                           (default: 0.5)\n";
+    std::cout << "  --pattern <type>         Draw a test pattern: bars (SMPTE), checker, stripes,\n";
+    std::cout << "                           hstripes or grid, in -c (default: white) on --background\n";
+    std::cout << "  --cell <px>              Checker cell, stripe width or grid spacing (default: 64)\n";
+    std::cout << "  --line-width <px>        Grid line thickness (default: 1)\n";
+    std::cout << "  --background <color>     Second pattern color (default: #000000)\n";
+    std::cout << "  --frames <n>             Video frames to write (default: 1)\n";
+    std::cout << "  --fps <n[/d]>            Video frame rate (default: 25)\n";
+    std::cout << "  --chroma <420|444>       Video chroma subsampling (default: 420)\n";
+    std::cout << "  --matrix <709|601>       Video YUV matrix, limited range (default: 709)\n";
+    std::cout << "  --fade <stops>           Video or animated PNG/GIF that fades through colors (same syntax as -g)\n";
+    std::cout << "  --loops <n>              Animated PNG/GIF plays n times (default: 0, forever)\n";
+    std::cout << "  --max-bytes <n>          Fail unless the output fits in <n> bytes; JPEG picks\n";
+    std::cout << "                           the highest quality that fits (overrides -q)\n";
+    std::cout << "  --batch <file|->         Generate every job in a CSV/JSONL manifest\n";
+    std::cout << "                           (color,resolution,output[,quality] per line)\n";
+    std::cout << "  --serve <socket>         Serve binary requests on a Unix domain socket\n";
+    std::cout << "  -j, --jobs <n>           Worker threads for --batch/--serve (default: all cores)\n";
+    std::cout << "  --cache-dir <dir>        Reuse previously encoded images from <dir>\n";
+    std::cout << "  --cache-hardlink         Allow cache hits to be hardlinked (read-only)\n";
+    std::cout << "  --cache-stats            Print cache hit ratios and bytes saved\n";
     std::cout << "  -h, --help               Show this help message\n\n";
     std::cout << "Presets:\n";
     std::cout << "  --hd                     1280x720\n";
@@ -39,25 +98,13 @@ void printUsage(const char* programName) {
     std::cout << "  " << programName << " -c \"#00FF00\" -r 800x600 -o green.bmp\n";
     std::cout << "  " << programName << " -c \"#FF573380\" -o semi-transparent.png\n";
     std::cout << "  " << programName << " -c \"#0000FF40\" --fullhd -o blue-25-percent.png\n";
-}
-
-/**
- * @brief Parse resolution string (e.g., "1920x1080")
- */
-Resolution parseResolution(const std::string& str) {
-    size_t xPos = str.find('x');
-    if (xPos == std::string::npos) {
-        xPos = str.find('X');
-    }
-
-    if (xPos == std::string::npos) {
-        throw std::invalid_argument("Invalid resolution format. Use WIDTHxHEIGHT (e.g., 1920x1080)");
-    }
-
-    uint32_t width = std::stoul(str.substr(0, xPos));
-    uint32_t height = std::stoul(str.substr(xPos + 1));
-
-    return Resolution(width, height);
+    std::cout << "  " << programName << " -g \"#FF5733,#3498DB\" --angle 90 --4k -o fade.png\n";
+    std::cout << "  " << programName << " -c #808080 --noise simplex --octaves 5 --seed 7 -o grain.png\n";
+    std::cout << "  " << programName << " --pattern bars --4k -o bars.png\n";
+    std::cout << "  " << programName << " --fade \"#000000,#FF5733,#000000\" --frames 250 --fullhd -o fade.y4m\n";
+    std::cout << "  " << programName << " --fade \"#FF0000,#0000FF\" --frames 60 --fps 30 --fullhd -o fade.apng\n";
+    std::cout << "  " << programName << " -c #3498DB --frames 600 -f y4m -o - | x264 --demuxer y4m -o out.264 -\n";
+    std::cout << "  " << programName << " --batch swatches.csv -j 8\n";
 }
 
 /**
@@ -71,15 +118,62 @@ std::string getFileExtension(const std::string& filename) {
     return "";
 }
 
+/**
+ * @brief Report how much smaller the image-specific Huffman tables made @p outputFile
+ *
+ * The size with the standard tables is counted by encoding @p source
+ * again without writing it. Does nothing unless the tables were optimized.
+ */
+void printHuffmanSaving(std::ostream& status, const IImageFormat& writer, const RowSource& source,
+                        const std::string& outputFile) {
+    const STBImageWriter* stbWriter = dynamic_cast<const STBImageWriter*>(&writer);
+    if (!stbWriter || !stbWriter->getJPEGOptions().optimizeHuffman) {
+        return;
+    }
+    JPEGEncoder::Options standard = stbWriter->getJPEGOptions();
+    standard.optimizeHuffman = false;
+    const uint64_t standardSize = JPEGEncoder::encodedSize(source, standard);
+    const uint64_t size = std::filesystem::file_size(outputFile);
+    const double delta = 100.0 * (static_cast<double>(size) / static_cast<double>(standardSize) - 1.0);
+    status << "Optimized Huffman tables: " << size << " bytes, " << std::fixed << std::setprecision(1)
+           << delta << "% against " << standardSize << " bytes with the standard tables\n";
+}
+
 int main(int argc, char* argv[]) {
     try {
         // Default values
         std::string colorStr = "#000000";  // Black
+        bool colorGiven = false;
         std::string outputFile;
-        Resolution resolution;  // Auto-detected screen resolution by default
+        Resolution resolution = Resolution::FullHD();  // Replaced by screen resolution in auto mode
         bool useAutoResolution = true;
         std::string formatStr;
         int jpegQuality = 95;
+        JPEG::Subsampling jpegSubsampling = JPEG::Subsampling::Auto;
+        JPEG::DCTMethod jpegDCT = JPEG::DCTMethod::Float;
+        bool jpegOptimizeHuffman = false;
+        uint32_t jpegHuffmanSampleStep = 1;
+        bool jpegOptionsGiven = false;
+        uint64_t maxBytes = 0;
+        std::string gradientStops;
+        Gradient::Options gradientOptions;
+        bool gradientOptionsGiven = false;
+        bool useNoise = false;
+        Noise::Options noiseOptions;
+        bool usePattern = false;
+        TestPattern::Options patternOptions;
+        Y4MWriter::Options videoOptions;
+        bool videoOptionsGiven = false;
+        bool yuvOptionsGiven = false;
+        uint32_t loops = 0;
+        bool loopsGiven = false;
+        std::string fadeStops;
+        std::string cacheDir;
+        bool cacheHardlink = false;
+        bool cacheStats = false;
+        std::string batchManifest;
+        std::string serveSocket;
+        size_t batchThreads = 0;
 
         // Parse command line arguments
         for (int i = 1; i < argc; ++i) {
@@ -92,6 +186,7 @@ int main(int argc, char* argv[]) {
             else if (arg == "-c" || arg == "--color") {
                 if (i + 1 < argc) {
                     colorStr = argv[++i];
+                    colorGiven = true;
                 } else {
                     throw std::invalid_argument("Missing color value");
                 }
@@ -105,7 +200,7 @@ int main(int argc, char* argv[]) {
             }
             else if (arg == "-r" || arg == "--resolution") {
                 if (i + 1 < argc) {
-                    resolution = parseResolution(argv[++i]);
+                    resolution = Resolution::parse(argv[++i]);
                     useAutoResolution = false;
                 } else {
                     throw std::invalid_argument("Missing resolution value");
@@ -128,6 +223,280 @@ int main(int argc, char* argv[]) {
                     throw std::invalid_argument("Missing quality value");
                 }
             }
+            else if (arg == "--subsampling") {
+                if (i + 1 < argc) {
+                    std::string subsampling = argv[++i];
+                    if (subsampling == "444") {
+                        jpegSubsampling = JPEG::Subsampling::YUV444;
+                    } else if (subsampling == "422") {
+                        jpegSubsampling = JPEG::Subsampling::YUV422;
+                    } else if (subsampling == "420") {
+                        jpegSubsampling = JPEG::Subsampling::YUV420;
+                    } else {
+                        throw std::invalid_argument("Subsampling must be 444, 422 or 420");
+                    }
+                    jpegOptionsGiven = true;
+                } else {
+                    throw std::invalid_argument("Missing chroma subsampling");
+                }
+            }
+            else if (arg == "--dct") {
+                if (i + 1 < argc) {
+                    std::string dct = argv[++i];
+                    if (dct == "float") {
+                        jpegDCT = JPEG::DCTMethod::Float;
+                    } else if (dct == "int") {
+                        jpegDCT = JPEG::DCTMethod::Integer;
+                    } else {
+                        throw std::invalid_argument("DCT must be float or int");
+                    }
+                    jpegOptionsGiven = true;
+                } else {
+                    throw std::invalid_argument("Missing DCT method");
+                }
+            }
+            else if (arg == "--optimize-huffman") {
+                jpegOptimizeHuffman = true;
+                jpegOptionsGiven = true;
+            }
+            else if (arg == "--huffman-sample") {
+                if (i + 1 < argc) {
+                    int step = std::stoi(argv[++i]);
+                    if (step < 1) {
+                        throw std::invalid_argument("Huffman sample step must be at least 1");
+                    }
+                    jpegHuffmanSampleStep = static_cast<uint32_t>(step);
+                    jpegOptimizeHuffman = true;
+                    jpegOptionsGiven = true;
+                } else {
+                    throw std::invalid_argument("Missing Huffman sample step");
+                }
+            }
+            else if (arg == "-g" || arg == "--gradient") {
+                if (i + 1 < argc) {
+                    gradientStops = argv[++i];
+                } else {
+                    throw std::invalid_argument("Missing gradient stops");
+                }
+            }
+            else if (arg == "--gradient-type") {
+                if (i + 1 < argc) {
+                    gradientOptions.shape = Gradient::parseShape(argv[++i]);
+                    gradientOptionsGiven = true;
+                } else {
+                    throw std::invalid_argument("Missing gradient type");
+                }
+            }
+            else if (arg == "--angle") {
+                if (i + 1 < argc) {
+                    gradientOptions.angle = std::stof(argv[++i]);
+                    gradientOptionsGiven = true;
+                } else {
+                    throw std::invalid_argument("Missing angle value");
+                }
+            }
+            else if (arg == "--center") {
+                if (i + 1 < argc) {
+                    std::string center = argv[++i];
+                    size_t comma = center.find(',');
+                    if (comma == std::string::npos) {
+                        throw std::invalid_argument("Center must be <x>,<y>");
+                    }
+                    gradientOptions.centerX = std::stof(center.substr(0, comma));
+                    gradientOptions.centerY = std::stof(center.substr(comma + 1));
+                    gradientOptionsGiven = true;
+                } else {
+                    throw std::invalid_argument("Missing center value");
+                }
+            }
+            else if (arg == "--dither") {
+                if (i + 1 < argc) {
+                    gradientOptions.dither = Gradient::parseDither(argv[++i]);
+                    gradientOptionsGiven = true;
+                } else {
+                    throw std::invalid_argument("Missing dither mode");
+                }
+            }
+            else if (arg == "--noise") {
+                if (i + 1 < argc) {
+                    noiseOptions.type = Noise::parseType(argv[++i]);
+                    useNoise = true;
+                } else {
+                    throw std::invalid_argument("Missing noise type");
+                }
+            }
+            else if (arg == "--seed") {
+                if (i + 1 < argc) {
+                    noiseOptions.seed = std::stoull(argv[++i]);
+                } else {
+                    throw std::invalid_argument("Missing seed value");
+                }
+            }
+            else if (arg == "--noise-scale") {
+                if (i + 1 < argc) {
+                    noiseOptions.scale = std::stof(argv[++i]);
+                } else {
+                    throw std::invalid_argument("Missing noise scale");
+                }
+            }
+            else if (arg == "--octaves") {
+                if (i + 1 < argc) {
+                    noiseOptions.octaves = std::stoi(argv[++i]);
+                } else {
+                    throw std::invalid_argument("Missing octave count");
+                }
+            }
+            else if (arg == "--noise-amount") {
+                if (i + 1 < argc) {
+                    noiseOptions.amount = std::stof(argv[++i]);
+                } else {
+                    throw std::invalid_argument("Missing noise amount");
+                }
+            }
+            else if (arg == "--pattern") {
+                if (i + 1 < argc) {
+                    patternOptions.type = TestPattern::parseType(argv[++i]);
+                    usePattern = true;
+                } else {
+                    throw std::invalid_argument("Missing pattern type");
+                }
+            }
+            else if (arg == "--cell") {
+                if (i + 1 < argc) {
+                    patternOptions.cell = static_cast<uint32_t>(std::stoul(argv[++i]));
+                } else {
+                    throw std::invalid_argument("Missing cell size");
+                }
+            }
+            else if (arg == "--line-width") {
+                if (i + 1 < argc) {
+                    patternOptions.lineWidth = static_cast<uint32_t>(std::stoul(argv[++i]));
+                } else {
+                    throw std::invalid_argument("Missing line width");
+                }
+            }
+            else if (arg == "--background") {
+                if (i + 1 < argc) {
+                    patternOptions.background = Color(argv[++i]);
+                } else {
+                    throw std::invalid_argument("Missing background color");
+                }
+            }
+            else if (arg == "--frames") {
+                if (i + 1 < argc) {
+                    videoOptions.frames = static_cast<uint32_t>(std::stoul(argv[++i]));
+                    videoOptionsGiven = true;
+                } else {
+                    throw std::invalid_argument("Missing frame count");
+                }
+            }
+            else if (arg == "--fps") {
+                if (i + 1 < argc) {
+                    std::string rate = argv[++i];
+                    size_t slash = rate.find('/');
+                    videoOptions.frameRateNum = static_cast<uint32_t>(std::stoul(rate.substr(0, slash)));
+                    videoOptions.frameRateDen = slash == std::string::npos
+                        ? 1 : static_cast<uint32_t>(std::stoul(rate.substr(slash + 1)));
+                    videoOptionsGiven = true;
+                } else {
+                    throw std::invalid_argument("Missing frame rate");
+                }
+            }
+            else if (arg == "--chroma") {
+                if (i + 1 < argc) {
+                    std::string chroma = argv[++i];
+                    if (chroma == "420") {
+                        videoOptions.chroma = Y4MWriter::Chroma::YUV420;
+                    } else if (chroma == "444") {
+                        videoOptions.chroma = Y4MWriter::Chroma::YUV444;
+                    } else {
+                        throw std::invalid_argument("Chroma must be 420 or 444");
+                    }
+                    videoOptionsGiven = true;
+                    yuvOptionsGiven = true;
+                } else {
+                    throw std::invalid_argument("Missing chroma subsampling");
+                }
+            }
+            else if (arg == "--matrix") {
+                if (i + 1 < argc) {
+                    std::string matrix = argv[++i];
+                    if (matrix == "709") {
+                        videoOptions.matrix = Y4MWriter::Matrix::BT709;
+                    } else if (matrix == "601") {
+                        videoOptions.matrix = Y4MWriter::Matrix::BT601;
+                    } else {
+                        throw std::invalid_argument("Matrix must be 709 or 601");
+                    }
+                    videoOptionsGiven = true;
+                    yuvOptionsGiven = true;
+                } else {
+                    throw std::invalid_argument("Missing YUV matrix");
+                }
+            }
+            else if (arg == "--fade") {
+                if (i + 1 < argc) {
+                    fadeStops = argv[++i];
+                } else {
+                    throw std::invalid_argument("Missing fade colors");
+                }
+            }
+            else if (arg == "--loops") {
+                if (i + 1 < argc) {
+                    loops = static_cast<uint32_t>(std::stoul(argv[++i]));
+                    loopsGiven = true;
+                } else {
+                    throw std::invalid_argument("Missing loop count");
+                }
+            }
+            else if (arg == "--max-bytes") {
+                if (i + 1 < argc) {
+                    maxBytes = std::stoull(argv[++i]);
+                    if (maxBytes == 0) {
+                        throw std::invalid_argument("Byte budget must be at least 1");
+                    }
+                } else {
+                    throw std::invalid_argument("Missing byte budget");
+                }
+            }
+            else if (arg == "--batch") {
+                if (i + 1 < argc) {
+                    batchManifest = argv[++i];
+                } else {
+                    throw std::invalid_argument("Missing batch manifest");
+                }
+            }
+            else if (arg == "--serve") {
+                if (i + 1 < argc) {
+                    serveSocket = argv[++i];
+                } else {
+                    throw std::invalid_argument("Missing socket path");
+                }
+            }
+            else if (arg == "-j" || arg == "--jobs") {
+                if (i + 1 < argc) {
+                    int jobs = std::stoi(argv[++i]);
+                    if (jobs < 1) {
+                        throw std::invalid_argument("Job count must be at least 1");
+                    }
+                    batchThreads = static_cast<size_t>(jobs);
+                } else {
+                    throw std::invalid_argument("Missing job count");
+                }
+            }
+            else if (arg == "--cache-dir") {
+                if (i + 1 < argc) {
+                    cacheDir = argv[++i];
+                } else {
+                    throw std::invalid_argument("Missing cache directory");
+                }
+            }
+            else if (arg == "--cache-hardlink") {
+                cacheHardlink = true;
+            }
+            else if (arg == "--cache-stats") {
+                cacheStats = true;
+            }
             else if (arg == "--hd") {
                 resolution = Resolution::HD();
                 useAutoResolution = false;
@@ -151,6 +520,91 @@ int main(int argc, char* argv[]) {
             }
         }
 
+        std::unique_ptr<ImageCache> cache;
+        if (!cacheDir.empty()) {
+            // A single image never reads the memory tier again, so it is not filled
+            const bool longRunning = !serveSocket.empty() || !batchManifest.empty();
+            cache = std::make_unique<ImageCache>(cacheDir, longRunning ? ImageCache::DEFAULT_MEMORY_CAPACITY : 0);
+            cache->setAllowHardlinks(cacheHardlink);
+        } else if (cacheStats || cacheHardlink) {
+            throw std::invalid_argument("Cache options require --cache-dir");
+        }
+
+        if (maxBytes && (!serveSocket.empty() || !batchManifest.empty())) {
+            throw std::invalid_argument("--max-bytes applies to single images only");
+        }
+
+        if (!gradientStops.empty() && (maxBytes || cache || !serveSocket.empty() || !batchManifest.empty())) {
+            throw std::invalid_argument("--gradient applies to single uncached images only");
+        }
+
+        if (gradientOptionsGiven && gradientStops.empty()) {
+            throw std::invalid_argument("--gradient-type, --angle, --center and --dither require --gradient");
+        }
+
+        if (useNoise && (!gradientStops.empty() || maxBytes || cache || !serveSocket.empty() || !batchManifest.empty())) {
+            throw std::invalid_argument("--noise applies to single uncached images without --gradient");
+        }
+
+        if (usePattern && (useNoise || !gradientStops.empty() || maxBytes || cache ||
+                           !serveSocket.empty() || !batchManifest.empty())) {
+            throw std::invalid_argument("--pattern applies to single uncached images without --gradient or --noise");
+        }
+
+        // Solid colors bypass JPEGEncoder, whose options would have no effect
+        if (jpegOptionsGiven && gradientStops.empty() && !useNoise && !usePattern) {
+            throw std::invalid_argument("--subsampling, --dct and the Huffman options apply to drawn images "
+                                        "(-g, --noise or --pattern)");
+        }
+
+        if (!fadeStops.empty() && (usePattern || useNoise || !gradientStops.empty() || maxBytes || cache ||
+                                   !serveSocket.empty() || !batchManifest.empty())) {
+            throw std::invalid_argument("--fade applies to single uncached videos without other generators");
+        }
+
+        // Server mode: runs until interrupted, every request is self-describing
+        if (!serveSocket.empty()) {
+            ImageServer server(serveSocket, batchThreads, cache.get());
+            server.run();
+            if (cache) {
+                cache->persistStats();
+                if (cacheStats) {
+                    cache->printStats(std::cout);
+                }
+            }
+            return 0;
+        }
+
+        // Batch mode: command line color/resolution/format/quality become defaults
+        if (!batchManifest.empty()) {
+            if (useAutoResolution) {
+                try {
+                    resolution = Resolution::detectScreenResolution();
+                } catch (const std::exception&) {
+                    resolution = Resolution::FullHD();
+                }
+            }
+
+            BatchDefaults defaults{resolution, formatStr, jpegQuality};
+            BatchProcessor batch(defaults, batchThreads, cache.get());
+            BatchSummary summary = batch.run(batchManifest, std::cerr);
+            BatchProcessor::printSummary(summary, std::cout);
+
+            if (cache) {
+                cache->persistStats();
+                if (cacheStats) {
+                    cache->printStats(std::cout);
+                }
+            }
+            return summary.failed == 0 ? 0 : 1;
+        }
+
+        // Stats can be queried without generating an image
+        if (outputFile.empty() && cache && cacheStats) {
+            cache->printStats(std::cout);
+            return 0;
+        }
+
         // Validate required parameters
         if (outputFile.empty()) {
             std::cerr << "Error: Output file is required (-o or --output)\n\n";
@@ -158,6 +612,9 @@ int main(int argc, char* argv[]) {
             return 1;
         }
 
+        // Video written to standard output leaves only stderr for messages
+        std::ostream& status = outputFile == "-" ? std::cerr : std::cout;
+
         // Parse color
         Color color(colorStr);
 
@@ -165,7 +622,7 @@ int main(int argc, char* argv[]) {
         if (useAutoResolution) {
             try {
                 resolution = Resolution::detectScreenResolution();
-                std::cout << "Detected screen resolution: " << resolution.toString() << "\n";
+                status << "Detected screen resolution: " << resolution.toString() << "\n";
             } catch (const std::exception& e) {
                 std::cerr << "Warning: Failed to detect screen resolution, using Full HD (1920x1080)\n";
                 resolution = Resolution::FullHD();
@@ -184,30 +641,159 @@ int main(int argc, char* argv[]) {
         }
 
         // Create writer
-        ImageFormatPtr writer = ImageWriter::createWriterFromExtension(extension);
+        FormatType format = ImageWriter::getFormatFromExtension(extension);
+        ImageFormatPtr writer = ImageWriter::createWriter(format);
+
+        // Video writers take their frame count and layout from the video options
+        Y4MWriter* video = dynamic_cast<Y4MWriter*>(writer.get());
+        if (video) {
+            if (maxBytes || cache) {
+                throw std::invalid_argument("--max-bytes and --cache-dir do not apply to video output");
+            }
+            if (loopsGiven) {
+                throw std::invalid_argument("--loops applies to animated PNG or GIF output");
+            }
+            video->setOptions(videoOptions);
+        } else if ((format == FormatType::PNG || format == FormatType::GIF) && !fadeStops.empty()) {
+            // A PNG or GIF fade is an animation, which takes frames and rate but no YUV layout
+            if (yuvOptionsGiven) {
+                throw std::invalid_argument("--chroma and --matrix apply to y4m or yuv output");
+            }
+        } else if (videoOptionsGiven || !fadeStops.empty() || loopsGiven) {
+            throw std::invalid_argument("Video options require y4m, yuv or animated png/gif output");
+        }
+
+        if (jpegOptionsGiven && format != FormatType::JPEG) {
+            throw std::invalid_argument("--subsampling, --dct and the Huffman options apply to jpg output");
+        }
+
+        // Size the output in memory and pick the settings before anything is written
+        if (maxBytes) {
+            SizeFit fit = SizeBudget::fit(format, color, resolution, jpegQuality, maxBytes);
+            if (format == FormatType::JPEG) {
+                jpegQuality = fit.quality;
+                status << "Quality " << fit.quality << " fits the " << maxBytes << " byte budget ("
+                       << fit.size << " bytes, " << fit.evaluations << " size evaluations)\n";
+            }
+        }
 
         // Special handling for JPEG quality
-        if (extension == ".jpg" || extension == ".jpeg") {
+        if (format == FormatType::JPEG) {
             STBImageWriter* stbWriter = dynamic_cast<STBImageWriter*>(writer.get());
             if (stbWriter) {
                 stbWriter->setJPEGQuality(jpegQuality);
+                jpegQuality = stbWriter->getJPEGQuality();
+                stbWriter->setJPEGSubsampling(jpegSubsampling);
+                stbWriter->setJPEGDCT(jpegDCT);
+                stbWriter->setJPEGHuffman(jpegOptimizeHuffman, jpegHuffmanSampleStep);
+            }
+        }
+
+        if (!fadeStops.empty() && format == FormatType::GIF) {
+            GIFWriter::AnimationOptions animationOptions;
+            animationOptions.frameRateNum = videoOptions.frameRateNum;
+            animationOptions.frameRateDen = videoOptions.frameRateDen;
+            animationOptions.loops = loops;
+            status << "Generating " << videoOptions.frames << " frames of " << resolution.toString()
+                   << " animated GIF fade...\n";
+            GIFWriter::writeFade(outputFile, Fade(Gradient::parseStops(fadeStops), videoOptions.frames),
+                                 resolution, animationOptions);
+            status << "Animation successfully saved to: " << outputFile << "\n";
+            return 0;
+        }
+
+        if (!fadeStops.empty() && !video) {
+            APNGEncoder::Options animationOptions;
+            animationOptions.frameRateNum = videoOptions.frameRateNum;
+            animationOptions.frameRateDen = videoOptions.frameRateDen;
+            animationOptions.loops = loops;
+            status << "Generating " << videoOptions.frames << " frames of " << resolution.toString()
+                   << " animated PNG fade...\n";
+            APNGEncoder::write(outputFile, Fade(Gradient::parseStops(fadeStops), videoOptions.frames),
+                               resolution, animationOptions);
+            status << "Animation successfully saved to: " << outputFile << "\n";
+            return 0;
+        }
+
+        if (!fadeStops.empty()) {
+            status << "Generating " << videoOptions.frames << " frames of " << resolution.toString()
+                   << " " << writer->getFormatName() << " fade...\n";
+            video->writeFade(outputFile, Gradient::parseStops(fadeStops), resolution);
+            status << "Video successfully saved to: " << outputFile << "\n";
+            return 0;
+        }
+
+        // Generated images are streamed from a row source
+        if (!gradientStops.empty()) {
+            Gradient gradient(Gradient::parseStops(gradientStops), resolution, gradientOptions);
+            status << "Generating " << resolution.toString()
+                   << " " << writer->getFormatName() << " gradient...\n";
+            if (!writer->write(outputFile, gradient)) {
+                std::cerr << "Failed to write image\n";
+                return 1;
             }
+            printHuffmanSaving(status, *writer, gradient, outputFile);
+            status << "Image successfully saved to: " << outputFile << "\n";
+            return 0;
+        }
+
+        if (useNoise) {
+            Noise noise(color, resolution, noiseOptions);
+            status << "Generating " << resolution.toString()
+                   << " " << writer->getFormatName() << " noise with color "
+                   << color.toHex(!color.isOpaque()) << "...\n";
+            if (!writer->write(outputFile, noise)) {
+                std::cerr << "Failed to write image\n";
+                return 1;
+            }
+            printHuffmanSaving(status, *writer, noise, outputFile);
+            status << "Image successfully saved to: " << outputFile << "\n";
+            return 0;
+        }
+
+        if (usePattern) {
+            patternOptions.foreground = colorGiven ? color : Color(255, 255, 255);
+            TestPattern pattern(resolution, patternOptions);
+            status << "Generating " << resolution.toString()
+                   << " " << writer->getFormatName() << " test pattern...\n";
+            if (!writer->write(outputFile, pattern)) {
+                std::cerr << "Failed to write image\n";
+                return 1;
+            }
+            printHuffmanSaving(status, *writer, pattern, outputFile);
+            status << "Image successfully saved to: " << outputFile << "\n";
+            return 0;
         }
 
         // Generate image
-        std::cout << "Generating " << resolution.toString()
-                  << " " << writer->getFormatName()
-                  << " image with color " << color.toHex(!color.isOpaque()) << "...\n";
+        status << "Generating " << resolution.toString()
+               << " " << writer->getFormatName()
+               << " image with color " << color.toHex(!color.isOpaque()) << "...\n";
 
         if (!color.isOpaque()) {
-            std::cout << "Note: Color has transparency (alpha = "
-                      << static_cast<int>(color.getAlpha()) << "/255)\n";
+            status << "Note: Color has transparency (alpha = "
+                   << static_cast<int>(color.getAlpha()) << "/255)\n";
         }
 
-        bool success = writer->write(outputFile, color, resolution);
+        bool success;
+        if (cache) {
+            CacheKey key{color, resolution, format, jpegQuality};
+            CacheResult result = cache->write(*writer, key, outputFile);
+            if (result != CacheResult::Miss) {
+                status << "Served from " << (result == CacheResult::MemoryHit ? "memory" : "disk")
+                       << " cache\n";
+            }
+            cache->persistStats();
+            if (cacheStats) {
+                cache->printStats(status);
+            }
+            success = true;
+        } else {
+            success = writer->write(outputFile, color, resolution);
+        }
 
         if (success) {
-            std::cout << "Image successfully saved to: " << outputFile << "\n";
+            status << "Image successfully saved to: " << outputFile << "\n";
             return 0;
         } else {
             std::cerr << "Failed to write image\n";